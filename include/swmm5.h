@@ -128,6 +128,111 @@ int  DLLEXPORT   swmm_getWarnings(void);                                       /
 int  swmm_IsOpenFlag(void);
 int  swmm_IsStartedFlag(void);
 
+/**
+ @brief Opaque handle to a SWMM project context
+*/
+typedef struct TProject* SWMM_Project;
+
+/**
+ @brief Opaque handle to an in-memory snapshot of a running simulation
+*/
+typedef struct TSnapshot* SWMM_Snapshot;
+
+/**
+ @brief Creates an empty project context
+ @param[out] ph handle of the new project
+ @return error code
+*/
+int  DLLEXPORT   swmm_createProject(SWMM_Project* ph);
+
+/**
+ @brief Closes a project if still open and frees its context
+ @param ph project handle
+ @return error code
+*/
+int  DLLEXPORT   swmm_deleteProject(SWMM_Project ph);
+
+/**
+ @brief Selects the project acted on by the calling thread
+ @param ph project handle (NULL selects the default project)
+ @return handle of the previously selected project
+*/
+SWMM_Project DLLEXPORT swmm_selectProject(SWMM_Project ph);
+
+/**
+ @brief Creates a scenario project that shares the parsed input data of an
+        opened project and can be modified and run independently of it
+ @param base handle of an opened project that is not running (NULL for the
+        default project)
+ @param[out] ph handle of the new scenario project
+ @param f2 name of the scenario's report file
+ @param f3 name of the scenario's binary output file (or blank)
+ @return error code
+ @note A scenario must be deleted with swmm_deleteProject before its base
+       project is closed.
+*/
+int  DLLEXPORT   swmm_createScenario(SWMM_Project base, SWMM_Project* ph,
+                 char* f2, char* f3);
+
+/**
+ @brief Runs the scenarios listed in a scenario file on parallel threads,
+        each as a variation of a single input file that is read only once
+ @param f1 name of input file
+ @param f2 name of report file
+ @param f3 name of binary output file (or blank)
+ @param f4 name of scenario file
+ @param nThreads number of scenarios run at once (0 for one per processor)
+ @return error code
+*/
+int  DLLEXPORT   swmm_runEnsemble(char* f1, char* f2, char* f3, char* f4,
+                 int nThreads);
+
+/**
+ @brief Saves the full state of the running simulation in memory
+ @param[out] sh handle of the new snapshot
+ @return error code
+*/
+int  DLLEXPORT   swmm_snapshot(SWMM_Snapshot* sh);
+
+/**
+ @brief Replaces the state saved in a snapshot with the current state of
+        the simulation it was taken from
+ @param sh snapshot handle
+ @return error code
+*/
+int  DLLEXPORT   swmm_updateSnapshot(SWMM_Snapshot sh);
+
+/**
+ @brief Returns the running simulation to the time a snapshot was taken
+ @param sh snapshot handle
+ @return error code
+ @note A snapshot can only be restored into the same run of the project it
+       was taken from and may be restored any number of times.
+*/
+int  DLLEXPORT   swmm_restore(SWMM_Snapshot sh);
+
+/**
+ @brief Frees the memory used by a snapshot
+ @param sh snapshot handle
+ @return error code
+*/
+int  DLLEXPORT   swmm_deleteSnapshot(SWMM_Snapshot sh);
+
+/**
+ @brief Re-entrant versions of the run control functions. Each one acts on
+        project ph, so different projects may be run on different threads.
+*/
+int  DLLEXPORT   swmm_run_r(SWMM_Project ph, char* f1, char* f2, char* f3);
+int  DLLEXPORT   swmm_open_r(SWMM_Project ph, char* f1, char* f2, char* f3);
+int  DLLEXPORT   swmm_start_r(SWMM_Project ph, int saveFlag);
+int  DLLEXPORT   swmm_step_r(SWMM_Project ph, double* elapsedTime);
+int  DLLEXPORT   swmm_end_r(SWMM_Project ph);
+int  DLLEXPORT   swmm_report_r(SWMM_Project ph);
+int  DLLEXPORT   swmm_close_r(SWMM_Project ph);
+int  DLLEXPORT   swmm_getMassBalErr_r(SWMM_Project ph, float* runoffErr,
+                 float* flowErr, float* qualErr);
+int  DLLEXPORT   swmm_getError_r(SWMM_Project ph, char* errMsg, int msgLen);
+
 #ifdef __cplusplus 
 }   // matches the linkage specification from above */ 
 #endif
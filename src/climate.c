@@ -58,56 +58,41 @@ enum   WindSpeedType  {WDMV, AWND};
 static char* ClimateVarWords[] = {"TMIN", "TMAX", "EVAP", "WDMV", "AWND",
                                   NULL};
 
-//-----------------------------------------------------------------------------
-//  Data Structures
-//-----------------------------------------------------------------------------
-typedef struct
-{
-    double    tAve;          // moving avg. for daily temperature (deg F)
-    double    tRng;          // moving avg. for daily temp. range (deg F)
-    double    ta[7];         // data window for tAve
-    double    tr[7];         // data window for tRng
-    int       count;         // length of moving average window
-    int       maxCount;      // maximum length of moving average window
-    int       front;         // index of front of moving average window
-} TMovAve;
-
-
 //-----------------------------------------------------------------------------
 //  Shared variables
 //-----------------------------------------------------------------------------
 // Temperature variables
-static double    Tmin;                 // min. daily temperature (deg F)
-static double    Tmax;                 // max. daily temperature (deg F)
-static double    Trng;                 // 1/2 range of daily temperatures
-static double    Trng1;                // prev. max - current min. temp.
-static double    Tave;                 // average daily temperature (deg F)
-static double    Hrsr;                 // time of min. temp. (hrs)
-static double    Hrss;                 // time of max. temp (hrs)
-static double    Hrday;                // avg. of min/max temp times
-static double    Dhrdy;                // hrs. between min. & max. temp. times
-static double    Dydif;                // hrs. between max. & min. temp. times
-static DateTime  LastDay;              // date of last day with temp. data
-static TMovAve   Tma;                  // moving average of daily temperatures
+#define Tmin    (Prj->climate.Tmin)    // min. daily temperature (deg F)
+#define Tmax    (Prj->climate.Tmax)    // max. daily temperature (deg F)
+#define Trng    (Prj->climate.Trng)    // 1/2 range of daily temperatures
+#define Trng1   (Prj->climate.Trng1)   // prev. max - current min. temp.
+#define Tave    (Prj->climate.Tave)    // average daily temperature (deg F)
+#define Hrsr    (Prj->climate.Hrsr)    // time of min. temp. (hrs)
+#define Hrss    (Prj->climate.Hrss)    // time of max. temp (hrs)
+#define Hrday   (Prj->climate.Hrday)   // avg. of min/max temp times
+#define Dhrdy   (Prj->climate.Dhrdy)   // hrs. between min. & max. temp. times
+#define Dydif   (Prj->climate.Dydif)   // hrs. between max. & min. temp. times
+#define LastDay (Prj->climate.LastDay) // date of last day with temp. data
+#define Tma     (Prj->climate.Tma)     // moving average of daily temperatures
 
 // Evaporation variables
-static DateTime  NextEvapDate;         // next date when evap. rate changes
-static double    NextEvapRate;         // next evaporation rate (user units)
+#define NextEvapDate (Prj->climate.NextEvapDate) // next date when evap. rate changes
+#define NextEvapRate (Prj->climate.NextEvapRate) // next evaporation rate (user units)
 
 // Climate file variables
-static int      FileFormat;            // file format (see ClimateFileFormats)
-static int      FileYear;              // current year of file data
-static int      FileMonth;             // current month of year of file data
-static int      FileDay;               // current day of month of file data
-static int      FileLastDay;           // last day of current month of file data
-static int      FileElapsedDays;       // number of days read from file
-static double   FileValue[4];          // current day's values of climate data
-static double   FileData[4][32];       // month's worth of daily climate data
-static char     FileLine[MAXLINE+1];   // line from climate data file
-
-static int      FileFieldPos[4];       // start of data fields for file record
-static int      FileDateFieldPos;      // start of date field for file record 
-static int      FileWindType;          // wind speed type
+#define FileFormat      (Prj->climate.FileFormat)      // file format (see ClimateFileFormats)
+#define FileYear        (Prj->climate.FileYear)        // current year of file data
+#define FileMonth       (Prj->climate.FileMonth)       // current month of year of file data
+#define FileDay         (Prj->climate.FileDay)         // current day of month of file data
+#define FileLastDay     (Prj->climate.FileLastDay)     // last day of current month of file data
+#define FileElapsedDays (Prj->climate.FileElapsedDays) // number of days read from file
+#define FileValue       (Prj->climate.FileValue)       // current day's values of climate data
+#define FileData        (Prj->climate.FileData)        // month's worth of daily climate data
+#define FileLine        (Prj->climate.FileLine)        // line from climate data file
+
+#define FileFieldPos     (Prj->climate.FileFieldPos)     // start of data fields for file record
+#define FileDateFieldPos (Prj->climate.FileDateFieldPos) // start of date field for file record
+#define FileWindType     (Prj->climate.FileWindType)     // wind speed type
 
 //-----------------------------------------------------------------------------
 //  External functions (defined in funcs.h)
@@ -31,6 +31,12 @@
 #define   MAXTOKS            40             // Max. items per line of input
 #define   MAXSTATES          10             // Max. # computed hyd. variables
 #define   MAXODES            4              // Max. # ODE's to be solved
+#define   MAX_STATS          5              // Max. # critical elements reported
+#define   MAXANDERSON        10             // Max. Anderson accel. history depth
+#define   MINTHREADLINKS     500            // Min. links (or subcatchments)
+                                            //   per automatic thread
+#define   MAXCONDUITBATCH    32             // Max. conduits updated as a batch
+#define   MAXDENSETBL        100001         // Max. size of dense geometry tables
 #define   NA                 -1             // NOT APPLICABLE code
 #define   TRUE               1              // Value for TRUE state
 #define   FALSE              0              // Value for FALSE state
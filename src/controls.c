@@ -140,20 +140,23 @@ struct  TRule
 //-----------------------------------------------------------------------------
 //  Shared variables
 //-----------------------------------------------------------------------------
-struct   TRule*       Rules;           // array of control rules
-struct   TActionList* ActionList;      // linked list of control actions
-int      InputState;                   // state of rule interpreter
-int      RuleCount;                    // total number of rules
-double   ControlValue;                 // value of controller variable
-double   SetPoint;                     // value of controller setpoint
-DateTime CurrentDate;                  // current date in whole days 
-DateTime CurrentTime;                  // current time of day (decimal)
+#define Rules        (Prj->controls.Rules)        // array of control rules
+#define ActionList   (Prj->controls.ActionList)   // linked list of control actions
+#define InputState   (Prj->controls.InputState)   // state of rule interpreter
+#define RuleCount    (Prj->controls.RuleCount)    // total number of rules
+#define ControlValue (Prj->controls.ControlValue) // value of controller variable
+#define SetPoint     (Prj->controls.SetPoint)     // value of controller setpoint
+#define CurrentDate  (Prj->controls.CurrentDate)  // current date in whole days
+#define CurrentTime  (Prj->controls.CurrentTime)  // current time of day (decimal)
 
 //-----------------------------------------------------------------------------
 //  External functions (declared in funcs.h)
 //-----------------------------------------------------------------------------
 //     controls_create
 //     controls_delete
+//     controls_clone
+//     controls_deleteClone
+//     controls_snapshot
 //     controls_addRuleClause
 //     controls_evaluate
 
@@ -176,6 +179,8 @@ int    executeActionList(DateTime currentTime);
 void   clearActionList(void);
 void   deleteActionList(void);
 void   deleteRules(void);
+void   deleteActions(struct TAction* a);
+struct TAction* cloneActions(struct TAction* a, int* errcode);
 
 int    findExactMatch(char *s, char *keyword[]);
 int    setActionSetting(char* tok[], int nToks, int* curve, int* tseries,
@@ -227,6 +232,78 @@ void controls_delete(void)
 
 //=============================================================================
 
+int  controls_clone(void)
+//
+//  Input:   none
+//  Output:  returns error code
+//  Purpose: replaces the control rules of a scenario project with copies
+//           of those it shares with its base project.
+//
+//  Note: rule premises are read-only and remain shared with the base
+//        project; action clauses carry PID state and so are copied.
+{
+   int r;
+   int errcode = 0;
+   ActionList = NULL;
+   if ( RuleCount == 0 ) return 0;
+   Rules = (struct TRule *) memdup(Rules, RuleCount*sizeof(struct TRule));
+   if ( Rules == NULL )
+   {
+       RuleCount = 0;
+       return ERR_MEMORY;
+   }
+   for ( r=0; r<RuleCount; r++ )
+   {
+       Rules[r].thenActions = cloneActions(Rules[r].thenActions, &errcode);
+       Rules[r].elseActions = cloneActions(Rules[r].elseActions, &errcode);
+   }
+   return errcode;
+}
+
+//=============================================================================
+
+void controls_deleteClone(void)
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: deletes the control rule copies owned by a scenario project.
+//
+{
+   int r;
+   if ( RuleCount == 0 ) return;
+   deleteActionList();
+   for ( r=0; r<RuleCount; r++ )
+   {
+       deleteActions(Rules[r].thenActions);
+       deleteActions(Rules[r].elseActions);
+   }
+   FREE(Rules);
+   RuleCount = 0;
+}
+
+//=============================================================================
+
+void controls_snapshot(struct TSnapshot* snap)
+//
+//  Input:   snap = snapshot being built
+//  Output:  none
+//  Purpose: adds the state of each rule action (the errors carried between
+//           time steps by PID controllers) to a snapshot.
+//
+{
+   int r;
+   struct TAction* a;
+   for ( r=0; r<RuleCount; r++ )
+   {
+       for ( a = Rules[r].thenActions; a; a = a->next )
+           snapshot_addBlock(snap, a, sizeof(struct TAction));
+       for ( a = Rules[r].elseActions; a; a = a->next )
+           snapshot_addBlock(snap, a, sizeof(struct TAction));
+   }
+}
+
+//=============================================================================
+
 int  controls_addRuleClause(int r, int keyword, char* tok[], int nToks)
 //
 //  Input:   r = rule index
@@ -1151,8 +1228,6 @@ void  deleteRules(void)
 {
    struct TPremise* p;
    struct TPremise* pnext;
-   struct TAction*  a;
-   struct TAction*  anext;
    int r;
    for (r=0; r<RuleCount; r++)
    {
@@ -1163,20 +1238,8 @@ void  deleteRules(void)
          free(p);
          p = pnext;
       }
-      a = Rules[r].thenActions;
-      while (a )
-      {
-         anext = a->next;
-         free(a);
-         a = anext;
-      }
-      a = Rules[r].elseActions;
-      while (a )
-      {
-         anext = a->next;
-         free(a);
-         a = anext;
-      }
+      deleteActions(Rules[r].thenActions);
+      deleteActions(Rules[r].elseActions);
    }
    FREE(Rules);
    RuleCount = 0;
@@ -1184,6 +1247,53 @@ void  deleteRules(void)
 
 //=============================================================================
 
+void  deleteActions(struct TAction* a)
+//
+//  Input:   a = head of a rule's list of action clauses
+//  Output:  none
+//  Purpose: frees the memory used for a list of action clauses.
+//
+{
+   struct TAction* anext;
+   while ( a )
+   {
+      anext = a->next;
+      free(a);
+      a = anext;
+   }
+}
+
+//=============================================================================
+
+struct TAction* cloneActions(struct TAction* a, int* errcode)
+//
+//  Input:   a = head of a rule's list of action clauses
+//           errcode = error code
+//  Output:  returns head of a copy of the list
+//  Purpose: copies a list of action clauses, preserving its order.
+//
+{
+   struct TAction*  head = NULL;
+   struct TAction** tail = &head;
+   struct TAction*  a1;
+   while ( a )
+   {
+      a1 = (struct TAction *) memdup(a, sizeof(struct TAction));
+      if ( a1 == NULL )
+      {
+         *errcode = ERR_MEMORY;
+         break;
+      }
+      a1->next = NULL;
+      *tail = a1;
+      tail = &a1->next;
+      a = a->next;
+   }
+   return head;
+}
+
+//=============================================================================
+
 int  findExactMatch(char *s, char *keyword[])
 //
 //  Input:   s = character string
@@ -20,6 +20,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include "macros.h"
 #include "datetime.h"
 
 // Macro to convert charcter x to upper case
@@ -43,7 +44,7 @@ static const double SecsPerDay = 86400.;    // seconds per day
 //-----------------------------------------------------------------------------
 //  Shared variables
 //-----------------------------------------------------------------------------
-static int DateFormat;
+static THREADLOCAL int DateFormat = M_D_Y;
 
 
 //=============================================================================
@@ -23,6 +23,14 @@
 //   Build 5.1.013:
 //   - Preissmann slot surcharge option implemented.
 //   - Changed sign of uniform loss rate term (dq6) in flow updating equation.
+//
+//   Build 5.2.0:
+//   - Node depths & inverts are read from, and new link flow variables are
+//     also saved to, the densely packed arrays used by dynwave.c.
+//   - Conduits are updated in batches so that flow areas & hyd. radii of
+//     conduits with the same shape are computed together, for shapes whose
+//     geometry is found by closed-form expressions. Other conduits are
+//     updated one at a time.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -31,6 +39,43 @@
 
 static const  double MAXVELOCITY =  50.;     // max. allowable velocity (ft/sec)
 
+//-----------------------------------------------------------------------------
+//  Shared variables
+//-----------------------------------------------------------------------------
+#define Hot  (Prj->dynwave.Hot)      // hot node & link state (see dynwave.c)
+
+//-----------------------------------------------------------------------------
+//  Data Structures
+//-----------------------------------------------------------------------------
+typedef struct                         // state of a conduit in a batch
+{                                      // being updated
+    int    link;                       // link index
+    double h1, h2;                     // upstream/downstream heads (ft)
+    double y1, y2, yMid;               // upstream/downstream/mid depths (ft)
+    double a1, a2, aMid;               // upstream/downstream/mid areas (ft2)
+    double r1, rMid;                   // upstream/mid hyd. radii (ft)
+} TConduitState;
+
+typedef struct                         // depths of same-shaped conduits
+{                                      // awaiting a geometry evaluation
+    int     n;                         // number of depths
+    TXsect* xsect[3*MAXCONDUITBATCH];  // cross section of each depth
+    double  y[3*MAXCONDUITBATCH];      // depth (ft)
+    double  value[3*MAXCONDUITBATCH];  // area (ft2) or hyd. radius (ft)
+    double* result[3*MAXCONDUITBATCH]; // where to store each value
+} TGeomBatch;
+
+//-----------------------------------------------------------------------------
+//  Function declarations
+//-----------------------------------------------------------------------------
+static void   findConduitDepths(int link, TConduitState* c);
+static void   findConduitGeometry(TConduitState c[], int n);
+static void   getConduitGeometry(TConduitState* c);
+static int    isBatchShape(int type);
+static void   addArea(TGeomBatch* batch, TXsect* xsect, double y, double* a);
+static void   addHydRad(TGeomBatch* batch, TXsect* xsect, double y, double* r);
+static void   findConduitFlow(TConduitState* c, int steps, double omega,
+              double dt);
 static int    getFlowClass(int link, double q, double h1, double h2,
               double y1, double y2, double* criticalDepth, double* normalDepth,
               double* fasnh);
@@ -49,20 +94,255 @@ static double checkNormalFlow(int j, double q, double y1, double y2,
 
 //=============================================================================
 
-void  dwflow_findConduitFlow(int j, int steps, double omega, double dt)
+void  dwflow_findConduitFlows(int links[], int n, int steps, double omega,
+                              double dt)
 //
-//  Input:   j        = link index
+//  Input:   links    = indexes of non-dummy conduit links
+//           n        = number of links
 //           steps    = number of iteration steps taken
 //           omega    = under-relaxation parameter
 //           dt       = time step (sec)
-//  Output:  returns new flow value (cfs)
+//  Output:  none
+//  Purpose: updates flow in a group of conduit links by solving finite
+//           difference form of continuity and momentum equations.
+//
+//  NOTE: conduits whose shape has vectorized geometry (see isBatchShape)
+//        are updated in a batch. Flow depths at the ends of each conduit
+//        in the batch are found first, then the flow areas & hyd. radii
+//        of all conduits with the same shape are found together, and
+//        finally the new flow in each conduit is computed. Other conduits
+//        are updated one at a time as they are reached. Either way, how a
+//        conduit is updated depends only on its shape, so results do not
+//        depend on how the links are split among threads.
+{
+    int    i, m, start;
+    TConduitState c[MAXCONDUITBATCH];
+
+    for (start = 0; start < n; start += MAXCONDUITBATCH)
+    {
+        m = 0;
+        for (i = start; i < MIN(n, start + MAXCONDUITBATCH); i++)
+        {
+            findConduitDepths(links[i], &c[m]);
+            if ( isBatchShape(Link[links[i]].xsect.type) ) m++;
+            else
+            {
+                getConduitGeometry(&c[m]);
+                findConduitFlow(&c[m], steps, omega, dt);
+            }
+        }
+        findConduitGeometry(c, m);
+        for (i = 0; i < m; i++) findConduitFlow(&c[i], steps, omega, dt);
+    }
+}
+
+//=============================================================================
+
+int  isBatchShape(int type)
+//
+//  Input:   type = cross section shape code
+//  Output:  returns TRUE if conduits of this shape are updated in batches
+//  Purpose: checks if the batch geometry functions are faster than the
+//           scalar ones for a cross section shape.
+//
+//  NOTE: the batch functions only vectorize shapes with closed-form
+//        geometry, which they evaluate several times faster than the
+//        scalar ones (see tools/benchmarks/bench_xsect.c); other shapes
+//        gain nothing from being batched.
+{
+    switch ( type )
+    {
+      case RECT_CLOSED:
+      case RECT_OPEN:
+      case TRAPEZOIDAL:
+      case TRIANGULAR: return TRUE;
+      default:         return FALSE;
+    }
+}
+
+//=============================================================================
+
+void  findConduitDepths(int j, TConduitState* c)
+//
+//  Input:   j = link index
+//  Output:  c = conduit's heads & flow depths
+//  Purpose: finds the heads & flow depths at each end of a conduit.
+//
+{
+    int    k;                          // index of conduit
+    int    n1, n2;                     // indexes of end nodes
+    double z1, z2;                     // upstream/downstream invert elev. (ft)
+    double h1, h2;                     // upstream/dounstream flow heads (ft)
+    double y1, y2;                     // upstream/downstream flow depths (ft)
+    TXsect* xsect = &Link[j].xsect;    // ptr. to conduit's cross section data
+
+    // --- get most current heads at upstream and downstream ends of conduit
+    k =  Link[j].subIndex;
+    n1 = Link[j].node1;
+    n2 = Link[j].node2;
+    z1 = Hot.nodeInvert[n1] + Link[j].offset1;
+    z2 = Hot.nodeInvert[n2] + Link[j].offset2;
+    h1 = Hot.nodeDepth[n1] + Hot.nodeInvert[n1];
+    h2 = Hot.nodeDepth[n2] + Hot.nodeInvert[n2];
+    h1 = MAX(h1, z1);
+    h2 = MAX(h2, z2);
+
+    // --- get unadjusted upstream and downstream flow depths in conduit
+    //    (flow depth = head in conduit - elev. of conduit invert)
+    y1 = h1 - z1;
+    y2 = h2 - z2;
+    y1 = MAX(y1, FUDGE);
+    y2 = MAX(y2, FUDGE);
+
+    // --- flow depths can't exceed full depth of conduit if slot not used
+    if ( SurchargeMethod != SLOT )                                             //(5.1.013)
+    {
+        y1 = MIN(y1, xsect->yFull);
+        y2 = MIN(y2, xsect->yFull);
+    }
+
+    // --- find surface area contributions to upstream and downstream nodes
+    //     based on previous iteration's flow estimate
+    //     (using Courant-modified length instead of conduit's actual length)
+    findSurfArea(j, Conduit[k].q1, Conduit[k].modLength, &h1, &h2, &y1, &y2);
+
+    c->link = j;
+    c->h1 = h1;
+    c->h2 = h2;
+    c->y1 = y1;
+    c->y2 = y2;
+    c->yMid = 0.5 * (y1 + y2);
+}
+
+//=============================================================================
+
+void  findConduitGeometry(TConduitState c[], int n)
+//
+//  Input:   c = heads & flow depths of a batch of conduits
+//           n = number of conduits in batch
+//  Output:  c = updated with flow areas & hyd. radii
+//  Purpose: computes the flow area at each end & midpoint of a batch of
+//           conduits and the hyd. radius at their upstream end & midpoint.
+//
+//  NOTE: depths below full depth are collected by cross section shape and
+//        evaluated with xsect_getAofYBatch & xsect_getRofYBatch.
+{
+    int     i, k, type;
+    char    done[MAXCONDUITBATCH];
+    TXsect* xsect;
+    TGeomBatch areas;
+    TGeomBatch radii;
+
+    for (i = 0; i < n; i++) done[i] = FALSE;
+    for (i = 0; i < n; i++)
+    {
+        if ( done[i] ) continue;
+
+        // --- collect depths of all conduits in batch with same shape
+        type = Link[c[i].link].xsect.type;
+        areas.n = 0;
+        radii.n = 0;
+        for (k = i; k < n; k++)
+        {
+            xsect = &Link[c[k].link].xsect;
+            if ( done[k] || xsect->type != type ) continue;
+            done[k] = TRUE;
+            addArea(&areas, xsect, c[k].y1, &c[k].a1);
+            addArea(&areas, xsect, c[k].y2, &c[k].a2);
+            addArea(&areas, xsect, c[k].yMid, &c[k].aMid);
+            addHydRad(&radii, xsect, c[k].y1, &c[k].r1);
+            addHydRad(&radii, xsect, c[k].yMid, &c[k].rMid);
+        }
+
+        // --- evaluate the collected depths
+        xsect_getAofYBatch(areas.xsect, areas.y, areas.value, areas.n);
+        for (k = 0; k < areas.n; k++) *areas.result[k] = areas.value[k];
+        xsect_getRofYBatch(radii.xsect, radii.y, radii.value, radii.n);
+        for (k = 0; k < radii.n; k++) *radii.result[k] = radii.value[k];
+    }
+}
+
+//=============================================================================
+
+void  getConduitGeometry(TConduitState* c)
+//
+//  Input:   c = heads & flow depths of a conduit
+//  Output:  c = updated with flow areas & hyd. radii
+//  Purpose: computes the flow area at each end & midpoint of a conduit
+//           and the hyd. radius at its upstream end & midpoint.
+//
+{
+    TXsect* xsect = &Link[c->link].xsect;
+
+    c->a1 = getArea(xsect, c->y1, getSlotWidth(xsect, c->y1));
+    c->a2 = getArea(xsect, c->y2, getSlotWidth(xsect, c->y2));
+    c->aMid = getArea(xsect, c->yMid, getSlotWidth(xsect, c->yMid));
+    c->r1 = getHydRad(xsect, c->y1);
+    c->rMid = getHydRad(xsect, c->yMid);
+}
+
+//=============================================================================
+
+void  addArea(TGeomBatch* batch, TXsect* xsect, double y, double* a)
+//
+//  Input:   batch = depths waiting to have their flow area computed
+//           xsect = ptr. to conduit cross section
+//           y     = flow depth (ft)
+//           a     = where to store the flow area (ft2)
+//  Output:  none
+//  Purpose: finds the flow area of a surcharged conduit or adds the depth
+//           to a batch of depths whose areas are computed together.
+//
+{
+    if ( y >= xsect->yFull ) *a = getArea(xsect, y, getSlotWidth(xsect, y));   //(5.1.013)
+    else
+    {
+        batch->xsect[batch->n] = xsect;
+        batch->y[batch->n] = y;
+        batch->result[batch->n] = a;
+        batch->n++;
+    }
+}
+
+//=============================================================================
+
+void  addHydRad(TGeomBatch* batch, TXsect* xsect, double y, double* r)
+//
+//  Input:   batch = depths waiting to have their hyd. radius computed
+//           xsect = ptr. to conduit cross section
+//           y     = flow depth (ft)
+//           r     = where to store the hyd. radius (ft)
+//  Output:  none
+//  Purpose: finds the hyd. radius of a full conduit or adds the depth
+//           to a batch of depths whose radii are computed together.
+//
+{
+    if ( y >= xsect->yFull ) *r = xsect->rFull;
+    else
+    {
+        batch->xsect[batch->n] = xsect;
+        batch->y[batch->n] = y;
+        batch->result[batch->n] = r;
+        batch->n++;
+    }
+}
+
+//=============================================================================
+
+void  findConduitFlow(TConduitState* c, int steps, double omega, double dt)
+//
+//  Input:   c        = conduit's heads, depths, flow areas & hyd. radii
+//           steps    = number of iteration steps taken
+//           omega    = under-relaxation parameter
+//           dt       = time step (sec)
+//  Output:  none
 //  Purpose: updates flow in conduit link by solving finite difference
 //           form of continuity and momentum equations.
 //
 {
+    int    j = c->link;                // link index
     int    k;                          // index of conduit
     int    n1, n2;                     // indexes of end nodes
-    double z1, z2;                     // upstream/downstream invert elev. (ft)
     double h1, h2;                     // upstream/dounstream flow heads (ft)
     double y1, y2;                     // upstream/downstream flow depths (ft)
     double a1, a2;                     // upstream/downstream flow areas (ft2)
@@ -76,7 +356,6 @@ void  dwflow_findConduitFlow(int j, int steps, double omega, double dt)
     double rho;                        // upstream weighting factor
     double sigma;                      // inertial damping factor
     double length;                     // effective conduit length (ft)
-    double wSlot;                      // Preissmann slot width (ft)           //(5.1.013)
     double dq1, dq2, dq3, dq4, dq5,    // terms in momentum eqn.
            dq6;                        // term for evap and infil losses
     double denom;                      // denominator of flow update formula
@@ -86,8 +365,6 @@ void  dwflow_findConduitFlow(int j, int steps, double omega, double dt)
     char   isFull = FALSE;             // TRUE if conduit flowing full
     char   isClosed = FALSE;           // TRUE if conduit closed
 
-
-
     // --- adjust isClosed status by any control action
     if ( Link[j].setting == 0 ) isClosed = TRUE;
 
@@ -97,29 +374,19 @@ void  dwflow_findConduitFlow(int j, int steps, double omega, double dt)
     qOld = Link[j].oldFlow / barrels;
     qLast = Conduit[k].q1;
 
-    // --- get most current heads at upstream and downstream ends of conduit
+    // --- retrieve heads, depths, areas & hyd. radii found for the batch
     n1 = Link[j].node1;
     n2 = Link[j].node2;
-    z1 = Node[n1].invertElev + Link[j].offset1;
-    z2 = Node[n2].invertElev + Link[j].offset2;
-    h1 = Node[n1].newDepth + Node[n1].invertElev;
-    h2 = Node[n2].newDepth + Node[n2].invertElev;
-    h1 = MAX(h1, z1);
-    h2 = MAX(h2, z2);
-
-    // --- get unadjusted upstream and downstream flow depths in conduit
-    //    (flow depth = head in conduit - elev. of conduit invert)
-    y1 = h1 - z1;
-    y2 = h2 - z2;
-    y1 = MAX(y1, FUDGE);
-    y2 = MAX(y2, FUDGE);
-
-    // --- flow depths can't exceed full depth of conduit if slot not used
-    if ( SurchargeMethod != SLOT )                                             //(5.1.013)
-    {
-        y1 = MIN(y1, xsect->yFull);
-        y2 = MIN(y2, xsect->yFull);
-    }
+    h1 = c->h1;
+    h2 = c->h2;
+    y1 = c->y1;
+    y2 = c->y2;
+    yMid = c->yMid;
+    a1 = c->a1;
+    a2 = c->a2;
+    aMid = c->aMid;
+    r1 = c->r1;
+    rMid = c->rMid;
 
     // -- get area from solution at previous time step
     aOld = Conduit[k].a2;
@@ -128,23 +395,6 @@ void  dwflow_findConduitFlow(int j, int steps, double omega, double dt)
     // --- use Courant-modified length instead of conduit's actual length
     length = Conduit[k].modLength;
 
-    // --- find surface area contributions to upstream and downstream nodes
-    //     based on previous iteration's flow estimate
-    findSurfArea(j, qLast, length, &h1, &h2, &y1, &y2);
-
-    // --- compute area at each end of conduit & hyd. radius at upstream end
-    wSlot = getSlotWidth(xsect, y1);                                           //(5.1.013)
-    a1 = getArea(xsect, y1, wSlot);                                            //(5.1.013)
-    r1 = getHydRad(xsect, y1);
-    wSlot = getSlotWidth(xsect, y2);                                           //(5.1.013)
-    a2 = getArea(xsect, y2, wSlot);                                            //(5.1.013)
-
-    // --- compute area & hyd. radius at midpoint
-    yMid = 0.5 * (y1 + y2);
-    wSlot = getSlotWidth(xsect, yMid);                                         //(5.1.013)
-    aMid = getArea(xsect, yMid, wSlot);                                        //(5.1.013)
-    rMid = getHydRad(xsect, yMid);
-
     // --- alternate approach not currently used, but might produce better
     //     Bernoulli energy balance for steady flows
     //aMid = (a1+a2)/2.0;
@@ -169,6 +419,8 @@ void  dwflow_findConduitFlow(int j, int steps, double omega, double dt)
         Link[j].newDepth = MIN(yMid, Link[j].xsect.yFull);
         Link[j].newVolume = Conduit[k].a1 * link_getLength(j) * barrels;
         Link[j].newFlow = 0.0;
+        Hot.linkFlow[j] = 0.0;
+        Hot.linkDqdh[j] = Link[j].dqdh;
         return;
     }
 
@@ -227,6 +479,7 @@ void  dwflow_findConduitFlow(int j, int steps, double omega, double dt)
 
     // --- 6. term for evap and seepage losses per unit length
     dq6 = link_getLossRate(j, qOld, dt) * 2.5 * dt * v / link_getLength(j);
+    Hot.linkLossRate[j] = Conduit[k].evapLossRate + Conduit[k].seepLossRate;
 
     // --- combine terms to find new conduit flow
     denom = 1.0 + dq1 + dq5;
@@ -271,8 +524,8 @@ void  dwflow_findConduitFlow(int j, int steps, double omega, double dt)
 
     // --- do not allow flow out of a dry node
     //     (as suggested by R. Dickinson)
-    if( q >  FUDGE && Node[n1].newDepth <= FUDGE ) q =  FUDGE;
-    if( q < -FUDGE && Node[n2].newDepth <= FUDGE ) q = -FUDGE;
+    if( q >  FUDGE && Hot.nodeDepth[n1] <= FUDGE ) q =  FUDGE;
+    if( q < -FUDGE && Hot.nodeDepth[n2] <= FUDGE ) q = -FUDGE;
 
     // --- save new values of area, flow, depth, & volume
     Conduit[k].a1 = aMid;
@@ -284,6 +537,8 @@ void  dwflow_findConduitFlow(int j, int steps, double omega, double dt)
     Conduit[k].fullState = link_getFullState(a1, a2, xsect->aFull);
     Link[j].newVolume = aMid * link_getLength(j) * barrels;
     Link[j].newFlow = q * barrels;
+    Hot.linkFlow[j] = Link[j].newFlow;
+    Hot.linkDqdh[j] = Link[j].dqdh;
 }
 
 //=============================================================================
@@ -318,8 +573,8 @@ int getFlowClass(int j, double q, double h1, double h2, double y1, double y2,
     z2 = Link[j].offset2;
 
     // --- base offset of an outfall conduit on outfall's depth
-    if ( Node[n1].type == OUTFALL ) z1 = MAX(0.0, (z1 - Node[n1].newDepth));
-    if ( Node[n2].type == OUTFALL ) z2 = MAX(0.0, (z2 - Node[n2].newDepth));
+    if ( Node[n1].type == OUTFALL ) z1 = MAX(0.0, (z1 - Hot.nodeDepth[n1]));
+    if ( Node[n2].type == OUTFALL ) z2 = MAX(0.0, (z2 - Hot.nodeDepth[n2]));
 
     // --- default class is SUBCRITICAL
     flowClass = SUBCRITICAL;
@@ -372,7 +627,7 @@ int getFlowClass(int j, double q, double h1, double h2, double y1, double y2,
     {
         // --- flow classification is UP_DRY if downstream head <
         //     invert of upstream end of conduit
-        if ( h2 < Node[n1].invertElev + Link[j].offset1 ) flowClass = UP_DRY;
+        if ( h2 < Hot.nodeInvert[n1] + Link[j].offset1 ) flowClass = UP_DRY;
 
         // --- otherwise, the downstream head will be >= upstream
         //     conduit invert creating a flow reversal and upstream end
@@ -391,7 +646,7 @@ int getFlowClass(int j, double q, double h1, double h2, double y1, double y2,
     {
         // --- flow classification is DN_DRY if upstream head <
         //     invert of downstream end of conduit
-        if ( h1 < Node[n2].invertElev + Link[j].offset2 ) flowClass = DN_DRY;
+        if ( h1 < Hot.nodeInvert[n2] + Link[j].offset2 ) flowClass = DN_DRY;
 
         // --- otherwise flow at downstream end should be at critical depth
         //     providing that a downstream offset exists (otherwise
@@ -474,7 +729,7 @@ void findSurfArea(int j, double q, double length, double* h1, double* h2,
         flowDepth1 = criticalDepth;
         if ( normalDepth < criticalDepth ) flowDepth1 = normalDepth;
         flowDepth1 = MAX(flowDepth1, FUDGE);
-        *h1 = Node[n1].invertElev + Link[j].offset1 + flowDepth1;
+        *h1 = Hot.nodeInvert[n1] + Link[j].offset1 + flowDepth1;
         flowDepthMid = 0.5 * (flowDepth1 + flowDepth2);
         if ( flowDepthMid < FUDGE ) flowDepthMid = FUDGE;
         width2   = getWidth(xsect, flowDepth2);
@@ -486,7 +741,7 @@ void findSurfArea(int j, double q, double length, double* h1, double* h2,
         flowDepth2 = criticalDepth;
         if ( normalDepth < criticalDepth ) flowDepth2 = normalDepth;
         flowDepth2 = MAX(flowDepth2, FUDGE);
-        *h2 = Node[n2].invertElev + Link[j].offset2 + flowDepth2;
+        *h2 = Hot.nodeInvert[n2] + Link[j].offset2 + flowDepth2;
         width1 = getWidth(xsect, flowDepth1);
         flowDepthMid = 0.5 * (flowDepth1 + flowDepth2);
         if ( flowDepthMid < FUDGE ) flowDepthMid = FUDGE;
@@ -541,6 +796,8 @@ void findSurfArea(int j, double q, double length, double* h1, double* h2,
     }
     Link[j].surfArea1 = surfArea1;
     Link[j].surfArea2 = surfArea2;
+    Hot.linkSurfArea1[j] = surfArea1;
+    Hot.linkSurfArea2[j] = surfArea2;
     *y1 = flowDepth1;
     *y2 = flowDepth2;
 }
@@ -0,0 +1,453 @@
+//-----------------------------------------------------------------------------
+//   ensemble.c
+//
+//   Project:  EPA SWMM5
+//   Version:  5.2
+//   Date:     10/16/26   (Build 5.2.0)
+//
+//   Scenario ensemble runner.
+//
+//   Runs a set of scenarios that differ from a single input file only in
+//   the values of some object properties. The input file is read and
+//   validated once into a base project and each scenario is created from
+//   it with swmm_createScenario, so that scenarios can be run on parallel
+//   threads without re-parsing the input.
+//
+//   Each line of a scenario file has the format:
+//      scenarioID  (objectType  objectID  property  value)
+//   where objectType is NODE, LINK or SUBCATCH and property is one of the
+//   keywords listed below for that type of object. Values are in the
+//   project's units. A line with just a scenario ID declares a scenario
+//   that runs the base input unchanged. Text following a ';' is a comment.
+//
+//   Scenario i writes its results to the report and output files named
+//   in the call, with "_<scenarioID>" inserted before the file extension.
+//
+//-----------------------------------------------------------------------------
+#define _CRT_SECURE_NO_DEPRECATE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_OPENMP)
+  #include <omp.h>
+#endif
+
+#include "headers.h"
+#include "swmm5.h"
+#include "toolkitAPI.h"
+
+//-----------------------------------------------------------------------------
+//  Data Structures
+//-----------------------------------------------------------------------------
+// Property change made by a scenario
+typedef struct
+{
+    int      type;                 // NODE, LINK or SUBCATCH
+    int      index;                // index of object being changed
+    int      param;                // SM_NodeProperty, SM_LinkProperty or
+                                   // SM_SubcProperty code
+    double   value;                // new property value (user's units)
+}   TScenarioParam;
+
+// Scenario
+typedef struct
+{
+    char             ID[MAXFNAME+1];   // scenario name
+    int              paramCount;       // number of property changes
+    TScenarioParam*  params;           // array of property changes
+    int              errCode;          // error code returned by its run
+}   TScenario;
+
+//-----------------------------------------------------------------------------
+//  Constants
+//-----------------------------------------------------------------------------
+static char* ObjectWords[]   = {"NODE", "LINK", "SUBCATCH", NULL};
+static char* NodeParamWords[] = {"INVERTEL", "FULLDEPTH", "SURCHDEPTH",
+                                 "PONDAREA", "INITDEPTH", NULL};
+static char* LinkParamWords[] = {"OFFSET1", "OFFSET2", "INITFLOW",
+                                 "FLOWLIMIT", "INLETLOSS", "OUTLETLOSS",
+                                 "AVELOSS", NULL};
+static char* SubcParamWords[] = {"WIDTH", "AREA", "FRACIMPERV", "SLOPE",
+                                 "CURBLEN", NULL};
+static const int ObjectTypes[] = {NODE, LINK, SUBCATCH};
+
+//-----------------------------------------------------------------------------
+//  External functions (declared in swmm5.h)
+//-----------------------------------------------------------------------------
+//  swmm_runEnsemble
+
+//-----------------------------------------------------------------------------
+//  Local functions
+//-----------------------------------------------------------------------------
+static int   readScenarios(char* f, TScenario** scenarios, int* count);
+static int   parseScenarioLine(char* line, TScenario** scenarios, int* count);
+static int   findScenario(TScenario* scenarios, int count, char* id);
+static int   runScenario(SWMM_Project base, TScenario* scenario,
+             char* f2, char* f3);
+static int   setScenarioParams(TScenario* scenario);
+static char* getScenarioFileName(char* dest, char* fname, char* id);
+static void  writeEnsembleSummary(TScenario* scenarios, int count,
+             int nThreads);
+static void  deleteScenarios(TScenario* scenarios, int count);
+
+//=============================================================================
+
+int DLLEXPORT swmm_runEnsemble(char* f1, char* f2, char* f3, char* f4,
+                               int nThreads)
+//
+//  Input:   f1 = name of input file
+//           f2 = name of report file
+//           f3 = name of binary output file (or blank if not saved)
+//           f4 = name of scenario file
+//           nThreads = number of scenarios run at once (0 for one per
+//                      processor)
+//  Output:  returns error code
+//  Purpose: runs each scenario listed in a scenario file as a variation
+//           of a single input file.
+//
+{
+    SWMM_Project base;
+    TProject*    oldPrj;
+    TScenario*   scenarios = NULL;
+    int          count = 0;
+    int          i;
+    int          errcode;
+
+    // --- read the input file into a base project
+    errcode = swmm_createProject(&base);
+    if ( errcode ) return errcode;
+    errcode = swmm_open_r(base, f1, f2, f3);
+
+    // --- read the scenario file using the base project's object names
+    oldPrj = swmm_selectProject(base);
+    if ( !errcode )
+    {
+        ErrorCode = readScenarios(f4, &scenarios, &count);
+        errcode = error_getCode(ErrorCode);
+    }
+
+    // --- run the scenarios
+    if ( !errcode )
+    {
+#if defined(_OPENMP)
+        if ( nThreads <= 0 ) nThreads = omp_get_num_procs();
+#else
+        nThreads = 1;
+#endif
+        nThreads = MAX(1, MIN(nThreads, count));
+#pragma omp parallel for schedule(dynamic) num_threads(nThreads)
+        for (i = 0; i < count; i++)
+        {
+            scenarios[i].errCode = runScenario(base, &scenarios[i], f2, f3);
+        }
+        writeEnsembleSummary(scenarios, count, nThreads);
+        for (i = 0; i < count; i++)
+        {
+            if ( scenarios[i].errCode )
+            {
+                errcode = scenarios[i].errCode;
+                break;
+            }
+        }
+    }
+
+    // --- close the base project
+    deleteScenarios(scenarios, count);
+    Prj = oldPrj;
+    swmm_deleteProject(base);
+    return errcode;
+}
+
+//=============================================================================
+
+int readScenarios(char* f, TScenario** scenarios, int* count)
+//
+//  Input:   f = name of scenario file
+//  Output:  scenarios = array of scenarios read from the file
+//           count = number of scenarios
+//           returns an error code
+//  Purpose: reads the contents of a scenario file.
+//
+{
+    FILE* file;
+    char  line[MAXLINE+1];
+    int   errcode = 0;
+
+    *scenarios = NULL;
+    *count = 0;
+    file = fopen(f, "rt");
+    if ( file == NULL )
+    {
+        report_writeErrorMsg(ERR_SCENARIO_FILE_OPEN, f);
+        return ERR_SCENARIO_FILE_OPEN;
+    }
+    while ( fgets(line, MAXLINE, file) != NULL )
+    {
+        errcode = parseScenarioLine(line, scenarios, count);
+        if ( errcode )
+        {
+            report_writeErrorMsg(errcode, line);
+            break;
+        }
+    }
+    fclose(file);
+    if ( !errcode && *count == 0 )
+    {
+        errcode = ERR_SCENARIO_FILE_DATA;
+        report_writeErrorMsg(errcode, "(no scenarios)");
+    }
+    return errcode;
+}
+
+//=============================================================================
+
+int parseScenarioLine(char* line, TScenario** scenarios, int* count)
+//
+//  Input:   line = line of scenario file
+//           scenarios = array of scenarios
+//           count = number of scenarios
+//  Output:  returns an error code
+//  Purpose: adds the scenario or property change described on a line of
+//           a scenario file.
+//
+{
+    char   id[MAXLINE+1], objType[MAXLINE+1], objID[MAXLINE+1];
+    char   paramName[MAXLINE+1], valueStr[MAXLINE+1];
+    char*  comment;
+    char** paramWords;
+    int    n, k, type, index, param;
+    double value;
+    TScenario* s;
+    TScenarioParam* p;
+
+    // --- strip comments & line endings, skipping blank lines
+    comment = strchr(line, ';');
+    if ( comment ) *comment = '\0';
+    line[strcspn(line, "\r\n")] = '\0';
+    n = sscanf(line, "%s %s %s %s %s", id, objType, objID, paramName,
+               valueStr);
+    if ( n <= 0 ) return 0;
+    if ( n != 1 && n != 5 ) return ERR_SCENARIO_FILE_DATA;
+
+    // --- find the scenario, adding a new one if needed
+    k = findScenario(*scenarios, *count, id);
+    if ( k < 0 )
+    {
+        s = (TScenario *) realloc(*scenarios, (*count+1) * sizeof(TScenario));
+        if ( s == NULL ) return ERR_MEMORY;
+        *scenarios = s;
+        k = (*count)++;
+        sstrncpy(s[k].ID, id, MAXFNAME);
+        s[k].paramCount = 0;
+        s[k].params = NULL;
+        s[k].errCode = 0;
+    }
+    if ( n == 1 ) return 0;
+
+    // --- identify the object & property being changed
+    type = findmatch(objType, ObjectWords);
+    if ( type < 0 ) return ERR_SCENARIO_FILE_DATA;
+    if      ( type == 0 ) paramWords = NodeParamWords;
+    else if ( type == 1 ) paramWords = LinkParamWords;
+    else                  paramWords = SubcParamWords;
+    type = ObjectTypes[type];
+    index = project_findObject(type, objID);
+    param = findmatch(paramName, paramWords);
+    if ( index < 0 || param < 0 ) return ERR_SCENARIO_FILE_DATA;
+    if ( !getDouble(valueStr, &value) ) return ERR_SCENARIO_FILE_DATA;
+
+    // --- add the property change to the scenario
+    s = &(*scenarios)[k];
+    p = (TScenarioParam *) realloc(s->params,
+                                   (s->paramCount+1) * sizeof(TScenarioParam));
+    if ( p == NULL ) return ERR_MEMORY;
+    s->params = p;
+    p = &s->params[s->paramCount++];
+    p->type = type;
+    p->index = index;
+    p->param = param;
+    p->value = value;
+    return 0;
+}
+
+//=============================================================================
+
+int findScenario(TScenario* scenarios, int count, char* id)
+//
+//  Input:   scenarios = array of scenarios
+//           count = number of scenarios
+//           id = scenario name
+//  Output:  returns index of scenario with name id or -1 if not found
+//  Purpose: finds a scenario by name.
+//
+{
+    int k;
+    for (k = 0; k < count; k++)
+    {
+        if ( strcomp(scenarios[k].ID, id) ) return k;
+    }
+    return -1;
+}
+
+//=============================================================================
+
+int runScenario(SWMM_Project base, TScenario* scenario, char* f2, char* f3)
+//
+//  Input:   base = base project
+//           scenario = scenario to run
+//           f2 = name of base report file
+//           f3 = name of base binary output file
+//  Output:  returns an error code
+//  Purpose: creates a scenario project from the base project, runs it
+//           to completion and deletes it.
+//
+{
+    char rptName[MAXFNAME+1];
+    char outName[MAXFNAME+1];
+    SWMM_Project p;
+    TProject*    oldPrj;
+    double elapsedTime = 0.0;
+    int    errcode;
+
+    getScenarioFileName(rptName, f2, scenario->ID);
+    getScenarioFileName(outName, f3, scenario->ID);
+    errcode = swmm_createScenario(base, &p, rptName, outName);
+    if ( errcode ) return errcode;
+
+    // --- apply the scenario's changes & run it in the same way as swmm_run
+    oldPrj = swmm_selectProject(p);
+    errcode = setScenarioParams(scenario);
+    if ( !errcode )
+    {
+        swmm_start(TRUE);
+        if ( !ErrorCode )
+        {
+            do
+            {
+                swmm_step(&elapsedTime);
+            } while ( elapsedTime > 0.0 && !ErrorCode );
+        }
+        swmm_end();
+        if ( Fout.mode == SCRATCH_FILE ) swmm_report();
+        errcode = error_getCode(ErrorCode);
+    }
+    swmm_close();
+    Prj = oldPrj;
+    swmm_deleteProject(p);
+    return errcode;
+}
+
+//=============================================================================
+
+int setScenarioParams(TScenario* scenario)
+//
+//  Input:   scenario = scenario being run
+//  Output:  returns an error code
+//  Purpose: applies a scenario's property changes to the current project.
+//
+{
+    int k;
+    int errcode = 0;
+    TScenarioParam* p;
+
+    for (k = 0; k < scenario->paramCount && !errcode; k++)
+    {
+        p = &scenario->params[k];
+        switch ( p->type )
+        {
+        case NODE:
+            errcode = swmm_setNodeParam(p->index, p->param, p->value);
+            break;
+        case LINK:
+            errcode = swmm_setLinkParam(p->index, p->param, p->value);
+            break;
+        case SUBCATCH:
+            errcode = swmm_setSubcatchParam(p->index, p->param, p->value);
+            break;
+        }
+    }
+    return errcode;
+}
+
+//=============================================================================
+
+char* getScenarioFileName(char* dest, char* fname, char* id)
+//
+//  Input:   fname = name of a base project file
+//           id = scenario name
+//  Output:  dest = fname with "_id" inserted before its extension
+//           returns a pointer to dest
+//  Purpose: names a file written by a scenario.
+//
+{
+    char*  ext;
+    char*  sep;
+    size_t n;
+
+    // --- a blank name (e.g., no saved output file) remains blank
+    if ( fname == NULL || strlen(fname) == 0 )
+    {
+        dest[0] = '\0';
+        return dest;
+    }
+
+    // --- locate the extension of the file's name, ignoring its path
+    ext = strrchr(fname, '.');
+    sep = strrchr(fname, '/');
+    if ( sep == NULL ) sep = strrchr(fname, '\\');
+    if ( ext == NULL || (sep && ext < sep) ) ext = fname + strlen(fname);
+
+    n = MIN((size_t)(ext - fname), MAXFNAME);
+    strncpy(dest, fname, n);
+    dest[n] = '\0';
+    snprintf(dest + n, MAXFNAME + 1 - n, "_%s%s", id, ext);
+    return dest;
+}
+
+//=============================================================================
+
+void writeEnsembleSummary(TScenario* scenarios, int count, int nThreads)
+//
+//  Input:   scenarios = array of scenarios
+//           count = number of scenarios
+//           nThreads = number of scenarios run at once
+//  Output:  none
+//  Purpose: lists the outcome of each scenario run in the base project's
+//           report file.
+//
+{
+    int k;
+    if ( Frpt.file == NULL ) return;
+    fprintf(Frpt.file,
+        "\n  *************************"
+        "\n  Scenario Ensemble Summary"
+        "\n  *************************"
+        "\n  %d scenarios run on %d threads.\n"
+        "\n  ----------------------------------------------"
+        "\n  Scenario                  Changes  Error Code"
+        "\n  ----------------------------------------------",
+        count, nThreads);
+    for (k = 0; k < count; k++)
+    {
+        fprintf(Frpt.file, "\n  %-24s  %7d  %10d", scenarios[k].ID,
+                scenarios[k].paramCount, scenarios[k].errCode);
+    }
+    fprintf(Frpt.file, "\n");
+}
+
+//=============================================================================
+
+void deleteScenarios(TScenario* scenarios, int count)
+//
+//  Input:   scenarios = array of scenarios
+//           count = number of scenarios
+//  Output:  none
+//  Purpose: frees the memory used by an array of scenarios.
+//
+{
+    int k;
+    for (k = 0; k < count; k++) FREE(scenarios[k].params);
+    free(scenarios);
+}
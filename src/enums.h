@@ -37,6 +37,17 @@
 //   - SURCHARGE_METHOD and RULE_STEP options added.
 //   - WEIR_CURVE added as a curve type. 
 //
+//   Build 5.2.0:
+//   - SOLVER_METHOD and ANDERSON_DEPTH options added.
+//   - THREAD_SCHEDULE option added.
+//   - DENSE_TABLE_SIZE option added.
+//   - CIRCULAR_GEOMETRY option added.
+//   - NETWORK_ORDER option added.
+//   - PREDICTOR option added.
+//   - RUNOFF_SOLVER option added.
+//   - DEPTH_WARM_START option added.
+//   - ACTIVE_SET option added.
+//
 //-----------------------------------------------------------------------------
 
 //-------------------------------------
@@ -82,6 +93,21 @@
       WEIR,
       OUTLET};
 
+//-------------------------------------
+// Lists of links of the same kind
+//-------------------------------------
+ #define MAX_LINK_LISTS 9
+ enum LinkListType {
+      CONDUIT_LIST,                    // all conduits
+      TRUE_CONDUIT_LIST,               // conduits without dummy cross sections
+      DUMMY_CONDUIT_LIST,              // conduits with dummy cross sections
+      PUMP_LIST,                       // pumps
+      ORIFICE_LIST,                    // orifices
+      WEIR_LIST,                       // weirs
+      OUTLET_LIST,                     // outlets
+      REGULATOR_LIST,                  // orifices, weirs & outlets
+      OUTFALL_LINK_LIST};              // links attached to outfalls
+
 //-------------------------------------
 // File types
 //-------------------------------------
@@ -368,6 +394,33 @@ enum  CompatibilityType {
       EXTRAN,                          // original EXTRAN method
       SLOT};                           // Preissmann slot method
 
+ enum  SolverMethodType {
+      PICARD,                          // successive approximations
+      NEWTON,                          // Jacobian-free Newton-Krylov method
+      ANDERSON};                       // Anderson accelerated iterations
+
+ enum  ThreadScheduleType {
+      STATIC,                          // same run of nodes & links per thread
+      DYNAMIC,                         // chunks handed to free threads
+      GUIDED};                         // chunks of decreasing size
+
+ enum  CircGeometryType {
+      TABLE_GEOMETRY,                  // interpolated from xsect.dat tables
+      ANALYTIC_GEOMETRY};              // non-iterative closed form solution
+
+ enum  NetworkOrderType {
+      INPUT_ORDER,                     // nodes & links indexed as read in
+      RCM_ORDER};                      // reverse Cuthill-McKee ordering
+
+ enum  PredictorType {
+      NO_PREDICTOR,                    // start from last step's solution
+      LINEAR_PREDICTOR,                // extrapolate from last 2 solutions
+      QUADRATIC_PREDICTOR};            // extrapolate from last 3 solutions
+
+ enum  RunoffSolverType {
+      RK_RUNOFF,                       // adaptive Runge-Kutta ODE solver
+      ROSENBROCK_RUNOFF};              // Rosenbrock steps in fixed substeps
+
  enum InflowType {
       EXTERNAL_INFLOW,                 // user-supplied external inflow
       DRY_WEATHER_INFLOW,              // user-supplied dry weather inflow
@@ -470,7 +523,11 @@ enum  CompatibilityType {
     IGNORE_SNOWMELT, IGNORE_GWATER, IGNORE_ROUTING,
     IGNORE_QUALITY, MAX_TRIALS, HEAD_TOL,
     SYS_FLOW_TOL, LAT_FLOW_TOL, IGNORE_RDII,
-    MIN_ROUTE_STEP, NUM_THREADS, SURCHARGE_METHOD};                              //(5.1.013)
+    MIN_ROUTE_STEP, NUM_THREADS, SURCHARGE_METHOD,                               //(5.1.013)
+    SOLVER_METHOD, ANDERSON_DEPTH, THREAD_SCHEDULE,
+    DENSE_TABLE_SIZE, CIRCULAR_GEOMETRY, NETWORK_ORDER,
+    PREDICTOR, RUNOFF_SOLVER, DEPTH_WARM_START,
+    ACTIVE_SET};
 
 enum  NoYesType {
       NO,
@@ -20,6 +20,7 @@
 #define _CRT_SECURE_NO_DEPRECATE
 
 #include <string.h>
+#include "macros.h"
 #include "error.h"
 
 #define ERR101 "\n  ERROR 101: memory allocation error."
@@ -160,6 +161,9 @@
 #define ERR361 "\n  ERROR 361: could not open external file used for Time Series %s."
 #define ERR363 "\n  ERROR 363: invalid data in external file used for Time Series %s."
 
+#define ERR365 "\n  ERROR 365: cannot open scenario file %s."
+#define ERR367 "\n  ERROR 367: invalid data in scenario file at line: %s"
+
 #define ERR401 "\n  ERROR 401: general system error."
 #define ERR402 \
 "\n  ERROR 402: cannot open new project while current project still open."
@@ -180,6 +184,7 @@
 #define ERR509 "\n API Key Error: Invalid Pattern Index"
 #define ERR510 "\n API Key Error: Invalid Lid Unit Index"
 #define ERR511 "\n API Key Error: Undefined Subcatchment Lid"
+#define ERR512 "\n API Key Error: Snapshot not taken from current simulation"
 
 ////////////////////////////////////////////////////////////////////////////
 //  NOTE: Need to update ErrorMsgs[], ErrorCodes[], and ErrorType
@@ -198,8 +203,9 @@ char* ErrorMsgs[] =
       ERR313, ERR315, ERR317, ERR318, ERR319, ERR320, ERR321, ERR323, ERR325,
       ERR327, ERR329, ERR330, ERR331, ERR333, ERR335, ERR336, ERR337, ERR338,
       ERR339, ERR341, ERR343, ERR345, ERR351, ERR353, ERR355, ERR357, ERR361,
-      ERR363, ERR401, ERR402, ERR403, ERR405, ERR501, ERR502, ERR503, ERR504,
-      ERR505, ERR506, ERR507, ERR508, ERR509, ERR510, ERR511};
+      ERR363, ERR365, ERR367, ERR401, ERR402, ERR403, ERR405, ERR501, ERR502,
+      ERR503, ERR504, ERR505, ERR506, ERR507, ERR508, ERR509, ERR510, ERR511,
+      ERR512};
 
 int ErrorCodes[] =
     { 0,      101,    103,    105,    107,    108,    109,    110,    111,
@@ -213,10 +219,11 @@ int ErrorCodes[] =
       313,    315,    317,    318,    319,    320,    321,    323,    325,
       327,    329,    330,    331,    333,    335,    336,    337,    338,
       339,    341,    343,    345,    351,    353,    355,    357,    361,
-      363,    401,    402,    403,    405,    501,    502,    503,    504,
-      505,    506,    507,    508,    509,    510,    511};
+      363,    365,    367,    401,    402,    403,    405,    501,    502,
+      503,    504,    505,    506,    507,    508,    509,    510,    511,
+      512};
 
-char  ErrString[256];
+THREADLOCAL char  ErrString[256];
 
 char* error_getMsg(int i)
 {
@@ -154,24 +154,29 @@ enum  ErrorType {
       ERR_TABLE_FILE_OPEN,      //361  98
       ERR_TABLE_FILE_READ,      //363  99
 
+  //... Scenario File Errors
+      ERR_SCENARIO_FILE_OPEN,   //365  100
+      ERR_SCENARIO_FILE_DATA,   //367  101
+
   //... Runtime Errors
-      ERR_SYSTEM,               //401  100
-      ERR_NOT_CLOSED,           //402  101
-      ERR_NOT_OPEN,             //403  102
-      ERR_FILE_SIZE,            //405  103
+      ERR_SYSTEM,               //401  102
+      ERR_NOT_CLOSED,           //402  103
+      ERR_NOT_OPEN,             //403  104
+      ERR_FILE_SIZE,            //405  105
 
   //... API Errors
-      ERR_API_OUTBOUNDS,        //501  104
-      ERR_API_INPUTNOTOPEN,     //502  105
-      ERR_API_SIM_NRUNNING,     //503  106
-      ERR_API_WRONG_TYPE,       //504  107
-      ERR_API_OBJECT_INDEX,     //505  108
-      ERR_API_POLLUT_INDEX,     //506  109
-      ERR_API_INFLOWTYPE,       //507  110
-      ERR_API_TSERIES_INDEX,    //508  111
-      ERR_API_PATTERN_INDEX,    //509  112
-      ERR_API_LIDUNIT_INDEX,    //510  113
-      ERR_API_UNDEFINED_LID,    //511  114
+      ERR_API_OUTBOUNDS,        //501  106
+      ERR_API_INPUTNOTOPEN,     //502  107
+      ERR_API_SIM_NRUNNING,     //503  108
+      ERR_API_WRONG_TYPE,       //504  109
+      ERR_API_OBJECT_INDEX,     //505  110
+      ERR_API_POLLUT_INDEX,     //506  111
+      ERR_API_INFLOWTYPE,       //507  112
+      ERR_API_TSERIES_INDEX,    //508  113
+      ERR_API_PATTERN_INDEX,    //509  114
+      ERR_API_LIDUNIT_INDEX,    //510  115
+      ERR_API_UNDEFINED_LID,    //511  116
+      ERR_API_SNAPSHOT,         //512  117
       MAXERRMSG};
 
 char* error_getMsg(int i);
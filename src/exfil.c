@@ -20,6 +20,9 @@
 //   Build 5.1.011:
 //   - Fixed units conversion error for storage units with surface area curves.
 //
+//   Build 5.2.0:
+//   - Global conductivity adjustment passed to grnampt_getInfil().
+//
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -159,7 +162,7 @@ double exfil_getLoss(TExfil* exfil, double tStep, double depth, double area)
         exfilRate = exfil->btmExfil->Ks * Adjust.hydconFactor;
     }
     else exfilRate = grnampt_getInfil(exfil->btmExfil, tStep, 0.0, depth,
-                                      MOD_GREEN_AMPT);
+                                      MOD_GREEN_AMPT, Adjust.hydconFactor);
     exfilRate *= exfil->btmArea;
 
     // --- find infiltration through sloped banks
@@ -191,7 +194,8 @@ double exfil_getLoss(TExfil* exfil, double tStep, double depth, double area)
 
                 // --- use Green-Ampt function for bank infiltration
                 exfilRate += area * grnampt_getInfil(exfil->bankExfil,
-                                    tStep, 0.0, depth, MOD_GREEN_AMPT);
+                                    tStep, 0.0, depth, MOD_GREEN_AMPT,
+                                    Adjust.hydconFactor);
             }
         }
     }
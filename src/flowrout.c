@@ -25,12 +25,22 @@
 //   - Overflow computed in updateStorageState() must be non-negative.
 //   - Terminal storage nodes now updated corectly.
 //
+//   Build 5.2.0:
+//   - Kinematic Wave & Steady Flow routing of the links leaving nodes of
+//     the same topological level is split among threads, with each node's
+//     inflow added up in the same order as when routing one link at a
+//     time (see routeLevels).
+//   - flowrout_setThreadSchedule() moved here from dynwave.c.
+//
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
 #include "headers.h"
 #include <stdlib.h>
 #include <math.h>
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
 
 //-----------------------------------------------------------------------------
 //  Constants
@@ -38,6 +48,18 @@
 static const double OMEGA   = 0.55;    // under-relaxation parameter
 static const int    MAXITER = 10;      // max. iterations for storage updating
 static const double STOPTOL = 0.005;   // storage updating stopping tolerance
+static const int    DYNAMIC_CHUNK = 8; // loop chunk size for DYNAMIC schedule
+static const int    MINLEVELNODES = 8; // min. nodes per thread to split a level
+
+//-----------------------------------------------------------------------------
+//  Shared variables
+//-----------------------------------------------------------------------------
+#define NumLevels   (Prj->flowrout.NumLevels)   // number of levels of nodes
+#define LevelStart  (Prj->flowrout.LevelStart)  // start of each level's nodes
+#define LevelNodes  (Prj->flowrout.LevelNodes)  // nodes listed by level
+#define OutletPos   (Prj->flowrout.OutletPos)   // position of node's 1st outlink
+#define InletStart  (Prj->flowrout.InletStart)  // start of node's inlinks
+#define InletLinks  (Prj->flowrout.InletLinks)  // inlinks in topo-sorted order
 
 //-----------------------------------------------------------------------------
 //  External functions (declared in funcs.h)
@@ -46,6 +68,7 @@ static const double STOPTOL = 0.005;   // storage updating stopping tolerance
 //  flowrout_close           (called by routing_close)
 //  flowrout_getRoutingStep  (called routing_getRoutingStep)
 //  flowrout_execute         (called routing_execute)
+//  flowrout_setThreadSchedule (called by flowrout_execute & dynwave_execute)
 
 //-----------------------------------------------------------------------------
 //  Local functions
@@ -56,6 +79,10 @@ static void   initNodes(void);
 static void   initLinks(int routingModel);
 static void   validateTreeLayout(void);      
 static void   validateGeneralLayout(void);
+static int    createLevels(int links[]);
+static double routeLevels(int links[], int routingModel, double tStep);
+static double routeNodeLinks(int n, int links[], int routingModel,
+                             double tStep);
 static void   updateStorageState(int i, int j, int links[], double dt);
 static double getStorageOutflow(int node, int j, int links[], double dt);
 static double getLinkInflow(int link, double dt);
@@ -68,13 +95,21 @@ static int    steadyflow_execute(int link, double* qin, double* qout,
 
 //=============================================================================
 
-void flowrout_init(int routingModel)
+void flowrout_init(int links[], int routingModel)
 //
-//  Input:   routingModel = routing model code
+//  Input:   links = array of link indexes in topo-sorted order
+//           routingModel = routing model code
 //  Output:  none
 //  Purpose: initializes flow routing system.
 //
 {
+    NumLevels = 0;
+    LevelStart = NULL;
+    LevelNodes = NULL;
+    OutletPos = NULL;
+    InletStart = NULL;
+    InletLinks = NULL;
+
     // --- initialize for dynamic wave routing 
     if ( routingModel == DW )
     {
@@ -91,7 +126,16 @@ void flowrout_init(int routingModel)
     }
 
     // --- validate network layout for kinematic wave routing
-    else validateTreeLayout();
+    //     and group its nodes into levels for routing in parallel
+    else
+    {
+        validateTreeLayout();
+        if ( NumThreads > 1 && !ErrorCode && !createLevels(links) )
+        {
+            report_writeErrorMsg(ERR_MEMORY, "");
+            return;
+        }
+    }
 
     // --- initialize node & link volumes
     initNodes();
@@ -108,6 +152,11 @@ void  flowrout_close(int routingModel)
 //
 {
     if ( routingModel == DW ) dynwave_close();
+    FREE(LevelStart);
+    FREE(LevelNodes);
+    FREE(OutletPos);
+    FREE(InletStart);
+    FREE(InletLinks);
 }
 
 //=============================================================================
@@ -163,27 +212,35 @@ int flowrout_execute(int links[], int routingModel, double tStep)
         return dynwave_execute(tStep);
     }
 
+    // --- route links in parallel, level by level, if possible
+    if ( NumLevels > 0 ) steps = routeLevels(links, routingModel, tStep);
+
     // --- otherwise examine each link, moving from upstream to downstream
-    steps = 0.0;
-    for (i = 0; i < Nobjects[LINK]; i++)
+    else
     {
-        // --- see if upstream node is a storage unit whose state needs updating
-        j = links[i];
-        n1 = Link[j].node1;
-        if ( Node[n1].type == STORAGE ) updateStorageState(n1, i, links, tStep);
-
-        // --- retrieve inflow at upstream end of link
-        qin  = getLinkInflow(j, tStep);
-
-        // route flow through link
-        if ( routingModel == SF )
-            steps += steadyflow_execute(j, &qin, &qout, tStep);
-        else steps += kinwave_execute(j, &qin, &qout, tStep);
-        Link[j].newFlow = qout;
-
-        // adjust outflow at upstream node and inflow at downstream node
-        Node[ Link[j].node1 ].outflow += qin;
-        Node[ Link[j].node2 ].inflow += qout;
+        steps = 0.0;
+        for (i = 0; i < Nobjects[LINK]; i++)
+        {
+            // --- see if upstream node is a storage unit whose state
+            //     needs updating
+            j = links[i];
+            n1 = Link[j].node1;
+            if ( Node[n1].type == STORAGE )
+                updateStorageState(n1, i, links, tStep);
+
+            // --- retrieve inflow at upstream end of link
+            qin  = getLinkInflow(j, tStep);
+
+            // route flow through link
+            if ( routingModel == SF )
+                steps += steadyflow_execute(j, &qin, &qout, tStep);
+            else steps += kinwave_execute(j, &qin, &qout, tStep);
+            Link[j].newFlow = qout;
+
+            // adjust outflow at upstream node and inflow at downstream node
+            Node[ Link[j].node1 ].outflow += qin;
+            Node[ Link[j].node2 ].inflow += qout;
+        }
     }
     if ( Nobjects[LINK] > 0 ) steps /= Nobjects[LINK];
 
@@ -195,6 +252,162 @@ int flowrout_execute(int links[], int routingModel, double tStep)
 
 //=============================================================================
 
+void flowrout_setThreadSchedule()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: sets how the parallel loops over nodes & links are split among
+//           the calling thread's team of threads.
+//
+{
+#if defined(_OPENMP)
+    if ( ThreadSchedule == DYNAMIC )
+        omp_set_schedule(omp_sched_dynamic, DYNAMIC_CHUNK);
+    else if ( ThreadSchedule == GUIDED )
+        omp_set_schedule(omp_sched_guided, 0);
+    else omp_set_schedule(omp_sched_static, 0);
+#endif
+}
+
+//=============================================================================
+
+int createLevels(int links[])
+//
+//  Input:   links = array of link indexes in topo-sorted order
+//  Output:  returns FALSE if not enough memory
+//  Purpose: groups nodes into levels that can be routed in parallel and
+//           lists the links entering & leaving each node.
+//
+{
+    int i, j, k, n, nNodes = Nobjects[NODE], nLinks = Nobjects[LINK];
+
+    LevelStart = (int *) calloc(nNodes + 1, sizeof(int));
+    LevelNodes = (int *) calloc(nNodes + 1, sizeof(int));
+    OutletPos  = (int *) calloc(nNodes + 1, sizeof(int));
+    InletStart = (int *) calloc(nNodes + 1, sizeof(int));
+    InletLinks = (int *) calloc(nLinks + 1, sizeof(int));
+    if ( !LevelStart || !LevelNodes || !OutletPos || !InletStart ||
+         !InletLinks ) return FALSE;
+
+    // --- position of the first of each node's outgoing links
+    //     (topoSort lists all of a node's outgoing links together)
+    for (n = 0; n < nNodes; n++) OutletPos[n] = -1;
+    for (k = nLinks - 1; k >= 0; k--) OutletPos[Link[links[k]].node1] = k;
+
+    // --- list the links entering each node in topo-sorted order
+    for (k = 0; k < nLinks; k++) InletStart[Link[k].node2 + 1]++;
+    for (n = 0; n < nNodes; n++) InletStart[n+1] += InletStart[n];
+    for (k = 0; k < nLinks; k++)
+    {
+        j = links[k];
+        n = Link[j].node2;
+        i = InletStart[n]++;
+        InletLinks[i] = j;
+    }
+    for (n = nNodes; n > 0; n--) InletStart[n] = InletStart[n-1];
+    InletStart[0] = 0;
+
+    NumLevels = toposort_findLevels(links, LevelStart, LevelNodes);
+    return ( NumLevels >= 0 );
+}
+
+//=============================================================================
+
+double routeLevels(int links[], int routingModel, double tStep)
+//
+//  Input:   links = array of link indexes in topo-sorted order
+//           routingModel = type of routing method used
+//           tStep = routing time step (sec)
+//  Output:  returns total number of computational steps taken
+//  Purpose: routes flow through the links leaving the nodes of each level,
+//           splitting the nodes of a level among threads.
+//
+//  A node's outgoing links are routed by one thread once the flows of the
+//  links entering it have been added to its inflow. These are added in
+//  topo-sorted order, as when routing one link at a time, so results do
+//  not depend on the number of threads. Runs of levels with too few nodes
+//  to be worth splitting are routed by a single thread.
+{
+    double steps = 0.0;
+
+    flowrout_setThreadSchedule();
+#pragma omp parallel num_threads(NumThreads) copyin(Prj)
+{
+    int k, level = 0, last;
+    int minNodes = MINLEVELNODES * NumThreads;
+
+    while ( level < NumLevels )
+    {
+        // --- find the run of small levels starting at the current one
+        last = level;
+        while ( last < NumLevels &&
+                LevelStart[last+1] - LevelStart[last] < minNodes ) last++;
+
+        // --- route the nodes of a run of small levels in a single thread
+        if ( last > level )
+        {
+            #pragma omp single
+            {
+                for (k = LevelStart[level]; k < LevelStart[last]; k++)
+                    steps += routeNodeLinks(LevelNodes[k], links,
+                                            routingModel, tStep);
+            }
+            level = last;
+        }
+
+        // --- otherwise split a level's nodes among threads
+        else
+        {
+            #pragma omp for schedule(runtime) reduction(+:steps)
+            for (k = LevelStart[level]; k < LevelStart[level+1]; k++)
+                steps += routeNodeLinks(LevelNodes[k], links,
+                                        routingModel, tStep);
+            level++;
+        }
+    }
+}
+    return steps;
+}
+
+//=============================================================================
+
+double routeNodeLinks(int n, int links[], int routingModel, double tStep)
+//
+//  Input:   n = node index
+//           links = array of link indexes in topo-sorted order
+//           routingModel = type of routing method used
+//           tStep = routing time step (sec)
+//  Output:  returns number of computational steps taken
+//  Purpose: adds the outflows of the links entering a node to its inflow
+//           and routes flow through the links leaving it.
+//
+{
+    int    i, j, k;
+    double qin;                        // link inflow (cfs)
+    double qout;                       // link outflow (cfs)
+    double steps = 0.0;                // computational step count
+
+    for (k = InletStart[n]; k < InletStart[n+1]; k++)
+        Node[n].inflow += Link[InletLinks[k]].newFlow;
+
+    i = OutletPos[n];
+    if ( i < 0 ) return 0.0;
+    if ( Node[n].type == STORAGE ) updateStorageState(n, i, links, tStep);
+    for ( ; i < Nobjects[LINK] && Link[links[i]].node1 == n; i++)
+    {
+        j = links[i];
+        qin = getLinkInflow(j, tStep);
+        if ( routingModel == SF )
+            steps += steadyflow_execute(j, &qin, &qout, tStep);
+        else steps += kinwave_execute(j, &qin, &qout, tStep);
+        Link[j].newFlow = qout;
+        Node[n].outflow += qin;
+    }
+    return steps;
+}
+
+//=============================================================================
+
 void validateTreeLayout()
 //
 //  Input:   none
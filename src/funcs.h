@@ -27,8 +27,23 @@
 //   Build 5.1.013:
 //   - Additional arguments added to function stats_updateSubcatchStats.
 //
+//   Build 5.2.0:
+//   - project_createScenario() and memdup() added.
+//   - snapshot_addBlock(), snapshot_addFile() and a _snapshot() function
+//     for each module that owns simulation state added.
+//   - project_getObjectIndex(), project_getInputPos(), input_readLinkNodes()
+//     and toposort_orderNetwork() added.
+//   - toposort_findLevels() and flowrout_setThreadSchedule() added and
+//     sorted links passed to flowrout_init().
+//   - Runoff context added to the arguments of subcatch_getRunoff(),
+//     gwater_getGroundwater() and surfqual_getWashoff().
+//   - subcatch_initRunoff() and subcatch_getInfilBatch() added.
+//
 //-----------------------------------------------------------------------------
 
+struct TProject;                       // project context defined in globals.h
+struct TSnapshot;                      // simulation snapshot defined in snapshot.c
+
 void     project_open(char *f1, char *f2, char *f3);
 void     project_close(void);
 
@@ -36,11 +51,15 @@ void     project_readInput(void);
 int      project_readOption(char* s1, char* s2);
 void     project_validate(void);
 int      project_init(void);
+int      project_createScenario(struct TProject* base, char *f2, char *f3);
+void     project_snapshot(struct TSnapshot* snap);
 
 int      project_addObject(int type, char* id, int n);
 
 int      project_findObject(int type, char* id);
 char*    project_findID(int type, char* id);
+int      project_getObjectIndex(int type, int i);
+int      project_getInputPos(int type, int j);
 
 double** project_createMatrix(int nrows, int ncols);
 void     project_freeMatrix(double** m);
@@ -50,6 +69,7 @@ void     project_freeMatrix(double** m);
 //-----------------------------------------------------------------------------
 int     input_countObjects(void);
 int     input_readData(void);
+void    input_readLinkNodes(int node1[], int node2[]);
 
 //-----------------------------------------------------------------------------
 //   Report Writer Methods
@@ -76,9 +96,9 @@ void    report_writeGwaterError(TGwaterTotals* totals, double area);
 void    report_writeFlowError(TRoutingTotals* totals);
 void    report_writeQualError(TRoutingTotals* totals);
 
-void    report_writeMaxStats(TMaxStats massBalErrs[], TMaxStats CourantCrit[],
+void    report_writeMaxStats(TMaxStats* massBalErrs, TMaxStats* CourantCrit,
         int nMaxStats);
-void    report_writeMaxFlowTurns(TMaxStats flowTurns[], int nMaxStats);
+void    report_writeMaxFlowTurns(TMaxStats* flowTurns, int nMaxStats);
 void    report_writeSysStats(TSysStats* sysStats);
 
 void    report_writeErrorMsg(int code, char* msg);
@@ -133,6 +153,7 @@ double  snow_getSnowCover(int subcatch);
 int     runoff_open(void);
 void    runoff_execute(void);
 void    runoff_close(void);
+void    runoff_snapshot(struct TSnapshot* snap);
 
 //-----------------------------------------------------------------------------
 //   Conveyance System Routing Methods
@@ -151,6 +172,7 @@ void    output_close(void);
 void    output_checkFileSize(void);
 void    output_saveResults(double reportTime);
 void    output_updateAvgResults(void);
+void    output_snapshot(struct TSnapshot* snap);
 void    output_readDateTime(int period, DateTime *aDate);
 void    output_readSubcatchResults(int period, int area);
 void    output_readNodeResults(int period, int node);
@@ -172,7 +194,7 @@ void    gwater_getState(int subcatch, double x[]);
 void    gwater_setState(int subcatch, double x[]);
 
 void    gwater_getGroundwater(int subcatch, double evap, double infil,
-        double tStep);
+        double tStep, TRunoffContext* ctx);
 double  gwater_getVolume(int subcatch);
 
 //-----------------------------------------------------------------------------
@@ -186,6 +208,7 @@ void    rdii_openRdii(void);
 void    rdii_closeRdii(void);
 int     rdii_getNumRdiiFlows(DateTime aDate);
 void    rdii_getRdiiFlow(int index, int* node, double* q);
+void    rdii_snapshot(struct TSnapshot* snap);
 
 //-----------------------------------------------------------------------------
 //   Landuse Methods
@@ -208,12 +231,18 @@ double  landuse_getCoPollutLoad(int p, double washoff[]);
 //-----------------------------------------------------------------------------
 //   Flow/Quality Routing Methods
 //-----------------------------------------------------------------------------
-void    flowrout_init(int routingModel);
+void    flowrout_init(int links[], int routingModel);
 void    flowrout_close(int routingModel);
 double  flowrout_getRoutingStep(int routingModel, double fixedStep);
 int     flowrout_execute(int links[], int routingModel, double tStep);
+void    flowrout_setThreadSchedule(void);
 
 void    toposort_sortLinks(int links[]);
+int     toposort_partitionNetwork(int nodeOrder[], int linkOrder[]);
+int     toposort_orderNetwork(int nNodes, int nLinks, int node1[],
+                              int node2[], int nodeOrder[], int linkOrder[]);
+int     toposort_findLevels(int sortedLinks[], int levelStart[],
+                            int levelNodes[]);
 int     kinwave_execute(int link, double* qin, double* qout, double tStep);
 
 void    dynwave_validate(void);
@@ -221,7 +250,11 @@ void    dynwave_init(void);
 void    dynwave_close(void);
 double  dynwave_getRoutingStep(double fixedStep);
 int     dynwave_execute(double tStep);
-void    dwflow_findConduitFlow(int j, int steps, double omega, double dt);
+void    dynwave_snapshot(struct TSnapshot* snap);
+void    dynwave_wakeNode(int node);
+void    dynwave_wakeLink(int link);
+void    dwflow_findConduitFlows(int links[], int n, int steps, double omega,
+        double dt);
 
 void    qualrout_init(void);
 void    qualrout_execute(double tStep);
@@ -242,6 +275,7 @@ void    treatmnt_setInflow(double qIn, double wIn[]);
 int     massbal_open(void);
 void    massbal_close(void);
 void    massbal_report(void);
+void    massbal_snapshot(struct TSnapshot* snap);
 
 void    massbal_updateRunoffTotals(int type, double v);
 void    massbal_updateLoadingTotals(int type, int pollut, double w);
@@ -269,6 +303,7 @@ double  massbal_getFlowError(void);
 int     stats_open(void);
 void    stats_close(void);
 void    stats_report(void);
+void    stats_snapshot(struct TSnapshot* snap);
 
 void    stats_updateCriticalTimeCount(int node, int link);
 void    stats_updateFlowStats(double tStep, DateTime aDate, int stepCount,
@@ -312,7 +347,10 @@ double  subcatch_getBuildup(int subcatch, int pollut);
 
 void    subcatch_getRunon(int subcatch);
 void    subcatch_addRunonFlow(int subcatch, double flow);
-double  subcatch_getRunoff(int subcatch, double tStep);
+void    subcatch_initRunoff(int subcatch, double tStep, TRunoffContext* ctx);
+void    subcatch_getInfilBatch(int first, int last, double tStep,
+        TRunoffContext ctx[]);
+double  subcatch_getRunoff(int subcatch, double tStep, TRunoffContext* ctx);
 
 double  subcatch_getWtdOutflow(int subcatch, double wt);
 void    subcatch_getResults(int subcatch, double wt, float x[]);
@@ -321,7 +359,8 @@ void    subcatch_getResults(int subcatch, double wt, float x[]);
 //  Surface Pollutant Buildup/Washoff Methods
 //-----------------------------------------------------------------------------
 void    surfqual_initState(int subcatch);
-void    surfqual_getWashoff(int subcatch, double runoff, double tStep);
+void    surfqual_getWashoff(int subcatch, double runoff, double tStep,
+        TRunoffContext* ctx);
 void    surfqual_getBuildup(int subcatch, double tStep);
 void    surfqual_sweepBuildup(int subcatch, DateTime aDate);
 double  surfqual_getWtdWashoff(int subcatch, int pollut, double wt);
@@ -370,6 +409,7 @@ double  inflow_getExtInflow(TExtInflow* inflow, DateTime aDate);
 double  inflow_getDwfInflow(TDwfInflow* inflow, int m, int d, int h);
 double  inflow_getPatternFactor(int p, int month, int day, int hour);
 
+int     inflow_copyExtInflows(int node);
 void    inflow_deleteExtInflows(int node);
 void    inflow_deleteDwfInflows(int node);
 
@@ -384,6 +424,7 @@ int     iface_getIfaceNode(int index);
 double  iface_getIfaceFlow(int index);
 double  iface_getIfaceQual(int index, int pollut);
 void    iface_saveOutletResults(DateTime reportDate, FILE* file);
+void    iface_snapshot(struct TSnapshot* snap);
 
 //-----------------------------------------------------------------------------
 //   Hot Start File Methods
@@ -400,6 +441,8 @@ int     link_readLossParams(char* tok[], int ntoks);
 
 void    link_validate(int link);
 void    link_initState(int link);
+int     link_createLists(void);
+void    link_deleteLists(void);
 void    link_setOldHydState(int link);
 void    link_setOldQualState(int link);
 
@@ -433,11 +476,19 @@ double  xsect_getSofA(TXsect* xsect, double area);
 double  xsect_getYofA(TXsect* xsect, double area);
 double  xsect_getRofA(TXsect* xsect, double area);
 double  xsect_getAofS(TXsect* xsect, double sFactor);
+double  xsect_getAofSNear(TXsect* xsect, double sFactor, double a0,
+                          long* evals);
 double  xsect_getdSdA(TXsect* xsect, double area);
 double  xsect_getAofY(TXsect* xsect, double y);
 double  xsect_getRofY(TXsect* xsect, double y);
 double  xsect_getWofY(TXsect* xsect, double y);
 double  xsect_getYcrit(TXsect* xsect, double q);
+double  xsect_getYcritNear(TXsect* xsect, double q, TDepthCache* cache);
+void    xsect_getAofYBatch(TXsect* xsect[], double y[], double a[], int n);
+void    xsect_getRofYBatch(TXsect* xsect[], double y[], double r[], int n);
+int     xsect_createDenseTables(void);
+void    xsect_deleteDenseTables(void);
+double  xsect_getDenseTableSize(int* nTables, int* nSections);
 
 //-----------------------------------------------------------------------------
 //   Culvert/Roadway Methods
@@ -471,6 +522,9 @@ int     shape_validate(TShape *shape, TTable *curve);
 //-----------------------------------------------------------------------------
 int     controls_create(int n);
 void    controls_delete(void);
+int     controls_clone(void);
+void    controls_deleteClone(void);
+void    controls_snapshot(struct TSnapshot* snap);
 int     controls_addRuleClause(int rule, int keyword, char* Tok[], int nTokens);
 int     controls_evaluate(DateTime currentTime, DateTime elapsedTime, 
         double tStep);
@@ -502,6 +556,12 @@ double  table_getInverseArea(TTable* table, double a);
 void    table_tseriesInit(TTable *table);
 double  table_tseriesLookup(TTable* table, double t, char extend);
 
+//-----------------------------------------------------------------------------
+//   Simulation Snapshot Methods
+//-----------------------------------------------------------------------------
+void    snapshot_addBlock(struct TSnapshot* snap, void* data, size_t size);
+void    snapshot_addFile(struct TSnapshot* snap, FILE* file);
+
 //-----------------------------------------------------------------------------
 //   Utility Methods
 //-----------------------------------------------------------------------------
@@ -515,6 +575,7 @@ int      match(char *str, char *substr);      // true if substr matches part of
 int      strcomp(char *s1, char *s2);         // case insensitive string compare
 char*    sstrncpy(char *dest, const char *src,
          size_t maxlen);                      // safe string copy
+void*    memdup(const void *src, size_t size);// copy of a memory block
 void     writecon(char *s);                   // writes string to console
 DateTime getDateTime(double elapsedMsec);     // convert elapsed time to date
 void     getElapsedTime(DateTime aDate,       // convert elapsed date
@@ -35,134 +35,627 @@
 //
 //   Build 5.1.013:
 //   - CrownCutoff and RuleStep added as analysis option variables.
+//
+//   Build 5.2.0:
+//   - Global variables, together with the state shared within individual
+//     code modules, now belong to a TProject structure so that several
+//     projects can be analyzed at the same time. Prj points to the project
+//     being analyzed by the calling thread and each global variable name
+//     is a macro that refers to its member in that project.
+//   - SolverMethod, AndersonDepth, ThreadSchedule, DenseTableSize,
+//     CircGeometry and NetworkOrder added as analysis option variables.
+//   - The dense link arrays used in each dynamic wave iteration can be
+//     stored in single precision (SWMM_SINGLE_PRECISION_STATE build flag).
+//   - Predictor added as an analysis option variable, with counts of the
+//     time steps it predicted and of those done in a single trial.
+//   - Levels of nodes used for parallel Kinematic Wave & Steady Flow
+//     routing added to the flowrout.c state.
+//   - Subcatchment runoff contexts used for parallel runoff added to the
+//     runoff.c state and the shared infiltration adjustment factor removed.
+//   - ODE solver work arrays for each thread added to the runoff.c state.
+//   - RunoffSolver added as an analysis option variable.
+//   - DepthWarmStart added as an analysis option variable.
+//   - ActiveSet added as an analysis option variable.
+//   - Newton-Krylov solver work arrays added to the dynwave.c state.
+//   - Subcatchment infiltration variables of the infil.c state held in
+//     arrays with one entry per subcatchment.
 //-----------------------------------------------------------------------------
 
-EXTERN TFile
-                  Finp,                     // Input file
-                  Fout,                     // Output file
-                  Frpt,                     // Report file
-                  Fclimate,                 // Climate file
-                  Frain,                    // Rainfall file
-                  Frunoff,                  // Runoff file
-                  Frdii,                    // RDII inflow file
-                  Fhotstart1,               // Hot start input file
-                  Fhotstart2,               // Hot start output file
-                  Finflows,                 // Inflows routing file
-                  Foutflows;                // Outflows routing file
-
-EXTERN long
-                  Nperiods,                 // Number of reporting periods
-                  StepCount,                // Number of routing steps used
-                  NonConvergeCount;         // Number of non-converging steps
-
-EXTERN char
-                  Msg[MAXMSG+1],            // Text of output message
-                  ErrorMsg[MAXMSG+1],       // Text of error message
-                  Title[MAXTITLE][MAXMSG+1],// Project title
-                  TempDir[MAXFNAME+1];      // Temporary file directory
-
-EXTERN TRptFlags
-                  RptFlags;                 // Reporting options
-
-EXTERN int
-                  Nobjects[MAX_OBJ_TYPES],  // Number of each object type
-                  Nnodes[MAX_NODE_TYPES],   // Number of each node sub-type
-                  Nlinks[MAX_LINK_TYPES],   // Number of each link sub-type
-                  UnitSystem,               // Unit system
-                  FlowUnits,                // Flow units
-                  InfilModel,               // Infiltration method
-                  RouteModel,               // Flow routing method
-                  ForceMainEqn,             // Flow equation for force mains
-                  LinkOffsets,              // Link offset convention
-                  SurchargeMethod,          // EXTRAN or SLOT method           //(5.1.013)
-                  AllowPonding,             // Allow water to pond at nodes
-                  InertDamping,             // Degree of inertial damping
-                  NormalFlowLtd,            // Normal flow limited
-                  SlopeWeighting,           // Use slope weighting
-                  Compatibility,            // SWMM 5/3/4 compatibility
-                  SkipSteadyState,          // Skip over steady state periods
-                  IgnoreRainfall,           // Ignore rainfall/runoff
-                  IgnoreRDII,               // Ignore RDII
-                  IgnoreSnowmelt,           // Ignore snowmelt
-                  IgnoreGwater,             // Ignore groundwater
-                  IgnoreRouting,            // Ignore flow routing
-                  IgnoreQuality,            // Ignore water quality
-                  ErrorCode,                // Error code number
-                  Warnings,                 // Number of warning messages
-                  WetStep,                  // Runoff wet time step (sec)
-                  DryStep,                  // Runoff dry time step (sec)
-                  ReportStep,               // Reporting time step (sec)
-                  RuleStep,                 // Rule evaluation time step (sec) //(5.1.013)
-                  SweepStart,               // Day of year when sweeping starts
-                  SweepEnd,                 // Day of year when sweeping ends
-                  MaxTrials,                // Max. trials for DW routing
-                  NumThreads,               // Number of parallel threads used
-                  NumEvents;                // Number of detailed events
-                //InSteadyState;            // System flows remain constant
-
-EXTERN double
-                  RouteStep,                // Routing time step (sec)
-                  MinRouteStep,             // Minimum variable time step (sec)
-                  LengtheningStep,          // Time step for lengthening (sec)
-                  StartDryDays,             // Antecedent dry days
-                  CourantFactor,            // Courant time step factor
-                  MinSurfArea,              // Minimum nodal surface area
-                  MinSlope,                 // Minimum conduit slope
-                  RunoffError,              // Runoff continuity error
-                  GwaterError,              // Groundwater continuity error
-                  FlowError,                // Flow routing error
-                  QualError,                // Quality routing error
-                  HeadTol,                  // DW routing head tolerance (ft)
-                  SysFlowTol,               // Tolerance for steady system flow
-                  LatFlowTol,               // Tolerance for steady nodal inflow
-                  CrownCutoff;              // Fractional pipe crown cutoff    //(5.1.013)
-
-EXTERN DateTime
-                  StartDate,                // Starting date
-                  StartTime,                // Starting time
-                  StartDateTime,            // Starting Date+Time
-                  EndDate,                  // Ending date
-                  EndTime,                  // Ending time
-                  EndDateTime,              // Ending Date+Time
-                  ReportStartDate,          // Report start date
-                  ReportStartTime,          // Report start time
-                  ReportStart;              // Report start Date+Time
-
-EXTERN double
-                  ReportTime,               // Current reporting time (msec)
-                  OldRunoffTime,            // Previous runoff time (msec)
-                  NewRunoffTime,            // Current runoff time (msec)
-                  OldRoutingTime,           // Previous routing time (msec)
-                  NewRoutingTime,           // Current routing time (msec)
-                  TotalDuration,            // Simulation duration (msec)
-                  ElapsedTime;              // Current elapsed time (days)
-
-EXTERN TTemp      Temp;                     // Temperature data
-EXTERN TEvap      Evap;                     // Evaporation data
-EXTERN TWind      Wind;                     // Wind speed data
-EXTERN TSnow      Snow;                     // Snow melt data
-EXTERN TAdjust    Adjust;                   // Climate adjustments
-
-EXTERN TSnowmelt* Snowmelt;                 // Array of snow melt objects
-EXTERN TGage*     Gage;                     // Array of rain gages
-EXTERN TSubcatch* Subcatch;                 // Array of subcatchments
-EXTERN TAquifer*  Aquifer;                  // Array of groundwater aquifers
-EXTERN TUnitHyd*  UnitHyd;                  // Array of unit hydrographs
-EXTERN TNode*     Node;                     // Array of nodes
-EXTERN TOutfall*  Outfall;                  // Array of outfall nodes
-EXTERN TDivider*  Divider;                  // Array of divider nodes
-EXTERN TStorage*  Storage;                  // Array of storage nodes
-EXTERN TLink*     Link;                     // Array of links
-EXTERN TConduit*  Conduit;                  // Array of conduit links
-EXTERN TPump*     Pump;                     // Array of pump links
-EXTERN TOrifice*  Orifice;                  // Array of orifice links
-EXTERN TWeir*     Weir;                     // Array of weir links
-EXTERN TOutlet*   Outlet;                   // Array of outlet device links
-EXTERN TPollut*   Pollut;                   // Array of pollutants
-EXTERN TLanduse*  Landuse;                  // Array of landuses
-EXTERN TPattern*  Pattern;                  // Array of time patterns
-EXTERN TTable*    Curve;                    // Array of curve tables
-EXTERN TTable*    Tseries;                  // Array of time series tables
-EXTERN TTransect* Transect;                 // Array of transect data
-EXTERN TShape*    Shape;                    // Array of custom conduit shapes
-EXTERN TEvent*    Event;                    // Array of routing events
+// Type of the dense link arrays used in each dynamic wave iteration
+// (node values, accumulated totals & the Node/Link objects stay double)
+// and its relative rounding error (from <float.h>)
+#ifdef SWMM_SINGLE_PRECISION_STATE
+typedef float  HotReal;
+#define HOTREAL_EPSILON FLT_EPSILON
+#else
+typedef double HotReal;
+#define HOTREAL_EPSILON DBL_EPSILON
+#endif
+
+typedef struct TProject
+{
+    TFile
+                      Finp,                     // Input file
+                      Fout,                     // Output file
+                      Frpt,                     // Report file
+                      Fclimate,                 // Climate file
+                      Frain,                    // Rainfall file
+                      Frunoff,                  // Runoff file
+                      Frdii,                    // RDII inflow file
+                      Fhotstart1,               // Hot start input file
+                      Fhotstart2,               // Hot start output file
+                      Finflows,                 // Inflows routing file
+                      Foutflows;                // Outflows routing file
+
+    long
+                      Nperiods,                 // Number of reporting periods
+                      StepCount,                // Number of routing steps used
+                      NonConvergeCount,         // Number of non-converging steps
+                      PredictCount,             // Number of predicted steps
+                      PredictHitCount;          // Predicted steps done in 1 trial
+
+    char
+                      Msg[MAXMSG+1],            // Text of output message
+                      ErrorMsg[MAXMSG+1],       // Text of error message
+                      Title[MAXTITLE][MAXMSG+1],// Project title
+                      TempDir[MAXFNAME+1];      // Temporary file directory
+
+    TRptFlags
+                      RptFlags;                 // Reporting options
+
+    int
+                      Nobjects[MAX_OBJ_TYPES],  // Number of each object type
+                      Nnodes[MAX_NODE_TYPES],   // Number of each node sub-type
+                      Nlinks[MAX_LINK_TYPES],   // Number of each link sub-type
+                      UnitSystem,               // Unit system
+                      FlowUnits,                // Flow units
+                      InfilModel,               // Infiltration method
+                      RouteModel,               // Flow routing method
+                      ForceMainEqn,             // Flow equation for force mains
+                      LinkOffsets,              // Link offset convention
+                      SurchargeMethod,          // EXTRAN or SLOT method           //(5.1.013)
+                      SolverMethod,             // PICARD or NEWTON dyn. wave solver
+                      ThreadSchedule,           // Schedule of parallel routing loops
+                      CircGeometry,             // Circular xsect geometry method
+                      NetworkOrder,             // Ordering of node & link indexes
+                      Predictor,                // Initial guess of dyn. wave iterations
+                      RunoffSolver,             // ODE solver for subarea ponded depth
+                      DepthWarmStart,           // Start depth solves from last root
+                      ActiveSet,                // Route only active nodes & links
+                      AllowPonding,             // Allow water to pond at nodes
+                      InertDamping,             // Degree of inertial damping
+                      NormalFlowLtd,            // Normal flow limited
+                      SlopeWeighting,           // Use slope weighting
+                      Compatibility,            // SWMM 5/3/4 compatibility
+                      SkipSteadyState,          // Skip over steady state periods
+                      IgnoreRainfall,           // Ignore rainfall/runoff
+                      IgnoreRDII,               // Ignore RDII
+                      IgnoreSnowmelt,           // Ignore snowmelt
+                      IgnoreGwater,             // Ignore groundwater
+                      IgnoreRouting,            // Ignore flow routing
+                      IgnoreQuality,            // Ignore water quality
+                      ErrorCode,                // Error code number
+                      Warnings,                 // Number of warning messages
+                      WetStep,                  // Runoff wet time step (sec)
+                      DryStep,                  // Runoff dry time step (sec)
+                      ReportStep,               // Reporting time step (sec)
+                      RuleStep,                 // Rule evaluation time step (sec) //(5.1.013)
+                      SweepStart,               // Day of year when sweeping starts
+                      SweepEnd,                 // Day of year when sweeping ends
+                      MaxTrials,                // Max. trials for DW routing
+                      AndersonDepth,            // History depth of Anderson accel.
+                      DenseTableSize,           // Size of dense geometry tables
+                      NumThreads,               // Number of parallel threads used
+                      NumEvents;                // Number of detailed events
+                    //InSteadyState;            // System flows remain constant
+
+    double
+                      RouteStep,                // Routing time step (sec)
+                      MinRouteStep,             // Minimum variable time step (sec)
+                      LengtheningStep,          // Time step for lengthening (sec)
+                      StartDryDays,             // Antecedent dry days
+                      CourantFactor,            // Courant time step factor
+                      MinSurfArea,              // Minimum nodal surface area
+                      MinSlope,                 // Minimum conduit slope
+                      RunoffError,              // Runoff continuity error
+                      GwaterError,              // Groundwater continuity error
+                      FlowError,                // Flow routing error
+                      QualError,                // Quality routing error
+                      HeadTol,                  // DW routing head tolerance (ft)
+                      SysFlowTol,               // Tolerance for steady system flow
+                      LatFlowTol,               // Tolerance for steady nodal inflow
+                      CrownCutoff;              // Fractional pipe crown cutoff    //(5.1.013)
+
+    DateTime
+                      StartDate,                // Starting date
+                      StartTime,                // Starting time
+                      StartDateTime,            // Starting Date+Time
+                      EndDate,                  // Ending date
+                      EndTime,                  // Ending time
+                      EndDateTime,              // Ending Date+Time
+                      ReportStartDate,          // Report start date
+                      ReportStartTime,          // Report start time
+                      ReportStart;              // Report start Date+Time
+
+    double
+                      ReportTime,               // Current reporting time (msec)
+                      OldRunoffTime,            // Previous runoff time (msec)
+                      NewRunoffTime,            // Current runoff time (msec)
+                      OldRoutingTime,           // Previous routing time (msec)
+                      NewRoutingTime,           // Current routing time (msec)
+                      TotalDuration,            // Simulation duration (msec)
+                      ElapsedTime;              // Current elapsed time (days)
+
+    TTemp      Temp;                     // Temperature data
+    TEvap      Evap;                     // Evaporation data
+    TWind      Wind;                     // Wind speed data
+    TSnow      Snow;                     // Snow melt data
+    TAdjust    Adjust;                   // Climate adjustments
+
+    TSnowmelt* Snowmelt;                 // Array of snow melt objects
+    TGage*     Gage;                     // Array of rain gages
+    TSubcatch* Subcatch;                 // Array of subcatchments
+    TAquifer*  Aquifer;                  // Array of groundwater aquifers
+    TUnitHyd*  UnitHyd;                  // Array of unit hydrographs
+    TNode*     Node;                     // Array of nodes
+    TOutfall*  Outfall;                  // Array of outfall nodes
+    TDivider*  Divider;                  // Array of divider nodes
+    TStorage*  Storage;                  // Array of storage nodes
+    TLink*     Link;                     // Array of links
+    TConduit*  Conduit;                  // Array of conduit links
+    TPump*     Pump;                     // Array of pump links
+    TOrifice*  Orifice;                  // Array of orifice links
+    TWeir*     Weir;                     // Array of weir links
+    TOutlet*   Outlet;                   // Array of outlet device links
+    TPollut*   Pollut;                   // Array of pollutants
+    TLanduse*  Landuse;                  // Array of landuses
+    TPattern*  Pattern;                  // Array of time patterns
+    TTable*    Curve;                    // Array of curve tables
+    TTable*    Tseries;                  // Array of time series tables
+    TTransect* Transect;                 // Array of transect data
+    TShape*    Shape;                    // Array of custom conduit shapes
+    TEvent*    Event;                    // Array of routing events
+    int*       LinkListStart;            // start of each list in LinkLists
+    int*       LinkLists;                // links listed by kind (see link.c)
+
+    //-------------------------------------------------------------------------
+    //  Variables shared within individual code modules
+    //-------------------------------------------------------------------------
+    struct                                  // swmm5.c
+    {
+        int   IsOpenFlag;                   // TRUE if a project has been opened
+        int   IsStartedFlag;                // TRUE if a simulation has been started
+        int   SaveResultsFlag;              // TRUE if output to be saved to binary file
+        int   ExceptionCount;               // number of exceptions handled
+        int   DoRunoff;                     // TRUE if runoff is computed
+        int   DoRouting;                    // TRUE if flow routing is computed
+        int   RunCount;                     // number of simulations started
+    }     swmm5;
+
+    struct                                  // climate.c
+    {
+        double    Tmin;                     // min. daily temperature (deg F)
+        double    Tmax;                     // max. daily temperature (deg F)
+        double    Trng;                     // 1/2 range of daily temperatures
+        double    Trng1;                    // prev. max - current min. temp.
+        double    Tave;                     // average daily temperature (deg F)
+        double    Hrsr;                     // time of min. temp. (hrs)
+        double    Hrss;                     // time of max. temp (hrs)
+        double    Hrday;                    // avg. of min/max temp times
+        double    Dhrdy;                    // hrs. between min. & max. temp. times
+        double    Dydif;                    // hrs. between max. & min. temp. times
+        DateTime  LastDay;                  // date of last day with temp. data
+        TMovAve   Tma;                      // moving average of daily temperatures
+        DateTime  NextEvapDate;             // next date when evap. rate changes
+        double    NextEvapRate;             // next evaporation rate (user units)
+        int       FileFormat;               // file format (see ClimateFileFormats)
+        int       FileYear;                 // current year of file data
+        int       FileMonth;                // current month of year of file data
+        int       FileDay;                  // current day of month of file data
+        int       FileLastDay;              // last day of current month of file data
+        int       FileElapsedDays;          // number of days read from file
+        double    FileValue[4];             // current day's values of climate data
+        double    FileData[4][32];          // month's worth of daily climate data
+        char      FileLine[MAXLINE+1];      // line from climate data file
+        int       FileFieldPos[4];          // start of data fields for file record
+        int       FileDateFieldPos;         // start of date field for file record
+        int       FileWindType;             // wind speed type
+    }     climate;
+
+    struct                                  // controls.c
+    {
+        struct TRule*       Rules;          // array of control rules
+        struct TActionList* ActionList;     // linked list of control actions
+        int       InputState;               // state of rule interpreter
+        int       RuleCount;                // total number of rules
+        double    ControlValue;             // value of controller variable
+        double    SetPoint;                 // value of controller setpoint
+        DateTime  CurrentDate;              // current date in whole days
+        DateTime  CurrentTime;              // current time of day (decimal)
+    }     controls;
+
+    struct                                  // dynwave.c
+    {
+        double    VariableStep;             // size of variable time step (sec)
+        struct TXnode* Xnode;               // extended nodal information
+        int*      AdjStart;                 // start of each node's entries in AdjConduits
+        int*      AdjConduits;              // conduit ends (2*link + end) at each node
+        int       HasCritSteps;             // TRUE if critical steps below are current
+        double    LinkCritStep;             // smallest conduit Courant time step (sec)
+        int       LinkCritIndex;            // index of link with LinkCritStep
+        double    NodeCritStep;             // smallest node depth change time step (sec)
+        int       NodeCritIndex;            // index of node with NodeCritStep
+        struct                              // densely packed copies of the node
+        {                                   // & link variables used in each
+                                            // iteration (see dynwave.c)
+            double* block;                  // memory holding the node arrays
+            double* nodeDepth;              // node water depth (ft)
+            double* nodeInvert;             // node invert elevation (ft)
+            double* nodeInflow;             // node total inflow (cfs)
+            double* nodeOutflow;            // node total outflow (cfs)
+            HotReal* linkBlock;             // memory holding the link arrays
+            HotReal* linkFlow;              // link flow (cfs)
+            HotReal* linkDqdh;              // link dqdh (ft2/sec)
+            HotReal* linkSurfArea1;         // upstream surface area per barrel (ft2)
+            HotReal* linkSurfArea2;         // downstream surface area per barrel (ft2)
+            HotReal* linkBarrels;           // number of barrels
+            HotReal* linkLossRate;          // evap. + seepage loss rate per barrel (cfs)
+            int*    linkNodes;              // end nodes (2*link + end)
+        }         Hot;
+        double    Omega;                    // actual under-relaxation parameter
+        int       Steps;                    // number of Picard iterations
+        int       NodesConverged;           // TRUE if last iteration's node
+                                            // depths converged
+        double*   NewtonVars;               // Newton solver variables, scales
+                                            // & starting values
+        struct TNkSolver* NewtonSolver;     // Newton-Krylov solver work arrays
+        double*   AndersonVars;             // node depth & residual histories
+                                            // for Anderson acceleration
+        int       AndersonCount;            // number of residual differences
+        int       AndersonNext;             // next position in histories
+        double    AndersonNorm;             // largest residual of last iteration
+        struct                              // nodes & links whose state can
+        {                                   // change in a time step
+                                            // (see dynwave.c)
+            int     hasSolution;            // TRUE if last step was solved
+            double  time;                   // start of next step in sequence
+                                            // with last step's set (msec)
+            double  evapRate;               // evaporation rate of last step
+            int     nNodes;                 // number of active nodes
+            int     nLinks;                 // number of active links
+            int     nFrontier;              // number of frontier nodes
+            int     nConduits;              // number of true conduits
+            int     nOtherLinks;            // number of non-conduit links
+            int     nSteadyNodes;           // number of steady nodes
+            int     nSteadyLinks;           // number of steady links
+            int     nWoken;                 // number of woken nodes & links
+            int*    nodes;                  // indexes of active nodes
+            int*    links;                  // indexes of active true conduits
+            int*    frontier;               // active nodes with unrouted links
+            int*    conduits;               // true conduits in partition order
+            int*    otherLinks;             // links other than true conduits
+                                            // (2*link + regulator flag)
+            int*    steadyNodes;            // inactive nodes with flow
+            int*    steadyLinks;            // inactive conduits with a
+                                            // Courant time step, in a heap
+                                            // ordered by linkStep
+            int*    steadyPos;              // position of node (index) or
+                                            // link (node count + index) in
+                                            // its steady list (or -1)
+            int*    woken;                  // nodes & links woken since the
+                                            // last time step (as in
+                                            // steadyPos)
+            double* linkStep;               // Courant time step of each
+                                            // steady link (sec)
+            char*   nodeState;              // inactive, frontier or changing
+            char*   linkActive;             // TRUE if link is active
+            char*   linkSteady;             // TRUE if link flow was unchanged
+                                            // over last step
+            char*   isWoken;                // TRUE if node or link is listed
+                                            // in woken
+            char*   canSettle;              // FALSE if node is always active
+        }         Active;
+        int*      PartNodes;                // nodes listed in partition order
+        int*      PartLinks;                // links listed in partition order
+        double*   PredHistory;              // conduit flows (cfs) & node
+                                            // depths (ft) at the start of
+                                            // the last 2 time steps
+        int*      PredStamp;                // last step whose start is in
+                                            // each node's & link's history
+        int       PredStep;                 // number of current step
+        double    PredSteps[2];             // sizes of the last 2 steps (sec)
+        int       PredCount;                // number of past steps in history
+        double    PredTime;                 // start time of next step in
+                                            // sequence with history (msec)
+        int       Predicted;                // TRUE if current step starts
+                                            // from extrapolated solution
+    }     dynwave;
+
+    struct                                  // flowrout.c
+    {
+        int       NumLevels;                // number of levels of nodes
+        int*      LevelStart;               // start of each level in LevelNodes
+        int*      LevelNodes;               // nodes listed by level
+        int*      OutletPos;                // position of each node's first
+                                            // outgoing link in sorted links
+        int*      InletStart;               // start of each node's entries
+                                            // in InletLinks
+        int*      InletLinks;               // links entering each node in
+                                            // topo-sorted order
+    }     flowrout;
+
+    struct                                  // iface.c
+    {
+        int       IfaceFlowUnits;           // flow units for routing interface file
+        int       IfaceStep;                // interface file time step (sec)
+        int       NumIfacePolluts;          // number of pollutants in interface file
+        int*      IfacePolluts;             // indexes of interface file pollutants
+        int       NumIfaceNodes;            // number of nodes on interface file
+        int*      IfaceNodes;               // indexes of nodes on interface file
+        double**  OldIfaceValues;           // interface flows & WQ at previous time
+        double**  NewIfaceValues;           // interface flows & WQ at next time
+        double    IfaceFrac;                // fraction of interface file time step
+        DateTime  OldIfaceDate;             // previous date of interface values
+        DateTime  NewIfaceDate;             // next date of interface values
+    }     iface;
+
+    struct                                  // infil.c
+    {
+        double*         block;              // memory holding the arrays below
+        int             blockSize;          // number of values in block
+        THortonArrays   HortInfil;          // Horton infiltration arrays
+        TGrnAmptArrays  GAInfil;            // Green-Ampt infiltration arrays
+        TCurveNumArrays CNInfil;            // Curve Number infiltration arrays
+    }     infil;
+
+    struct                                  // lid.c
+    {
+        struct TLidProc*  LidProcs;         // array of LID processes
+        int               LidCount;         // number of LID processes
+        struct LidGroup** LidGroups;        // array of LID process groups
+        int               GroupCount;       // number of LID groups (subcatchments)
+    }     lid;
+
+    struct                                  // massbal.c
+    {
+        TRunoffTotals    RunoffTotals;      // overall surface runoff continuity totals
+        TLoadingTotals*  LoadingTotals;     // overall WQ washoff continuity totals
+        TGwaterTotals    GwaterTotals;      // overall groundwater continuity totals
+        TRoutingTotals   FlowTotals;        // overall routed flow continuity totals
+        TRoutingTotals*  QualTotals;        // overall routed WQ continuity totals
+        TRoutingTotals   StepFlowTotals;    // routed flow totals over time step
+        TRoutingTotals   OldStepFlowTotals; // routed flow totals over previous step
+        TRoutingTotals*  StepQualTotals;    // routed WQ totals over time step
+        double*          NodeInflow;        // total inflow volume to each node (ft3)
+        double*          NodeOutflow;       // total outflow volume from each node (ft3)
+        double           TotalArea;         // total drainage area (ft2)
+    }     massbal;
+
+    struct                                  // output.c
+    {
+        int       IDStartPos;               // starting file position of ID names
+        int       InputStartPos;            // starting file position of input data
+        int       OutputStartPos;           // starting file position of output data
+        int       BytesPerPeriod;           // bytes saved per simulation time period
+        int       NumSubcatchVars;          // number of subcatchment output variables
+        int       NumNodeVars;              // number of node output variables
+        int       NumLinkVars;              // number of link output variables
+        int       NumSubcatch;              // number of subcatchments reported on
+        int       NumNodes;                 // number of nodes reported on
+        int       NumLinks;                 // number of links reported on
+        int       NumPolluts;               // number of pollutants reported on
+        float     SysResults[MAX_SYS_RESULTS]; // values of system output vars.
+        struct TAvgResults* AvgLinkResults; // average link results
+        struct TAvgResults* AvgNodeResults; // average node results
+        int       Nsteps;                   // number of steps averaged over
+        float*    SubcatchResults;          // subcatchment results vector
+        float*    NodeResults;              // node results vector
+        float*    LinkResults;              // link results vector
+    }     output;
+
+    struct                                  // project.c
+    {
+        struct HTentry** Htable[MAX_OBJ_TYPES]; // Hash tables for object ID names
+        struct alloc_handle_t* MemPool;     // memory pool for object ID names
+        struct TProject* BaseProject;       // project a scenario was made from
+        int*      ObjIndex[MAX_OBJ_TYPES];  // index of each object in input order
+        int*      InputPos[MAX_OBJ_TYPES];  // input position of each object
+    }     project;
+
+    struct                                  // rdii.c
+    {
+        struct TUHGroup* UHGroup;           // processing data for each UH group
+        int       RdiiStep;                 // RDII time step (sec)
+        int       NumRdiiNodes;             // number of nodes w/ RDII data
+        int*      RdiiNodeIndex;            // indexes of nodes w/ RDII data
+        float*    RdiiNodeFlow;             // inflows for nodes with RDII
+        int       RdiiFlowUnits;            // RDII flow units code
+        DateTime  RdiiStartDate;            // start date of RDII inflow period
+        DateTime  RdiiEndDate;              // end date of RDII inflow period
+        double    TotalRainVol;             // total rainfall volume (ft3)
+        double    TotalRdiiVol;             // total RDII volume (ft3)
+        int       RdiiFileType;             // type (binary/text) of RDII file
+    }     rdii;
+
+    struct                                  // report.c
+    {
+        time_t    SysTime;                  // system time when project opened
+    }     report;
+
+    struct                                  // routing.c
+    {
+        int*      SortedLinks;              // topologically sorted links
+        int       NextEvent;                // index of next routing event
+        int       BetweenEvents;            // TRUE if between routing events
+        double    NewRuleTime;              // next time to evaluate control rules
+    }     routing;
+
+    struct                                  // runoff.c
+    {
+        char      IsRaining;                // TRUE if precip. falls on study area
+        char      HasRunoff;                // TRUE if study area generates runoff
+        char      HasSnow;                  // TRUE if any snow cover on study area
+        char      HasWetLids;               // TRUE if any LIDs are wet
+        int       Nsteps;                   // number of runoff time steps taken
+        int       MaxSteps;                 // final number of runoff time steps
+        long      MaxStepsPos;              // position in Runoff interface file
+                                            //    where MaxSteps is saved
+        double*   OutflowLoad;              // exported pollutant mass load
+        TRunoffContext* RunoffCtx;          // runoff context of each subcatch.
+        struct TOdeSolver* OdeSolvers;      // ODE solver of each thread
+    }     runoff;
+
+    struct                                  // stats.c
+    {
+        TSysStats       SysStats;           // system-wide statistics
+        TMaxStats       MaxMassBalErrs[MAX_STATS];  // nodes w/ largest errors
+        TMaxStats       MaxCourantCrit[MAX_STATS];  // most Courant-critical
+        TMaxStats       MaxFlowTurns[MAX_STATS];    // links w/ most flow turns
+        double          SysOutfallFlow;     // total outfall flow (cfs)
+        TSubcatchStats* SubcatchStats;      // subcatchment statistics
+        TNodeStats*     NodeStats;          // node statistics
+        TLinkStats*     LinkStats;          // link statistics
+        TStorageStats*  StorageStats;       // storage node statistics
+        TOutfallStats*  OutfallStats;       // outfall node statistics
+        TPumpStats*     PumpStats;          // pump statistics
+        double          MaxOutfallFlow;     // max. total outfall flow (cfs)
+        double          MaxRunoffFlow;      // max. total runoff flow (cfs)
+    }     stats;
+
+    struct                                  // treatmnt.c
+    {
+        double*   R;                        // array of pollut. removals
+        double*   Cin;                      // node inflow concentrations
+    }     treatmnt;
+}  TProject;
+
+EXTERN THREADLOCAL_IE TProject* Prj;        // Project used by calling thread
+
+//-----------------------------------------------------------------------------
+//  Names of the global variables of the current project
+//-----------------------------------------------------------------------------
+#define Finp             (Prj->Finp)
+#define Fout             (Prj->Fout)
+#define Frpt             (Prj->Frpt)
+#define Fclimate         (Prj->Fclimate)
+#define Frain            (Prj->Frain)
+#define Frunoff          (Prj->Frunoff)
+#define Frdii            (Prj->Frdii)
+#define Fhotstart1       (Prj->Fhotstart1)
+#define Fhotstart2       (Prj->Fhotstart2)
+#define Finflows         (Prj->Finflows)
+#define Foutflows        (Prj->Foutflows)
+#define Nperiods         (Prj->Nperiods)
+#define StepCount        (Prj->StepCount)
+#define NonConvergeCount (Prj->NonConvergeCount)
+#define PredictCount     (Prj->PredictCount)
+#define PredictHitCount  (Prj->PredictHitCount)
+#define Msg              (Prj->Msg)
+#define ErrorMsg         (Prj->ErrorMsg)
+#define Title            (Prj->Title)
+#define TempDir          (Prj->TempDir)
+#define RptFlags         (Prj->RptFlags)
+#define Nobjects         (Prj->Nobjects)
+#define Nnodes           (Prj->Nnodes)
+#define Nlinks           (Prj->Nlinks)
+#define UnitSystem       (Prj->UnitSystem)
+#define FlowUnits        (Prj->FlowUnits)
+#define InfilModel       (Prj->InfilModel)
+#define RouteModel       (Prj->RouteModel)
+#define ForceMainEqn     (Prj->ForceMainEqn)
+#define LinkOffsets      (Prj->LinkOffsets)
+#define SurchargeMethod  (Prj->SurchargeMethod)
+#define SolverMethod     (Prj->SolverMethod)
+#define ThreadSchedule   (Prj->ThreadSchedule)
+#define CircGeometry     (Prj->CircGeometry)
+#define NetworkOrder     (Prj->NetworkOrder)
+#define Predictor        (Prj->Predictor)
+#define RunoffSolver     (Prj->RunoffSolver)
+#define DepthWarmStart   (Prj->DepthWarmStart)
+#define ActiveSet        (Prj->ActiveSet)
+#define AllowPonding     (Prj->AllowPonding)
+#define InertDamping     (Prj->InertDamping)
+#define NormalFlowLtd    (Prj->NormalFlowLtd)
+#define SlopeWeighting   (Prj->SlopeWeighting)
+#define Compatibility    (Prj->Compatibility)
+#define SkipSteadyState  (Prj->SkipSteadyState)
+#define IgnoreRainfall   (Prj->IgnoreRainfall)
+#define IgnoreRDII       (Prj->IgnoreRDII)
+#define IgnoreSnowmelt   (Prj->IgnoreSnowmelt)
+#define IgnoreGwater     (Prj->IgnoreGwater)
+#define IgnoreRouting    (Prj->IgnoreRouting)
+#define IgnoreQuality    (Prj->IgnoreQuality)
+#define ErrorCode        (Prj->ErrorCode)
+#define Warnings         (Prj->Warnings)
+#define WetStep          (Prj->WetStep)
+#define DryStep          (Prj->DryStep)
+#define ReportStep       (Prj->ReportStep)
+#define RuleStep         (Prj->RuleStep)
+#define SweepStart       (Prj->SweepStart)
+#define SweepEnd         (Prj->SweepEnd)
+#define MaxTrials        (Prj->MaxTrials)
+#define AndersonDepth    (Prj->AndersonDepth)
+#define DenseTableSize   (Prj->DenseTableSize)
+#define NumThreads       (Prj->NumThreads)
+#define NumEvents        (Prj->NumEvents)
+#define RouteStep        (Prj->RouteStep)
+#define MinRouteStep     (Prj->MinRouteStep)
+#define LengtheningStep  (Prj->LengtheningStep)
+#define StartDryDays     (Prj->StartDryDays)
+#define CourantFactor    (Prj->CourantFactor)
+#define MinSurfArea      (Prj->MinSurfArea)
+#define MinSlope         (Prj->MinSlope)
+#define RunoffError      (Prj->RunoffError)
+#define GwaterError      (Prj->GwaterError)
+#define FlowError        (Prj->FlowError)
+#define QualError        (Prj->QualError)
+#define HeadTol          (Prj->HeadTol)
+#define SysFlowTol       (Prj->SysFlowTol)
+#define LatFlowTol       (Prj->LatFlowTol)
+#define CrownCutoff      (Prj->CrownCutoff)
+#define StartDate        (Prj->StartDate)
+#define StartTime        (Prj->StartTime)
+#define StartDateTime    (Prj->StartDateTime)
+#define EndDate          (Prj->EndDate)
+#define EndTime          (Prj->EndTime)
+#define EndDateTime      (Prj->EndDateTime)
+#define ReportStartDate  (Prj->ReportStartDate)
+#define ReportStartTime  (Prj->ReportStartTime)
+#define ReportStart      (Prj->ReportStart)
+#define ReportTime       (Prj->ReportTime)
+#define OldRunoffTime    (Prj->OldRunoffTime)
+#define NewRunoffTime    (Prj->NewRunoffTime)
+#define OldRoutingTime   (Prj->OldRoutingTime)
+#define NewRoutingTime   (Prj->NewRoutingTime)
+#define TotalDuration    (Prj->TotalDuration)
+#define ElapsedTime      (Prj->ElapsedTime)
+#define Temp             (Prj->Temp)
+#define Evap             (Prj->Evap)
+#define Wind             (Prj->Wind)
+#define Snow             (Prj->Snow)
+#define Adjust           (Prj->Adjust)
+#define Snowmelt         (Prj->Snowmelt)
+#define Gage             (Prj->Gage)
+#define Subcatch         (Prj->Subcatch)
+#define Aquifer          (Prj->Aquifer)
+#define UnitHyd          (Prj->UnitHyd)
+#define Node             (Prj->Node)
+#define Outfall          (Prj->Outfall)
+#define Divider          (Prj->Divider)
+#define Storage          (Prj->Storage)
+#define Link             (Prj->Link)
+#define Conduit          (Prj->Conduit)
+#define Pump             (Prj->Pump)
+#define Orifice          (Prj->Orifice)
+#define Weir             (Prj->Weir)
+#define Outlet           (Prj->Outlet)
+#define Pollut           (Prj->Pollut)
+#define Landuse          (Prj->Landuse)
+#define Pattern          (Prj->Pattern)
+#define Curve            (Prj->Curve)
+#define Tseries          (Prj->Tseries)
+#define Transect         (Prj->Transect)
+#define Shape            (Prj->Shape)
+#define Event            (Prj->Event)
+#define LinkListStart    (Prj->LinkListStart)
+#define LinkLists        (Prj->LinkLists)
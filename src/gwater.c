@@ -24,6 +24,13 @@
 //   Build 5.1.010:
 //   - Unsaturated hydraulic conductivity added to GW flow equation variables.
 //
+//   Build 5.2.0:
+//   - GW mass balance volumes saved to the subcatchment's runoff context
+//     rather than added directly to the system totals.
+//   - Quantities shared between functions kept in a TGwaterState local to
+//     gwater_getGroundwater() and passed to the calling thread's ODE solver
+//     as its user data.
+//
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -61,33 +68,44 @@ static char* GWVarWords[] = {"HGW", "HSW", "HCB", "HGS", "KS", "K",
                              "THETA", "PHI", "FI", "FU", "A", NULL};
 
 //-----------------------------------------------------------------------------
-//  Shared variables
+//  Data Structures
 //-----------------------------------------------------------------------------
+//  Quantities shared by the functions that find a subcatchment's GW flow
+//  over a time step (also passed to the ODE solver as its user data).
 //  NOTE: all flux rates are in ft/sec, all depths are in ft.
-static double    Area;            // subcatchment area (ft2)
-static double    Infil;           // infiltration rate from surface
-static double    MaxEvap;         // max. evaporation rate
-static double    AvailEvap;       // available evaporation rate
-static double    UpperEvap;       // evaporation rate from upper GW zone
-static double    LowerEvap;       // evaporation rate from lower GW zone
-static double    UpperPerc;       // percolation rate from upper to lower zone
-static double    LowerLoss;       // loss rate from lower GW zone
-static double    GWFlow;          // flow rate from lower zone to conveyance node
-static double    MaxUpperPerc;    // upper limit on UpperPerc
-static double    MaxGWFlowPos;    // upper limit on GWFlow when its positve
-static double    MaxGWFlowNeg;    // upper limit on GWFlow when its negative
-static double    FracPerv;        // fraction of surface that is pervious
-static double    TotalDepth;      // total depth of GW aquifer
-static double    Theta;           // moisture content of upper zone
-static double    HydCon;          // unsaturated hydraulic conductivity (ft/s)
-static double    Hgw;             // ht. of saturated zone
-static double    Hstar;           // ht. from aquifer bottom to node invert
-static double    Hsw;             // ht. from aquifer bottom to water surface
-static double    Tstep;           // current time step (sec)
-static TAquifer  A;               // aquifer being analyzed
-static TGroundwater* GW;          // groundwater object being analyzed
-static MathExpr* LatFlowExpr;     // user-supplied lateral GW flow expression
-static MathExpr* DeepFlowExpr;    // user-supplied deep GW flow expression
+typedef struct
+{
+    double    area;            // subcatchment area (ft2)
+    double    infil;           // infiltration rate from surface
+    double    maxEvap;         // max. evaporation rate
+    double    availEvap;       // available evaporation rate
+    double    upperEvap;       // evaporation rate from upper GW zone
+    double    lowerEvap;       // evaporation rate from lower GW zone
+    double    upperPerc;       // percolation rate from upper to lower zone
+    double    lowerLoss;       // loss rate from lower GW zone
+    double    gwFlow;          // flow rate from lower zone to conveyance node
+    double    maxUpperPerc;    // upper limit on upperPerc
+    double    maxGWFlowPos;    // upper limit on gwFlow when its positve
+    double    maxGWFlowNeg;    // upper limit on gwFlow when its negative
+    double    fracPerv;        // fraction of surface that is pervious
+    double    totalDepth;      // total depth of GW aquifer
+    double    theta;           // moisture content of upper zone
+    double    hydCon;          // unsaturated hydraulic conductivity (ft/s)
+    double    hgw;             // ht. of saturated zone
+    double    hstar;           // ht. from aquifer bottom to node invert
+    double    hsw;             // ht. from aquifer bottom to water surface
+    double    tStep;           // current time step (sec)
+    TAquifer  aquifer;         // aquifer being analyzed
+    TGroundwater* gw;          // groundwater object being analyzed
+    MathExpr* latFlowExpr;     // user-supplied lateral GW flow expression
+    MathExpr* deepFlowExpr;    // user-supplied deep GW flow expression
+}  TGwaterState;
+
+//-----------------------------------------------------------------------------
+//  Shared variables
+//-----------------------------------------------------------------------------
+// GW state whose variables are used in custom GW flow expressions
+static THREADLOCAL TGwaterState* theState;
 
 //-----------------------------------------------------------------------------
 //  External Functions (declared in funcs.h)
@@ -107,12 +125,16 @@ static MathExpr* DeepFlowExpr;    // user-supplied deep GW flow expression
 //-----------------------------------------------------------------------------
 //  Local functions
 //-----------------------------------------------------------------------------
-static void   getDxDt(double t, double* x, double* dxdt);
-static void   getFluxes(double upperVolume, double lowerDepth);
-static void   getEvapRates(double theta, double upperDepth);
-static double getUpperPerc(double theta, double upperDepth);
-static double getGWFlow(double lowerDepth);
-static void   updateMassBal(double area,  double tStep);
+static void   getDxDt(void* data, double t, double* x, double* dxdt);
+static void   getFluxes(TGwaterState* gws, double upperVolume,
+              double lowerDepth);
+static void   getEvapRates(TGwaterState* gws, double theta,
+              double upperDepth);
+static double getUpperPerc(TGwaterState* gws, double theta,
+              double upperDepth);
+static double getGWFlow(TGwaterState* gws, double lowerDepth);
+static void   updateMassBal(TGwaterState* gws, double tStep,
+              TRunoffContext* ctx);
 
 // Used to process custom GW outflow equations
 static int    getVariableIndex(char* s);
@@ -478,163 +500,168 @@ double gwater_getVolume(int j)
 
 //=============================================================================
 
-void gwater_getGroundwater(int j, double evap, double infil, double tStep)
+void gwater_getGroundwater(int j, double evap, double infil, double tStep,
+                           TRunoffContext* ctx)
 //
 //  Purpose: computes groundwater flow from subcatchment during current time step.
 //  Input:   j     = subcatchment index
 //           evap  = pervious surface evaporation volume consumed (ft3)
 //           infil = surface infiltration volume (ft3)
 //           tStep = time step (sec)
-//  Output:  none
+//           ctx   = subcatchment's runoff context
+//  Output:  saves GW mass balance volumes in ctx
 //
 {
     int    n;                          // node exchanging groundwater
     double x[2];                       // upper moisture content & lower depth 
     double vUpper;                     // upper vol. available for percolation
     double nodeFlow;                   // max. possible GW flow from node
+    TGwaterState  state;               // quantities shared with GW functions
+    TGwaterState* gws = &state;
 
     // --- save subcatchment's groundwater and aquifer objects to 
     //     shared variables
-    GW = Subcatch[j].groundwater;
-    if ( GW == NULL ) return;
-    LatFlowExpr = Subcatch[j].gwLatFlowExpr;
-    DeepFlowExpr = Subcatch[j].gwDeepFlowExpr;
-    A = Aquifer[GW->aquifer];
+    gws->gw = Subcatch[j].groundwater;
+    if ( gws->gw == NULL ) return;
+    gws->latFlowExpr = Subcatch[j].gwLatFlowExpr;
+    gws->deepFlowExpr = Subcatch[j].gwDeepFlowExpr;
+    gws->aquifer = Aquifer[gws->gw->aquifer];
 
     // --- get fraction of total area that is pervious
-    FracPerv = subcatch_getFracPerv(j);
-    if ( FracPerv <= 0.0 ) return;
-    Area = Subcatch[j].area;
+    gws->fracPerv = subcatch_getFracPerv(j);
+    if ( gws->fracPerv <= 0.0 ) return;
+    gws->area = Subcatch[j].area;
 
     // --- convert infiltration volume (ft3) to equivalent rate
     //     over entire GW (subcatchment) area
-    infil = infil / Area / tStep;
-    Infil = infil;
-    Tstep = tStep;
+    infil = infil / gws->area / tStep;
+    gws->infil = infil;
+    gws->tStep = tStep;
 
     // --- convert pervious surface evaporation already exerted (ft3)
     //     to equivalent rate over entire GW (subcatchment) area
-    evap = evap / Area / tStep;
+    evap = evap / gws->area / tStep;
 
     // --- convert max. surface evap rate (ft/sec) to a rate
     //     that applies to GW evap (GW evap can only occur
     //     through the pervious land surface area)
-    MaxEvap = Evap.rate * FracPerv;
+    gws->maxEvap = Evap.rate * gws->fracPerv;
 
     // --- available subsurface evaporation is difference between max.
     //     rate and pervious surface evap already exerted
-    AvailEvap = MAX((MaxEvap - evap), 0.0);
+    gws->availEvap = MAX((gws->maxEvap - evap), 0.0);
 
     // --- save total depth & outlet node properties to shared variables
-    TotalDepth = GW->surfElev - GW->bottomElev;
-    if ( TotalDepth <= 0.0 ) return;
-    n = GW->node;
+    gws->totalDepth = gws->gw->surfElev - gws->gw->bottomElev;
+    if ( gws->totalDepth <= 0.0 ) return;
+    n = gws->gw->node;
 
     // --- establish min. water table height above aquifer bottom at which
     //     GW flow can occur (override node's invert if a value was provided
     //     in the GW object)
-    if ( GW->nodeElev != MISSING ) Hstar = GW->nodeElev - GW->bottomElev;
-    else Hstar = Node[n].invertElev - GW->bottomElev;
+    if ( gws->gw->nodeElev != MISSING )
+        gws->hstar = gws->gw->nodeElev - gws->gw->bottomElev;
+    else gws->hstar = Node[n].invertElev - gws->gw->bottomElev;
     
     // --- establish surface water height (relative to aquifer bottom)
     //     for drainage system node connected to the GW aquifer
-    if ( GW->fixedDepth > 0.0 )
+    if ( gws->gw->fixedDepth > 0.0 )
     {
-        Hsw = GW->fixedDepth + Node[n].invertElev - GW->bottomElev;
+        gws->hsw = gws->gw->fixedDepth + Node[n].invertElev -
+                   gws->gw->bottomElev;
     }
-    else Hsw = Node[n].newDepth + Node[n].invertElev - GW->bottomElev;
+    else gws->hsw = Node[n].newDepth + Node[n].invertElev -
+                    gws->gw->bottomElev;
 
     // --- store state variables (upper zone moisture content, lower zone
     //     depth) in work vector x
-    x[THETA] = GW->theta;
-    x[LOWERDEPTH] = GW->lowerDepth;
+    x[THETA] = gws->gw->theta;
+    x[LOWERDEPTH] = gws->gw->lowerDepth;
 
     // --- set limit on percolation rate from upper to lower GW zone
-    vUpper = (TotalDepth - x[LOWERDEPTH]) * (x[THETA] - A.fieldCapacity);
+    vUpper = (gws->totalDepth - x[LOWERDEPTH]) *
+             (x[THETA] - gws->aquifer.fieldCapacity);
     vUpper = MAX(0.0, vUpper); 
-    MaxUpperPerc = vUpper / tStep;
+    gws->maxUpperPerc = vUpper / tStep;
 
     // --- set limit on GW flow out of aquifer based on volume of lower zone
-    MaxGWFlowPos = x[LOWERDEPTH]*A.porosity / tStep;
+    gws->maxGWFlowPos = x[LOWERDEPTH]*gws->aquifer.porosity / tStep;
 
     // --- set limit on GW flow into aquifer from drainage system node
     //     based on min. of capacity of upper zone and drainage system
     //     inflow to the node
-    MaxGWFlowNeg = (TotalDepth - x[LOWERDEPTH]) * (A.porosity - x[THETA])
-                   / tStep;
-    nodeFlow = (Node[n].inflow + Node[n].newVolume/tStep) / Area;
-    MaxGWFlowNeg = -MIN(MaxGWFlowNeg, nodeFlow);
+    gws->maxGWFlowNeg = (gws->totalDepth - x[LOWERDEPTH]) *
+                        (gws->aquifer.porosity - x[THETA]) / tStep;
+    nodeFlow = (Node[n].inflow + Node[n].newVolume/tStep) / gws->area;
+    gws->maxGWFlowNeg = -MIN(gws->maxGWFlowNeg, nodeFlow);
     
     // --- integrate eqns. for d(Theta)/dt and d(LowerDepth)/dt
-    //     NOTE: ODE solver must have been initialized previously
-    odesolve_integrate(x, 2, 0, tStep, GWTOL, tStep, getDxDt);
+    //     using the calling thread's ODE solver
+    theState = gws;
+    odesolve_integrate(ctx->ode, x, 2, 0, tStep, GWTOL, tStep, getDxDt, gws);
     
     // --- keep state variables within allowable bounds
-    x[THETA] = MAX(x[THETA], A.wiltingPoint);
-    if ( x[THETA] >= A.porosity )
+    x[THETA] = MAX(x[THETA], gws->aquifer.wiltingPoint);
+    if ( x[THETA] >= gws->aquifer.porosity )
     {
-        x[THETA] = A.porosity - XTOL;
-        x[LOWERDEPTH] = TotalDepth - XTOL;
+        x[THETA] = gws->aquifer.porosity - XTOL;
+        x[LOWERDEPTH] = gws->totalDepth - XTOL;
     }
     x[LOWERDEPTH] = MAX(x[LOWERDEPTH],  0.0);
-    if ( x[LOWERDEPTH] >= TotalDepth )
+    if ( x[LOWERDEPTH] >= gws->totalDepth )
     {
-        x[LOWERDEPTH] = TotalDepth - XTOL;
+        x[LOWERDEPTH] = gws->totalDepth - XTOL;
     }
 
     // --- save new values of state values
-    GW->theta = x[THETA];
-    GW->lowerDepth  = x[LOWERDEPTH];
-    getFluxes(GW->theta, GW->lowerDepth);
-    GW->oldFlow = GW->newFlow;
-    GW->newFlow = GWFlow;
-    GW->evapLoss = UpperEvap + LowerEvap;
+    gws->gw->theta = x[THETA];
+    gws->gw->lowerDepth  = x[LOWERDEPTH];
+    getFluxes(gws, gws->gw->theta, gws->gw->lowerDepth);
+    gws->gw->oldFlow = gws->gw->newFlow;
+    gws->gw->newFlow = gws->gwFlow;
+    gws->gw->evapLoss = gws->upperEvap + gws->lowerEvap;
 
     //--- find max. infiltration volume (as depth over
     //    the pervious portion of the subcatchment)
     //    that upper zone can support in next time step
-    GW->maxInfilVol = (TotalDepth - x[LOWERDEPTH]) *
-                      (A.porosity - x[THETA]) / FracPerv;
+    gws->gw->maxInfilVol = (gws->totalDepth - x[LOWERDEPTH]) *
+                           (gws->aquifer.porosity - x[THETA]) / gws->fracPerv;
 
     // --- update GW mass balance
-    updateMassBal(Area, tStep);
+    updateMassBal(gws, tStep, ctx);
 
     // --- update GW statistics 
-    stats_updateGwaterStats(j, infil, GW->evapLoss, GWFlow, LowerLoss,
-        GW->theta, GW->lowerDepth + GW->bottomElev, tStep);
+    stats_updateGwaterStats(j, infil, gws->gw->evapLoss, gws->gwFlow,
+        gws->lowerLoss, gws->gw->theta,
+        gws->gw->lowerDepth + gws->gw->bottomElev, tStep);
 }
 
 //=============================================================================
 
-void updateMassBal(double area, double tStep)
+void updateMassBal(TGwaterState* gws, double tStep, TRunoffContext* ctx)
 //
-//  Input:   area  = subcatchment area (ft2)
+//  Input:   gws   = subcatchment's GW state
 //           tStep = time step (sec)
+//           ctx   = subcatchment's runoff context
 //  Output:  none
-//  Purpose: updates GW mass balance with volumes of water fluxes.
+//  Purpose: saves volumes of GW water fluxes for the GW mass balance.
 //
 {
-    double vInfil;                     // infiltration volume
-    double vUpperEvap;                 // upper zone evap. volume
-    double vLowerEvap;                 // lower zone evap. volume
-    double vLowerPerc;                 // lower zone deep perc. volume
-    double vGwater;                    // volume of exchanged groundwater
-    double ft2sec = area * tStep;
-
-    vInfil     = Infil * ft2sec;
-    vUpperEvap = UpperEvap * ft2sec;
-    vLowerEvap = LowerEvap * ft2sec;
-    vLowerPerc = LowerLoss * ft2sec;
-    vGwater    = 0.5 * (GW->oldFlow + GW->newFlow) * ft2sec;
-    massbal_updateGwaterTotals(vInfil, vUpperEvap, vLowerEvap, vLowerPerc,
-                               vGwater);
+    double ft2sec = gws->area * tStep;
+
+    ctx->gwInfil     = gws->infil * ft2sec;
+    ctx->gwUpperEvap = gws->upperEvap * ft2sec;
+    ctx->gwLowerEvap = gws->lowerEvap * ft2sec;
+    ctx->gwLowerPerc = gws->lowerLoss * ft2sec;
+    ctx->gwFlow      = 0.5 * (gws->gw->oldFlow + gws->gw->newFlow) * ft2sec;
 }
 
 //=============================================================================
 
-void  getFluxes(double theta, double lowerDepth)
+void  getFluxes(TGwaterState* gws, double theta, double lowerDepth)
 //
-//  Input:   upperVolume = vol. depth of upper zone (ft)
+//  Input:   gws         = subcatchment's GW state
+//           upperVolume = vol. depth of upper zone (ft)
 //           upperDepth  = depth of upper zone (ft)
 //  Output:  none
 //  Purpose: computes water fluxes into/out of upper/lower GW zones.
@@ -644,60 +671,64 @@ void  getFluxes(double theta, double lowerDepth)
 
     // --- find upper zone depth
     lowerDepth = MAX(lowerDepth, 0.0);
-    lowerDepth = MIN(lowerDepth, TotalDepth);
-    upperDepth = TotalDepth - lowerDepth;
+    lowerDepth = MIN(lowerDepth, gws->totalDepth);
+    upperDepth = gws->totalDepth - lowerDepth;
 
-    // --- save lower depth and theta to global variables
-    Hgw = lowerDepth;
-    Theta = theta;
+    // --- save lower depth and theta to the GW state
+    gws->hgw = lowerDepth;
+    gws->theta = theta;
 
     // --- find evaporation rate from both zones
-    getEvapRates(theta, upperDepth);
+    getEvapRates(gws, theta, upperDepth);
 
     // --- find percolation rate from upper to lower zone
-    UpperPerc = getUpperPerc(theta, upperDepth);
-    UpperPerc = MIN(UpperPerc, MaxUpperPerc);
+    gws->upperPerc = getUpperPerc(gws, theta, upperDepth);
+    gws->upperPerc = MIN(gws->upperPerc, gws->maxUpperPerc);
 
     // --- find loss rate to deep GW
-    if ( DeepFlowExpr != NULL )
-        LowerLoss = mathexpr_eval(DeepFlowExpr, getVariableValue) /
-                    UCF(RAINFALL);
+    if ( gws->deepFlowExpr != NULL )
+        gws->lowerLoss = mathexpr_eval(gws->deepFlowExpr, getVariableValue) /
+                         UCF(RAINFALL);
     else
-        LowerLoss = A.lowerLossCoeff * lowerDepth / TotalDepth;
-    LowerLoss = MIN(LowerLoss, lowerDepth/Tstep);
+        gws->lowerLoss = gws->aquifer.lowerLossCoeff * lowerDepth /
+                         gws->totalDepth;
+    gws->lowerLoss = MIN(gws->lowerLoss, lowerDepth/gws->tStep);
 
     // --- find GW flow rate from lower zone to drainage system node
-    GWFlow = getGWFlow(lowerDepth);
-    if ( LatFlowExpr != NULL )
+    gws->gwFlow = getGWFlow(gws, lowerDepth);
+    if ( gws->latFlowExpr != NULL )
     {
-        GWFlow += mathexpr_eval(LatFlowExpr, getVariableValue) / UCF(GWFLOW);
+        gws->gwFlow += mathexpr_eval(gws->latFlowExpr, getVariableValue) /
+                       UCF(GWFLOW);
     }
-    if ( GWFlow >= 0.0 ) GWFlow = MIN(GWFlow, MaxGWFlowPos);
-    else GWFlow = MAX(GWFlow, MaxGWFlowNeg);
+    if ( gws->gwFlow >= 0.0 ) gws->gwFlow = MIN(gws->gwFlow, gws->maxGWFlowPos);
+    else gws->gwFlow = MAX(gws->gwFlow, gws->maxGWFlowNeg);
 }
 
 //=============================================================================
 
-void  getDxDt(double t, double* x, double* dxdt)
+void  getDxDt(void* data, double t, double* x, double* dxdt)
 //
-//  Input:   t    = current time (not used)
+//  Input:   data = subcatchment's GW state
+//           t    = current time (not used)
 //           x    = array of state variables
 //  Output:  dxdt = array of time derivatives of state variables
 //  Purpose: computes time derivatives of upper moisture content 
 //           and lower depth.
 //
 {
+    TGwaterState* gws = (TGwaterState *)data;
     double qUpper;    // inflow - outflow for upper zone (ft/sec)
     double qLower;    // inflow - outflow for lower zone (ft/sec)
     double denom;
 
-    getFluxes(x[THETA], x[LOWERDEPTH]);
-    qUpper = Infil - UpperEvap - UpperPerc;
-    qLower = UpperPerc - LowerLoss - LowerEvap - GWFlow;
+    getFluxes(gws, x[THETA], x[LOWERDEPTH]);
+    qUpper = gws->infil - gws->upperEvap - gws->upperPerc;
+    qLower = gws->upperPerc - gws->lowerLoss - gws->lowerEvap - gws->gwFlow;
 
     // --- d(upper zone moisture)/dt = (net upper zone flow) /
     //                                 (upper zone depth)
-    denom = TotalDepth - x[LOWERDEPTH];
+    denom = gws->totalDepth - x[LOWERDEPTH];
     if (denom > 0.0)
         dxdt[THETA] = qUpper / denom;
     else
@@ -705,7 +736,7 @@ void  getDxDt(double t, double* x, double* dxdt)
 
     // --- d(lower zone depth)/dt = (net lower zone flow) /
     //                              (upper zone moisture deficit)
-    denom = A.porosity - x[THETA];
+    denom = gws->aquifer.porosity - x[THETA];
     if (denom > 0.0)
         dxdt[LOWERDEPTH] = qLower / denom;
     else
@@ -714,9 +745,10 @@ void  getDxDt(double t, double* x, double* dxdt)
 
 //=============================================================================
 
-void getEvapRates(double theta, double upperDepth)
+void getEvapRates(TGwaterState* gws, double theta, double upperDepth)
 //
-//  Input:   theta      = moisture content of upper zone
+//  Input:   gws        = subcatchment's GW state
+//           theta      = moisture content of upper zone
 //           upperDepth = depth of upper zone (ft)
 //  Output:  none
 //  Purpose: computes evapotranspiration out of upper & lower zones.
@@ -727,14 +759,14 @@ void getEvapRates(double theta, double upperDepth)
     double lowerFrac, upperFrac;
 
     // --- no GW evaporation when infiltration is occurring
-    UpperEvap = 0.0;
-    LowerEvap = 0.0;
-    if ( Infil > 0.0 ) return;
+    gws->upperEvap = 0.0;
+    gws->lowerEvap = 0.0;
+    if ( gws->infil > 0.0 ) return;
 
     // --- get monthly-adjusted upper zone evap fraction
-    upperFrac = A.upperEvapFrac;
+    upperFrac = gws->aquifer.upperEvapFrac;
     f = 1.0;
-    p = A.upperEvapPat;
+    p = gws->aquifer.upperEvapPat;
     if ( p >= 0 )
     {
         month = datetime_monthOfYear(getDateTime(NewRunoffTime));
@@ -744,35 +776,37 @@ void getEvapRates(double theta, double upperDepth)
 
     // --- upper zone evaporation requires that soil moisture
     //     be above the wilting point
-    if ( theta > A.wiltingPoint )
+    if ( theta > gws->aquifer.wiltingPoint )
     {
         // --- actual evap is upper zone fraction applied to max. potential
         //     rate, limited by the available rate after any surface evap 
-        UpperEvap = upperFrac * MaxEvap;
-        UpperEvap = MIN(UpperEvap, AvailEvap);
+        gws->upperEvap = upperFrac * gws->maxEvap;
+        gws->upperEvap = MIN(gws->upperEvap, gws->availEvap);
     }
 
     // --- check if lower zone evaporation is possible
-    if ( A.lowerEvapDepth > 0.0 )
+    if ( gws->aquifer.lowerEvapDepth > 0.0 )
     {
         // --- find the fraction of the lower evaporation depth that
         //     extends into the saturated lower zone
-        lowerFrac = (A.lowerEvapDepth - upperDepth) / A.lowerEvapDepth;
+        lowerFrac = (gws->aquifer.lowerEvapDepth - upperDepth) /
+                    gws->aquifer.lowerEvapDepth;
         lowerFrac = MAX(0.0, lowerFrac);
         lowerFrac = MIN(lowerFrac, 1.0);
 
         // --- make the lower zone evap rate proportional to this fraction
         //     and the evap not used in the upper zone
-        LowerEvap = lowerFrac * (1.0 - upperFrac) * MaxEvap;
-        LowerEvap = MIN(LowerEvap, (AvailEvap - UpperEvap));
+        gws->lowerEvap = lowerFrac * (1.0 - upperFrac) * gws->maxEvap;
+        gws->lowerEvap = MIN(gws->lowerEvap, (gws->availEvap - gws->upperEvap));
     }
 }
 
 //=============================================================================
 
-double getUpperPerc(double theta, double upperDepth)
+double getUpperPerc(TGwaterState* gws, double theta, double upperDepth)
 //
-//  Input:   theta      = moisture content of upper zone
+//  Input:   gws        = subcatchment's GW state
+//           theta      = moisture content of upper zone
 //           upperDepth = depth of upper zone (ft)
 //  Output:  returns percolation rate (ft/sec)
 //  Purpose: finds percolation rate from upper to lower zone.
@@ -783,53 +817,57 @@ double getUpperPerc(double theta, double upperDepth)
     double hydcon;                      // unsaturated hydraulic conductivity
 
     // --- no perc. from upper zone if no depth or moisture content too low    
-    if ( upperDepth <= 0.0 || theta <= A.fieldCapacity ) return 0.0;
+    if ( upperDepth <= 0.0 || theta <= gws->aquifer.fieldCapacity ) return 0.0;
 
     // --- compute hyd. conductivity as function of moisture content
-    delta = theta - A.porosity;
-    hydcon = A.conductivity * exp(delta * A.conductSlope);
+    delta = theta - gws->aquifer.porosity;
+    hydcon = gws->aquifer.conductivity * exp(delta * gws->aquifer.conductSlope);
 
     // --- compute integral of dh/dz term
-    delta = theta - A.fieldCapacity;
-    dhdz = 1.0 + A.tensionSlope * 2.0 * delta / upperDepth;
+    delta = theta - gws->aquifer.fieldCapacity;
+    dhdz = 1.0 + gws->aquifer.tensionSlope * 2.0 * delta / upperDepth;
 
     // --- compute upper zone percolation rate
-    HydCon = hydcon;
+    gws->hydCon = hydcon;
     return hydcon * dhdz;
 }
 
 //=============================================================================
 
-double getGWFlow(double lowerDepth)
+double getGWFlow(TGwaterState* gws, double lowerDepth)
 //
-//  Input:   lowerDepth = depth of lower zone (ft)
+//  Input:   gws        = subcatchment's GW state
+//           lowerDepth = depth of lower zone (ft)
 //  Output:  returns groundwater flow rate (ft/sec)
 //  Purpose: finds groundwater outflow from lower saturated zone.
 //
 {
     double q, t1, t2, t3;
+    double hstar = gws->hstar;
+    double hsw = gws->hsw;
+    TGroundwater* gw = gws->gw;
 
     // --- water table must be above Hstar for flow to occur
-    if ( lowerDepth <= Hstar ) return 0.0;
+    if ( lowerDepth <= hstar ) return 0.0;
 
     // --- compute groundwater component of flow
-    if ( GW->b1 == 0.0 ) t1 = GW->a1;
-    else t1 = GW->a1 * pow( (lowerDepth - Hstar)*UCF(LENGTH), GW->b1);
+    if ( gw->b1 == 0.0 ) t1 = gw->a1;
+    else t1 = gw->a1 * pow( (lowerDepth - hstar)*UCF(LENGTH), gw->b1);
 
     // --- compute surface water component of flow
-    if ( GW->b2 == 0.0 ) t2 = GW->a2;
-    else if (Hsw > Hstar)
+    if ( gw->b2 == 0.0 ) t2 = gw->a2;
+    else if (hsw > hstar)
     {
-        t2 = GW->a2 * pow( (Hsw - Hstar)*UCF(LENGTH), GW->b2);
+        t2 = gw->a2 * pow( (hsw - hstar)*UCF(LENGTH), gw->b2);
     }
     else t2 = 0.0;
 
     // --- compute groundwater/surface water interaction term
-    t3 = GW->a3 * lowerDepth * Hsw * UCF(LENGTH) * UCF(LENGTH);
+    t3 = gw->a3 * lowerDepth * hsw * UCF(LENGTH) * UCF(LENGTH);
 
     // --- compute total groundwater flow
     q = (t1 - t2 + t3) / UCF(GWFLOW); 
-    if ( q < 0.0 && GW->a3 != 0.0 ) q = 0.0;
+    if ( q < 0.0 && gw->a3 != 0.0 ) q = 0.0;
     return q;
 }
 
@@ -858,19 +896,20 @@ double getVariableValue(int varIndex)
 //  Purpose: finds current value of a GW variable.
 //
 {
+    TGwaterState* gws = theState;
     switch (varIndex)
     {
-    case gwvHGW:  return Hgw * UCF(LENGTH);
-    case gwvHSW:  return Hsw * UCF(LENGTH);
-    case gwvHCB:  return Hstar * UCF(LENGTH);
-    case gwvHGS:  return TotalDepth * UCF(LENGTH);
-    case gwvKS:   return A.conductivity * UCF(RAINFALL);
-    case gwvK:    return HydCon * UCF(RAINFALL);
-    case gwvTHETA:return Theta;
-    case gwvPHI:  return A.porosity;
-    case gwvFI:   return Infil * UCF(RAINFALL); 
-    case gwvFU:   return UpperPerc * UCF(RAINFALL);
-    case gwvA:    return Area * UCF(LANDAREA);
+    case gwvHGW:  return gws->hgw * UCF(LENGTH);
+    case gwvHSW:  return gws->hsw * UCF(LENGTH);
+    case gwvHCB:  return gws->hstar * UCF(LENGTH);
+    case gwvHGS:  return gws->totalDepth * UCF(LENGTH);
+    case gwvKS:   return gws->aquifer.conductivity * UCF(RAINFALL);
+    case gwvK:    return gws->hydCon * UCF(RAINFALL);
+    case gwvTHETA:return gws->theta;
+    case gwvPHI:  return gws->aquifer.porosity;
+    case gwvFI:   return gws->infil * UCF(RAINFALL); 
+    case gwvFU:   return gws->upperPerc * UCF(RAINFALL);
+    case gwvA:    return gws->area * UCF(LANDAREA);
     default:      return 0.0;
     }
 }
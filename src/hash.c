@@ -12,6 +12,7 @@
 //      HTcreate() - creates a hash table
 //      HTinsert() - inserts a string & its index value into a hash table
 //      HTfind()   - retrieves the index value of a string from a table
+//      HTrenumber() - replaces the index values stored in a table
 //      HTfree()   - frees a hash table
 //-----------------------------------------------------------------------------
 
@@ -98,6 +99,18 @@ char    *HTfindKey(HTtable *ht, char *key)
         return(NULL);
 }
 
+/* Replace each index value i stored in the table with newIndex[i] */
+void    HTrenumber(HTtable *ht, int *newIndex)
+{
+        struct HTentry *entry;
+        int i;
+        for (i=0; i<HTMAXSIZE; i++)
+        {
+            for (entry = ht[i]; entry != NULL; entry = entry->next)
+                entry->data = newIndex[entry->data];
+        }
+}
+
 void    HTfree(HTtable *ht)
 {
         struct HTentry *entry,
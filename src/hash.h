@@ -20,4 +20,5 @@ HTtable *HTcreate(void);
 int     HTinsert(HTtable *, char *, int);
 int     HTfind(HTtable *, char *);
 char    *HTfindKey(HTtable *, char *);
+void    HTrenumber(HTtable *, int *);
 void    HTfree(HTtable *);
@@ -37,6 +37,10 @@
 //   Build 5.1.011:
 //   - Link control setting bug when reading a hot start file fixed.    
 //
+//   Build 5.2.0:
+//   - Nodes & links are kept in input file order when the network has
+//     been renumbered.
+//
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -49,7 +53,7 @@
 //-----------------------------------------------------------------------------
 //  Local Variables
 //-----------------------------------------------------------------------------
-static int fileVersion;
+static THREADLOCAL int fileVersion;
 
 //-----------------------------------------------------------------------------
 //  External functions (declared in funcs.h)
@@ -228,11 +232,12 @@ void  saveRouting()
 //  Purpose: saves current state of all nodes and links to hotstart file.
 //
 {
-    int   i, j;
+    int   i, j, k;
     float x[3];
 
-    for (i = 0; i < Nobjects[NODE]; i++)
+    for (k = 0; k < Nobjects[NODE]; k++)
     {
+        i = project_getObjectIndex(NODE, k);
         x[0] = (float)Node[i].newDepth;
         x[1] = (float)Node[i].newLatFlow;
         fwrite(x, sizeof(float), 2, Fhotstart2.file);
@@ -250,8 +255,9 @@ void  saveRouting()
             fwrite(&x[0], sizeof(float), 1, Fhotstart2.file);
         }
     }
-    for (i = 0; i < Nobjects[LINK]; i++)
+    for (k = 0; k < Nobjects[LINK]; k++)
     {
+        i = project_getObjectIndex(LINK, k);
         x[0] = (float)Link[i].newFlow;
         x[1] = (float)Link[i].newDepth;
         x[2] = (float)Link[i].setting;
@@ -274,7 +280,7 @@ void readRouting()
 //           from hotstart file.
 //
 {
-    int   i, j;
+    int   i, j, k;
     float x;
     double xgw[4];
     FILE* f = Fhotstart1.file;
@@ -299,8 +305,9 @@ void readRouting()
     }
 
     // --- read node states
-    for (i = 0; i < Nobjects[NODE]; i++)
+    for (k = 0; k < Nobjects[NODE]; k++)
     {
+        i = project_getObjectIndex(NODE, k);
         if ( !readFloat(&x, f) ) return;
         Node[i].newDepth = x;
         if ( !readFloat(&x, f) ) return;
@@ -330,8 +337,9 @@ void readRouting()
     }
 
     // --- read link states
-    for (i = 0; i < Nobjects[LINK]; i++)
+    for (k = 0; k < Nobjects[LINK]; k++)
     {
+        i = project_getObjectIndex(LINK, k);
         if ( !readFloat(&x, f) ) return;
         Link[i].newFlow = x;
         if ( !readFloat(&x, f) ) return;
@@ -7,6 +7,10 @@
 //   Author:   L. Rossman
 //
 //   Routing interface file functions.
+//
+//   Build 5.2.0:
+//   - Outlet nodes are listed in input file order when the network has
+//     been renumbered.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -23,17 +27,17 @@ extern double Qcf[];                   // flow units conversion factors
 //-----------------------------------------------------------------------------                  
 //  Shared variables
 //-----------------------------------------------------------------------------                  
-static int      IfaceFlowUnits;        // flow units for routing interface file
-static int      IfaceStep;             // interface file time step (sec)
-static int      NumIfacePolluts;       // number of pollutants in interface file
-static int*     IfacePolluts;          // indexes of interface file pollutants
-static int      NumIfaceNodes;         // number of nodes on interface file
-static int*     IfaceNodes;            // indexes of nodes on interface file
-static double** OldIfaceValues;        // interface flows & WQ at previous time
-static double** NewIfaceValues;        // interface flows & WQ at next time
-static double   IfaceFrac;             // fraction of interface file time step
-static DateTime OldIfaceDate;          // previous date of interface values
-static DateTime NewIfaceDate;          // next date of interface values
+#define IfaceFlowUnits  (Prj->iface.IfaceFlowUnits)  // flow units for routing interface file
+#define IfaceStep       (Prj->iface.IfaceStep)       // interface file time step (sec)
+#define NumIfacePolluts (Prj->iface.NumIfacePolluts) // number of pollutants in interface file
+#define IfacePolluts    (Prj->iface.IfacePolluts)    // indexes of interface file pollutants
+#define NumIfaceNodes   (Prj->iface.NumIfaceNodes)   // number of nodes on interface file
+#define IfaceNodes      (Prj->iface.IfaceNodes)      // indexes of nodes on interface file
+#define OldIfaceValues  (Prj->iface.OldIfaceValues)  // interface flows & WQ at previous time
+#define NewIfaceValues  (Prj->iface.NewIfaceValues)  // interface flows & WQ at next time
+#define IfaceFrac       (Prj->iface.IfaceFrac)       // fraction of interface file time step
+#define OldIfaceDate    (Prj->iface.OldIfaceDate)    // previous date of interface values
+#define NewIfaceDate    (Prj->iface.NewIfaceDate)    // next date of interface values
 
 //-----------------------------------------------------------------------------
 //  External Functions (declared in funcs.h)
@@ -46,6 +50,7 @@ static DateTime NewIfaceDate;          // next date of interface values
 //  iface_getIfaceFlow       (called by addIfaceInflows in routing.c)
 //  iface_getIfaceQual       (called by addIfaceInflows in routing.c)
 //  iface_saveOutletResults  (called by output_saveResults)
+//  iface_snapshot           (called by listState in snapshot.c)
 
 //-----------------------------------------------------------------------------
 //  Local functions
@@ -180,6 +185,24 @@ void iface_closeRoutingFiles()
 
 //=============================================================================
 
+void iface_snapshot(struct TSnapshot* snap)
+//
+//  Input:   snap = snapshot being built
+//  Output:  none
+//  Purpose: adds the values last read from the inflows interface file
+//           to a snapshot.
+//
+{
+    size_t size = NumIfaceNodes * (1 + NumIfacePolluts) * sizeof(double);
+
+    // --- rows of a matrix are stored in a single block (see
+    //     project_createMatrix)
+    if ( OldIfaceValues ) snapshot_addBlock(snap, OldIfaceValues[0], size);
+    if ( NewIfaceValues ) snapshot_addBlock(snap, NewIfaceValues[0], size);
+}
+
+//=============================================================================
+
 int iface_getNumIfaceNodes(DateTime currentDate)
 //
 //  Input:   currentDate = current date/time
@@ -282,7 +305,7 @@ void iface_saveOutletResults(DateTime reportDate, FILE* file)
 //  Purpose: saves system outflows to routing interface file.
 //
 {
-    int i, p, yr, mon, day, hr, min, sec;
+    int i, j, p, yr, mon, day, hr, min, sec;
     char theDate[25];
     datetime_decodeDate(reportDate, &yr, &mon, &day);
     datetime_decodeTime(reportDate, &hr, &min, &sec);
@@ -291,15 +314,16 @@ void iface_saveOutletResults(DateTime reportDate, FILE* file)
     for (i=0; i<Nobjects[NODE]; i++)
     {
         // --- check that node is an outlet node
-        if ( !isOutletNode(i) ) continue;
+        j = project_getObjectIndex(NODE, i);
+        if ( !isOutletNode(j) ) continue;
 
         // --- write node ID, date, flow, and quality to file
-        fprintf(file, "\n%-16s", Node[i].ID);
+        fprintf(file, "\n%-16s", Node[j].ID);
         fprintf(file, "%s", theDate);
-        fprintf(file, " %-10f", Node[i].inflow * UCF(FLOW));
+        fprintf(file, " %-10f", Node[j].inflow * UCF(FLOW));
         for ( p = 0; p < Nobjects[POLLUT]; p++ )
         {
-            fprintf(file, " %-10f", Node[i].newQual[p]);
+            fprintf(file, " %-10f", Node[j].newQual[p]);
         }
     }
 }
@@ -349,8 +373,9 @@ void openFileForOutput()
     fprintf(Foutflows.file, "\n%-4d - number of nodes as listed below:", n);
     for (i=0; i<Nobjects[NODE]; i++)
     {
-          if ( isOutletNode(i) )
-            fprintf(Foutflows.file, "\n%s", Node[i].ID);
+          n = project_getObjectIndex(NODE, i);
+          if ( isOutletNode(n) )
+            fprintf(Foutflows.file, "\n%s", Node[n].ID);
     }
 
     // --- write column headings
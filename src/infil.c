@@ -33,34 +33,75 @@
 //   Build 5.1.013:
 //   - Support added for subcatchment-specific time patterns that adjust
 //     hydraulic conductivity.
+//
+//   Build 5.2.0:
+//   - Hydraulic conductivity adjustment factor passed as an argument to
+//     infil_getInfil() & grnampt_getInfil() so that several subcatchments
+//     can be analyzed at once.
+//   - New function infil_getInfilFactor() replaces infil_setInfilFactor()
+//     and the shared InfilFactor variable.
+//   - Module-level variable Fumax replaced by a local variable.
+//   - New function infil_getInfilBatch() computes the infiltration of a
+//     batch of subcatchments, one per lane of a set of arrays.
+//   - Horton, Green-Ampt & Curve Number variables of subcatchments held in
+//     arrays with one entry per subcatchment, which the batch functions
+//     update in place.
+//   - infil_getInfil(), horton_getInfil(), modHorton_getInfil() &
+//     curvenum_getInfil() removed; a single subcatchment is analyzed as a
+//     batch of one.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 #include "headers.h"
 #include "infil.h"
 
 //-----------------------------------------------------------------------------
 //  Local Variables
 //-----------------------------------------------------------------------------
-THorton*   HortInfil = NULL;
-TGrnAmpt*  GAInfil   = NULL;
-TCurveNum* CNInfil   = NULL;
+#define InfilBlock      (Prj->infil.block)
+#define InfilBlockSize  (Prj->infil.blockSize)
+#define HortInfil       (Prj->infil.HortInfil)
+#define GAInfil         (Prj->infil.GAInfil)
+#define CNInfil         (Prj->infil.CNInfil)
+
+// number of arrays of subcatchment variables used by each InfilType
+static const int InfilArrayCount[] = {7, 7, 9, 9, 9};
+
+//-----------------------------------------------------------------------------
+//  Enumerated Constants
+//-----------------------------------------------------------------------------
+enum HortonLaneType {                  // branch taken by a Horton lane
+     HORTON_NONE,                      //   no infiltration
+     HORTON_CONST,                     //   constant infiltration rate
+     HORTON_WET,                       //   water available to infiltrate
+     HORTON_DRY};                      //   infil. capacity regenerating
+
+enum GrnAmptLaneType {                 // branch taken by a Green-Ampt lane
+     GA_NONE,                          //   no infiltration
+     GA_DRY,                           //   upper zone moisture recovering
+     GA_LIGHT,                         //   unsaturated, rainfall <= Ksat
+     GA_FILL,                          //   surface remains unsaturated
+     GA_TRANS,                         //   surface saturates during step
+     GA_SAT};                          //   surface saturated
 
-static double Fumax;   // saturated water volume in upper soil zone (ft)
-static double InfilFactor;                                                     //(5.1.013)
 
 //-----------------------------------------------------------------------------
 //  External Functions (declared in infil.h)
 //-----------------------------------------------------------------------------
 //  infil_create     (called by createObjects in project.c)
+//  infil_clone      (called by cloneObjects in project.c)
+//  infil_snapshot   (called by listState in snapshot.c)
 //  infil_delete     (called by deleteObjects in project.c)
 //  infil_readParams (called by input_readLine)
 //  infil_initState  (called by subcatch_initState)
 //  infil_getState   (called by writeRunoffFile in hotstart.c)
 //  infil_setState   (called by readRunoffFile in hotstart.c)
-//  infil_getInfil   (called by getSubareaRunoff in subcatch.c)
+//  infil_getInfilFactor (called by subcatch_initRunoff)
+//  infil_getInfilBatch (called by subcatch_getInfilBatch &
+//                       findNativeInfil in lid.c)
 
 //  Called locally and by storage node methods in node.c
 //  grnampt_setParams
@@ -70,73 +111,159 @@ static double InfilFactor;                                                     /
 //-----------------------------------------------------------------------------
 //  Local functions
 //-----------------------------------------------------------------------------
-static int    horton_setParams(THorton *infil, double p[]);
-static void   horton_initState(THorton *infil);
-static void   horton_getState(THorton *infil, double x[]);
-static void   horton_setState(THorton *infil, double x[]);
-static double horton_getInfil(THorton *infil, double tstep, double irate,
-              double depth);
-static double modHorton_getInfil(THorton *infil, double tstep, double irate,
-              double depth);
-
-static void   grnampt_getState(TGrnAmpt *infil, double x[]);
-static void   grnampt_setState(TGrnAmpt *infil, double x[]);
+static void   setArrays(int model, int subcatchCount);
+static void   getAvailableWater(TInfilBatch* batch, double dt[],
+              double fa[]);
+
+static int    horton_setParams(int j, double p[]);
+static void   horton_initState(int j);
+static void   horton_getState(int j, double x[]);
+static void   horton_setState(int j, double x[]);
+static void   horton_getInfilBatch(TInfilBatch* batch, double tstep);
+static void   modHorton_getInfilBatch(TInfilBatch* batch, double tstep);
+
+static int    grnampt_setSubcatchParams(int j, double p[]);
+static void   grnampt_initSubcatchState(int j);
+static void   grnampt_getState(int j, double x[]);
+static void   grnampt_setState(int j, double x[]);
 static double grnampt_getUnsatInfil(TGrnAmpt *infil, double tstep,
-              double irate, double depth, int modelType);
+              double irate, double depth, int modelType, double factor);
 static double grnampt_getSatInfil(TGrnAmpt *infil, double tstep,
-              double irate, double depth);
+              double irate, double depth, double factor);
 static double grnampt_getF2(double f1, double c1, double ks, double ts);
+static void   grnampt_getInfilBatch(TInfilBatch* batch, double tstep,
+              int modelType);
+static void   grnampt_getF2Batch(int n, double f1[], double c1[], double ks[],
+              double ts[], double f2[]);
 
-static int    curvenum_setParams(TCurveNum *infil, double p[]);
-static void   curvenum_initState(TCurveNum *infil);
-static void   curvenum_getState(TCurveNum *infil, double x[]);
-static void   curvenum_setState(TCurveNum *infil, double x[]);
-static double curvenum_getInfil(TCurveNum *infil, double tstep, double irate,
-              double depth);
+static int    curvenum_setParams(int j, double p[]);
+static void   curvenum_initState(int j);
+static void   curvenum_getState(int j, double x[]);
+static void   curvenum_setState(int j, double x[]);
+static void   curvenum_getInfilBatch(TInfilBatch* batch, double tstep);
 
 //=============================================================================
 
 void infil_create(int subcatchCount, int model)
 //
-//  Purpose: creates an array of infiltration objects.
+//  Purpose: creates the arrays of subcatchment infiltration variables.
 //  Input:   n = number of subcatchments
 //           m = infiltration method code
 //  Output:  none
 //
+//  All of the arrays used by the infiltration method are held in a single
+//  block of memory, one after the other.
 {
-    switch (model)
+    if ( model < HORTON || model > CURVE_NUMBER )
     {
-    case HORTON:
-    case MOD_HORTON:
-        HortInfil = (THorton *) calloc(subcatchCount, sizeof(THorton));
-        if ( HortInfil == NULL ) ErrorCode = ERR_MEMORY;
-        break;
-    case GREEN_AMPT:
-    case MOD_GREEN_AMPT:
-        GAInfil = (TGrnAmpt *) calloc(subcatchCount, sizeof(TGrnAmpt));
-        if ( GAInfil == NULL ) ErrorCode = ERR_MEMORY;
-        break;
-    case CURVE_NUMBER:
-        CNInfil = (TCurveNum *) calloc(subcatchCount, sizeof(TCurveNum));
-        if ( CNInfil == NULL ) ErrorCode = ERR_MEMORY;
-        break;
-    default: ErrorCode = ERR_MEMORY;
+        ErrorCode = ERR_MEMORY;
+        return;
+    }
+    InfilBlockSize = InfilArrayCount[model] * subcatchCount + 1;
+    InfilBlock = (double *) calloc(InfilBlockSize, sizeof(double));
+    if ( InfilBlock == NULL )
+    {
+        ErrorCode = ERR_MEMORY;
+        return;
     }
-    InfilFactor = 1.0;                                                         //(5.1.013)
+    setArrays(model, subcatchCount);
+}
+
+//=============================================================================
+
+void infil_clone(int subcatchCount)
+//
+//  Purpose: replaces the infiltration arrays shared with a base project
+//           with private copies.
+//  Input:   subcatchCount = number of subcatchments
+//  Output:  none
+//
+{
+    if ( InfilBlock == NULL ) return;
+    InfilBlock = (double *) memdup(InfilBlock,
+                                   InfilBlockSize * sizeof(double));
+    if ( InfilBlock == NULL ) ErrorCode = ERR_MEMORY;
+    else setArrays(InfilModel, subcatchCount);
+}
+
+//=============================================================================
+
+void infil_snapshot(struct TSnapshot* snap, int subcatchCount)
+//
+//  Purpose: adds the state of the infiltration arrays to a snapshot.
+//  Input:   snap = snapshot being built
+//           subcatchCount = number of subcatchments
+//  Output:  none
+//
+{
+    snapshot_addBlock(snap, InfilBlock, InfilBlockSize * sizeof(double));
 }
 
 //=============================================================================
 
 void infil_delete()
 //
-//  Purpose: deletes infiltration objects associated with subcatchments
+//  Purpose: deletes infiltration arrays associated with subcatchments
 //  Input:   none
 //  Output:  none
 //
 {
-    FREE(HortInfil);
-    FREE(GAInfil);
-    FREE(CNInfil);
+    FREE(InfilBlock);
+    InfilBlockSize = 0;
+    memset(&HortInfil, 0, sizeof(THortonArrays));
+    memset(&GAInfil, 0, sizeof(TGrnAmptArrays));
+    memset(&CNInfil, 0, sizeof(TCurveNumArrays));
+}
+
+//=============================================================================
+
+void setArrays(int model, int n)
+//
+//  Input:   model = infiltration method code
+//           n = number of subcatchments
+//  Output:  none
+//  Purpose: points the arrays of the infiltration method's variables to
+//           consecutive parts of the memory block that holds them.
+//
+{
+    double* p = InfilBlock;
+
+    switch (model)
+    {
+    case HORTON:
+    case MOD_HORTON:
+        HortInfil.f0 = p;       p += n;
+        HortInfil.fmin = p;     p += n;
+        HortInfil.Fmax = p;     p += n;
+        HortInfil.decay = p;    p += n;
+        HortInfil.regen = p;    p += n;
+        HortInfil.tp = p;       p += n;
+        HortInfil.Fe = p;
+        break;
+    case GREEN_AMPT:
+    case MOD_GREEN_AMPT:
+        GAInfil.S = p;          p += n;
+        GAInfil.Ks = p;         p += n;
+        GAInfil.IMDmax = p;     p += n;
+        GAInfil.IMD = p;        p += n;
+        GAInfil.F = p;          p += n;
+        GAInfil.Fu = p;         p += n;
+        GAInfil.Lu = p;         p += n;
+        GAInfil.T = p;          p += n;
+        GAInfil.Sat = p;
+        break;
+    case CURVE_NUMBER:
+        CNInfil.Smax = p;       p += n;
+        CNInfil.regen = p;      p += n;
+        CNInfil.Tmax = p;       p += n;
+        CNInfil.S = p;          p += n;
+        CNInfil.F = p;          p += n;
+        CNInfil.P = p;          p += n;
+        CNInfil.T = p;          p += n;
+        CNInfil.Se = p;         p += n;
+        CNInfil.f = p;
+        break;
+    }
 }
 
 //=============================================================================
@@ -188,13 +315,13 @@ int infil_readParams(int m, char* tok[], int ntoks)
     switch (m)
     {
       case HORTON:
-      case MOD_HORTON:   status = horton_setParams(&HortInfil[j], x);
+      case MOD_HORTON:   status = horton_setParams(j, x);
                          break;
       case GREEN_AMPT:
       case MOD_GREEN_AMPT:
-                         status = grnampt_setParams(&GAInfil[j], x);
+                         status = grnampt_setSubcatchParams(j, x);
                          break;
-      case CURVE_NUMBER: status = curvenum_setParams(&CNInfil[j], x);
+      case CURVE_NUMBER: status = curvenum_setParams(j, x);
                          break;
       default:           status = TRUE;
     }
@@ -215,11 +342,11 @@ void infil_initState(int j, int m)
     switch (m)
     {
       case HORTON:
-      case MOD_HORTON:   horton_initState(&HortInfil[j]);   break;
+      case MOD_HORTON:   horton_initState(j);               break;
       case GREEN_AMPT:
       case MOD_GREEN_AMPT:
-                         grnampt_initState(&GAInfil[j]);    break;
-      case CURVE_NUMBER: curvenum_initState(&CNInfil[j]);   break;
+                         grnampt_initSubcatchState(j);      break;
+      case CURVE_NUMBER: curvenum_initState(j);             break;
     }
 }
 
@@ -236,11 +363,11 @@ void infil_getState(int j, int m, double x[])
     switch (m)
     {
       case HORTON:
-      case MOD_HORTON:   horton_getState(&HortInfil[j], x); break;
+      case MOD_HORTON:   horton_getState(j, x);             break;
       case GREEN_AMPT:
       case MOD_GREEN_AMPT:
-                         grnampt_getState(&GAInfil[j],x);   break;
-      case CURVE_NUMBER: curvenum_getState(&CNInfil[j], x); break;
+                         grnampt_getState(j, x);            break;
+      case CURVE_NUMBER: curvenum_getState(j, x);           break;
     }
 }
 
@@ -257,11 +384,11 @@ void infil_setState(int j, int m, double x[])
     switch (m)
     {
       case HORTON:
-      case MOD_HORTON:   horton_setState(&HortInfil[j], x); break;
+      case MOD_HORTON:   horton_setState(j, x);             break;
       case GREEN_AMPT:
       case MOD_GREEN_AMPT:
-                         grnampt_setState(&GAInfil[j],x);   break;
-      case CURVE_NUMBER: curvenum_setState(&CNInfil[j], x); break;
+                         grnampt_setState(j, x);            break;
+      case CURVE_NUMBER: curvenum_setState(j, x);           break;
     }
 }
 
@@ -269,17 +396,19 @@ void infil_setState(int j, int m, double x[])
 
 ////  New function added for release 5.1.013.  ////                            //(5.1.013)
 
-void infil_setInfilFactor(int j)
+double infil_getInfilFactor(int j)
 //
-//  Input:   j = subcatchment index
-//  Output:  none
-//  Purpose: assigns a value to the infiltration adjustment factor.
+//  Input:   j = subcatchment index (or -1 for the global factor)
+//  Output:  returns a hydraulic conductivity adjustment factor
+//  Purpose: finds the infiltration adjustment factor that applies to a
+//           subcatchment at the current runoff time.
 {
     int m;
     int p;
+    double factor;
 
-    // ... set factor to the global conductivity adjustment factor
-    InfilFactor = Adjust.hydconFactor;
+    // ... start with the global conductivity adjustment factor
+    factor = Adjust.hydconFactor;
 
     // ... override global factor with subcatchment's adjustment if assigned 
     if (j >= 0)
@@ -288,53 +417,74 @@ void infil_setInfilFactor(int j)
         if (p >= 0 && Pattern[p].type == MONTHLY_PATTERN)
         {
             m = datetime_monthOfYear(getDateTime(OldRunoffTime)) - 1;
-            InfilFactor = Pattern[p].factor[m];
+            factor = Pattern[p].factor[m];
         }
     }
+    return factor;
 }
 
 //=============================================================================
 
-double infil_getInfil(int j, int m, double tstep, double rainfall,
-                      double runon, double depth)
+void infil_getInfilBatch(TInfilBatch* batch, int m, double tstep)
 //
-//  Input:   j = subcatchment index
+//  Input:   batch = range of subcatchments with their rainfall, runon,
+//                   ponded depth & conductivity adjustment factor
 //           m = infiltration method code
 //           tstep = runoff time step (sec)
-//           rainfall = rainfall rate (ft/sec)
-//           runon = runon rate from other sub-areas or subcatchments (ft/sec)
-//           depth = depth of surface water on subcatchment (ft)
-//  Output:  returns infiltration rate (ft/sec)
-//  Purpose: computes infiltration rate depending on infiltration method.
+//  Output:  sets batch->infil to each subcatchment's infiltration rate
+//           (ft/sec)
+//  Purpose: computes infiltration rates for a batch of subcatchments.
 //
+//  Lane k of the batch is subcatchment batch->first + k. Its parameters
+//  and state are read from and updated in the infiltration arrays in
+//  place, in loops the compiler can vectorize; lanes that are not active
+//  are left unchanged and have no infiltration. Branches are turned into
+//  lane states so that costly steps (exponentials, logarithms and
+//  Newton-Raphson iterations) are only taken by the lanes that need them,
+//  one lane at a time, so that each lane's result does not depend on the
+//  other lanes of the batch.
 {
+    int k;
+
     switch (m)
     {
-      case HORTON:
-          return horton_getInfil(&HortInfil[j], tstep, rainfall+runon, depth);
-
-      case MOD_HORTON:
-          return modHorton_getInfil(&HortInfil[j], tstep, rainfall+runon,
-                                    depth);
-
+      case HORTON:       horton_getInfilBatch(batch, tstep);     break;
+      case MOD_HORTON:   modHorton_getInfilBatch(batch, tstep);  break;
       case GREEN_AMPT:
       case MOD_GREEN_AMPT:
-        return grnampt_getInfil(&GAInfil[j], tstep, rainfall+runon, depth, m);
-
-      case CURVE_NUMBER:
-        depth += runon / tstep;
-        return curvenum_getInfil(&CNInfil[j], tstep, rainfall, depth);
-
+                         grnampt_getInfilBatch(batch, tstep, m); break;
+      case CURVE_NUMBER: curvenum_getInfilBatch(batch, tstep);   break;
       default:
-        return 0.0;
+        for (k = 0; k < batch->count; k++) batch->infil[k] = 0.0;
     }
 }
 
 //=============================================================================
 
-int horton_setParams(THorton *infil, double p[])
+void getAvailableWater(TInfilBatch* b, double dt[], double fa[])
+//
+//  Input:   b = batch of subcatchments & their infiltration inputs
+//           dt[] = runoff time step of each lane (sec)
+//  Output:  fa[] = rate at which water is available to infiltrate (ft/sec)
+//  Purpose: finds the water available for infiltration in each lane of a
+//           Horton batch.
+//
+{
+    int k;
+#ifdef __FAST_MATH__
+    for (k = 0; k < b->count; k++) fa[k] = b->runon[k] + b->depth[k] / dt[k];
+    for (k = 0; k < b->count; k++) fa[k] = b->rainfall[k] + fa[k];
+#else
+    for (k = 0; k < b->count; k++)
+        fa[k] = b->rainfall[k] + b->runon[k] + b->depth[k] / dt[k];
+#endif
+}
+
+//=============================================================================
+
+int horton_setParams(int j, double p[])
 //
-//  Input:   infil = ptr. to Horton infiltration object
+//  Input:   j = subcatchment index
 //           p[] = array of parameter values
 //  Output:  returns TRUE if parameters are valid, FALSE otherwise
 //  Purpose: assigns Horton infiltration parameters to a subcatchment.
@@ -344,224 +494,328 @@ int horton_setParams(THorton *infil, double p[])
     for (k=0; k<5; k++) if ( p[k] < 0.0 ) return FALSE;
 
     // --- max. & min. infil rates (ft/sec)
-    infil->f0   = p[0] / UCF(RAINFALL);
-    infil->fmin = p[1] / UCF(RAINFALL);
+    HortInfil.f0[j]   = p[0] / UCF(RAINFALL);
+    HortInfil.fmin[j] = p[1] / UCF(RAINFALL);
 
     // --- convert decay const. to 1/sec
-    infil->decay = p[2] / 3600.;
+    HortInfil.decay[j] = p[2] / 3600.;
 
     // --- convert drying time (days) to a regeneration const. (1/sec)
     //     assuming that former is time to reach 98% dry along an
     //     exponential drying curve
     if (p[3] == 0.0 ) p[3] = TINY;
-    infil->regen = -log(1.0-0.98) / p[3] / SECperDAY;
+    HortInfil.regen[j] = -log(1.0-0.98) / p[3] / SECperDAY;
 
     // --- optional max. infil. capacity (ft) (p[4] = 0 if no value supplied)
-    infil->Fmax = p[4] / UCF(RAINDEPTH);
-    if ( infil->f0 < infil->fmin ) return FALSE;
+    HortInfil.Fmax[j] = p[4] / UCF(RAINDEPTH);
+    if ( HortInfil.f0[j] < HortInfil.fmin[j] ) return FALSE;
     return TRUE;
 }
 
 //=============================================================================
 
-void horton_initState(THorton *infil)
+void horton_initState(int j)
 //
-//  Input:   infil = ptr. to Horton infiltration object
+//  Input:   j = subcatchment index
 //  Output:  none
 //  Purpose: initializes time on Horton infiltration curve for a subcatchment.
 //
 {
-    infil->tp = 0.0;
-    infil->Fe = 0.0;
+    HortInfil.tp[j] = 0.0;
+    HortInfil.Fe[j] = 0.0;
 }
 
 //=============================================================================
 
-void horton_getState(THorton *infil, double x[])
+void horton_getState(int j, double x[])
 {
-    x[0] = infil->tp;
-    x[1] = infil->Fe;
+    x[0] = HortInfil.tp[j];
+    x[1] = HortInfil.Fe[j];
 }
 
-void horton_setState(THorton *infil, double x[])
+void horton_setState(int j, double x[])
 {
-    infil->tp = x[0];
-    infil->Fe = x[1];
+    HortInfil.tp[j] = x[0];
+    HortInfil.Fe[j] = x[1];
 }
 
 //=============================================================================
 
-double horton_getInfil(THorton *infil, double tstep, double irate, double depth)
+void horton_getInfilBatch(TInfilBatch* b, double tstep)
 //
-//  Input:   infil = ptr. to Horton infiltration object
-//           tstep =  runoff time step (sec),
-//           irate = net "rainfall" rate (ft/sec),
-//                 = rainfall + snowmelt + runon - evaporation
-//           depth = depth of ponded water (ft).
-//  Output:  returns infiltration rate (ft/sec)
-//  Purpose: computes Horton infiltration for a subcatchment.
-//
-{
-    // --- assign local variables
-    int    iter;
-    double fa, fp = 0.0;
-    double Fp, F1, t1, tlim, ex, kt;
-    double FF, FF1, r;
-    double f0   = infil->f0 * InfilFactor;                                     //(5.1.013)
-    double fmin = infil->fmin * InfilFactor;                                   //(5.1.013)
-    double Fmax = infil->Fmax;
-    double tp   = infil->tp;
-    double df   = f0 - fmin;
-    double kd   = infil->decay;
-    double kr   = infil->regen * Evap.recoveryFactor;
-
-    // --- special cases of no infil. or constant infil
-    if ( df < 0.0 || kd < 0.0 || kr < 0.0 ) return 0.0;
-    if ( df == 0.0 || kd == 0.0 )
-    {
-        fp = f0;
-        fa = irate + depth / tstep;
-        if ( fp > fa ) fp = fa;
-        return MAX(0.0, fp);
-    }
-
-    // --- compute water available for infiltration
-    fa = irate + depth / tstep;
-
-    // --- case where there is water to infiltrate
-    if ( fa > ZERO )
-    {
-        // --- compute average infil. rate over time step
-        t1 = tp + tstep;         // future cumul. time
-        tlim = 16.0 / kd;        // for tp >= tlim, f = fmin
-        if ( tp >= tlim )
+//  Input:   b = batch of subcatchments & their infiltration inputs
+//           tstep = runoff time step (sec)
+//  Output:  sets b->infil to each subcatchment's infiltration rate (ft/sec)
+//  Purpose: computes Horton infiltration for a batch of subcatchments.
+//
+//  Each lane's infiltration rate is its average over the time step along
+//  the Horton curve, limited to the water available to it. Its time on
+//  the curve (tp) moves ahead by the time step or, when the rate is
+//  limited by the available water, to where the cumulative infiltration
+//  on the curve matches the actual one. When no water is available the
+//  infiltration capacity regenerates along an exponential drying curve.
+{
+    int    i, k, iter;
+    int    n = b->count;
+    int    m = 0;                      // number of lanes in list
+    int    count;
+    int    list[MAXINFILBATCH];        // lanes still being iterated
+    char   state[MAXINFILBATCH];       // branch taken (HortonLaneType)
+    char   solve[MAXINFILBATCH];       // TRUE if tp must be solved for
+    double f0[MAXINFILBATCH], fmin[MAXINFILBATCH], Fmax[MAXINFILBATCH];
+    double df[MAXINFILBATCH], kd[MAXINFILBATCH], kr[MAXINFILBATCH];
+    double tp[MAXINFILBATCH], Fe[MAXINFILBATCH], fa[MAXINFILBATCH];
+    double fp[MAXINFILBATCH], t1[MAXINFILBATCH], tlim[MAXINFILBATCH];
+    double Fp[MAXINFILBATCH], F1[MAXINFILBATCH], dF[MAXINFILBATCH];
+    double dt[MAXINFILBATCH];
+    double ex, kt, FF, FF1, r;
+    double rf = Evap.recoveryFactor;
+    int    j = b->first;               // subcatchment of first lane
+
+    // --- copy parameters & state of each lane
+    for (k = 0; k < n; k++)
+    {
+        f0[k]   = HortInfil.f0[j+k] * b->factor[k];
+        fmin[k] = HortInfil.fmin[j+k] * b->factor[k];
+        Fmax[k] = HortInfil.Fmax[j+k];
+        kd[k]   = HortInfil.decay[j+k];
+        kr[k]   = HortInfil.regen[j+k] * rf;
+        tp[k]   = HortInfil.tp[j+k];
+        Fe[k]   = HortInfil.Fe[j+k];
+        dt[k]   = tstep;
+    }
+
+    // --- rates are found by dividing by dt[] rather than tstep, since
+    //     the compiler would replace division by a loop invariant with
+    //     multiplication by its reciprocal; under fast-math (-Ofast),
+    //     which lets the compiler regroup arithmetic, terms are grouped
+    //     the way the scalar functions are compiled to (using separate
+    //     loops where needed). This keeps the results identical to those
+    //     of infiltrating one subcatchment at a time.
+    getAvailableWater(b, dt, fa);
+
+    // --- find branch taken by each lane
+    #pragma omp simd
+    for (k = 0; k < n; k++)
+    {
+        df[k] = f0[k] - fmin[k];
+        t1[k] = tp[k] + tstep;
+        tlim[k] = 16.0 / kd[k];
+        fp[k] = 0.0;
+        if ( !b->active[k] ) state[k] = HORTON_NONE;
+        else if ( df[k] < 0.0 || kd[k] < 0.0 || kr[k] < 0.0 )
+            state[k] = HORTON_NONE;
+        else if ( df[k] == 0.0 || kd[k] == 0.0 ) state[k] = HORTON_CONST;
+        else if ( fa[k] > ZERO ) state[k] = HORTON_WET;
+        else state[k] = HORTON_DRY;
+    }
+
+    // --- cumulative infiltration at start & end of time step
+    //     (exp() & log() are evaluated for lists of lanes one lane at a
+    //     time, here & below, since their vector versions do not return
+    //     the same results as the scalar functions)
+    for (k = 0; k < n; k++)
+    {
+        if ( state[k] != HORTON_WET ) continue;
+        if ( tp[k] >= tlim[k] )
         {
-            Fp = fmin * tp + df / kd;
-            F1 = Fp + fmin * tstep;
+            Fp[k] = fmin[k] * tp[k] + df[k] / kd[k];
+#ifdef __FAST_MATH__
+            dF[k] = fmin[k] * tstep;
+            F1[k] = Fp[k] + dF[k];
+#else
+            F1[k] = Fp[k] + fmin[k] * tstep;
+            dF[k] = F1[k] - Fp[k];
+#endif
         }
-        else
+        else list[m++] = k;
+    }
+    #pragma omp simd simdlen(1)
+    for (i = 0; i < m; i++)
+    {
+        k = list[i];
+        Fp[k] = fmin[k] * tp[k] +
+                df[k] / kd[k] * (1.0 - exp(-kd[k] * tp[k]));
+        F1[k] = fmin[k] * t1[k] +
+                df[k] / kd[k] * (1.0 - exp(-kd[k] * t1[k]));
+        dF[k] = F1[k] - Fp[k];
+    }
+
+    // --- infil. rate limited to available water; lanes whose rate is
+    //     limited on the curved part of the curve must solve for tp
+    #pragma omp simd
+    for (k = 0; k < n; k++)
+    {
+        solve[k] = FALSE;
+        if ( state[k] == HORTON_CONST )
         {
-            Fp = fmin * tp + df / kd * (1.0 - exp(-kd * tp));
-            F1 = fmin * t1 + df / kd * (1.0 - exp(-kd * t1));
+            fp[k] = f0[k];
+            if ( fp[k] > fa[k] ) fp[k] = fa[k];
+            fp[k] = MAX(0.0, fp[k]);
         }
-        fp = (F1 - Fp) / tstep;
-        fp = MAX(fp, fmin);
-
-        // --- limit infil rate to available infil
-        if ( fp > fa ) fp = fa;
-
-        // --- if fp on flat portion of curve then increase tp by tstep
-        if ( t1 > tlim ) tp = t1;
-
-        // --- if infil < available capacity then increase tp by tstep
-        else if ( fp < fa ) tp = t1;
-
-        // --- if infil limited by available capacity then
-        //     solve F(tp) - F1 = 0 using Newton-Raphson method
-        else
+        else if ( state[k] == HORTON_WET )
         {
-            F1 = Fp + fp * tstep;
-            tp = tp + tstep / 2.0;
-            for ( iter=1; iter<=20; iter++ )
+            fp[k] = dF[k] / dt[k];
+            fp[k] = MAX(fp[k], fmin[k]);
+            if ( fp[k] > fa[k] ) fp[k] = fa[k];
+            if ( t1[k] > tlim[k] || fp[k] < fa[k] ) tp[k] = t1[k];
+            else
             {
-                kt = MIN( 60.0, kd*tp );
-                ex = exp(-kt);
-                FF = fmin * tp + df / kd * (1.0 - ex) - F1;
-                FF1 = fmin + df * ex;
-                r = FF / FF1;
-                tp = tp - r;
-                if ( fabs(r) <= 0.001 * tstep ) break;
+                F1[k] = Fp[k] + fp[k] * tstep;
+                tp[k] = tp[k] + tstep / 2.0;
+                solve[k] = TRUE;
             }
         }
+    }
+    m = 0;
+    for (k = 0; k < n; k++) if ( solve[k] ) list[m++] = k;
 
-        // --- limit cumulative infiltration to Fmax
-        if ( Fmax > 0.0 )
+    // --- solve F(tp) - F1 = 0 using Newton-Raphson method, dropping
+    //     each lane from the list once it has converged
+    for ( iter=1; iter<=20 && m > 0; iter++ )
+    {
+        count = m;
+        m = 0;
+        for (i = 0; i < count; i++)
         {
-            if ( infil->Fe + fp * tstep > Fmax )
-                fp = (Fmax - infil->Fe) / tstep;
-            fp = MAX(fp, 0.0);
-            infil->Fe += fp * tstep;
+            k = list[i];
+            kt = MIN( 60.0, kd[k]*tp[k] );
+            ex = exp(-kt);
+            FF = fmin[k] * tp[k] + df[k] / kd[k] * (1.0 - ex) - F1[k];
+            FF1 = fmin[k] + df[k] * ex;
+            r = FF / FF1;
+            tp[k] = tp[k] - r;
+            if ( !(fabs(r) <= 0.001 * tstep) ) list[m++] = k;
         }
     }
 
-    // --- case where infil. capacity is regenerating; update tp.
-    else if (kr > 0.0)
+    // --- limit cumulative infiltration to Fmax
+    #pragma omp simd
+    for (k = 0; k < n; k++)
     {
-        r = exp(-kr * tstep);
-        tp = 1.0 - exp(-kd * tp);
-        tp = -log(1.0 - r*tp) / kd;
+        if ( state[k] == HORTON_WET && Fmax[k] > 0.0 )
+        {
+            if ( Fe[k] + fp[k] * tstep > Fmax[k] )
+                fp[k] = (Fmax[k] - Fe[k]) / dt[k];
+            fp[k] = MAX(fp[k], 0.0);
+            Fe[k] += fp[k] * tstep;
+        }
+        b->infil[k] = fp[k];
+    }
 
-        // reduction in cumulative infiltration
-        if ( Fmax > 0.0 )
+    // --- regenerate infil. capacity of dry lanes, reducing their
+    //     cumulative infiltration
+    m = 0;
+    for (k = 0; k < n; k++)
+    {
+        if ( state[k] == HORTON_DRY && kr[k] > 0.0 ) list[m++] = k;
+    }
+    #pragma omp simd simdlen(1)
+    for (i = 0; i < m; i++)
+    {
+        k = list[i];
+        r = exp(-kr[k] * tstep);
+        tp[k] = 1.0 - exp(-kd[k] * tp[k]);
+        tp[k] = -log(1.0 - r*tp[k]) / kd[k];
+        if ( Fmax[k] > 0.0 )
         {
-            infil->Fe = fmin*tp + (df/kd)*(1.0 - exp(-kd*tp));
+            Fe[k] = fmin[k]*tp[k] + (df[k]/kd[k])*(1.0 - exp(-kd[k]*tp[k]));
         }
     }
-    infil->tp = tp;
-    return fp;
+
+    // --- copy back new state
+    for (k = 0; k < n; k++)
+    {
+        HortInfil.tp[j+k] = tp[k];
+        HortInfil.Fe[j+k] = Fe[k];
+    }
 }
 
 //=============================================================================
 
-double modHorton_getInfil(THorton *infil, double tstep, double irate,
-                          double depth)
+void modHorton_getInfilBatch(TInfilBatch* b, double tstep)
 //
-//  Input:   infil = ptr. to Horton infiltration object
-//           tstep =  runoff time step (sec),
-//           irate = net "rainfall" rate (ft/sec),
-//                 = rainfall + snowmelt + runon
-//           depth = depth of ponded water (ft).
-//  Output:  returns infiltration rate (ft/sec)
-//  Purpose: computes modified Horton infiltration for a subcatchment.
+//  Input:   b = batch of subcatchments & their infiltration inputs
+//           tstep = runoff time step (sec)
+//  Output:  sets b->infil to each subcatchment's infiltration rate (ft/sec)
+//  Purpose: computes modified Horton infiltration for a batch of
+//           subcatchments.
 //
+//  The potential infiltration rate of each lane decreases with its
+//  cumulative infiltration in excess of the minimum rate (Fe). When no
+//  water is available Fe decays exponentially.
 {
-    // --- assign local variables
-    double f  = 0.0;
-    double fp, fa;
-    double f0 = infil->f0 * InfilFactor;                                       //(5.1.013)
-    double fmin = infil->fmin * InfilFactor;                                   //(5.1.013)
-    double df = f0 - fmin;
-    double kd = infil->decay;
-    double kr = infil->regen * Evap.recoveryFactor;
-
-    // --- special cases of no or constant infiltration
-    if ( df < 0.0 || kd < 0.0 || kr < 0.0 ) return 0.0;
-    if ( df == 0.0 || kd == 0.0 )
+    int    i, k;
+    int    n = b->count;
+    int    m = 0;                      // number of lanes in list
+    int    list[MAXINFILBATCH];        // dry lanes
+    char   dry[MAXINFILBATCH];         // TRUE if infil. capacity regenerates
+    double f0[MAXINFILBATCH], fmin[MAXINFILBATCH], Fmax[MAXINFILBATCH];
+    double kd[MAXINFILBATCH], kr[MAXINFILBATCH], Fe[MAXINFILBATCH];
+    double fa[MAXINFILBATCH], dt[MAXINFILBATCH];
+    double df, fp;
+    double rf = Evap.recoveryFactor;
+    int    j = b->first;               // subcatchment of first lane
+
+    // --- copy parameters & state of each lane
+    for (k = 0; k < n; k++)
     {
-        fp = f0;
-        fa = irate + depth / tstep;
-        if ( fp > fa ) fp = fa;
-        return MAX(0.0, fp);
+        f0[k]   = HortInfil.f0[j+k] * b->factor[k];
+        fmin[k] = HortInfil.fmin[j+k] * b->factor[k];
+        Fmax[k] = HortInfil.Fmax[j+k];
+        kd[k]   = HortInfil.decay[j+k];
+        kr[k]   = HortInfil.regen[j+k] * rf;
+        Fe[k]   = HortInfil.Fe[j+k];
+        dt[k]   = tstep;
     }
 
-    // --- compute water available for infiltration
-    fa = irate + depth / tstep;
+    // --- water available for infiltration (see horton_getInfilBatch())
+    getAvailableWater(b, dt, fa);
 
-    // --- case where there is water to infiltrate
-    if ( fa > ZERO )
+    // --- find infiltration of lanes with water to infiltrate
+    #pragma omp simd private(df, fp)
+    for (k = 0; k < n; k++)
     {
-        // --- saturated condition
-        if ( infil->Fmax > 0.0 && infil->Fe >= infil->Fmax ) return 0.0;
-
-        // --- potential infiltration
-        fp = f0 - kd * infil->Fe;
-        fp = MAX(fp, fmin);
-
-        // --- actual infiltration
-        f = MIN(fa, fp);
+        b->infil[k] = 0.0;
+        dry[k] = FALSE;
+        if ( !b->active[k] ) continue;
+        df = f0[k] - fmin[k];
+
+        // --- special cases of no or constant infiltration
+        if ( df < 0.0 || kd[k] < 0.0 || kr[k] < 0.0 ) continue;
+        if ( df == 0.0 || kd[k] == 0.0 )
+        {
+            fp = f0[k];
+            if ( fp > fa[k] ) fp = fa[k];
+            b->infil[k] = MAX(0.0, fp);
+        }
 
-        // --- new cumulative infiltration minus seepage
-        infil->Fe += MAX((f - fmin), 0.0) * tstep;
-        if ( infil->Fmax > 0.0 ) infil->Fe = MAX(infil->Fe, infil->Fmax);
+        // --- infiltration & new cumulative infiltration minus seepage
+        else if ( fa[k] > ZERO )
+        {
+            if ( Fmax[k] > 0.0 && Fe[k] >= Fmax[k] ) continue;
+            fp = f0[k] - kd[k] * Fe[k];
+            fp = MAX(fp, fmin[k]);
+            b->infil[k] = MIN(fa[k], fp);
+            Fe[k] += MAX((b->infil[k] - fmin[k]), 0.0) * tstep;
+            if ( Fmax[k] > 0.0 ) Fe[k] = MAX(Fe[k], Fmax[k]);
+        }
+        else if ( kr[k] > 0.0 ) dry[k] = TRUE;
     }
 
-    // --- reduce cumulative infiltration for dry condition
-    else if (kr > 0.0)
+    // --- reduce cumulative infiltration of dry lanes
+    //     (one lane at a time, see horton_getInfilBatch())
+    for (k = 0; k < n; k++) if ( dry[k] ) list[m++] = k;
+    #pragma omp simd simdlen(1)
+    for (i = 0; i < m; i++)
     {
-        infil->Fe *= exp(-kr * tstep);
-        infil->Fe = MAX(infil->Fe, 0.0);
+        k = list[i];
+        Fe[k] *= exp(-kr[k] * tstep);
+        Fe[k] = MAX(Fe[k], 0.0);
     }
-    return f;
+
+    // --- copy back new state
+    for (k = 0; k < n; k++) HortInfil.Fe[j+k] = Fe[k];
 }
 
 //=============================================================================
@@ -604,28 +858,66 @@ void grnampt_initState(TGrnAmpt *infil)
     infil->T = 0.0;
 }
 
-void grnampt_getState(TGrnAmpt *infil, double x[])
+//=============================================================================
+
+int grnampt_setSubcatchParams(int j, double p[])
+//
+//  Input:   j = subcatchment index
+//           p[] = array of parameter values
+//  Output:  returns TRUE if parameters are valid, FALSE otherwise
+//  Purpose: assigns Green-Ampt infiltration parameters to a subcatchment.
+//
+{
+    TGrnAmpt infil;
+
+    if ( !grnampt_setParams(&infil, p) ) return FALSE;
+    GAInfil.S[j]      = infil.S;
+    GAInfil.Ks[j]     = infil.Ks;
+    GAInfil.IMDmax[j] = infil.IMDmax;
+    GAInfil.Lu[j]     = infil.Lu;
+    return TRUE;
+}
+
+//=============================================================================
+
+void grnampt_initSubcatchState(int j)
+//
+//  Input:   j = subcatchment index
+//  Output:  none
+//  Purpose: initializes state of Green-Ampt infiltration for a subcatchment.
+//
+{
+    GAInfil.IMD[j] = GAInfil.IMDmax[j];
+    GAInfil.Fu[j] = 0.0;
+    GAInfil.F[j] = 0.0;
+    GAInfil.Sat[j] = FALSE;
+    GAInfil.T[j] = 0.0;
+}
+
+//=============================================================================
+
+void grnampt_getState(int j, double x[])
 {
-    x[0] = infil->IMD;
-    x[1] = infil->F;
-    x[2] = infil->Fu;
-    x[3] = infil->Sat;
-    x[4] = infil->T;
+    x[0] = GAInfil.IMD[j];
+    x[1] = GAInfil.F[j];
+    x[2] = GAInfil.Fu[j];
+    x[3] = GAInfil.Sat[j];
+    x[4] = GAInfil.T[j];
 }
 
-void grnampt_setState(TGrnAmpt *infil, double x[])
+void grnampt_setState(int j, double x[])
 {
-    infil->IMD = x[0];
-    infil->F   = x[1];
-    infil->Fu  = x[2];
-    infil->Sat = (char)x[3];
-    infil->T   = x[4];
+    GAInfil.IMD[j] = x[0];
+    GAInfil.F[j]   = x[1];
+    GAInfil.Fu[j]  = x[2];
+    GAInfil.Sat[j] = (char)x[3];
+    GAInfil.T[j]   = x[4];
 }
 
 //=============================================================================
 
 double grnampt_getInfil(TGrnAmpt *infil, double tstep, double irate,
-    double depth, int modelType) 
+    double depth, int modelType, double factor)
 //
 //  Input:   infil = ptr. to Green-Ampt infiltration object
 //           tstep =  time step (sec),
@@ -634,26 +926,26 @@ double grnampt_getInfil(TGrnAmpt *infil, double tstep, double irate,
 //                   does not include ponded water (added on below)
 //           depth = depth of ponded water (ft)
 //           modelType = either GREEN_AMPT or MOD_GREEN_AMPT 
+//           factor = hydraulic conductivity adjustment factor
 //  Output:  returns infiltration rate (ft/sec)
 //  Purpose: computes Green-Ampt infiltration for a subcatchment
 //           or a storage node.
 //
 {
-    // --- find saturated upper soil zone water volume
-    Fumax = infil->IMDmax * infil->Lu * sqrt(InfilFactor);                     //(5.1.013)
-
     // --- reduce time until next event
     infil->T -= tstep;
 
     // --- use different procedures depending on upper soil zone saturation
-    if ( infil->Sat ) return grnampt_getSatInfil(infil, tstep, irate, depth);
-    else return grnampt_getUnsatInfil(infil, tstep, irate, depth, modelType);
+    if ( infil->Sat )
+        return grnampt_getSatInfil(infil, tstep, irate, depth, factor);
+    else return grnampt_getUnsatInfil(infil, tstep, irate, depth, modelType,
+                                      factor);
 }
 
 //=============================================================================
 
 double grnampt_getUnsatInfil(TGrnAmpt *infil, double tstep, double irate,
-    double depth, int modelType)
+    double depth, int modelType, double factor)
 //
 //  Input:   infil = ptr. to Green-Ampt infiltration object
 //           tstep =  runoff time step (sec),
@@ -662,14 +954,19 @@ double grnampt_getUnsatInfil(TGrnAmpt *infil, double tstep, double irate,
 //                   does not include ponded water (added on below)
 //           depth = depth of ponded water (ft)
 //           modelType = either GREEN_AMPT or MOD_GREEN_AMPT
+//           factor = hydraulic conductivity adjustment factor
 //  Output:  returns infiltration rate (ft/sec)
 //  Purpose: computes Green-Ampt infiltration when upper soil zone is
 //           unsaturated.
 //
 {
     double ia, c1, F2, dF, Fs, kr, ts;
-    double ks = infil->Ks * InfilFactor;                                       //(5.1.013)
-    double lu = infil->Lu * sqrt(InfilFactor);                                 //(5.1.013)
+    double ks = infil->Ks * factor;                                            //(5.1.013)
+    double lu = infil->Lu * sqrt(factor);                                      //(5.1.013)
+    double fumax;                      // saturated upper zone volume (ft)
+
+    // --- find saturated upper soil zone water volume
+    fumax = infil->IMDmax * infil->Lu * sqrt(factor);
 
     // --- get available infiltration rate (rainfall + ponded water)
     ia = irate + depth / tstep;
@@ -680,7 +977,7 @@ double grnampt_getUnsatInfil(TGrnAmpt *infil, double tstep, double irate,
     {
         if ( infil->Fu <= 0.0 ) return 0.0;
         kr = lu / 90000.0 * Evap.recoveryFactor; 
-        dF = kr * Fumax * tstep;
+        dF = kr * fumax * tstep;
         infil->F -= dF;
         infil->Fu -= dF;
         if ( infil->Fu <= 0.0 )
@@ -694,7 +991,7 @@ double grnampt_getUnsatInfil(TGrnAmpt *infil, double tstep, double irate,
         // --- if new wet event begins then reset IMD & F
         if ( infil->T <= 0.0 )
         {
-            infil->IMD = (Fumax - infil->Fu) / lu; 
+            infil->IMD = (fumax - infil->Fu) / lu; 
             infil->F = 0.0;
         }
         return 0.0;
@@ -706,10 +1003,10 @@ double grnampt_getUnsatInfil(TGrnAmpt *infil, double tstep, double irate,
         dF = ia * tstep;
         infil->F += dF;
         infil->Fu += dF;
-        infil->Fu = MIN(infil->Fu, Fumax);
+        infil->Fu = MIN(infil->Fu, fumax);
         if ( modelType == GREEN_AMPT &&  infil->T <= 0.0 )
         {
-            infil->IMD = (Fumax - infil->Fu) / lu;
+            infil->IMD = (fumax - infil->Fu) / lu;
             infil->F = 0.0;
         }
         return ia;
@@ -725,7 +1022,7 @@ double grnampt_getUnsatInfil(TGrnAmpt *infil, double tstep, double irate,
     if ( infil->F > Fs )
     {
         infil->Sat = TRUE;
-        return grnampt_getSatInfil(infil, tstep, irate, depth);
+        return grnampt_getSatInfil(infil, tstep, irate, depth, factor);
     }
 
     // --- surface layer remains unsaturated
@@ -734,7 +1031,7 @@ double grnampt_getUnsatInfil(TGrnAmpt *infil, double tstep, double irate,
         dF = ia * tstep;
         infil->F += dF;
         infil->Fu += dF;
-        infil->Fu = MIN(infil->Fu, Fumax);
+        infil->Fu = MIN(infil->Fu, fumax);
         return ia;
     }
 
@@ -752,7 +1049,7 @@ double grnampt_getUnsatInfil(TGrnAmpt *infil, double tstep, double irate,
     dF = F2 - infil->F;
     infil->F = F2;
     infil->Fu += dF;
-    infil->Fu = MIN(infil->Fu, Fumax);
+    infil->Fu = MIN(infil->Fu, fumax);
     infil->Sat = TRUE;
     return dF / tstep;
 }
@@ -760,7 +1057,7 @@ double grnampt_getUnsatInfil(TGrnAmpt *infil, double tstep, double irate,
 //=============================================================================
 
 double grnampt_getSatInfil(TGrnAmpt *infil, double tstep, double irate,
-    double depth)
+    double depth, double factor)
 //
 //  Input:   infil = ptr. to Green-Ampt infiltration object
 //           tstep =  runoff time step (sec),
@@ -768,14 +1065,19 @@ double grnampt_getSatInfil(TGrnAmpt *infil, double tstep, double irate,
 //                 = rainfall + snowmelt + runon,
 //                   does not include ponded water (added on below)
 //           depth = depth of ponded water (ft).
+//           factor = hydraulic conductivity adjustment factor
 //  Output:  returns infiltration rate (ft/sec)
 //  Purpose: computes Green-Ampt infiltration when upper soil zone is
 //           saturated.
 //
 {
     double ia, c1, dF, F2;
-    double ks = infil->Ks * InfilFactor;                                       //(5.1.013)
-    double lu = infil->Lu * sqrt(InfilFactor);                                 //(5.1.013)
+    double ks = infil->Ks * factor;                                            //(5.1.013)
+    double lu = infil->Lu * sqrt(factor);                                      //(5.1.013)
+    double fumax;                      // saturated upper zone volume (ft)
+
+    // --- find saturated upper soil zone water volume
+    fumax = infil->IMDmax * infil->Lu * sqrt(factor);
 
     // --- get available infiltration rate (rainfall + ponded water)
     ia = irate + depth / tstep;
@@ -799,12 +1101,249 @@ double grnampt_getSatInfil(TGrnAmpt *infil, double tstep, double irate,
     // --- update total infiltration and upper zone moisture deficit
     infil->F += dF;
     infil->Fu += dF;
-    infil->Fu = MIN(infil->Fu, Fumax);
+    infil->Fu = MIN(infil->Fu, fumax);
     return dF / tstep;
 }
 
 //=============================================================================
 
+void grnampt_getInfilBatch(TInfilBatch* b, double tstep, int modelType)
+//
+//  Input:   b = batch of subcatchments & their infiltration inputs
+//           tstep = runoff time step (sec)
+//           modelType = either GREEN_AMPT or MOD_GREEN_AMPT
+//  Output:  sets b->infil to each subcatchment's infiltration rate (ft/sec)
+//  Purpose: computes Green-Ampt infiltration for a batch of subcatchments
+//           in the same way as grnampt_getInfil().
+//
+//  Each lane is first assigned the branch of grnampt_getUnsatInfil() or
+//  grnampt_getSatInfil() that it takes, which then masks the updates made
+//  to it. Lanes whose surface is or becomes saturated solve the G-A
+//  equation together in grnampt_getF2Batch().
+{
+    int    i, k, m;
+    int    n = b->count;
+    int    list[MAXINFILBATCH];        // lanes solving the G-A equation
+    char   state[MAXINFILBATCH];       // branch taken (GrnAmptLaneType)
+    char   sat[MAXINFILBATCH];
+    double S[MAXINFILBATCH], ks[MAXINFILBATCH], lu[MAXINFILBATCH];
+    double fumax[MAXINFILBATCH], IMDmax[MAXINFILBATCH], IMD[MAXINFILBATCH];
+    double F[MAXINFILBATCH], Fu[MAXINFILBATCH], T[MAXINFILBATCH];
+    double ia[MAXINFILBATCH], Fs[MAXINFILBATCH], ts[MAXINFILBATCH];
+    double f1[MAXINFILBATCH], c1[MAXINFILBATCH], ks1[MAXINFILBATCH];
+    double ts1[MAXINFILBATCH], F2[MAXINFILBATCH], dt[MAXINFILBATCH];
+    double sf[MAXINFILBATCH], dFr[MAXINFILBATCH];
+#ifdef __FAST_MATH__
+    double Fd[MAXINFILBATCH];          // upper zone deficit before recovery
+#endif
+    double dF;
+    double rf = Evap.recoveryFactor;
+    int    j = b->first;               // subcatchment of first lane
+
+    // --- copy parameters & state of each lane
+    for (k = 0; k < n; k++)
+    {
+        S[k]      = GAInfil.S[j+k];
+        ks[k]     = GAInfil.Ks[j+k] * b->factor[k];
+        sf[k]     = sqrt(b->factor[k]);
+        lu[k]     = GAInfil.Lu[j+k] * sf[k];
+        fumax[k]  = GAInfil.IMDmax[j+k] * GAInfil.Lu[j+k] * sf[k];
+        IMDmax[k] = GAInfil.IMDmax[j+k];
+        IMD[k]    = GAInfil.IMD[j+k];
+        F[k]      = GAInfil.F[j+k];
+        Fu[k]     = GAInfil.Fu[j+k];
+        T[k]      = GAInfil.T[j+k];
+        sat[k]    = (char)GAInfil.Sat[j+k];
+        dt[k]     = tstep;
+    }
+
+    // --- available infiltration rate & part of the saturated volume
+    //     (see horton_getInfilBatch())
+    for (k = 0; k < n; k++) ia[k] = b->runon[k] + b->rainfall[k];
+    for (k = 0; k < n; k++) ia[k] = ia[k] + b->depth[k] / dt[k];
+    for (k = 0; k < n; k++) Fs[k] = ks[k] * (b->depth[k] + S[k]);
+
+    // --- find available infiltration rate & branch taken by each lane
+    #pragma omp simd
+    for (k = 0; k < n; k++)
+    {
+        if ( !b->active[k] )
+        {
+            state[k] = GA_NONE;
+            continue;
+        }
+        T[k] -= tstep;
+
+        // --- saturated upper zone
+        if ( sat[k] )
+        {
+            if ( ia[k] < ZERO ) state[k] = GA_NONE;
+            else
+            {
+                state[k] = GA_SAT;
+#ifdef __FAST_MATH__
+                T[k] = 5400.0 / (sf[k] * (GAInfil.Lu[j+k] * rf));
+#else
+                T[k] = 5400.0 / lu[k] / rf;
+#endif
+            }
+        }
+
+        // --- unsaturated upper zone
+        else
+        {
+            if ( ia[k] < ZERO ) ia[k] = 0.0;
+            if ( ia[k] == 0.0 )
+            {
+                if ( Fu[k] <= 0.0 ) state[k] = GA_NONE;
+                else state[k] = GA_DRY;
+            }
+            else if ( ia[k] <= ks[k] ) state[k] = GA_LIGHT;
+            else
+            {
+                // --- renew time to drain upper zone
+                T[k] = 5400.0 / lu[k] / rf;
+                Fs[k] = Fs[k] * IMD[k] / (ia[k] - ks[k]);
+                if ( F[k] > Fs[k] )
+                {
+                    state[k] = GA_SAT;
+                    sat[k] = TRUE;
+                }
+                else if ( F[k] + ia[k]*tstep < Fs[k] ) state[k] = GA_FILL;
+                else state[k] = GA_TRANS;
+            }
+        }
+    }
+
+    // --- upper zone moisture recovered by lanes without rainfall
+#ifdef __FAST_MATH__
+    for (k = 0; k < n; k++) dFr[k] = fumax[k] * lu[k];
+    for (k = 0; k < n; k++) dFr[k] = rf / 90000.0 * dFr[k];
+    for (k = 0; k < n; k++) dFr[k] = dt[k] * dFr[k];
+    for (k = 0; k < n; k++) Fd[k] = fumax[k] - Fu[k];
+#else
+    for (k = 0; k < n; k++) dFr[k] = lu[k] / 90000.0 * rf * fumax[k] * tstep;
+#endif
+
+    // --- update lanes that remain unsaturated
+    #pragma omp simd private(dF)
+    for (k = 0; k < n; k++)
+    {
+        b->infil[k] = 0.0;
+
+        // --- no rainfall so recover upper zone moisture
+        if ( state[k] == GA_DRY )
+        {
+            dF = dFr[k];
+            F[k] -= dF;
+            Fu[k] -= dF;
+            if ( Fu[k] <= 0.0 )
+            {
+                Fu[k] = 0.0;
+                F[k] = 0.0;
+                IMD[k] = IMDmax[k];
+            }
+            else if ( T[k] <= 0.0 )
+            {
+#ifdef __FAST_MATH__
+                IMD[k] = (dF + Fd[k]) / lu[k];
+#else
+                IMD[k] = (fumax[k] - Fu[k]) / lu[k];
+#endif
+                F[k] = 0.0;
+            }
+        }
+
+        // --- all available water infiltrates
+        else if ( state[k] == GA_LIGHT || state[k] == GA_FILL )
+        {
+            dF = ia[k] * tstep;
+            F[k] += dF;
+            Fu[k] += dF;
+            Fu[k] = MIN(Fu[k], fumax[k]);
+            if ( state[k] == GA_LIGHT && modelType == GREEN_AMPT &&
+                 T[k] <= 0.0 )
+            {
+                IMD[k] = (fumax[k] - Fu[k]) / lu[k];
+                F[k] = 0.0;
+            }
+            b->infil[k] = ia[k];
+        }
+    }
+
+    // --- list lanes that are or become saturated, with the starting
+    //     volume and time over which they are saturated
+    m = 0;
+    for (k = 0; k < n; k++)
+    {
+        if ( state[k] == GA_TRANS )
+        {
+            ts[k] = tstep + (F[k] - Fs[k]) / ia[k];
+            if ( ts[k] <= 0.0 ) ts[k] = 0.0;
+            f1[m] = Fs[k];
+            ts1[m] = ts[k];
+        }
+        else if ( state[k] == GA_SAT )
+        {
+            f1[m] = F[k];
+            ts1[m] = tstep;
+        }
+        else continue;
+        c1[m] = (S[k] + b->depth[k]) * IMD[k];
+        ks1[m] = ks[k];
+        list[m++] = k;
+    }
+
+    // --- solve G-A equation for their new cumulative infiltration volume
+    grnampt_getF2Batch(m, f1, c1, ks1, ts1, F2);
+    for (i = 0; i < m; i++)
+    {
+        k = list[i];
+
+        // --- surface layer becomes saturated during time step
+        if ( state[k] == GA_TRANS )
+        {
+            if ( F2[i] > Fs[k] + ia[k]*ts[k] ) F2[i] = Fs[k] + ia[k]*ts[k];
+            dF = F2[i] - F[k];
+            F[k] = F2[i];
+            sat[k] = TRUE;
+        }
+
+        // --- saturated surface; if all available water infiltrates
+        //     then set saturated state to false
+        else
+        {
+            dF = F2[i] - F[k];
+            if ( dF > ia[k] * tstep )
+            {
+                dF = ia[k] * tstep;
+                F2[i] = F[k] + dF;
+                sat[k] = FALSE;
+            }
+#ifdef __FAST_MATH__
+            F[k] = F2[i];
+#else
+            F[k] += dF;
+#endif
+        }
+        Fu[k] += dF;
+        Fu[k] = MIN(Fu[k], fumax[k]);
+        b->infil[k] = dF / dt[k];
+    }
+
+    // --- copy back new state
+    for (k = 0; k < n; k++)
+    {
+        GAInfil.IMD[j+k] = IMD[k];
+        GAInfil.F[j+k]   = F[k];
+        GAInfil.Fu[j+k]  = Fu[k];
+        GAInfil.T[j+k]   = T[k];
+        GAInfil.Sat[j+k] = sat[k];
+    }
+}
+
+//=============================================================================
+
 double grnampt_getF2(double f1, double c1, double ks, double ts)
 //
 //  Input:   f1 = old infiltration volume (ft)
@@ -853,9 +1392,114 @@ double grnampt_getF2(double f1, double c1, double ks, double ts)
 
 //=============================================================================
 
-int curvenum_setParams(TCurveNum *infil, double p[])
+void grnampt_getF2Batch(int n, double f1[], double c1[], double ks[],
+                        double ts[], double f2[])
+//
+//  Input:   n = number of lanes
+//           f1[] = old infiltration volume of each lane (ft)
+//           c1[] = head * moisture deficit of each lane (ft)
+//           ks[] = sat. hyd. conductivity of each lane (ft/sec)
+//           ts[] = time step of each lane (sec)
+//  Output:  f2[] = infiltration volume of each lane at end of time step (ft)
+//  Purpose: computes new infiltration volumes over a time step for a
+//           batch of lanes in the same way as grnampt_getF2().
 //
-//  Input:   infil = ptr. to Curve Number infiltration object
+{
+    int    i, k, iter;
+    int    m = 0;                      // number of lanes in list
+    int    count;
+    int    list[MAXINFILBATCH];        // lanes still being iterated
+    char   solve[MAXINFILBATCH];       // TRUE if G-A eqn. must be solved
+#ifdef __FAST_MATH__
+    char   direct[MAXINFILBATCH];      // TRUE if direct form is used
+#endif
+    double f2min[MAXINFILBATCH], c2[MAXINFILBATCH], kt[MAXINFILBATCH];
+    double df2;
+
+    // --- use min. infil. volume for 0 moisture deficit & direct form of
+    //     G-A equation for small time steps and c1/f1 < 100
+    #pragma omp simd
+    for (k = 0; k < n; k++)
+    {
+        kt[k] = ks[k] * ts[k];
+        f2min[k] = f1[k] + kt[k];
+        f2[k] = f2min[k];
+        solve[k] = FALSE;
+#ifdef __FAST_MATH__
+        direct[k] = FALSE;
+#endif
+        if ( c1[k] == 0.0 ) continue;
+        if ( ts[k] < 10.0 && f1[k] > 0.01 * c1[k] )
+        {
+#ifdef __FAST_MATH__
+            f2[k] = c1[k] / f1[k] * kt[k];
+            direct[k] = TRUE;
+#else
+            f2[k] = f1[k] + ks[k] * (1.0 + c1[k]/f1[k]) * ts[k];
+            f2[k] = MAX(f2[k], f2min[k]);
+#endif
+        }
+        else solve[k] = TRUE;
+    }
+
+#ifdef __FAST_MATH__
+    // --- sum the direct form's terms in the same order as grnampt_getF2()
+    //     (see horton_getInfilBatch())
+    for (k = 0; k < n; k++) if ( direct[k] ) f2[k] = f2[k] + kt[k];
+    for (k = 0; k < n; k++) if ( direct[k] )
+    {
+        f2[k] = f2[k] + f1[k];
+        f2[k] = MAX(f2[k], f2min[k]);
+    }
+#endif
+
+    // --- use Newton-Raphson method to solve integrated G-A equation
+    //     for the other lanes, dropping each one once it has converged
+    //     (one lane at a time, see horton_getInfilBatch())
+    for (k = 0; k < n; k++) if ( solve[k] ) list[m++] = k;
+    #pragma omp simd simdlen(1)
+    for (i = 0; i < m; i++)
+    {
+        k = list[i];
+#ifdef __FAST_MATH__
+        c2[k] = c1[k] * log(f1[k] + c1[k]) - f2min[k];
+#else
+        c2[k] = c1[k] * log(f1[k] + c1[k]) - kt[k];
+#endif
+        f2[k] = f1[k];
+    }
+    for ( iter = 1; iter <= 20 && m > 0; iter++ )
+    {
+        count = m;
+        m = 0;
+        for (i = 0; i < count; i++)
+        {
+            k = list[i];
+#ifdef __FAST_MATH__
+            df2 = (f2[k] + c2[k] - c1[k] * log(f2[k] + c1[k])) /
+                  (1.0 - c1[k] / (f2[k] + c1[k]) );
+#else
+            df2 = (f2[k] - f1[k] - c1[k] * log(f2[k] + c1[k]) + c2[k]) /
+                  (1.0 - c1[k] / (f2[k] + c1[k]) );
+#endif
+            if ( fabs(df2) < 0.00001 ) f2[k] = MAX(f2[k], f2min[k]);
+            else
+            {
+                f2[k] -= df2;
+                list[m++] = k;
+            }
+        }
+    }
+
+    // --- lanes that did not converge use min. infil. volume
+    for (i = 0; i < m; i++) f2[list[i]] = f2min[list[i]];
+}
+
+//=============================================================================
+
+int curvenum_setParams(int j, double p[])
+//
+//  Input:   j = subcatchment index
 //           p[] = array of parameter values
 //  Output:  returns TRUE if parameters are valid, FALSE otherwise
 //  Purpose: assigns Curve Number infiltration parameters to a subcatchment.
@@ -865,137 +1509,170 @@ int curvenum_setParams(TCurveNum *infil, double p[])
     // --- convert Curve Number to max. infil. capacity
     if ( p[0] < 10.0 ) p[0] = 10.0;
     if ( p[0] > 99.0 ) p[0] = 99.0;
-    infil->Smax    = (1000.0 / p[0] - 10.0) / 12.0;
-    if ( infil->Smax < 0.0 ) return FALSE;
+    CNInfil.Smax[j]    = (1000.0 / p[0] - 10.0) / 12.0;
+    if ( CNInfil.Smax[j] < 0.0 ) return FALSE;
 
     // --- convert drying time (days) to a regeneration const. (1/sec)
-    if ( p[2] > 0.0 )  infil->regen =  1.0 / (p[2] * SECperDAY);
+    if ( p[2] > 0.0 )  CNInfil.regen[j] =  1.0 / (p[2] * SECperDAY);
     else return FALSE;
 
     // --- compute inter-event time from regeneration const. as in Green-Ampt
-    infil->Tmax = 0.06 / infil->regen;
+    CNInfil.Tmax[j] = 0.06 / CNInfil.regen[j];
 
     return TRUE;
 }
 
 //=============================================================================
 
-void curvenum_initState(TCurveNum *infil)
+void curvenum_initState(int j)
 //
-//  Input:   infil = ptr. to Curve Number infiltration object
+//  Input:   j = subcatchment index
 //  Output:  none
 //  Purpose: initializes state of Curve Number infiltration for a subcatchment.
 //
 {
-    infil->S  = infil->Smax;
-    infil->P  = 0.0;
-    infil->F  = 0.0;
-    infil->T  = 0.0;
-    infil->Se = infil->Smax;
-    infil->f  = 0.0;
+    CNInfil.S[j]  = CNInfil.Smax[j];
+    CNInfil.P[j]  = 0.0;
+    CNInfil.F[j]  = 0.0;
+    CNInfil.T[j]  = 0.0;
+    CNInfil.Se[j] = CNInfil.Smax[j];
+    CNInfil.f[j]  = 0.0;
 }
 
-void curvenum_getState(TCurveNum *infil, double x[])
+void curvenum_getState(int j, double x[])
 {
-    x[0] = infil->S;
-    x[1] = infil->P;
-    x[2] = infil->F;
-    x[3] = infil->T;
-    x[4] = infil->Se;
-    x[5] = infil->f;
+    x[0] = CNInfil.S[j];
+    x[1] = CNInfil.P[j];
+    x[2] = CNInfil.F[j];
+    x[3] = CNInfil.T[j];
+    x[4] = CNInfil.Se[j];
+    x[5] = CNInfil.f[j];
 }
 
-void curvenum_setState(TCurveNum *infil, double x[])
+void curvenum_setState(int j, double x[])
 {
-    infil->S  = x[0];
-    infil->P  = x[1];
-    infil->F  = x[2];
-    infil->T  = x[3];
-    infil->Se = x[4];
-    infil->f  = x[5];
+    CNInfil.S[j]  = x[0];
+    CNInfil.P[j]  = x[1];
+    CNInfil.F[j]  = x[2];
+    CNInfil.T[j]  = x[3];
+    CNInfil.Se[j] = x[4];
+    CNInfil.f[j]  = x[5];
 }
 
 //=============================================================================
 
-double curvenum_getInfil(TCurveNum *infil, double tstep, double irate,
-    double depth)
+void curvenum_getInfilBatch(TInfilBatch* b, double tstep)
+//
+//  Input:   b = batch of subcatchments & their infiltration inputs
+//           tstep = runoff time step (sec)
+//  Output:  sets b->infil to each subcatchment's infiltration rate (ft/sec)
+//  Purpose: computes Curve Number infiltration for a batch of subcatchments.
 //
-//  Input:   infil = ptr. to Curve Number infiltration object
-//           tstep = runoff time step (sec),
-//           irate = rainfall rate (ft/sec);
-//           depth = depth of runon + ponded water (ft)
-//  Output:  returns infiltration rate (ft/sec)
-//  Purpose: computes infiltration rate using the Curve Number method.
-//  Note:    this function treats runon from other subcatchments as part
-//           of the ponded depth and not as an effective rainfall rate.
 {
-    double F1;                         // new cumulative infiltration (ft)
-    double f1 = 0.0;                   // new infiltration rate (ft/sec)
-    double fa = irate + depth/tstep;   // max. available infil. rate (ft/sec)
-
-    // --- case where there is rainfall
-    if ( irate > ZERO )
+    int    k;
+    int    n = b->count;
+    double Smax[MAXINFILBATCH], regen[MAXINFILBATCH], Tmax[MAXINFILBATCH];
+    double S[MAXINFILBATCH], F[MAXINFILBATCH], P[MAXINFILBATCH];
+    double T[MAXINFILBATCH], Se[MAXINFILBATCH], f[MAXINFILBATCH];
+    double depth[MAXINFILBATCH], fa[MAXINFILBATCH], dt[MAXINFILBATCH];
+    double irate, F1, f1;
+    double rf = Evap.recoveryFactor;
+    int    j = b->first;               // subcatchment of first lane
+
+    // --- copy parameters & state of each lane
+    for (k = 0; k < n; k++)
     {
-        // --- check if new rain event
-        if ( infil->T >= infil->Tmax )
-        {
-            infil->P = 0.0;
-            infil->F = 0.0;
-            infil->f = 0.0;
-            infil->Se = infil->S;
-        }
-        infil->T = 0.0;
-
-        // --- update cumulative precip.
-        infil->P += irate * tstep;
-
-        // --- find potential new cumulative infiltration
-        F1 = infil->P * (1.0 - infil->P / (infil->P + infil->Se));
-
-        // --- compute potential infiltration rate
-        f1 = (F1 - infil->F) / tstep;
-        if ( f1 < 0.0 || infil->S <= 0.0 ) f1 = 0.0;
-
+        Smax[k]  = CNInfil.Smax[j+k];
+        regen[k] = CNInfil.regen[j+k];
+        Tmax[k]  = CNInfil.Tmax[j+k];
+        S[k]     = CNInfil.S[j+k];
+        F[k]     = CNInfil.F[j+k];
+        P[k]     = CNInfil.P[j+k];
+        T[k]     = CNInfil.T[j+k];
+        Se[k]    = CNInfil.Se[j+k];
+        f[k]     = CNInfil.f[j+k];
+        dt[k]    = tstep;
     }
 
-    // --- case of no rainfall
-    else
+    // --- runon is treated as part of the ponded depth
+    //     (see horton_getInfilBatch() for why separate loops are used)
+    for (k = 0; k < n; k++) depth[k] = b->runon[k] / dt[k] + b->depth[k];
+    for (k = 0; k < n; k++) fa[k] = b->rainfall[k] + depth[k] / dt[k];
+
+    #pragma omp simd private(irate, F1, f1)
+    for (k = 0; k < n; k++)
     {
-        // --- if there is ponded water then use previous infil. rate
-        if ( depth > MIN_TOTAL_DEPTH && infil->S > 0.0 )
+        b->infil[k] = 0.0;
+        if ( !b->active[k] ) continue;
+        irate = b->rainfall[k];
+        f1 = 0.0;
+
+        // --- rainfall: find potential infiltration rate, starting
+        //     a new event if the inter-event time has been exceeded
+        if ( irate > ZERO )
         {
-            f1 = infil->f;
-            if ( f1*tstep > infil->S ) f1 = infil->S / tstep;
+            if ( T[k] >= Tmax[k] )
+            {
+                P[k] = 0.0;
+                F[k] = 0.0;
+                f[k] = 0.0;
+                Se[k] = S[k];
+            }
+            T[k] = 0.0;
+            P[k] += irate * tstep;
+            F1 = P[k] * (1.0 - P[k] / (P[k] + Se[k]));
+            f1 = (F1 - F[k]) / dt[k];
+            if ( f1 < 0.0 || S[k] <= 0.0 ) f1 = 0.0;
         }
 
-        // --- otherwise update inter-event time
-        else infil->T += tstep;
-    }
-
-    // --- if there is some infiltration
-    if ( f1 > 0.0 )
-    {
-        // --- limit infil. rate to max. available rate
-        f1 = MIN(f1, fa);
-        f1 = MAX(f1, 0.0);
+        // --- no rainfall: use previous infil. rate if water is ponded,
+        //     otherwise update inter-event time
+        else
+        {
+            if ( depth[k] > MIN_TOTAL_DEPTH && S[k] > 0.0 )
+            {
+                f1 = f[k];
+                if ( f1*tstep > S[k] ) f1 = S[k] / dt[k];
+            }
+            else T[k] += tstep;
+        }
 
-        // --- update actual cumulative infiltration
-        infil->F += f1 * tstep;
+        // --- if there is some infiltration, limit it to the available
+        //     rate & update cumulative infiltration & infil. capacity
+        if ( f1 > 0.0 )
+        {
+            f1 = MIN(f1, fa[k]);
+            f1 = MAX(f1, 0.0);
+            F[k] += f1 * tstep;
+            if ( regen[k] > 0.0 )
+            {
+                S[k] -= f1 * tstep;
+                if ( S[k] < 0.0 ) S[k] = 0.0;
+            }
+        }
 
-        // --- reduce infil. capacity if a regen. constant was supplied
-        if ( infil->regen > 0.0 )
+        // --- otherwise regenerate infil. capacity
+        else
         {
-            infil->S -= f1 * tstep;
-            if ( infil->S < 0.0 ) infil->S = 0.0;
+#ifdef __FAST_MATH__
+            S[k] += regen[k] * Smax[k] * (tstep * rf);
+#else
+            S[k] += regen[k] * Smax[k] * tstep * rf;
+#endif
+            if ( S[k] > Smax[k] ) S[k] = Smax[k];
         }
+        f[k] = f1;
+        b->infil[k] = f1;
     }
 
-    // --- otherwise regenerate infil. capacity
-    else
+    // --- copy back new state
+    for (k = 0; k < n; k++)
     {
-        infil->S += infil->regen * infil->Smax * tstep * Evap.recoveryFactor;
-        if ( infil->S > infil->Smax ) infil->S = infil->Smax;
+        CNInfil.S[j+k]  = S[k];
+        CNInfil.F[j+k]  = F[k];
+        CNInfil.P[j+k]  = P[k];
+        CNInfil.T[j+k]  = T[k];
+        CNInfil.Se[j+k] = Se[k];
+        CNInfil.f[j+k]  = f[k];
     }
-    infil->f = f1;
-    return f1;
 }
@@ -16,11 +16,25 @@
 //
 //   Build 5.1.013:
 //   - New function infil_setInfilFactor() added.
+//
+//   Build 5.2.0:
+//   - Function infil_setInfilFactor() replaced by infil_getInfilFactor().
+//   - Conductivity adjustment factor added to the arguments of
+//     infil_getInfil() & grnampt_getInfil().
+//   - Batch of subcatchment infiltration inputs (TInfilBatch) and
+//     infil_getInfilBatch() added.
+//   - Horton, Green-Ampt & Curve Number variables of subcatchments held in
+//     arrays (THortonArrays, TGrnAmptArrays & TCurveNumArrays) instead of
+//     in one object per subcatchment.
+//   - infil_getInfil() removed; a single subcatchment is analyzed as a
+//     batch of one.
 //-----------------------------------------------------------------------------
 
 #ifndef INFIL_H
 #define INFIL_H
 
+#define MAXINFILBATCH  32         // max. subcatchments in an infil. batch
+
 //---------------------
 // Enumerated Constants
 //---------------------
@@ -34,23 +48,24 @@ enum InfilType {
 //---------------------
 // Horton Infiltration
 //---------------------
-typedef struct
+// Arrays with one entry per subcatchment.
+typedef struct THortonArrays
 {
-   double        f0;              // initial infil. rate (ft/sec)
-   double        fmin;            // minimum infil. rate (ft/sec)
-   double        Fmax;            // maximum total infiltration (ft);
-   double        decay;           // decay coeff. of infil. rate (1/sec)
-   double        regen;           // regeneration coeff. of infil. rate (1/sec)
+   double*       f0;              // initial infil. rate (ft/sec)
+   double*       fmin;            // minimum infil. rate (ft/sec)
+   double*       Fmax;            // maximum total infiltration (ft);
+   double*       decay;           // decay coeff. of infil. rate (1/sec)
+   double*       regen;           // regeneration coeff. of infil. rate (1/sec)
    //-----------------------------
-   double        tp;              // present time on infiltration curve (sec)
-   double        Fe;              // cumulative infiltration (ft)
-}  THorton;
+   double*       tp;              // present time on infiltration curve (sec)
+   double*       Fe;              // cumulative infiltration (ft)
+}  THortonArrays;
 
 
 //-------------------------
 // Green-Ampt Infiltration
 //-------------------------
-typedef struct
+typedef struct TGrnAmpt
 {
    double        S;               // avg. capillary suction (ft)
    double        Ks;              // saturated conductivity (ft/sec)
@@ -65,47 +80,82 @@ typedef struct
 }  TGrnAmpt;
 
 
+//-------------------------------------------
+// Green-Ampt Infiltration of Subcatchments
+//-------------------------------------------
+// Arrays with one entry per subcatchment, holding the same variables as
+// TGrnAmpt.
+typedef struct TGrnAmptArrays
+{
+   double*       S;               // avg. capillary suction (ft)
+   double*       Ks;              // saturated conductivity (ft/sec)
+   double*       IMDmax;          // max. soil moisture deficit (ft/ft)
+   //-----------------------------
+   double*       IMD;             // current initial soil moisture deficit
+   double*       F;               // current cumulative infiltrated volume (ft)
+   double*       Fu;              // current upper zone infiltrated volume (ft)
+   double*       Lu;              // depth of upper soil zone (ft)
+   double*       T;               // time until start of next rain event (sec)
+   double*       Sat;             // saturation flag (TRUE or FALSE)
+}  TGrnAmptArrays;
+
+
 //--------------------------
 // Curve Number Infiltration
 //--------------------------
-typedef struct
+// Arrays with one entry per subcatchment.
+typedef struct TCurveNumArrays
 {
-   double        Smax;            // max. infiltration capacity (ft)
-   double        regen;           // infil. capacity regeneration constant (1/sec)
-   double        Tmax;            // maximum inter-event time (sec)
+   double*       Smax;            // max. infiltration capacity (ft)
+   double*       regen;           // infil. capacity regeneration constant (1/sec)
+   double*       Tmax;            // maximum inter-event time (sec)
    //-----------------------------
-   double        S;               // current infiltration capacity (ft)
-   double        F;               // current cumulative infiltration (ft)
-   double        P;               // current cumulative precipitation (ft)
-   double        T;               // current inter-event time (sec)
-   double        Se;              // current event infiltration capacity (ft)
-   double        f;               // previous infiltration rate (ft/sec)
+   double*       S;               // current infiltration capacity (ft)
+   double*       F;               // current cumulative infiltration (ft)
+   double*       P;               // current cumulative precipitation (ft)
+   double*       T;               // current inter-event time (sec)
+   double*       Se;              // current event infiltration capacity (ft)
+   double*       f;               // previous infiltration rate (ft/sec)
+}  TCurveNumArrays;
 
-}  TCurveNum;
 
-//-----------------------------------------------------------------------------
-//   Exported Variables
-//-----------------------------------------------------------------------------
-extern THorton*   HortInfil;
-extern TGrnAmpt*  GAInfil;
-extern TCurveNum* CNInfil;
+//-----------------------------
+// Batch of Infiltration Inputs
+//-----------------------------
+// A range of consecutive subcatchments whose infiltration is found
+// together, one per lane.
+typedef struct TInfilBatch
+{
+   int           first;                     // index of first subcatchment
+   int           count;                     // number of lanes in use
+   char          active[MAXINFILBATCH];     // TRUE if lane's infil. is found
+   double        rainfall[MAXINFILBATCH];   // rainfall + snowmelt (ft/sec)
+   double        runon[MAXINFILBATCH];      // runon rate (ft/sec)
+   double        depth[MAXINFILBATCH];      // ponded water depth (ft)
+   double        factor[MAXINFILBATCH];     // hyd. conductivity adj. factor
+   //-----------------------------
+   double        infil[MAXINFILBATCH];      // infiltration rate (ft/sec)
+}  TInfilBatch;
 
 //-----------------------------------------------------------------------------
 //   Infiltration Methods
 //-----------------------------------------------------------------------------
+struct TSnapshot;                      // simulation snapshot (see snapshot.c)
+
 void    infil_create(int subcatchCount, int model);
+void    infil_clone(int subcatchCount);
+void    infil_snapshot(struct TSnapshot* snap, int subcatchCount);
 void    infil_delete(void);
 int     infil_readParams(int model, char* tok[], int ntoks);
 void    infil_initState(int area, int model);
 void    infil_getState(int j, int m, double x[]);
 void    infil_setState(int j, int m, double x[]);
-void    infil_setInfilFactor(int j);                                           //(5.1.013)
-double  infil_getInfil(int area, int model, double tstep, double rainfall,
-        double runon, double depth);
+double  infil_getInfilFactor(int j);
+void    infil_getInfilBatch(TInfilBatch* batch, int model, double tstep);
 
 int     grnampt_setParams(TGrnAmpt *infil, double p[]);
 void    grnampt_initState(TGrnAmpt *infil);
 double  grnampt_getInfil(TGrnAmpt *infil, double tstep, double irate,
-        double depth, int modelType);
+        double depth, int modelType, double factor);
 
 #endif
@@ -21,6 +21,7 @@
 //  inflow_initDwfPattern   (called createObjects in project.c)
 //  inflow_readExtInflow    (called by input_readLine)
 //  inflow_readDwfInflow    (called by input_readLine)
+//  inflow_copyExtInflows   (called by cloneObjects in project.c)
 //  inflow_deleteExtInflows (called by deleteObjects in project.c)
 //  inflow_deleteDwfInflows (called by deleteObjects in project.c)
 //  inflow_getExtInflow     (called by addExternalInflows in routing.c)
@@ -249,6 +250,31 @@ void inflow_deleteExtInflows(int j)
 
 //=============================================================================
 
+int inflow_copyExtInflows(int j)
+//
+//  Input:   j = node index
+//  Output:  returns an error code
+//  Purpose: replaces a node's time series inflow data with a private copy
+//           (used for scenarios that share the data of a base project).
+//
+{
+    TExtInflow*  inflow = Node[j].extInflow;
+    TExtInflow** last = &Node[j].extInflow;
+
+    *last = NULL;
+    while ( inflow )
+    {
+        *last = (TExtInflow *) memdup(inflow, sizeof(TExtInflow));
+        if ( *last == NULL ) return ERR_MEMORY;
+        inflow = inflow->next;
+        last = &(*last)->next;
+        *last = NULL;
+    }
+    return 0;
+}
+
+//=============================================================================
+
 double inflow_getExtInflow(TExtInflow* inflow, DateTime aDate)
 //
 //  Input:   inflow = external inflow data structure
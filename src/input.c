@@ -16,6 +16,11 @@
 //   Build 5.1.011:
 //   - Support added for reading hydraulic event dates.
 //
+//   Build 5.2.0:
+//   - End nodes of links can be read ahead of other data (for renumbering
+//     the network) and nodes & links are stored at the index assigned to
+//     their position in the input file.
+//
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -34,18 +39,19 @@ static const int MAXERRS = 100;        // Max. input errors reported
 //-----------------------------------------------------------------------------
 //  Shared variables
 //-----------------------------------------------------------------------------
-static char *Tok[MAXTOKS];             // String tokens from line of input
-static int  Ntokens;                   // Number of tokens in line of input
-static int  Mobjects[MAX_OBJ_TYPES];   // Working number of objects of each type
-static int  Mnodes[MAX_NODE_TYPES];    // Working number of node objects
-static int  Mlinks[MAX_LINK_TYPES];    // Working number of link objects
-static int  Mevents;                   // Working number of event periods
+static THREADLOCAL char *Tok[MAXTOKS];             // String tokens from line of input
+static THREADLOCAL int  Ntokens;                   // Number of tokens in line of input
+static THREADLOCAL int  Mobjects[MAX_OBJ_TYPES];   // Working number of objects of each type
+static THREADLOCAL int  Mnodes[MAX_NODE_TYPES];    // Working number of node objects
+static THREADLOCAL int  Mlinks[MAX_LINK_TYPES];    // Working number of link objects
+static THREADLOCAL int  Mevents;                   // Working number of event periods
 
 //-----------------------------------------------------------------------------
 //  External Functions (declared in funcs.h)
 //-----------------------------------------------------------------------------
 //  input_countObjects  (called by swmm_open in swmm5.c)
 //  input_readData      (called by swmm_open in swmm5.c)
+//  input_readLinkNodes (called by orderNetwork in project.c)
 
 //-----------------------------------------------------------------------------
 //  Local functions
@@ -243,6 +249,57 @@ int input_readData()
 
 //=============================================================================
 
+void input_readLinkNodes(int node1[], int node2[])
+//
+//  Input:   none
+//  Output:  node1 = index of each link's start node
+//           node2 = index of each link's end node
+//  Purpose: reads the end nodes of each link from the input file.
+//
+//  Links whose end nodes are missing or unknown are given a node index
+//  of -1 (input_readData reports the error).
+{
+    char  line[MAXLINE+1];        // line from input data file
+    char  wLine[MAXLINE+1];       // working copy of input line
+    int   sect = -1, newsect;     // data sections
+    int   j;
+
+    for (j = 0; j < Nobjects[LINK]; j++)
+    {
+        node1[j] = -1;
+        node2[j] = -1;
+    }
+    rewind(Finp.file);
+    while ( fgets(line, MAXLINE, Finp.file) != NULL )
+    {
+        strcpy(wLine, line);
+        Ntokens = getTokens(wLine);
+        if ( Ntokens == 0 ) continue;
+        if ( *Tok[0] == ';' ) continue;
+        if ( *Tok[0] == '[' )
+        {
+            newsect = findmatch(Tok[0], SectWords);
+            if ( newsect >= 0 ) sect = newsect;
+            continue;
+        }
+        switch ( sect )
+        {
+          case s_CONDUIT:
+          case s_PUMP:
+          case s_ORIFICE:
+          case s_WEIR:
+          case s_OUTLET:
+            j = project_findObject(LINK, Tok[0]);
+            if ( j < 0 || Ntokens < 3 ) continue;
+            node1[j] = project_findObject(NODE, Tok[1]);
+            node2[j] = project_findObject(NODE, Tok[2]);
+            break;
+        }
+    }
+}
+
+//=============================================================================
+
 int  addObject(int objType, char* id)
 //
 //  Input:   objType = object type index
@@ -689,7 +746,7 @@ int readNode(int type)
 //  Purpose: reads data for a node from a line of input.
 //
 {
-    int j = Mobjects[NODE];
+    int j = project_getObjectIndex(NODE, Mobjects[NODE]);
     int k = Mnodes[type];
     int err = node_readParams(j, type, k, Tok, Ntokens);
     Mobjects[NODE]++;
@@ -706,7 +763,7 @@ int readLink(int type)
 //  Purpose: reads data for a link from a line of input.
 //
 {
-    int j = Mobjects[LINK];
+    int j = project_getObjectIndex(LINK, Mobjects[LINK]);
     int k = Mlinks[type];
     int err = link_readParams(j, type, k, Tok, Ntokens);
     Mobjects[LINK]++;
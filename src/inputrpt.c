@@ -8,6 +8,10 @@
 //
 //   Report writing functions for input data summary.
 //
+//   Build 5.2.0:
+//   - Nodes & links listed in input file order when the network has been
+//     renumbered.
+//
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -28,7 +32,7 @@ void inputrpt_writeInput()
 //
 {
     int m;
-    int i, k;
+    int i, j, k;
     int lidCount = 0;
     if ( ErrorCode ) return;
 
@@ -161,12 +165,13 @@ void inputrpt_writeInput()
 "\n  -------------------------------------------------------------------------------");
         for (i = 0; i < Nobjects[NODE]; i++)
         {
-            fprintf(Frpt.file, "\n  %-20s %-16s%10.2f%10.2f%10.1f", Node[i].ID,
-                NodeTypeWords[Node[i].type-JUNCTION],
-                Node[i].invertElev*UCF(LENGTH),
-                Node[i].fullDepth*UCF(LENGTH),
-                Node[i].pondedArea*UCF(LENGTH)*UCF(LENGTH));
-            if ( Node[i].extInflow || Node[i].dwfInflow || Node[i].rdiiInflow )
+            j = project_getObjectIndex(NODE, i);
+            fprintf(Frpt.file, "\n  %-20s %-16s%10.2f%10.2f%10.1f", Node[j].ID,
+                NodeTypeWords[Node[j].type-JUNCTION],
+                Node[j].invertElev*UCF(LENGTH),
+                Node[j].fullDepth*UCF(LENGTH),
+                Node[j].pondedArea*UCF(LENGTH)*UCF(LENGTH));
+            if ( Node[j].extInflow || Node[j].dwfInflow || Node[j].rdiiInflow )
             {
                 fprintf(Frpt.file, "    Yes");
             }
@@ -186,31 +191,32 @@ void inputrpt_writeInput()
 "\n  ---------------------------------------------------------------------------------------------");
         for (i = 0; i < Nobjects[LINK]; i++)
         {
+            j = project_getObjectIndex(LINK, i);
             // --- list end nodes in their original orientation
-            if ( Link[i].direction == 1 )
+            if ( Link[j].direction == 1 )
                 fprintf(Frpt.file, "\n  %-16s %-16s %-16s ",
-                    Link[i].ID, Node[Link[i].node1].ID, Node[Link[i].node2].ID);
+                    Link[j].ID, Node[Link[j].node1].ID, Node[Link[j].node2].ID);
             else
                 fprintf(Frpt.file, "\n  %-16s %-16s %-16s ",
-                    Link[i].ID, Node[Link[i].node2].ID, Node[Link[i].node1].ID);
+                    Link[j].ID, Node[Link[j].node2].ID, Node[Link[j].node1].ID);
 
             // --- list link type
-            if ( Link[i].type == PUMP )
+            if ( Link[j].type == PUMP )
             {
-                k = Link[i].subIndex;
+                k = Link[j].subIndex;
                 fprintf(Frpt.file, "%-5s PUMP  ",
                     PumpTypeWords[Pump[k].type]);
             }
             else fprintf(Frpt.file, "%-12s",
-                LinkTypeWords[Link[i].type-CONDUIT]);
+                LinkTypeWords[Link[j].type-CONDUIT]);
 
             // --- list length, slope and roughness for conduit links
-            if (Link[i].type == CONDUIT)
+            if (Link[j].type == CONDUIT)
             {
-                k = Link[i].subIndex;
+                k = Link[j].subIndex;
                 fprintf(Frpt.file, "%10.1f%10.4f%10.4f",
                     Conduit[k].length*UCF(LENGTH),
-                    Conduit[k].slope*100.0*Link[i].direction,
+                    Conduit[k].slope*100.0*Link[j].direction,
                     Conduit[k].roughness);
             }
         }
@@ -228,24 +234,25 @@ void inputrpt_writeInput()
 "\n  ---------------------------------------------------------------------------------------");
         for (i = 0; i < Nobjects[LINK]; i++)
         {
-            if (Link[i].type == CONDUIT)
+            j = project_getObjectIndex(LINK, i);
+            if (Link[j].type == CONDUIT)
             {
-                k = Link[i].subIndex;
-                fprintf(Frpt.file, "\n  %-16s ", Link[i].ID);
-                if ( Link[i].xsect.type == CUSTOM )
-                    fprintf(Frpt.file, "%-16s ", Curve[Link[i].xsect.transect].ID);
-                else if ( Link[i].xsect.type == IRREGULAR )
+                k = Link[j].subIndex;
+                fprintf(Frpt.file, "\n  %-16s ", Link[j].ID);
+                if ( Link[j].xsect.type == CUSTOM )
+                    fprintf(Frpt.file, "%-16s ", Curve[Link[j].xsect.transect].ID);
+                else if ( Link[j].xsect.type == IRREGULAR )
                     fprintf(Frpt.file, "%-16s ",
-                    Transect[Link[i].xsect.transect].ID);
+                    Transect[Link[j].xsect.transect].ID);
                 else fprintf(Frpt.file, "%-16s ",
-                    XsectTypeWords[Link[i].xsect.type]);
+                    XsectTypeWords[Link[j].xsect.type]);
                 fprintf(Frpt.file, "%8.2f %8.2f %8.2f %8.2f      %3d %8.2f",
-                    Link[i].xsect.yFull*UCF(LENGTH),
-                    Link[i].xsect.aFull*UCF(LENGTH)*UCF(LENGTH),
-                    Link[i].xsect.rFull*UCF(LENGTH),
-                    Link[i].xsect.wMax*UCF(LENGTH),
+                    Link[j].xsect.yFull*UCF(LENGTH),
+                    Link[j].xsect.aFull*UCF(LENGTH)*UCF(LENGTH),
+                    Link[j].xsect.rFull*UCF(LENGTH),
+                    Link[j].xsect.wMax*UCF(LENGTH),
                     Conduit[k].barrels,
-                    Link[i].qFull*UCF(FLOW));
+                    Link[j].qFull*UCF(FLOW));
             }
         }
     }
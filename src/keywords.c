@@ -37,6 +37,18 @@
 //   Build 5.1.013:
 //   - New option keywords w_SURCHARGE_METHOD, w_RULE_STEP, w_AVERAGES 
 //     and w_WEIR added.
+//
+//   Build 5.2.0:
+//   - New option keywords w_SOLVER_METHOD, w_ANDERSON_DEPTH,
+//     w_THREAD_SCHEDULE, w_DENSE_TABLE_SIZE, w_CIRCULAR_GEOMETRY and
+//     w_NETWORK_ORDER added.
+//   - SolverWords, ScheduleWords, CircGeomWords and NetworkOrderWords
+//     added.
+//   - New option keyword w_PREDICTOR and PredictorWords added.
+//   - New option keyword w_RUNOFF_SOLVER and RunoffSolverWords added.
+//   - New report keyword w_CACHESTATS added to ReportWords.
+//   - New option keyword w_DEPTH_WARM_START added.
+//   - New option keyword w_ACTIVE_SET added.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -44,6 +56,7 @@
 #include "text.h"
 
 char* BuildupTypeWords[]   = { w_NONE, w_POW, w_EXP, w_SAT, w_EXT, NULL};
+char* CircGeomWords[]      = { w_TABULAR, w_ANALYTIC, NULL};
 char* CurveTypeWords[]     = { w_STORAGE, w_DIVERSION, w_TIDAL, w_RATING,
                                w_CONTROLS, w_SHAPE, w_WEIR,                    //(5.1.013)
                                w_PUMP1, w_PUMP2, w_PUMP3, w_PUMP4, NULL}; 
@@ -64,6 +77,7 @@ char* LinkOffsetWords[]    = { w_DEPTH, w_ELEVATION, NULL};
 char* LinkTypeWords[]      = { w_CONDUIT, w_PUMP, w_ORIFICE,
                                w_WEIR, w_OUTLET };
 char* LoadUnitsWords[]     = { w_LBS, w_KG, w_LOGN };
+char* NetworkOrderWords[]  = { w_INPUT, w_RCM, NULL};
 char* NodeTypeWords[]      = { w_JUNCTION, w_OUTFALL,
                                w_STORAGE, w_DIVIDER };
 char* NoneAllWords[]       = { w_NONE, w_ALL, NULL};
@@ -94,12 +108,18 @@ char* OptionWords[]        = { w_FLOW_UNITS,        w_INFIL_MODEL,
                                w_SYS_FLOW_TOL,      w_LAT_FLOW_TOL,
                                w_IGNORE_RDII,       w_MIN_ROUTE_STEP,
                                w_NUM_THREADS,       w_SURCHARGE_METHOD,        //(5.1.013)
+                               w_SOLVER_METHOD,     w_ANDERSON_DEPTH,
+                               w_THREAD_SCHEDULE,   w_DENSE_TABLE_SIZE,
+                               w_CIRCULAR_GEOMETRY, w_NETWORK_ORDER,
+                               w_PREDICTOR,         w_RUNOFF_SOLVER,
+                               w_DEPTH_WARM_START,  w_ACTIVE_SET,
                                NULL };
 char* OrificeTypeWords[]   = { w_SIDE, w_BOTTOM, NULL};
 char* OutfallTypeWords[]   = { w_FREE, w_NORMAL, w_FIXED, w_TIDAL,
                                w_TIMESERIES, NULL};
 char* PatternTypeWords[]   = { w_MONTHLY, w_DAILY, w_HOURLY, w_WEEKEND, NULL};
 char* PondingUnitsWords[]  = { w_PONDED_FEET, w_PONDED_METERS };
+char* PredictorWords[]     = { w_NONE, w_LINEAR, w_QUADRATIC, NULL};
 char* ProcessVarWords[]    = { w_HRT, w_DT, w_FLOW, w_DEPTH, w_AREA, NULL};
 char* PumpTypeWords[]      = { w_TYPE1, w_TYPE2, w_TYPE3, w_TYPE4, w_IDEAL };
 char* QualUnitsWords[]     = { w_MGperL, w_UGperL, w_COUNTperL, NULL};
@@ -108,11 +128,12 @@ char* RainUnitsWords[]     = { w_INCHES, w_MMETER, NULL};
 char* RelationWords[]      = { w_TABULAR, w_FUNCTIONAL, NULL};
 char* ReportWords[]        = { w_INPUT, w_CONTINUITY, w_FLOWSTATS,
                                w_CONTROLS, w_SUBCATCH, w_NODE, w_LINK,
-                               w_NODESTATS, w_AVERAGES, NULL};                 //(5.1.013)
+                               w_NODESTATS, w_AVERAGES, w_CACHESTATS, NULL};
 char* RouteModelWords[]    = { w_NONE, w_STEADY, w_KINWAVE, w_XKINWAVE,
                                w_DYNWAVE, NULL};
 char* RuleKeyWords[]       = { w_RULE, w_IF, w_AND, w_OR, w_THEN, w_ELSE, 
                                w_PRIORITY, NULL};
+char* RunoffSolverWords[]  = { w_RUNGE_KUTTA, w_ROSENBROCK, NULL};
 char* SectWords[]          = { ws_TITLE,          ws_OPTION,
                                ws_FILE,           ws_RAINGAGE,
                                ws_TEMP,           ws_EVAP, 
@@ -142,6 +163,8 @@ char* SectWords[]          = { ws_TITLE,          ws_OPTION,
                                ws_ADJUST,         ws_EVENT,
                                NULL};                       
 char* SnowmeltWords[]      = { w_PLOWABLE, w_IMPERV, w_PERV, w_REMOVAL, NULL};
+char* ScheduleWords[]      = { w_STATIC, w_DYNAMIC, w_GUIDED, NULL};
+char* SolverWords[]        = { w_PICARD, w_NEWTON, w_ANDERSON, NULL};
 char* SurchargeWords[]     = { w_EXTRAN, w_SLOT, NULL};                        //(5.1.013)
 char* TempKeyWords[]       = { w_TIMESERIES, w_FILE, w_WINDSPEED, w_SNOWMELT,
                                w_ADC, NULL};
@@ -15,9 +15,18 @@
 //
 //   Build 5.1.013:
 //   - New keyword array defined for surcharge method.
+//
+//   Build 5.2.0:
+//   - New keyword array defined for dynamic wave solver method.
+//   - New keyword array defined for parallel loop thread schedule.
+//   - New keyword array defined for circular geometry method.
+//   - New keyword array defined for network ordering.
+//   - New keyword array defined for dynamic wave predictor.
+//   - New keyword array defined for runoff ODE solver.
 //-----------------------------------------------------------------------------
 
 extern char* BuildupTypeWords[];
+extern char* CircGeomWords[];
 extern char* CurveTypeWords[];
 extern char* DividerTypeWords[];
 extern char* DynWaveMethodWords[];
@@ -32,6 +41,7 @@ extern char* InfilModelWords[];
 extern char* LinkOffsetWords[];
 extern char* LinkTypeWords[];
 extern char* LoadUnitsWords[];
+extern char* NetworkOrderWords[];
 extern char* NodeTypeWords[];
 extern char* NoneAllWords[];
 extern char* NormalFlowWords[];
@@ -44,6 +54,7 @@ extern char* OrificeTypeWords[];
 extern char* OutfallTypeWords[];
 extern char* PatternTypeWords[];
 extern char* PondingUnitsWords[];
+extern char* PredictorWords[];
 extern char* ProcessVarWords[];
 extern char* PumpTypeWords[];
 extern char* QualUnitsWords[];
@@ -53,8 +64,11 @@ extern char* ReportWords[];
 extern char* RelationWords[];
 extern char* RouteModelWords[];
 extern char* RuleKeyWords[];
+extern char* RunoffSolverWords[];
 extern char* SectWords[];
 extern char* SnowmeltWords[];
+extern char* ScheduleWords[];
+extern char* SolverWords[];
 extern char* SurchargeWords[];                                                 //(5.1.013)
 extern char* TempKeyWords[];
 extern char* TransectKeyWords[];
@@ -72,6 +72,14 @@
 //     control curve for underdrain flow.
 //   - Support added for unclogging permeable pavement at fixed intervals.
 //   - Support added for pollutant removal in underdrain flow.
+//
+//   Build 5.2.0:
+//   - A subcatchment's water balance volumes are updated in the
+//     TRunoffContext passed to lid_getRunoff() instead of in variables
+//     shared with subcatch.c, and drain flow sent to nodes is saved there
+//     for the system mass balance.
+//   - Native soil infiltration of a subcatchment without non-LID pervious
+//     area found with infil_getInfilBatch() as a batch of one.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -126,35 +134,31 @@ char* LidTypeWords[] =
 //-----------------------------------------------------------------------------
 //  Shared Variables
 //-----------------------------------------------------------------------------
-static TLidProc*  LidProcs;            // array of LID processes
-static int        LidCount;            // number of LID processes
-static TLidGroup* LidGroups;           // array of LID process groups
-static int        GroupCount;          // number of LID groups (subcatchments)
+#define LidProcs   (Prj->lid.LidProcs)   // array of LID processes
+#define LidCount   (Prj->lid.LidCount)   // number of LID processes
+#define LidGroups  (Prj->lid.LidGroups)  // array of LID process groups
+#define GroupCount (Prj->lid.GroupCount) // number of LID groups (subcatchments)
 
-static double     EvapRate;            // evaporation rate (ft/s)
-static double     NativeInfil;         // native soil infil. rate (ft/s)
-static double     MaxNativeInfil;      // native soil infil. rate limit (ft/s)
+static THREADLOCAL double EvapRate;            // evaporation rate (ft/s)
+static THREADLOCAL double NativeInfil;         // native soil infil. rate (ft/s)
+static THREADLOCAL double MaxNativeInfil;      // native soil infil. rate limit (ft/s)
 
 //-----------------------------------------------------------------------------
-//  Imported Variables (from SUBCATCH.C)
+//  Imported Variables
 //-----------------------------------------------------------------------------
-// Volumes (ft3) for a subcatchment over a time step 
-extern double     Vevap;               // evaporation
-extern double     Vpevap;              // pervious area evaporation
-extern double     Vinfil;              // non-LID infiltration
-extern double     VlidInfil;           // infiltration from LID units
-extern double     VlidIn;              // impervious area flow to LID units
-extern double     VlidOut;             // surface outflow from LID units
-extern double     VlidDrain;           // drain outflow from LID units
-extern double     VlidReturn;          // LID outflow returned to pervious area
-extern char       HasWetLids;          // TRUE if any LIDs are wet
-                                       // (from RUNOFF.C)
+#define HasWetLids (Prj->runoff.HasWetLids) // TRUE if any LIDs are wet
+                                            // (from RUNOFF.C)
+#define GAInfil    (Prj->infil.GAInfil)     // Green-Ampt infiltration arrays
+                                            // (from INFIL.C)
 
 //-----------------------------------------------------------------------------
 //  External Functions (prototyped in lid.h)
 //-----------------------------------------------------------------------------
 //  lid_create               called by createObjects in project.c
 //  lid_delete               called by deleteObjects in project.c
+//  lid_clone                called by cloneObjects in project.c
+//  lid_deleteClone          called by deleteClonedObjects in project.c
+//  lid_snapshot             called by listState in snapshot.c
 //  lid_validate             called by project_validate
 //  lid_initState            called by project_init
 
@@ -213,11 +217,11 @@ static int    isLidPervious(int k);
 static double getImpervAreaRunoff(int j);
 static double getPervAreaRunoff(int j);                                        //(5.1.013)
 static double getSurfaceDepth(int subcatch);
-static void   findNativeInfil(int j, double tStep);
+static void   findNativeInfil(int j, double tStep, TRunoffContext* ctx);
 
 static void   evalLidUnit(int j, TLidUnit* lidUnit, double lidArea,
               double lidInflow, double tStep, double *qRunoff,
-              double *qDrain, double *qReturn);
+              double *qDrain, double *qReturn, TRunoffContext* ctx);
 
 //=============================================================================
 
@@ -306,6 +310,126 @@ void lid_delete()
 
 //=============================================================================
 
+void lid_clone()
+//
+//  Purpose: replaces the LID groups of a scenario project with private
+//           copies of the groups it shares with its base project.
+//  Input:   none
+//  Output:  none
+//
+//  Note: LID process parameters remain shared with the base project and
+//        LID units of a scenario do not write detailed report files.
+{
+    int j;
+    TLidGroup  baseGroup;
+    TLidGroup  lidGroup;
+    TLidList*  baseList;
+    TLidList*  lidList;
+    TLidList** tail;
+
+    if ( GroupCount == 0 )
+    {
+        LidGroups = NULL;
+        return;
+    }
+    LidGroups = (TLidGroup *) memdup(LidGroups, GroupCount*sizeof(TLidGroup));
+    if ( LidGroups == NULL )
+    {
+        GroupCount = 0;
+        ErrorCode = ERR_MEMORY;
+        return;
+    }
+    for (j = 0; j < GroupCount; j++)
+    {
+        baseGroup = LidGroups[j];
+        LidGroups[j] = NULL;
+        if ( baseGroup == NULL ) continue;
+        lidGroup = (TLidGroup) memdup(baseGroup, sizeof(struct LidGroup));
+        if ( lidGroup == NULL ) break;
+        lidGroup->lidList = NULL;
+        LidGroups[j] = lidGroup;
+
+        //... copy each LID unit in the group, preserving list order
+        tail = &lidGroup->lidList;
+        for (baseList = baseGroup->lidList; baseList;
+             baseList = baseList->nextLidUnit)
+        {
+            lidList = (TLidList *) malloc(sizeof(TLidList));
+            if ( lidList == NULL ) break;
+            lidList->lidUnit = (TLidUnit *) memdup(baseList->lidUnit,
+                                                   sizeof(TLidUnit));
+            lidList->nextLidUnit = NULL;
+            if ( lidList->lidUnit == NULL )
+            {
+                free(lidList);
+                break;
+            }
+            lidList->lidUnit->rptFile = NULL;
+            *tail = lidList;
+            tail = &lidList->nextLidUnit;
+        }
+        if ( baseList ) break;
+    }
+
+    //... on failure clear the group pointers still owned by the base project
+    if ( j < GroupCount )
+    {
+        for (j = j + 1; j < GroupCount; j++) LidGroups[j] = NULL;
+        ErrorCode = ERR_MEMORY;
+    }
+}
+
+//=============================================================================
+
+void lid_deleteClone()
+//
+//  Purpose: deletes the LID groups owned by a scenario project.
+//  Input:   none
+//  Output:  none
+//
+{
+    int j;
+    for (j = 0; j < GroupCount; j++) freeLidGroup(j);
+    FREE(LidGroups);
+    GroupCount = 0;
+}
+
+//=============================================================================
+
+void lid_snapshot(struct TSnapshot* snap)
+//
+//  Purpose: adds the state of each LID group and LID unit to a snapshot.
+//  Input:   snap = snapshot being built
+//  Output:  none
+//
+{
+    int j;
+    TLidGroup  lidGroup;
+    TLidList*  lidList;
+    TLidUnit*  lidUnit;
+
+    for (j = 0; j < GroupCount; j++)
+    {
+        lidGroup = LidGroups[j];
+        if ( lidGroup == NULL ) continue;
+        snapshot_addBlock(snap, lidGroup, sizeof(struct LidGroup));
+        for (lidList = lidGroup->lidList; lidList;
+             lidList = lidList->nextLidUnit)
+        {
+            lidUnit = lidList->lidUnit;
+            snapshot_addBlock(snap, lidUnit, sizeof(TLidUnit));
+            if ( lidUnit->rptFile )
+            {
+                snapshot_addBlock(snap, lidUnit->rptFile,
+                                  sizeof(TLidRptFile));
+                snapshot_addFile(snap, lidUnit->rptFile->file);
+            }
+        }
+    }
+}
+
+//=============================================================================
+
 void freeLidGroup(int j)
 //
 //  Purpose: frees all LID units associated with a subcatchment.
@@ -1148,9 +1272,9 @@ void validateLidGroup(int j)
         {
             if ( InfilModel == GREEN_AMPT || InfilModel == MOD_GREEN_AMPT )
             {
-                p[0] = GAInfil[j].S * UCF(RAINDEPTH);
-                p[1] = GAInfil[j].Ks * UCF(RAINFALL);
-                p[2] = GAInfil[j].IMDmax;
+                p[0] = GAInfil.S[j] * UCF(RAINDEPTH);
+                p[1] = GAInfil.Ks[j] * UCF(RAINFALL);
+                p[2] = GAInfil.IMDmax[j];
                 if ( grnampt_setParams(&(lidUnit->soilInfil), p) == FALSE )
                 {
                     strcpy(Msg, LidProcs[k].ID);
@@ -1604,13 +1728,15 @@ void  lid_addDrainInflow(int j, double f)
 
 //=============================================================================
 
-void lid_getRunoff(int j, double tStep)
+void lid_getRunoff(int j, double tStep, TRunoffContext* ctx)
 //
 //  Purpose: computes runoff and drain flows from the LIDs in a subcatchment.
 //  Input:   j     = subcatchment index 
 //           tStep = time step (sec)
-//  Output:  updates following global quantities after LID treatment applied:
-//           Vevap, Vpevap, VlidInfil, VlidIn, VlidOut, VlidDrain.
+//           ctx   = subcatchment's runoff context
+//  Output:  updates following quantities of ctx after LID treatment applied:
+//           vEvap, vPevap, vLidInfil, vLidIn, vLidOut, vLidDrain, vDrains
+//           & hasWetLids.
 //
 {
     TLidGroup  theLidGroup;       // group of LIDs placed in the subcatchment
@@ -1635,7 +1761,7 @@ void lid_getRunoff(int j, double tStep)
     if ( Evap.dryOnly && Subcatch[j].rainfall > 0.0 ) EvapRate = 0.0;
 
     //... find subcatchment's infiltration rate into native soil
-    findNativeInfil(j, tStep);
+    findNativeInfil(j, tStep, ctx);
 
     //... get impervious and pervious area runoff from non-LID
     //    portion of subcatchment (cfs)
@@ -1660,7 +1786,7 @@ void lid_getRunoff(int j, double tStep)
                          qPerv * lidUnit->fromPerv) / lidArea;                 //
 
             //... update total runoff volume treated
-            VlidIn += lidInflow * lidArea * tStep;
+            ctx->vLidIn += lidInflow * lidArea * tStep;
 
             //... add rainfall onto LID inflow (ft/s)
             lidInflow = lidInflow + Subcatch[j].rainfall;
@@ -1675,7 +1801,7 @@ void lid_getRunoff(int j, double tStep)
             //    total surface runoff, drain flow, and flow returned to
             //    pervious area 
             evalLidUnit(j, lidUnit, lidArea, lidInflow, tStep,
-                        &qRunoff, &qDrain, &qReturn);
+                        &qRunoff, &qDrain, &qReturn, ctx);
         }
         lidList = lidList->nextLidUnit;
     }
@@ -1685,38 +1811,46 @@ void lid_getRunoff(int j, double tStep)
     theLidGroup->flowToPerv = qReturn;
 
     //... save the LID group's total surface, drain and return flow volumes
-    VlidOut = qRunoff * tStep; 
-    VlidDrain = qDrain * tStep;
-    VlidReturn = qReturn * tStep;
+    ctx->vLidOut = qRunoff * tStep; 
+    ctx->vLidDrain = qDrain * tStep;
+    ctx->vLidReturn = qReturn * tStep;
 }
 
 //=============================================================================
 
-void findNativeInfil(int j, double tStep)
+void findNativeInfil(int j, double tStep, TRunoffContext* ctx)
 //
 //  Purpose: determines a subcatchment's current infiltration rate into
 //           its native soil.
 //  Input:   j = subcatchment index
 //           tStep    = time step (sec)
+//           ctx      = subcatchment's runoff context
 //  Output:  sets values for module-level variables NativeInfil
 //
 {
     double nonLidArea;
+    TInfilBatch batch;
 
     //... subcatchment has non-LID pervious area
     nonLidArea = Subcatch[j].area - Subcatch[j].lidArea;
     if ( nonLidArea > 0.0 && Subcatch[j].fracImperv < 1.0 )
     {
-        NativeInfil = Vinfil / nonLidArea / tStep;
+        NativeInfil = ctx->vInfil / nonLidArea / tStep;
     }
 
     //... otherwise find infil. rate for the subcatchment's rainfall + runon
+    //    (as a batch of one subcatchment)
     else
     {
-        NativeInfil = infil_getInfil(j, InfilModel, tStep,
-                                     Subcatch[j].rainfall,
-                                     Subcatch[j].runon,
-                                     getSurfaceDepth(j));                      //(5.1.008)
+        batch.first = j;
+        batch.count = 1;
+        batch.active[0] = TRUE;
+        batch.rainfall[0] = Subcatch[j].rainfall;
+        batch.runon[0] = Subcatch[j].runon;
+        batch.depth[0] = getSurfaceDepth(j);                                   //(5.1.008)
+        batch.factor[0] = ctx->infilFactor;
+        infil_getInfilBatch(&batch, InfilModel, tStep);
+        NativeInfil = batch.infil[0];
     }
 
     //... see if there is any groundwater-imposed limit on infil.
@@ -1788,7 +1922,8 @@ double getPervAreaRunoff(int j)
 //=============================================================================
 
 void evalLidUnit(int j, TLidUnit* lidUnit, double lidArea, double lidInflow,
-    double tStep, double *qRunoff, double *qDrain, double *qReturn)
+    double tStep, double *qRunoff, double *qDrain, double *qReturn,
+    TRunoffContext* ctx)
 //
 //  Purpose: evaluates performance of a specific LID unit over current time step.
 //  Input:   j         = subcatchment index
@@ -1796,6 +1931,7 @@ void evalLidUnit(int j, TLidUnit* lidUnit, double lidArea, double lidInflow,
 //           lidArea   = area of LID unit
 //           lidInflow = inflow to LID unit (ft/s)
 //           tStep     = time step (sec)
+//           ctx       = subcatchment's runoff context
 //  Output:  qRunoff   = sum of surface runoff from all LIDs (cfs)
 //           qDrain    = sum of drain flows from all LIDs (cfs)
 //           qReturn   = sum of LID flows returned to pervious area (cfs)
@@ -1816,7 +1952,8 @@ void evalLidUnit(int j, TLidUnit* lidUnit, double lidArea, double lidInflow,
 
     //... find surface runoff from the LID unit (in cfs)
     lidRunoff = lidproc_getOutflow(lidUnit, lidProc, lidInflow, EvapRate,
-                                  NativeInfil, MaxNativeInfil, tStep,
+                                  NativeInfil, MaxNativeInfil,
+                                  ctx->infilFactor, tStep,
                                   &lidEvap, &lidInfil, &lidDrain) * lidArea;
     
     //... convert drain flow to CFS
@@ -1842,18 +1979,18 @@ void evalLidUnit(int j, TLidUnit* lidUnit, double lidArea, double lidInflow,
     //    conveyance system node
     if ( lidUnit->drainNode >= 0 )
     {
-        massbal_updateRunoffTotals(RUNOFF_DRAINS, lidDrain * tStep);
+        ctx->vDrains += lidDrain * tStep;
     }
 
     //... save new drain outflow
     lidUnit->newDrainFlow = lidDrain;
 
     //... update moisture losses (ft3)
-    Vevap  += lidEvap * tStep * lidArea;
-    VlidInfil += lidInfil * tStep * lidArea;
+    ctx->vEvap  += lidEvap * tStep * lidArea;
+    ctx->vLidInfil += lidInfil * tStep * lidArea;
     if ( isLidPervious(lidUnit->lidIndex) )
     {
-        Vpevap += lidEvap * tStep * lidArea;
+        ctx->vPevap += lidEvap * tStep * lidArea;
     }
 
     //... update time since last rainfall (for Rain Barrel emptying)
@@ -1861,7 +1998,8 @@ void evalLidUnit(int j, TLidUnit* lidUnit, double lidArea, double lidInflow,
     else lidUnit->dryTime += tStep;
 
     //... update LID water balance and save results
-    lidproc_saveResults(lidUnit, UCF(RAINFALL), UCF(RAINDEPTH));
+    if ( lidproc_saveResults(lidUnit, UCF(RAINFALL), UCF(RAINDEPTH)) )
+        ctx->hasWetLids = TRUE;
 
     //... update LID group totals
     *qRunoff += lidRunoff;
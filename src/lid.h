@@ -36,6 +36,12 @@
 //   - New members added to TPavementLayer and TLidUnit to support
 //     unclogging permeable pavement at fixed intervals.
 //
+//   Build 5.2.0:
+//   - Runoff context added to the arguments of lid_getRunoff().
+//   - Conductivity adjustment factor added to the arguments of
+//     lidproc_getOutflow() and lidproc_saveResults() returns TRUE if the
+//     LID unit is wet.
+//
 //-----------------------------------------------------------------------------
 
 #ifndef LID_H
@@ -135,7 +141,7 @@ typedef struct
 }  TDrainMatLayer;
 
 // LID Process - generic LID design per unit of area
-typedef struct
+typedef struct TLidProc
 {
     char*          ID;            // identifying name
     int            lidType;       // type of LID
@@ -244,8 +250,12 @@ typedef struct LidGroup* TLidGroup;
 //-----------------------------------------------------------------------------
 //   LID Methods
 //-----------------------------------------------------------------------------
+struct TRunoffContext;                 // subcatchment runoff context
 void     lid_create(int lidCount, int subcatchCount);
 void     lid_delete(void);
+void     lid_clone(void);
+void     lid_deleteClone(void);
+void     lid_snapshot(struct TSnapshot* snap);
 
 int      lid_readProcParams(char* tok[], int ntoks);
 int      lid_readGroupParams(char* tok[], int ntoks);
@@ -261,7 +271,8 @@ double   lid_getStoredVolume(int subcatch);
 void     lid_addDrainLoads(int subcatch, double c[], double tStep);
 void     lid_addDrainRunon(int subcatch);
 void     lid_addDrainInflow(int subcatch, double f);
-void     lid_getRunoff(int subcatch, double tStep);
+void     lid_getRunoff(int subcatch, double tStep,
+         struct TRunoffContext* ctx);
 void     lid_writeSummary(void);
 void     lid_writeWaterBalance(void);
 
@@ -280,8 +291,9 @@ void     lidproc_initWaterBalance(TLidUnit *lidUnit, double initVol);
 void     lidproc_initWaterRate(TLidUnit *lidUnit);
 double   lidproc_getOutflow(TLidUnit* lidUnit, TLidProc* lidProc,
          double inflow, double evap, double infil, double maxInfil,
-         double tStep, double* lidEvap, double* lidInfil, double* lidDrain);
+         double infilFactor, double tStep, double* lidEvap,
+         double* lidInfil, double* lidDrain);
 
-void     lidproc_saveResults(TLidUnit* lidUnit, double ucfRainfall,
+int      lidproc_saveResults(TLidUnit* lidUnit, double ucfRainfall,
          double ucfRainDepth);
 #endif
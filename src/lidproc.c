@@ -59,6 +59,13 @@
 //     to control underdrain flow.
 //   - Support added for regenerating pavement permeability at fixed intervals.
 //
+//   Build 5.2.0:
+//   - Hydraulic conductivity adjustment factor passed into
+//     lidproc_getOutflow() for the surface infiltration computation.
+//   - lidproc_saveResults() returns the unit's wet/dry status instead of
+//     setting the shared HasWetLids flag so that subcatchments can be
+//     evaluated concurrently.
+//
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -99,42 +106,37 @@ enum LidRptVars {
     STOR_DEPTH,              // water level in storage layer
     MAX_RPT_VARS};
 
-//-----------------------------------------------------------------------------
-//  Imported variables 
-//-----------------------------------------------------------------------------
-extern char HasWetLids;      // TRUE if any LIDs are wet (declared in runoff.c)
-
 //-----------------------------------------------------------------------------
 //  Local Variables
 //-----------------------------------------------------------------------------
-static TLidUnit*  theLidUnit;     // ptr. to a subcatchment's LID unit
-static TLidProc*  theLidProc;     // ptr. to a LID process
+static THREADLOCAL TLidUnit*  theLidUnit;     // ptr. to a subcatchment's LID unit
+static THREADLOCAL TLidProc*  theLidProc;     // ptr. to a LID process
 
-static double     Tstep;          // current time step (sec)
-static double     EvapRate;       // evaporation rate (ft/s)
-static double     MaxNativeInfil; // native soil infil. rate limit (ft/s)
+static THREADLOCAL double     Tstep;          // current time step (sec)
+static THREADLOCAL double     EvapRate;       // evaporation rate (ft/s)
+static THREADLOCAL double     MaxNativeInfil; // native soil infil. rate limit (ft/s)
 
-static double     SurfaceInflow;  // precip. + runon to LID unit (ft/s)
-static double     SurfaceInfil;   // infil. rate from surface layer (ft/s)
-static double     SurfaceEvap;    // evap. rate from surface layer (ft/s)
-static double     SurfaceOutflow; // outflow from surface layer (ft/s)
-static double     SurfaceVolume;  // volume in surface storage (ft)
+static THREADLOCAL double     SurfaceInflow;  // precip. + runon to LID unit (ft/s)
+static THREADLOCAL double     SurfaceInfil;   // infil. rate from surface layer (ft/s)
+static THREADLOCAL double     SurfaceEvap;    // evap. rate from surface layer (ft/s)
+static THREADLOCAL double     SurfaceOutflow; // outflow from surface layer (ft/s)
+static THREADLOCAL double     SurfaceVolume;  // volume in surface storage (ft)
 
-static double     PaveEvap;       // evap. from pavement layer (ft/s)
-static double     PavePerc;       // percolation from pavement layer (ft/s)
-static double     PaveVolume;     // volume stored in pavement layer  (ft)
+static THREADLOCAL double     PaveEvap;       // evap. from pavement layer (ft/s)
+static THREADLOCAL double     PavePerc;       // percolation from pavement layer (ft/s)
+static THREADLOCAL double     PaveVolume;     // volume stored in pavement layer  (ft)
 
-static double     SoilEvap;       // evap. from soil layer (ft/s)
-static double     SoilPerc;       // percolation from soil layer (ft/s)
-static double     SoilVolume;     // volume in soil/pavement storage (ft)
+static THREADLOCAL double     SoilEvap;       // evap. from soil layer (ft/s)
+static THREADLOCAL double     SoilPerc;       // percolation from soil layer (ft/s)
+static THREADLOCAL double     SoilVolume;     // volume in soil/pavement storage (ft)
 
-static double     StorageInflow;  // inflow rate to storage layer (ft/s)
-static double     StorageExfil;   // exfil. rate from storage layer (ft/s)
-static double     StorageEvap;    // evap.rate from storage layer (ft/s)
-static double     StorageDrain;   // underdrain flow rate layer (ft/s)
-static double     StorageVolume;  // volume in storage layer (ft)
+static THREADLOCAL double     StorageInflow;  // inflow rate to storage layer (ft/s)
+static THREADLOCAL double     StorageExfil;   // exfil. rate from storage layer (ft/s)
+static THREADLOCAL double     StorageEvap;    // evap.rate from storage layer (ft/s)
+static THREADLOCAL double     StorageDrain;   // underdrain flow rate layer (ft/s)
+static THREADLOCAL double     StorageVolume;  // volume in storage layer (ft)
 
-static double     Xold[MAX_LAYERS];  // previous moisture level in LID layers
+static THREADLOCAL double     Xold[MAX_LAYERS];  // previous moisture level in LID layers
 
 //-----------------------------------------------------------------------------
 //  External Functions (declared in lid.h)
@@ -227,7 +229,7 @@ void lidproc_initWaterRate(TLidUnit* lidUnit)
 
 double lidproc_getOutflow(TLidUnit* lidUnit, TLidProc* lidProc, double inflow,
                           double evap, double infil, double maxInfil,
-                          double tStep, double* lidEvap,
+                          double infilFactor, double tStep, double* lidEvap,
                           double* lidInfil, double* lidDrain)
 //
 //  Purpose: computes runoff outflow from a single LID unit.
@@ -237,6 +239,7 @@ double lidproc_getOutflow(TLidUnit* lidUnit, TLidProc* lidProc, double inflow,
 //           evap     = potential evaporation rate (ft/s)
 //           infil    = infiltration rate to native soil (ft/s)
 //           maxInfil = max. infiltration rate to native soil (ft/s)
+//           infilFactor = hydraulic conductivity adjustment factor
 //           tStep    = time step (sec)
 //  Output:  lidEvap  = evaporation rate for LID unit (ft/s)
 //           lidInfil = infiltration rate for LID unit (ft/s)
@@ -305,7 +308,7 @@ double lidproc_getOutflow(TLidUnit* lidUnit, TLidProc* lidProc, double inflow,
         SurfaceInfil =
             grnampt_getInfil(&theLidUnit->soilInfil, Tstep,
                              SurfaceInflow, theLidUnit->surfaceDepth,
-                             MOD_GREEN_AMPT);
+                             MOD_GREEN_AMPT, infilFactor);
     }
     else SurfaceInfil = infil;
 
@@ -384,14 +387,14 @@ double lidproc_getOutflow(TLidUnit* lidUnit, TLidProc* lidProc, double inflow,
 
 //=============================================================================
 
-void lidproc_saveResults(TLidUnit* lidUnit, double ucfRainfall, double ucfRainDepth)
+int lidproc_saveResults(TLidUnit* lidUnit, double ucfRainfall, double ucfRainDepth)
 //
 //  Purpose: updates the mass balance for an LID unit and saves
 //           current flux rates to the LID report file.
 //  Input:   lidUnit = ptr. to LID unit
 //           ucfRainfall = units conversion factor for rainfall rate
 //           ucfDepth = units conversion factor for rainfall depth
-//  Output:  none
+//  Output:  returns TRUE if the LID unit is wet, FALSE if dry
 //
 {
     double ucf;                        // units conversion factor
@@ -424,9 +427,6 @@ void lidproc_saveResults(TLidUnit* lidUnit, double ucfRainfall, double ucfRainDe
 		 totalEvap      < MINFLOW
        ) isDry = TRUE;
 
-    //... update status of HasWetLids
-    if ( !isDry ) HasWetLids = TRUE;
-
     //... write results to LID report file
     if ( lidUnit->rptFile )
     {
@@ -494,6 +494,7 @@ void lidproc_saveResults(TLidUnit* lidUnit, double ucfRainfall, double ucfRainDe
             theLidUnit->rptFile->wasDry = 0; 
         }
     }
+    return !isDry;
 }
 
 //=============================================================================
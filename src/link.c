@@ -45,6 +45,14 @@
 //   - Support added for head-dependent weir coefficient curves.
 //   - Adjustment of regulator link crest offset to match downstream node invert
 //     now only done for Dynamic Wave flow routing.
+//
+//   Build 5.2.0:
+//   - Last critical & normal depths found for each link are cached and
+//     used to start the next solution (see link_getYcrit & link_getYnorm).
+//     Roots found by iteration only start from them when the
+//     DepthWarmStart option is set.
+//   - Lists of the links of each kind are made for the routing loops
+//     (see link_createLists).
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -67,6 +75,8 @@ static const double MIN_DELTA_Z = 0.001; // minimum elevation change for conduit
 //  link_readLossParams    (called by parseLine in input.c)
 //  link_validate          (called by project_validate in project.c)
 //  link_initState         (called by initObjects in swmm5.c)
+//  link_createLists       (called by routing_open in routing.c)
+//  link_deleteLists       (called by routing_close in routing.c)
 //  link_setOldHydState    (called by routing_execute in routing.c)
 //  link_setOldQualState   (called by routing_execute in routing.c)
 //  link_setTargetSetting  (called by routing_execute in routing.c)
@@ -86,6 +96,7 @@ static const double MIN_DELTA_Z = 0.001; // minimum elevation change for conduit
 //  Local functions
 //-----------------------------------------------------------------------------
 static void   link_setParams(int j, int type, int n1, int n2, int k, double x[]);
+static void   getLinkLists(int j, int inList[]);
 static void   link_convertOffsets(int j);
 static double link_getOffsetHeight(int j, double offset, double elev);
 
@@ -501,6 +512,8 @@ void link_initState(int j)
     Link[j].timeLastSet = StartDate;
     Link[j].inletControl  = FALSE;
     Link[j].normalFlow    = FALSE;
+    memset(&Link[j].yCritCache, 0, sizeof(TDepthCache));
+    memset(&Link[j].yNormCache, 0, sizeof(TDepthCache));
     if ( Link[j].type == CONDUIT ) conduit_initState(j, Link[j].subIndex);
     if ( Link[j].type == PUMP    ) pump_initState(j, Link[j].subIndex);
 
@@ -515,6 +528,93 @@ void link_initState(int j)
 
 //=============================================================================
 
+int link_createLists()
+//
+//  Input:   none
+//  Output:  returns FALSE if not enough memory
+//  Purpose: lists the links of each kind used by the flow routing loops.
+//
+//  The links of list k are stored in increasing order of link index
+//  between positions LinkListStart[k] and LinkListStart[k+1]-1 of
+//  LinkLists, so that loops applying to only one kind of link need not
+//  visit (and test the type of) every link. A link can appear in more
+//  than one list. Link & node types don't change during a run, so the
+//  lists are made once when routing begins.
+{
+    int j, k;
+    int inList[MAX_LINK_LISTS];
+    int pos[MAX_LINK_LISTS];
+
+    LinkLists = NULL;
+    LinkListStart = (int *) calloc(MAX_LINK_LISTS + 1, sizeof(int));
+    if ( LinkListStart == NULL ) return FALSE;
+
+    // --- count the links in each list
+    for (j = 0; j < Nobjects[LINK]; j++)
+    {
+        getLinkLists(j, inList);
+        for (k = 0; k < MAX_LINK_LISTS; k++)
+            LinkListStart[k+1] += inList[k];
+    }
+    for (k = 0; k < MAX_LINK_LISTS; k++)
+        LinkListStart[k+1] += LinkListStart[k];
+
+    // --- add each link to its lists
+    LinkLists = (int *) calloc(LinkListStart[MAX_LINK_LISTS] + 1, sizeof(int));
+    if ( LinkLists == NULL ) return FALSE;
+    memcpy(pos, LinkListStart, MAX_LINK_LISTS * sizeof(int));
+    for (j = 0; j < Nobjects[LINK]; j++)
+    {
+        getLinkLists(j, inList);
+        for (k = 0; k < MAX_LINK_LISTS; k++)
+        {
+            if ( inList[k] ) LinkLists[pos[k]++] = j;
+        }
+    }
+    return TRUE;
+}
+
+//=============================================================================
+
+void link_deleteLists()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: frees the lists of links of each kind.
+//
+{
+    FREE(LinkListStart);
+    FREE(LinkLists);
+}
+
+//=============================================================================
+
+void getLinkLists(int j, int inList[])
+//
+//  Input:   j = link index
+//  Output:  inList[k] = TRUE if link belongs to list k
+//  Purpose: finds which lists of links a link belongs to.
+//
+{
+    int isConduit = ( Link[j].type == CONDUIT );
+    int isDummy = ( isConduit && Link[j].xsect.type == DUMMY );
+
+    inList[CONDUIT_LIST]       = isConduit;
+    inList[TRUE_CONDUIT_LIST]  = ( isConduit && !isDummy );
+    inList[DUMMY_CONDUIT_LIST] = isDummy;
+    inList[PUMP_LIST]          = ( Link[j].type == PUMP );
+    inList[ORIFICE_LIST]       = ( Link[j].type == ORIFICE );
+    inList[WEIR_LIST]          = ( Link[j].type == WEIR );
+    inList[OUTLET_LIST]        = ( Link[j].type == OUTLET );
+    inList[REGULATOR_LIST]     = ( Link[j].type == ORIFICE ||
+                                   Link[j].type == WEIR ||
+                                   Link[j].type == OUTLET );
+    inList[OUTFALL_LINK_LIST]  = ( Node[Link[j].node1].type == OUTFALL ||
+                                   Node[Link[j].node2].type == OUTFALL );
+}
+
+//=============================================================================
+
 double  link_getInflow(int j)
 //
 //  Input:   j = link index
@@ -749,8 +849,23 @@ double link_getYcrit(int j, double q)
 //  Output:  returns critical depth (ft)
 //  Purpose: computes critical depth for given flow rate.
 //
+//  The depth found for the link's previous flow is reused if the flow
+//  hasn't changed, otherwise the search interval that held it (and the
+//  depth itself when the DepthWarmStart option is set) starts the search
+//  for the new depth.
+//
 {
-    return xsect_getYcrit(&Link[j].xsect, q);
+    TDepthCache* cache = &Link[j].yCritCache;
+
+    cache->calls++;
+    if ( q == cache->q )
+    {
+        cache->hits++;
+        return cache->y;
+    }
+    cache->y = xsect_getYcritNear(&Link[j].xsect, q, cache);
+    cache->q = q;
+    return cache->y;
 }
 
 //=============================================================================
@@ -762,9 +877,14 @@ double  link_getYnorm(int j, double q)
 //  Output:  returns normal depth (ft)
 //  Purpose: computes normal depth for given flow rate.
 //
+//  The depth found for the link's previous flow is reused if the flow
+//  hasn't changed, otherwise its flow area starts the search for the
+//  new flow area when the DepthWarmStart option is set.
+//
 {
     int    k;
-    double s, a, y;
+    double s;
+    TDepthCache* cache = &Link[j].yNormCache;
 
     if ( Link[j].type != CONDUIT ) return 0.0;
     if ( Link[j].xsect.type == DUMMY ) return 0.0;
@@ -772,10 +892,19 @@ double  link_getYnorm(int j, double q)
     k = Link[j].subIndex;
     if ( q > Conduit[k].qMax ) q = Conduit[k].qMax;
     if ( q <= 0.0 ) return 0.0;
+    cache->calls++;
+    if ( q == cache->q )
+    {
+        cache->hits++;
+        return cache->y;
+    }
     s = q / Conduit[k].beta;
-    a = xsect_getAofS(&Link[j].xsect, s);
-    y = xsect_getYofA(&Link[j].xsect, a);
-    return y;
+    cache->a = xsect_getAofSNear(&Link[j].xsect, s,
+                                 DepthWarmStart ? cache->a : 0.0,
+                                 &cache->evals);
+    cache->y = xsect_getYofA(&Link[j].xsect, cache->a);
+    cache->q = q;
+    return cache->y;
 }
 
 //=============================================================================
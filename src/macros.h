@@ -36,3 +36,26 @@
 // Macro to evaluate function x with error checking
 //-------------------------------------------------
 #define CALL(x) (ErrorCode = ((ErrorCode>0) ? (ErrorCode) : (x)))
+
+//-------------------------------------------------
+// Storage class for data private to a calling thread
+//-------------------------------------------------
+#ifdef _MSC_VER
+#define THREADLOCAL __declspec(thread)
+#else
+#define THREADLOCAL __thread
+#endif
+
+//-------------------------------------------------
+// Storage class for the calling thread's project pointer, which is read
+// on every access to project data. The initial-exec model reads it at a
+// fixed offset from the thread pointer instead of calling
+// __tls_get_addr as a shared library otherwise must. It uses a few
+// bytes of the static TLS block that the loader reserves for libraries
+// opened with dlopen.
+//-------------------------------------------------
+#if defined(__GNUC__) && !defined(_WIN32)
+#define THREADLOCAL_IE __thread __attribute__((tls_model("initial-exec")))
+#else
+#define THREADLOCAL_IE THREADLOCAL
+#endif
@@ -8,8 +8,12 @@
 
 //   Main stub for the command line version of EPA SWMM 5.1
 //   to be run with swmm5.dll.
+//
+//   Build 5.2.0:
+//   - Added --ensemble option for running a file of scenarios in parallel.
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include "swmm5.h"
@@ -26,6 +30,10 @@ int  main(int argc, char *argv[])
 //  where f1 = name of input file, f2 = name of report file, and
 //  f3 = name of binary output file if saved (or blank if not saved).
 //
+//  or:  swmm5 --ensemble scn threads f1  f2  f3
+//  where scn = name of a scenario file and threads = number of scenarios
+//  run at once (0 for one per processor).
+//
 {
     char *inputFile;
     char *reportFile;
@@ -34,6 +42,7 @@ int  main(int argc, char *argv[])
     char blank[] = "";
     char errMsg[128];
     int  msgLen = 127;
+    int  errCode;
     time_t start;
     double runTime;
 
@@ -57,7 +66,10 @@ int  main(int argc, char *argv[])
             printf("\t--help (-h)       Help Docs\n");
             printf("\t--version (-v)    Build Version\n");
             printf("\nRUNNING A SIMULATION:\n");
-            printf("\t swmm5 <input file> <report file> <output file>\n\n");
+            printf("\t swmm5 <input file> <report file> <output file>\n");
+            printf("\nRUNNING A SCENARIO ENSEMBLE:\n");
+            printf("\t swmm5 --ensemble <scenario file> <threads> "
+                   "<input file> <report file> <output file>\n\n");
         }
         else if (strcmp(arg1, "--version") == 0 || strcmp(arg1, "-v") == 0)
         {
@@ -72,6 +84,31 @@ int  main(int argc, char *argv[])
             printf("\nUnknown Argument (See Help --help)\n\n");
         }
     }
+    else if (strcmp(argv[1], "--ensemble") == 0 || strcmp(argv[1], "-e") == 0)
+    {
+        if (argc < 6)
+        {
+            printf("\nNot Enough Arguments (See Help --help)\n\n");
+            return 0;
+        }
+        inputFile = argv[4];
+        reportFile = argv[5];
+        if (argc > 6) binaryFile = argv[6];
+        else          binaryFile = blank;
+        printf("\n... EPA-SWMM %s.%s (Build %s.%s.%s)\n",
+            SEMVERSION_MAJOR, SEMVERSION_MINOR,
+            SEMVERSION_MAJOR, SEMVERSION_MINOR, SEMVERSION_PATCH);
+
+        // --- run each scenario of the ensemble
+        errCode = swmm_runEnsemble(inputFile, reportFile, binaryFile,
+                                   argv[2], atoi(argv[3]));
+
+        // Display closing status on console
+        runTime = difftime(time(0), start);
+        printf("\n\n... EPA-SWMM ensemble completed in %.2f seconds.", runTime);
+        if ( errCode > 0 ) printf(" There are errors (see %s).\n", reportFile);
+        else printf("\n");
+    }
     else
     {
         // --- extract file names from command line arguments
@@ -55,21 +55,21 @@ static const double MAX_FLOW_BALANCE_ERR   = 10.0;
 //-----------------------------------------------------------------------------
 //  Shared variables   
 //-----------------------------------------------------------------------------
-TRunoffTotals    RunoffTotals;    // overall surface runoff continuity totals
-TLoadingTotals*  LoadingTotals;   // overall WQ washoff continuity totals
-TGwaterTotals    GwaterTotals;    // overall groundwater continuity totals 
-TRoutingTotals   FlowTotals;      // overall routed flow continuity totals 
-TRoutingTotals*  QualTotals;      // overall routed WQ continuity totals 
-TRoutingTotals   StepFlowTotals;  // routed flow totals over time step
-TRoutingTotals   OldStepFlowTotals;
-TRoutingTotals*  StepQualTotals;  // routed WQ totals over time step
+#define RunoffTotals      (Prj->massbal.RunoffTotals)
+#define LoadingTotals     (Prj->massbal.LoadingTotals)
+#define GwaterTotals      (Prj->massbal.GwaterTotals)
+#define FlowTotals        (Prj->massbal.FlowTotals)
+#define QualTotals        (Prj->massbal.QualTotals)
+#define StepFlowTotals    (Prj->massbal.StepFlowTotals)
+#define OldStepFlowTotals (Prj->massbal.OldStepFlowTotals)
+#define StepQualTotals    (Prj->massbal.StepQualTotals)
 
 //-----------------------------------------------------------------------------
 //  Exportable variables
 //-----------------------------------------------------------------------------
-double*  NodeInflow;              // total inflow volume to each node (ft3)
-double*  NodeOutflow;             // total outflow volume from each node (ft3)
-double   TotalArea;               // total drainage area (ft2)
+#define NodeInflow        (Prj->massbal.NodeInflow)
+#define NodeOutflow       (Prj->massbal.NodeOutflow)
+#define TotalArea         (Prj->massbal.TotalArea)
 
 //-----------------------------------------------------------------------------
 //  External functions (declared in funcs.h)
@@ -77,10 +77,11 @@ double   TotalArea;               // total drainage area (ft2)
 //  massbal_open                (called from swmm_start in swmm5.c)
 //  massbal_close               (called from swmm_end in swmm5.c)
 //  massbal_report              (called from swmm_end in swmm5.c)
-//  massbal_updateRunoffTotals  (called from subcatch_getRunoff)
+//  massbal_snapshot            (called from listState in snapshot.c)
+//  massbal_updateRunoffTotals  (called from runoff_updateTotals in runoff.c)
 //  massbal_updateDrainTotals   (called from evalLidUnit in lid.c)
 //  massbal_updateLoadingTotals (called from subcatch_getBuildup)
-//  massbal_updateGwaterTotals  (called from updateMassBal in gwater.c)
+//  massbal_updateGwaterTotals  (called from runoff_updateTotals in runoff.c)
 //  massbal_updateRoutingTotals (called from routing_execute)
 //  massbal_initTimeStepTotals  (called from routing_execute)
 //  massbal_addInflowFlow       (called from routing.c)
@@ -269,6 +270,23 @@ void massbal_close()
 
 //=============================================================================
 
+void massbal_snapshot(struct TSnapshot* snap)
+//
+//  Input:   snap = snapshot being built
+//  Output:  none
+//  Purpose: adds the mass balance totals to a snapshot.
+//
+{
+    int n = Nobjects[POLLUT];
+    snapshot_addBlock(snap, LoadingTotals, n * sizeof(TLoadingTotals));
+    snapshot_addBlock(snap, QualTotals, n * sizeof(TRoutingTotals));
+    snapshot_addBlock(snap, StepQualTotals, n * sizeof(TRoutingTotals));
+    snapshot_addBlock(snap, NodeInflow, Nobjects[NODE] * sizeof(double));
+    snapshot_addBlock(snap, NodeOutflow, Nobjects[NODE] * sizeof(double));
+}
+
+//=============================================================================
+
 void massbal_report()
 //
 //  Input:   none
@@ -48,6 +48,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <math.h>
+#include "macros.h"
 #include "mathexpr.h"
 
 #define MAX_STACK_SIZE  1024
@@ -67,14 +68,14 @@ typedef struct TreeNode ExprTree;
 
 // Local variables
 //----------------
-static int    Err;
-static int    Bc;
-static int    PrevLex, CurLex;
-static int    Len, Pos;
-static char   *S;
-static char   Token[255];
-static int    Ivar;
-static double Fvalue;
+static THREADLOCAL int    Err;
+static THREADLOCAL int    Bc;
+static THREADLOCAL int    PrevLex, CurLex;
+static THREADLOCAL int    Len, Pos;
+static THREADLOCAL char   *S;
+static THREADLOCAL char   Token[255];
+static THREADLOCAL int    Ivar;
+static THREADLOCAL double Fvalue;
 
 // math function names
 char *MathFunc[] =  {"COS", "SIN", "TAN", "COT", "ABS", "SGN",
@@ -101,7 +102,7 @@ static void       traverseTree(ExprTree *, MathExpr **);
 static void       deleteTree(ExprTree *);
 
 // Callback functions
-static int    (*getVariableIndex) (char *); // return index of named variable
+static THREADLOCAL int (*getVariableIndex) (char *); // return index of named variable
 
 //=============================================================================
 
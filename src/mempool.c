@@ -18,6 +18,7 @@
 
 #include <stdlib.h>
 #include <stdlib.h>
+#include "macros.h"
 #include "mempool.h"
 
 /*
@@ -53,7 +54,7 @@ typedef struct alloc_root_s
 **  root - Pointer to the current pool.
 */
 
-static alloc_root_t *root;
+static THREADLOCAL alloc_root_t *root;
 
 
 /*
@@ -7,7 +7,7 @@
 //  alloc pool - only the alloc routines know its structure.
 //-----------------------------------------------------------------------------
 
-typedef struct
+typedef struct alloc_handle_t
 {
    long  dummy;
 }  alloc_handle_t;
@@ -0,0 +1,270 @@
+//-----------------------------------------------------------------------------
+//   nksolve.c
+//
+//   Jacobian-free Newton-Krylov solution of a system of nonlinear equations
+//   F(x) = 0. Each Newton step is found with the GMRES method (without
+//   restarts), where the product of the Jacobian of F with a vector is
+//   approximated by a finite difference of F, and is followed by a
+//   backtracking line search on the norm of F.
+//
+//   All variables are scaled by user-supplied factors, and convergence is
+//   reached when every scaled component of F is no greater than 1.
+//
+//   Date:     10/16/26   (Build 5.2.0)
+//
+//   Work arrays are held in a TNkSolver owned by the caller and are
+//   re-allocated on demand.
+//
+//   The Krylov basis holds up to MAXKRYLOV+1 vectors of n values and is
+//   swept twice for each new vector by the Gram-Schmidt orthogonalization,
+//   so it makes up most of the memory traffic of the GMRES iterations. It
+//   is of type NkReal, which is float in builds made with
+//   SWMM_SINGLE_PRECISION_STATE defined. The GMRES solution only needs to
+//   reduce the residual by a factor of ETA, and the dot products are still
+//   summed in double precision.
+//-----------------------------------------------------------------------------
+
+#include <stdlib.h>
+#include <math.h>
+#include "macros.h"
+#include "nksolve.h"
+
+#define MAXKRYLOV   30         // max. number of GMRES iterations
+#define ETA         0.1        // relative tolerance of GMRES solution
+#define MAXBACKTRACK 5         // max. number of line search step cuts
+#define ALPHA       1.0e-4     // sufficient decrease factor of line search
+
+//-----------------------------------------------------------------------------
+//    Local declarations
+//-----------------------------------------------------------------------------
+// function that finds the Newton step by the GMRES method
+static int findStep(TNkSolver* nk, double x[], double xscal[], int n,
+                    double ferr, TNkResid resid, void* data);
+
+// function that finds the scaled 2-norm of F
+static double getNorm(double fx[], double xscal[], int n);
+
+
+//-----------------------------------------------------------------------------
+//    open the Newton-Krylov solver nk to solve system of n equations
+//    (return 1 if successful, 0 if not; nk must have been opened
+//    before or be zero-filled)
+//-----------------------------------------------------------------------------
+int nksolve_open(TNkSolver* nk, int n)
+{
+    nksolve_close(nk);
+    nk->f    = (double *) calloc(n, sizeof(double));
+    nk->ftry = (double *) calloc(n, sizeof(double));
+    nk->xtry = (double *) calloc(n, sizeof(double));
+    nk->dx   = (double *) calloc(n, sizeof(double));
+    nk->v    = (NkReal *) calloc((MAXKRYLOV+1)*n, sizeof(NkReal));
+    nk->h    = (double *) calloc((MAXKRYLOV+1)*MAXKRYLOV, sizeof(double));
+    nk->cs   = (double *) calloc(MAXKRYLOV, sizeof(double));
+    nk->sn   = (double *) calloc(MAXKRYLOV, sizeof(double));
+    nk->g    = (double *) calloc(MAXKRYLOV+1, sizeof(double));
+    if ( !nk->f || !nk->ftry || !nk->xtry || !nk->dx || !nk->v || !nk->h ||
+         !nk->cs || !nk->sn || !nk->g ) return 0;
+    nk->nmax = n;
+    return 1;
+}
+
+
+//-----------------------------------------------------------------------------
+//    close the Newton-Krylov solver nk
+//-----------------------------------------------------------------------------
+void nksolve_close(TNkSolver* nk)
+{
+    FREE(nk->f);
+    FREE(nk->ftry);
+    FREE(nk->xtry);
+    FREE(nk->dx);
+    FREE(nk->v);
+    FREE(nk->h);
+    FREE(nk->cs);
+    FREE(nk->sn);
+    FREE(nk->g);
+    nk->nmax = 0;
+}
+
+
+int nksolve_solve(TNkSolver* nk, double x[], double xscal[], int n,
+    double ferr, int maxIter, int* iter, TNkResid resid, void* data)
+//---------------------------------------------------------------
+//   Driver function for the Newton-Krylov solver. Starting from
+//   the n values in x[], finds x where resid(data, x, F) returns an F
+//   with |F[i]| <= xscal[i] for all i, taking at most maxIter
+//   Newton steps. ferr is the relative rounding error of the F
+//   values found by resid(). Returns 1 if successful (with x[]
+//   holding the solution and the last call to resid() made at x)
+//   or 0 if not, and the number of Newton steps taken in iter.
+//---------------------------------------------------------------
+{
+    int    i, k;
+    double fnorm, fnew, lambda;
+    double *f, *ftry, *xtry, *dx;
+
+    *iter = 0;
+    if ( nk->nmax < n && !nksolve_open(nk, n) ) return 0;
+    f = nk->f;
+    ftry = nk->ftry;
+    xtry = nk->xtry;
+    dx = nk->dx;
+    resid(data, x, f);
+    fnorm = getNorm(f, xscal, n);
+    for (;;)
+    {
+        // --- check for convergence
+        for (i = 0; i < n; i++)
+        {
+            if ( fabs(f[i]) > xscal[i] ) break;
+        }
+        if ( i == n ) return 1;
+        if ( *iter == maxIter ) return 0;
+
+        // --- find Newton step
+        if ( !findStep(nk, x, xscal, n, ferr, resid, data) ) return 0;
+        (*iter)++;
+
+        // --- cut step back until norm of F decreases enough
+        lambda = 1.0;
+        for (k = 0; k < MAXBACKTRACK; k++)
+        {
+            for (i = 0; i < n; i++) xtry[i] = x[i] + lambda * dx[i];
+            resid(data, xtry, ftry);
+            fnew = getNorm(ftry, xscal, n);
+            if ( fnew < (1.0 - ALPHA * lambda) * fnorm ) break;
+            lambda *= 0.5;
+        }
+        if ( k == MAXBACKTRACK ) return 0;
+
+        // --- accept trial solution
+        for (i = 0; i < n; i++)
+        {
+            x[i] = xtry[i];
+            f[i] = ftry[i];
+        }
+        fnorm = fnew;
+    }
+}
+
+
+int findStep(TNkSolver* nk, double x[], double xscal[], int n,
+             double ferr, TNkResid resid, void* data)
+//---------------------------------------------------------------
+//   Solves J*dx = -F for the Newton step dx by GMRES, where the
+//   product of J with the k-th Krylov vector is approximated by
+//   (F(x + eps*v[k]) - F(x)) / eps in scaled variables, with eps
+//   sized to the rounding error ferr of F. Returns 0 if no step
+//   could be found.
+//---------------------------------------------------------------
+{
+    int    i, j, k, m;
+    double beta, eps, t, xnorm;
+    NkReal tv;
+    NkReal *vk, *w, *v = nk->v;
+    double *f = nk->f, *ftry = nk->ftry, *xtry = nk->xtry, *dx = nk->dx,
+           *h = nk->h, *cs = nk->cs, *sn = nk->sn, *g = nk->g;
+
+    // --- first Krylov vector is the normalized scaled -F
+    m = MIN(MAXKRYLOV, n);
+    beta = getNorm(f, xscal, n);
+    if ( beta == 0.0 ) return 0;
+    for (i = 0; i < n; i++) v[i] = -f[i] / xscal[i] / beta;
+    g[0] = beta;
+
+    // --- size of finite difference increment
+    xnorm = 0.0;
+    for (i = 0; i < n; i++) xnorm += fabs(x[i] / xscal[i]);
+    eps = sqrt(ferr) * (1.0 + xnorm / n);
+
+    for (k = 0; k < m; k++)
+    {
+        // --- w = J * v[k] (stored as next Krylov vector)
+        vk = v + k*n;
+        w = v + (k+1)*n;
+        for (i = 0; i < n; i++) xtry[i] = x[i] + eps * vk[i] * xscal[i];
+        resid(data, xtry, ftry);
+        for (i = 0; i < n; i++) w[i] = (ftry[i] - f[i]) / xscal[i] / eps;
+
+        // --- orthogonalize w against previous vectors (modified G-S)
+        for (j = 0; j <= k; j++)
+        {
+            t = 0.0;
+            for (i = 0; i < n; i++) t += (double)w[i] * v[j*n+i];
+            h[j*MAXKRYLOV+k] = t;
+            tv = (NkReal)t;
+            for (i = 0; i < n; i++) w[i] -= tv * v[j*n+i];
+        }
+        t = 0.0;
+        for (i = 0; i < n; i++) t += (double)w[i] * w[i];
+        t = sqrt(t);
+        h[(k+1)*MAXKRYLOV+k] = t;
+        tv = (NkReal)t;
+        if ( t > 0.0 ) for (i = 0; i < n; i++) w[i] /= tv;
+
+        // --- apply previous Givens rotations to new column of h
+        for (j = 0; j < k; j++)
+        {
+            t = cs[j] * h[j*MAXKRYLOV+k] + sn[j] * h[(j+1)*MAXKRYLOV+k];
+            h[(j+1)*MAXKRYLOV+k] = -sn[j] * h[j*MAXKRYLOV+k] +
+                                    cs[j] * h[(j+1)*MAXKRYLOV+k];
+            h[j*MAXKRYLOV+k] = t;
+        }
+
+        // --- find new rotation that zeroes sub-diagonal of column k
+        t = sqrt(h[k*MAXKRYLOV+k] * h[k*MAXKRYLOV+k] +
+                 h[(k+1)*MAXKRYLOV+k] * h[(k+1)*MAXKRYLOV+k]);
+        if ( t == 0.0 ) break;
+        cs[k] = h[k*MAXKRYLOV+k] / t;
+        sn[k] = h[(k+1)*MAXKRYLOV+k] / t;
+        h[k*MAXKRYLOV+k] = t;
+        h[(k+1)*MAXKRYLOV+k] = 0.0;
+        g[k+1] = -sn[k] * g[k];
+        g[k] = cs[k] * g[k];
+
+        // --- stop if residual of linear system is small enough
+        if ( fabs(g[k+1]) <= ETA * beta )
+        {
+            k++;
+            break;
+        }
+    }
+    if ( k == 0 ) return 0;
+    m = MIN(k, m);
+
+    // --- back substitute for coefficients of Krylov vectors
+    //     (stored in g)
+    for (j = m-1; j >= 0; j--)
+    {
+        t = g[j];
+        for (i = j+1; i < m; i++) t -= h[j*MAXKRYLOV+i] * g[i];
+        if ( h[j*MAXKRYLOV+j] == 0.0 ) return 0;
+        g[j] = t / h[j*MAXKRYLOV+j];
+    }
+
+    // --- form Newton step in unscaled variables
+    for (i = 0; i < n; i++)
+    {
+        t = 0.0;
+        for (j = 0; j < m; j++) t += g[j] * v[j*n+i];
+        dx[i] = t * xscal[i];
+    }
+    return 1;
+}
+
+
+double getNorm(double fx[], double xscal[], int n)
+//---------------------------------------------------------------
+//   Returns the 2-norm of F with each component divided by the
+//   scale factor of its variable.
+//---------------------------------------------------------------
+{
+    int    i;
+    double t, sum = 0.0;
+    for (i = 0; i < n; i++)
+    {
+        t = fx[i] / xscal[i];
+        sum += t * t;
+    }
+    return sqrt(sum);
+}
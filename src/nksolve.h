@@ -0,0 +1,43 @@
+//-----------------------------------------------------------------------------
+//  nksolve.h
+//
+//  Header file for the Newton-Krylov solver contained in nksolve.c
+//
+//  Build 5.2.0:
+//  - Work arrays held in a TNkSolver owned by the caller and a user data
+//    pointer passed on to the residual function.
+//  - Krylov basis vectors can be stored in single precision
+//    (SWMM_SINGLE_PRECISION_STATE build flag).
+//-----------------------------------------------------------------------------
+
+// type of the Krylov basis vectors, by far the largest of the work arrays
+// (their dot products and all other work arrays stay double)
+#ifdef SWMM_SINGLE_PRECISION_STATE
+typedef float  NkReal;
+#else
+typedef double NkReal;
+#endif
+
+// work arrays used by one caller of the Newton-Krylov solver
+typedef struct TNkSolver
+{
+    int      nmax;             // max. number of equations
+    double*  f;                // F at current solution
+    double*  ftry;             // F at trial solution
+    double*  xtry;             // trial solution
+    double*  dx;               // Newton step
+    NkReal*  v;                // Krylov basis vectors
+    double*  h;                // Hessenberg matrix
+    double*  cs;               // cosines of Givens rotations
+    double*  sn;               // sines of Givens rotations
+    double*  g;                // rotated GMRES residual vector
+} TNkSolver;
+
+// function that computes the residual F of x for a caller's data
+typedef void (*TNkResid)(void* data, double* x, double* f);
+
+// functions that open, close, and use the Newton-Krylov solver
+int  nksolve_open(TNkSolver* nk, int n);
+void nksolve_close(TNkSolver* nk);
+int  nksolve_solve(TNkSolver* nk, double x[], double xscal[], int n,
+     double ferr, int maxIter, int* iter, TNkResid resid, void* data);
@@ -54,6 +54,14 @@
 //   - Adjustment patterns added to TSubcatch structure.
 //   - Members impervRunoff and pervRunoff added to TSubcatchStats structure.
 //   - Member cdCurve (weir coeff. curve) added to TWeir structure.
+//
+//   Build 5.2.0:
+//   - Dense geometry tables (TDenseTbl) added to TTransect & TShape.
+//   - Caches of last critical & normal depth found (TDepthCache) added
+//     to TLink, with a cacheStats member added to TRptFlags.
+//   - Subcatchment runoff context (TRunoffContext) added.
+//   - Net precipitation, evaporation rate, runon volume and pervious area
+//     infiltration rate added to TRunoffContext.
 //-----------------------------------------------------------------------------
 
 #include "mathexpr.h"
@@ -153,6 +161,20 @@ typedef struct
    double        tanAnglat;       // tangent of latitude angle
 }  TTemp;
 
+//--------------------------------------
+// MOVING AVERAGE OF DAILY TEMPERATURES
+//--------------------------------------
+typedef struct
+{
+    double    tAve;          // moving avg. for daily temperature (deg F)
+    double    tRng;          // moving avg. for daily temp. range (deg F)
+    double    ta[7];         // data window for tAve
+    double    tr[7];         // data window for tRng
+    int       count;         // length of moving average window
+    int       maxCount;      // maximum length of moving average window
+    int       front;         // index of front of moving average window
+} TMovAve;
+
 //-----------------
 // WINDSPEED OBJECT
 //-----------------
@@ -401,6 +423,49 @@ typedef struct
    double*       surfaceBuildup;  // current surface buildup (mass)
 }  TSubcatch;
 
+//-----------------------------
+// SUBCATCHMENT RUNOFF CONTEXT
+//-----------------------------
+// Working values used while finding a subcatchment's runoff over a time
+// step. It is passed down through the runoff, LID & groundwater functions
+// so that subcatchments can be analyzed in parallel, and it holds the
+// subcatchment's additions to the system mass balance until they are
+// added to the system totals in subcatchment order.
+typedef struct TRunoffContext
+{
+   struct TOdeSolver* ode;        // ODE solver of the calling thread
+   double        infilFactor;     // hyd. conductivity adjustment factor
+   TSubarea*     subarea;         // subarea whose ponded depth is integrated
+   double        dStore;          // monthly adjusted depression storage (ft)
+   double        alpha;           // monthly adjusted runoff coeff.
+   double        netPrecip[3];    // net precip. on each subarea (ft/sec)
+   double        evapRate;        // potential evaporation rate (ft/sec)
+   double        pervInfil;       // pervious area infiltration (ft/sec)
+   //-----------------------------
+   double        vRunon;          // runon volume from other areas (ft3)
+   double        vEvap;           // evaporation (ft3)
+   double        vPevap;          // pervious area evaporation (ft3)
+   double        vInfil;          // non-LID infiltration (ft3)
+   double        vInflow;         // non-LID precip + snowmelt + runon + ponded water (ft3)
+   double        vOutflow;        // non-LID runoff to subcatchment's outlet (ft3)
+   double        vLidIn;          // impervious area flow to LID units (ft3)
+   double        vLidInfil;       // infiltration from LID units (ft3)
+   double        vLidOut;         // surface outflow from LID units (ft3)
+   double        vLidDrain;       // drain outflow from LID units (ft3)
+   double        vLidReturn;      // LID outflow returned to pervious area (ft3)
+   char          hasWetLids;      // TRUE if any of the LID units are wet
+   double        runoff;          // total runoff generated (ft/sec)
+   //-----------------------------
+   double        vRainfall;       // rainfall volume for mass balance (ft3)
+   double        vRunoff;         // runoff volume for mass balance (ft3)
+   double        vDrains;         // LID drain volume sent to nodes (ft3)
+   double        gwInfil;         // infiltration to groundwater (ft3)
+   double        gwUpperEvap;     // upper zone groundwater evaporation (ft3)
+   double        gwLowerEvap;     // lower zone groundwater evaporation (ft3)
+   double        gwLowerPerc;     // percolation to deep groundwater (ft3)
+   double        gwFlow;          // groundwater outflow (ft3)
+}  TRunoffContext;
+
 //-----------------------
 // TIME PATTERN DATA
 //-----------------------
@@ -582,6 +647,17 @@ typedef struct
    double        rBot;            // radius of bottom section
 }  TXsect;
 
+//---------------------------------------
+// DENSE GEOMETRY TABLE DATA STRUCTURE
+//---------------------------------------
+typedef struct
+{
+    int          n;                         // size of tables (0 if not used)
+    double*      yTbl;                      // table of depth v. area
+    double*      rTbl;                      // table of hyd. radius v. area
+    double*      sTbl;                      // table of section factor v. area
+}   TDenseTbl;
+
 //--------------------------------------
 // CROSS SECTION TRANSECT DATA STRUCTURE
 //--------------------------------------
@@ -603,6 +679,7 @@ typedef struct
     double       hradTbl[N_TRANSECT_TBL];   // table of hyd. radius v. depth
     double       widthTbl[N_TRANSECT_TBL];  // table of top width v. depth
     int          nTbl;                      // size of geometry tables
+    TDenseTbl    dense;                     // dense tables indexed by area
 }   TTransect;
 
 //-------------------------------------
@@ -621,8 +698,25 @@ typedef struct
     double       areaTbl[N_SHAPE_TBL];      // table of area v. depth
     double       hradTbl[N_SHAPE_TBL];      // table of hyd. radius v. depth
     double       widthTbl[N_SHAPE_TBL];     // table of top width v. depth
+    TDenseTbl    dense;                     // dense tables indexed by area
 }   TShape;
 
+//-------------------------------
+// LAST DEPTH FOUND FOR A LINK FLOW
+//-------------------------------
+typedef struct
+{
+   double        q;               // flow rate (cfs)
+   double        y;               // depth found for flow q (ft)
+   double        a;               // flow area at depth y (ft2)
+   int           k;               // index of search interval holding y
+   double        qLo;             // crit. flow at bottom of interval (cfs)
+   double        qHi;             // crit. flow at top of interval (cfs)
+   long          calls;           // number of depths requested
+   long          hits;            // number of requests needing no root solve
+   long          evals;           // number of function evaluations in solves
+}  TDepthCache;
+
 //------------
 // LINK OBJECT
 //------------
@@ -667,6 +761,8 @@ typedef struct
    char          bypassed;        // bypass dynwave calc. flag
    char          normalFlow;      // normal flow limited flag
    char          inletControl;    // culvert inlet control flag
+   TDepthCache   yCritCache;      // last critical depth found
+   TDepthCache   yNormCache;      // last normal depth found
 }  TLink;
 
 //---------------
@@ -827,6 +923,7 @@ typedef struct
    char          nodeStats;       // TRUE if routing node depth stats. reported
    char          controls;        // TRUE if control actions reported
    char          averages;        // TRUE if average results reported          //(5.1.013)
+   char          cacheStats;      // TRUE if depth cache hit rates reported
    int           linesPerPage;    // number of lines printed per page
 }  TRptFlags;
 
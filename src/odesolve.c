@@ -7,10 +7,16 @@
 //
 //   Date:     11/15/06
 //   Author:   L. Rossman
+//
+//   Build 5.2.0:
+//   - Work arrays are held in a TOdeSolver owned by the caller and
+//     re-allocated on demand, and a user data pointer is passed on to the
+//     derivative function, so that several threads can integrate at once.
 //-----------------------------------------------------------------------------
 
 #include <stdlib.h>
 #include <math.h>
+#include "macros.h"
 #include "odesolve.h"
 
 #define MAXSTP 10000
@@ -24,87 +30,86 @@
 //-----------------------------------------------------------------------------
 //    Local declarations
 //-----------------------------------------------------------------------------
-int      nmax;      // max. number of equations
-double*  y;         // dependent variable
-double*  yscal;     // scaling factors
-double*  yerr;      // integration errors
-double*  ytemp;     // temporary values of y
-double*  dydx;      // derivatives of y
-double*  ak;        // derivatives at intermediate points
-
-
 // function that integrates over an error-controlled stepsize
-int rkqs(double* x, int n, double htry, double eps, double* hdid,
-         double* hnext, void (*derivs)(double, double*, double*));
+static int rkqs(TOdeSolver* ode, double* x, int n, double htry, double eps,
+                double* hdid, double* hnext, TOdeDerivs derivs, void* data);
 
 // function that performs the Runge-Kutta integration step
-void rkck(double x, int n, double h, void (*derivs)(double, double*, double*));
+static void rkck(TOdeSolver* ode, double x, int n, double h,
+                 TOdeDerivs derivs, void* data);
 
 
 //-----------------------------------------------------------------------------
-//    open the ODE solver to solve system of n equations
+//    open an ODE solver's work arrays to solve system of n equations
 //    (return 1 if successful, 0 if not)
 //-----------------------------------------------------------------------------
-int odesolve_open(int n)
+int odesolve_open(TOdeSolver* ode, int n)
 {
-    nmax  = 0;
-    y     = (double *) calloc(n, sizeof(double));
-    yscal = (double *) calloc(n, sizeof(double));
-    dydx  = (double *) calloc(n, sizeof(double));
-    yerr  = (double *) calloc(n, sizeof(double));
-    ytemp = (double *) calloc(n, sizeof(double));
-    ak    = (double *) calloc(5*n, sizeof(double));
-    if ( !y || !yscal || !dydx || !yerr || !ytemp || !ak ) return 0;
-    nmax = n;
+    odesolve_close(ode);
+    ode->y     = (double *) calloc(n, sizeof(double));
+    ode->yscal = (double *) calloc(n, sizeof(double));
+    ode->dydx  = (double *) calloc(n, sizeof(double));
+    ode->yerr  = (double *) calloc(n, sizeof(double));
+    ode->ytemp = (double *) calloc(n, sizeof(double));
+    ode->ak    = (double *) calloc(5*n, sizeof(double));
+    if ( !ode->y || !ode->yscal || !ode->dydx || !ode->yerr ||
+         !ode->ytemp || !ode->ak ) return 0;
+    ode->nmax = n;
     return 1;
 }
 
 
 //-----------------------------------------------------------------------------
-//    close the ODE solver
+//    close an ODE solver's work arrays
+//    (the solver must have been opened or zero-filled beforehand)
 //-----------------------------------------------------------------------------
-void odesolve_close()
+void odesolve_close(TOdeSolver* ode)
 {
-    if ( y ) free(y);
-    y = NULL;
-    if ( yscal ) free(yscal);
-    yscal = NULL;
-    if ( dydx ) free(dydx);
-    dydx = NULL;
-    if ( yerr ) free(yerr);
-    yerr = NULL;
-    if ( ytemp ) free(ytemp);
-    ytemp = NULL;
-    if ( ak ) free(ak);
-    ak = NULL;
-    nmax = 0;
+    if ( ode->y ) free(ode->y);
+    ode->y = NULL;
+    if ( ode->yscal ) free(ode->yscal);
+    ode->yscal = NULL;
+    if ( ode->dydx ) free(ode->dydx);
+    ode->dydx = NULL;
+    if ( ode->yerr ) free(ode->yerr);
+    ode->yerr = NULL;
+    if ( ode->ytemp ) free(ode->ytemp);
+    ode->ytemp = NULL;
+    if ( ode->ak ) free(ode->ak);
+    ode->ak = NULL;
+    ode->nmax = 0;
 }
 
 
-int odesolve_integrate(double ystart[], int n, double x1, double x2,
-      double eps, double h1, void (*derivs)(double, double*, double*))
+int odesolve_integrate(TOdeSolver* ode, double ystart[], int n, double x1,
+      double x2, double eps, double h1, TOdeDerivs derivs, void* data)
 //---------------------------------------------------------------
 //   Driver function for Runge-Kutta integration with adaptive
 //   stepsize control. Integrates starting n values in ystart[]
-//   from x1 to x2 with accuracy eps. h1 is the initial stepsize
-//   guess and derivs is a user-supplied function that computes
-//   derivatives dy/dx of y. On completion, ystart[] contains the
-//   new values of y at the end of the integration interval.
+//   from x1 to x2 with accuracy eps using the work arrays in ode.
+//   h1 is the initial stepsize guess and derivs is a user-supplied
+//   function that computes derivatives dy/dx of y, to which data
+//   is passed. On completion, ystart[] contains the new values of
+//   y at the end of the integration interval.
 //---------------------------------------------------------------
 {
     int    i, errcode, nstp;
     double hdid, hnext;
     double x = x1;
     double h = h1;
-    if (nmax < n) return 1;
+    double *y, *yscal, *dydx;
+    if (ode->nmax < n && !odesolve_open(ode, n)) return 1;
+    y = ode->y;
+    yscal = ode->yscal;
+    dydx = ode->dydx;
     for (i=0; i<n; i++) y[i] = ystart[i];
     for (nstp=1; nstp<=MAXSTP; nstp++)
     {
-        derivs(x,y,dydx);
+        derivs(data,x,y,dydx);
         for (i=0; i<n; i++)
             yscal[i] = fabs(y[i]) + fabs(dydx[i]*h) + TINY;
         if ((x+h-x2)*(x+h-x1) > 0.0) h = x2 - x;
-        errcode = rkqs(&x,n,h,eps,&hdid,&hnext,derivs);
+        errcode = rkqs(ode,&x,n,h,eps,&hdid,&hnext,derivs,data);
         if (errcode) break;
         if ((x-x2)*(x2-x1) >= 0.0)
         {
@@ -118,8 +123,8 @@ int odesolve_integrate(double ystart[], int n, double x1, double x2,
 }
 
 
-int rkqs(double* x, int n, double htry, double eps, double* hdid,
-         double* hnext, void (*derivs)(double, double*, double*))
+int rkqs(TOdeSolver* ode, double* x, int n, double htry, double eps,
+         double* hdid, double* hnext, TOdeDerivs derivs, void* data)
 //---------------------------------------------------------------
 //   Fifth-order Runge-Kutta integration step with monitoring of
 //   local truncation error to assure accuracy and adjust stepsize.
@@ -130,13 +135,15 @@ int rkqs(double* x, int n, double htry, double eps, double* hdid,
 {
     int i;
     double err, errmax, h, htemp, xnew, xold = *x;
+    double *y = ode->y, *yscal = ode->yscal, *yerr = ode->yerr,
+           *ytemp = ode->ytemp;
 
     // --- set initial stepsize
     h = htry;
     for (;;)
     {
         // --- take a Runge-Kutta-Cash-Karp step
-        rkck(xold, n, h, derivs);
+        rkck(ode, xold, n, h, derivs, data);
 
         // --- compute scaled maximum error
         errmax = 0.0;
@@ -179,7 +186,8 @@ int rkqs(double* x, int n, double htry, double eps, double* hdid,
 }
 
 
-void rkck(double x, int n, double h, void (*derivs)(double, double*, double*))
+void rkck(TOdeSolver* ode, double x, int n, double h, TOdeDerivs derivs,
+          void* data)
 //----------------------------------------------------------------------
 //   Uses the Runge-Kutta-Cash-Karp method to advance y[] at x
 //   over stepsize h.
@@ -195,6 +203,8 @@ void rkck(double x, int n, double h, void (*derivs)(double, double*, double*))
     double dc1=c1-2825.0/27648.0, dc3=c3-18575.0/48384.0,
            dc4=c4-13525.0/55296.0, dc6=c6-0.25;
     int i;
+    double *y = ode->y, *yerr = ode->yerr, *ytemp = ode->ytemp,
+           *dydx = ode->dydx, *ak = ode->ak;
     double *ak2 = (ak);
     double *ak3 = ((ak)+(n));
     double *ak4 = ((ak)+(2*n));
@@ -203,24 +213,24 @@ void rkck(double x, int n, double h, void (*derivs)(double, double*, double*))
 
     for (i=0; i<n; i++)
         ytemp[i] = y[i] + b21*h*dydx[i];
-    derivs(x+a2*h,ytemp,ak2);
+    derivs(data,x+a2*h,ytemp,ak2);
 
     for (i=0; i<n; i++)
         ytemp[i] = y[i] + h*(b31*dydx[i]+b32*ak2[i]);
-    derivs(x+a3*h,ytemp,ak3);
+    derivs(data,x+a3*h,ytemp,ak3);
 
     for (i=0; i<n; i++)
         ytemp[i] = y[i] + h*(b41*dydx[i]+b42*ak2[i] + b43*ak3[i]);
-    derivs(x+a4*h,ytemp,ak4);
+    derivs(data,x+a4*h,ytemp,ak4);
 
     for (i=0; i<n; i++)
         ytemp[i] = y[i] + h*(b51*dydx[i]+b52*ak2[i] + b53*ak3[i] + b54*ak4[i]);
-    derivs(x+a5*h,ytemp,ak5);
+    derivs(data,x+a5*h,ytemp,ak5);
 
     for (i=0; i<n; i++)
         ytemp[i] = y[i] + h*(b61*dydx[i]+b62*ak2[i] + b63*ak3[i] + b64*ak4[i]
                    + b65*ak5[i]);
-    derivs(x+a6*h,ytemp,ak6);
+    derivs(data,x+a6*h,ytemp,ak6);
 
     for (i=0; i<n; i++)
         ytemp[i] = y[i] + h*(c1*dydx[i] + c3*ak3[i] + c4*ak4[i] + c6*ak6[i]);
@@ -3,10 +3,28 @@
 //
 //  Header file for ODE solver contained in odesolve.c
 //
+//  Build 5.2.0:
+//  - Work arrays held in a TOdeSolver owned by the caller and a user data
+//    pointer passed on to the derivative function.
 //-----------------------------------------------------------------------------
 
+// work arrays used by one caller of the ODE solver
+typedef struct TOdeSolver
+{
+    int      nmax;             // max. number of equations
+    double*  y;                // dependent variable
+    double*  yscal;            // scaling factors
+    double*  yerr;             // integration errors
+    double*  ytemp;            // temporary values of y
+    double*  dydx;             // derivatives of y
+    double*  ak;               // derivatives at intermediate points
+} TOdeSolver;
+
+// function that computes derivatives dydx of y at x for a caller's data
+typedef void (*TOdeDerivs)(void* data, double x, double* y, double* dydx);
+
 // functions that open, close, and use the ODE solver
-int  odesolve_open(int n);
-void odesolve_close(void);
-int  odesolve_integrate(double ystart[], int n, double x1, double x2,
-     double eps, double h1, void (*derivs)(double, double*, double*));
+int  odesolve_open(TOdeSolver* ode, int n);
+void odesolve_close(TOdeSolver* ode);
+int  odesolve_integrate(TOdeSolver* ode, double ystart[], int n, double x1,
+     double x2, double eps, double h1, TOdeDerivs derivs, void* data);
@@ -24,6 +24,10 @@
 //   - Support added for saving average node & link routing results to
 //     binary file in each reporting period.
 //
+//   Build 5.2.0:
+//   - Nodes & links are written in input file order when the network
+//     has been renumbered.
+//
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -41,7 +45,7 @@
 enum InputDataType {INPUT_TYPE_CODE, INPUT_AREA, INPUT_INVERT, INPUT_MAX_DEPTH,
                     INPUT_OFFSET, INPUT_LENGTH};
 
-typedef struct                                                                 //(5.1.013)
+typedef struct TAvgResults                                                     //(5.1.013)
 {                                                                              //
     REAL4* xAvg;                                                               //
 }   TAvgResults;                                                               //
@@ -49,29 +53,34 @@ typedef struct                                                                 /
 //-----------------------------------------------------------------------------
 //  Shared variables    
 //-----------------------------------------------------------------------------
-static INT4      IDStartPos;           // starting file position of ID names
-static INT4      InputStartPos;        // starting file position of input data
-static INT4      OutputStartPos;       // starting file position of output data
-static INT4      BytesPerPeriod;       // bytes saved per simulation time period
-static INT4      NumSubcatchVars;      // number of subcatchment output variables
-static INT4      NumNodeVars;          // number of node output variables
-static INT4      NumLinkVars;          // number of link output variables
-static INT4      NumSubcatch;          // number of subcatchments reported on
-static INT4      NumNodes;             // number of nodes reported on
-static INT4      NumLinks;             // number of links reported on
-static INT4      NumPolluts;           // number of pollutants reported on
-static REAL4     SysResults[MAX_SYS_RESULTS];    // values of system output vars.
-
-static TAvgResults* AvgLinkResults;                                            //(5.1.013)
-static TAvgResults* AvgNodeResults;                                            //
-static int          Nsteps;                                                    //
+#define IDStartPos      (Prj->output.IDStartPos)
+#define InputStartPos   (Prj->output.InputStartPos)
+#define OutputStartPos  (Prj->output.OutputStartPos)
+#define BytesPerPeriod  (Prj->output.BytesPerPeriod)
+#define NumSubcatchVars (Prj->output.NumSubcatchVars)
+#define NumNodeVars     (Prj->output.NumNodeVars)
+#define NumLinkVars     (Prj->output.NumLinkVars)
+#define NumSubcatch     (Prj->output.NumSubcatch)
+#define NumNodes        (Prj->output.NumNodes)
+#define NumLinks        (Prj->output.NumLinks)
+#define NumPolluts      (Prj->output.NumPolluts)
+#define SysResults      (Prj->output.SysResults)
+
+#define AvgLinkResults  (Prj->output.AvgLinkResults)
+#define AvgNodeResults  (Prj->output.AvgNodeResults)
+#define Nsteps          (Prj->output.Nsteps)
 
 //-----------------------------------------------------------------------------
 //  Exportable variables (shared with report.c)
 //-----------------------------------------------------------------------------
-REAL4*           SubcatchResults;
-REAL4*           NodeResults;
-REAL4*           LinkResults;
+#define SubcatchResults (Prj->output.SubcatchResults)
+#define NodeResults     (Prj->output.NodeResults)
+#define LinkResults     (Prj->output.LinkResults)
+
+//-----------------------------------------------------------------------------
+//  Imported variables
+//-----------------------------------------------------------------------------
+#define StepFlowTotals  (Prj->massbal.StepFlowTotals)    // defined in massbal.c
 
 
 //-----------------------------------------------------------------------------
@@ -97,6 +106,7 @@ static void output_saveAvgResults(FILE* file);                                 /
 //  output_close                  (called by swmm_close in swmm5.c)
 //  output_updateAvgResults       (called by swmm_step in swmm5.c)             //(5.1.013)
 //  output_saveResults            (called by swmm_step in swmm5.c)
+//  output_snapshot               (called by listState in snapshot.c)
 //  output_checkFileSize          (called by swmm_report)
 //  output_readDateTime           (called by routines in report.c)
 //  output_readSubcatchResults    (called by report_Subcatchments)
@@ -113,7 +123,7 @@ int output_open()
 //  Purpose: writes basic project data to binary output file.
 //
 {
-    int   j;
+    int   i, j;
     int   m;
     INT4  k;
     REAL4 x;
@@ -197,12 +207,14 @@ int output_open()
     {
         if ( Subcatch[j].rptFlag ) output_saveID(Subcatch[j].ID, Fout.file);
     }
-    for (j=0; j<Nobjects[NODE];     j++)
+    for (i=0; i<Nobjects[NODE];     i++)
     {
+        j = project_getObjectIndex(NODE, i);
         if ( Node[j].rptFlag ) output_saveID(Node[j].ID, Fout.file);
     }
-    for (j=0; j<Nobjects[LINK];     j++)
+    for (i=0; i<Nobjects[LINK];     i++)
     {
+        j = project_getObjectIndex(LINK, i);
         if ( Link[j].rptFlag ) output_saveID(Link[j].ID, Fout.file);
     }
     for (j=0; j<NumPolluts; j++) output_saveID(Pollut[j].ID, Fout.file);
@@ -237,8 +249,9 @@ int output_open()
     fwrite(&k, sizeof(INT4), 1, Fout.file);
     k = INPUT_MAX_DEPTH;
     fwrite(&k, sizeof(INT4), 1, Fout.file);
-    for (j=0; j<Nobjects[NODE]; j++)
+    for (i=0; i<Nobjects[NODE]; i++)
     {
+        j = project_getObjectIndex(NODE, i);
         if ( !Node[j].rptFlag ) continue;
         k = Node[j].type;
         NodeResults[0] = (REAL4)(Node[j].invertElev * UCF(LENGTH));
@@ -261,8 +274,9 @@ int output_open()
     k = INPUT_LENGTH;
     fwrite(&k, sizeof(INT4), 1, Fout.file);
 
-    for (j=0; j<Nobjects[LINK]; j++)
+    for (i=0; i<Nobjects[LINK]; i++)
     {
+        j = project_getObjectIndex(LINK, i);
         if ( !Link[j].rptFlag ) continue;
         k = Link[j].type;
         if ( k == PUMP )
@@ -449,7 +463,6 @@ void output_saveResults(double reportTime)
 //
 {
     int i;
-    extern TRoutingTotals StepFlowTotals;  // defined in massbal.c             //(5.1.013)
     DateTime reportDate = getDateTime(reportTime);
     REAL8 date;
 
@@ -630,15 +643,16 @@ void output_saveNodeResults(double reportTime, FILE* file)
 //  Purpose: writes computed node results to binary file.
 //
 {
-    int j;
+    int i, j;
 
     // --- find where current reporting time lies between latest routing times
     double f = (reportTime - OldRoutingTime) /
                (NewRoutingTime - OldRoutingTime);
 
     // --- write node results to file
-    for (j=0; j<Nobjects[NODE]; j++)
+    for (i=0; i<Nobjects[NODE]; i++)
     {
+        j = project_getObjectIndex(NODE, i);
         // --- retrieve interpolated results for reporting time & write to file
         node_getResults(j, f, NodeResults);
         if ( Node[j].rptFlag )
@@ -660,7 +674,7 @@ void output_saveLinkResults(double reportTime, FILE* file)
 //  Purpose: writes computed link results to binary file.
 //
 {
-    int j;
+    int i, j;
     double f;
     double z;
 
@@ -668,8 +682,9 @@ void output_saveLinkResults(double reportTime, FILE* file)
     f = (reportTime - OldRoutingTime) / (NewRoutingTime - OldRoutingTime);
 
     // --- write link results to file
-    for (j=0; j<Nobjects[LINK]; j++)
+    for (i=0; i<Nobjects[LINK]; i++)
     {
+        j = project_getObjectIndex(LINK, i);
         // --- retrieve interpolated results for reporting time & write to file
         if (Link[j].rptFlag)
         {
@@ -802,6 +817,25 @@ int output_openAvgResults()
 
 //=============================================================================
 
+void output_snapshot(struct TSnapshot* snap)
+//
+//  Input:   snap = snapshot being built
+//  Output:  none
+//  Purpose: adds the results averaged over the current reporting period
+//           to a snapshot.
+//
+{
+    int i;
+    if ( AvgNodeResults ) for (i = 0; i < NumNodes; i++)
+        snapshot_addBlock(snap, AvgNodeResults[i].xAvg,
+                          NumNodeVars * sizeof(REAL4));
+    if ( AvgLinkResults ) for (i = 0; i < NumLinks; i++)
+        snapshot_addBlock(snap, AvgLinkResults[i].xAvg,
+                          NumLinkVars * sizeof(REAL4));
+}
+
+//=============================================================================
+
 void output_closeAvgResults()
 {
     int i;
@@ -837,12 +871,13 @@ void output_initAvgResults()
 
 void output_updateAvgResults()
 {
-    int i, j, k, sign;
+    int i, j, k, m, sign;
 
     // --- update average accumulations for nodes
     k = 0;
-    for (i = 0; i < Nobjects[NODE]; i++)
+    for (m = 0; m < Nobjects[NODE]; m++)
     {
+        i = project_getObjectIndex(NODE, m);
         if ( !Node[i].rptFlag ) continue;
         node_getResults(i, 1.0, NodeResults);
         for (j = 0; j < NumNodeVars; j++)
@@ -854,8 +889,9 @@ void output_updateAvgResults()
 
     // --- update average accumulations for links
     k = 0;
-    for (i = 0; i < Nobjects[LINK]; i++)
+    for (m = 0; m < Nobjects[LINK]; m++)
     {
+        i = project_getObjectIndex(LINK, m);
         if ( !Link[i].rptFlag ) continue;
         link_getResults(i, 1.0, LinkResults);
 
@@ -55,6 +55,24 @@
 //   - More robust parsing of MinSurfarea option provided.
 //   - Support added for new RuleStep analysis option.
 //
+//   Build 5.2.0:
+//   - Scenario projects that share the parsed input data of a base project
+//     added (see project_createScenario).
+//   - Support added for new SolverMethod and AndersonDepth analysis options.
+//   - Support added for new ThreadSchedule analysis option.
+//   - No thread team started to count threads when a single one is used.
+//   - Number of threads chosen from network size when THREADS is 0.
+//   - Support added for new DenseTableSize analysis option.
+//   - Support added for new CircGeometry analysis option.
+//   - Nodes & links can be renumbered for better memory locality (see
+//     orderNetwork) with their input file order kept for output.
+//   - Support added for new Predictor analysis option.
+//   - Subcatchments as well as links counted when limiting the number of
+//     threads used.
+//   - Support added for new RunoffSolver analysis option.
+//   - Support added for new DepthWarmStart analysis option.
+//   - Support added for new ActiveSet analysis option.
+//
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -77,23 +95,31 @@
 //-----------------------------------------------------------------------------
 //  Shared variables
 //-----------------------------------------------------------------------------
-static HTtable* Htable[MAX_OBJ_TYPES]; // Hash tables for object ID names
-static char     MemPoolAllocated;      // TRUE if memory pool allocated 
+#define Htable  (Prj->project.Htable)  // Hash tables for object ID names
+#define MemPool (Prj->project.MemPool) // Memory pool for object ID names
+#define BaseProject (Prj->project.BaseProject) // Project a scenario shares
+                                               // its input data with
+#define ObjIndex (Prj->project.ObjIndex) // Index of each object in input order
+#define InputPos (Prj->project.InputPos) // Input position of each object
 
 //-----------------------------------------------------------------------------
 //  External Functions (declared in funcs.h)
 //-----------------------------------------------------------------------------
 //  project_open           (called from swmm_open in swmm5.c)
+//  project_createScenario (called from swmm_createScenario in swmm5.c)
 //  project_close          (called from swmm_close in swmm5.c)
 //  project_readInput      (called from swmm_open in swmm5.c)
 //  project_readOption     (called from readOption in input.c)
 //  project_validate       (called from swmm_open in swmm5.c)
 //  project_init           (called from swmm_start in swmm5.c)
+//  project_snapshot       (called from listState in snapshot.c)
 //  project_addObject      (called from addObject in input.c)
 //  project_createMatrix   (called from openFileForInput in iface.c)
 //  project_freeMatrix     (called from iface_closeRoutingFiles)
 //  project_findObject
 //  project_findID
+//  project_getObjectIndex
+//  project_getInputPos
 
 //-----------------------------------------------------------------------------
 //  Function declarations
@@ -103,8 +129,12 @@ static void setDefaults(void);
 static void openFiles(char *f1, char *f2, char *f3);
 static void createObjects(void);
 static void deleteObjects(void);
+static void cloneObjects(void);
+static void deleteClonedObjects(void);
+static void* cloneBlock(const void* src, size_t size);
 static void createHashTables(void);
 static void deleteHashTables(void);
+static void orderNetwork(void);
 
 
 //=============================================================================
@@ -125,6 +155,64 @@ void project_open(char *f1, char *f2, char *f3)
 
 //=============================================================================
 
+int project_createScenario(struct TProject* base, char *f2, char *f3)
+//
+//  Input:   base = project whose input data is shared
+//           f2 = pointer to name of report file
+//           f3 = pointer to name of binary output file
+//  Output:  returns an error code
+//  Purpose: turns a byte-wise copy of an opened base project into a
+//           scenario that can be run independently of its base.
+//
+//  NOTE: the current project must already hold a copy of the base
+//        project's context. Objects whose state changes during a run
+//        are duplicated while read-only input data (pollutants, land
+//        uses, patterns, curve and time series entries, ID names, etc.)
+//        remain shared, so the base project must outlive the scenario.
+//
+{
+    BaseProject = base;
+    Finp.file = NULL;
+    Frpt.file = NULL;
+    Fout.file = NULL;
+    Fclimate.file = NULL;
+
+    // --- interface files saved by the base project can't be shared
+    if ( Frain.mode == SAVE_FILE ) Frain.mode = SCRATCH_FILE;
+    if ( Frdii.mode == SAVE_FILE ) Frdii.mode = SCRATCH_FILE;
+    if ( Frunoff.mode == SAVE_FILE ) Frunoff.mode = NO_FILE;
+    if ( Fhotstart2.mode == SAVE_FILE ) Fhotstart2.mode = NO_FILE;
+    if ( Foutflows.mode == SAVE_FILE ) Foutflows.mode = NO_FILE;
+
+    // --- make private copies of the objects a run modifies
+    cloneObjects();
+    if ( ErrorCode ) return ErrorCode;
+
+    // --- open the scenario's own report file
+    sstrncpy(Frpt.name, f2, MAXFNAME);
+    sstrncpy(Fout.name, f3, MAXFNAME);
+    if (strcomp(Finp.name, f2) || strcomp(Finp.name, f3) || strcomp(f2, f3))
+    {
+        writecon(FMT11);
+        ErrorCode = ERR_FILE_NAME;
+        return ErrorCode;
+    }
+    if ((Frpt.file = fopen(f2,"wt")) == NULL)
+    {
+       writecon(FMT13);
+       ErrorCode = ERR_RPT_FILE;
+       return ErrorCode;
+    }
+    report_writeLogo();
+    report_writeTitle();
+
+    // --- re-open a climate file since its read position is not shared
+    if ( Fclimate.mode == USE_FILE ) climate_openFile();
+    return ErrorCode;
+}
+
+//=============================================================================
+
 void project_readInput()
 //
 //  Input:   none
@@ -136,7 +224,9 @@ void project_readInput()
     createHashTables();
 
     // --- count number of objects in input file and create them
+    //     (renumbering nodes & links first if called for)
     input_countObjects();
+    if ( NetworkOrder == RCM_ORDER && !ErrorCode ) orderNetwork();
     createObjects();
 
     // --- read project data from input file
@@ -194,6 +284,8 @@ void project_validate()
     int i;
     int j;
     int err;
+    int autoThreads;
+    int nItems;
 
     // --- validate Curves and TimeSeries
     for ( i=0; i<Nobjects[CURVE]; i++ )
@@ -232,11 +324,15 @@ void project_validate()
         }
     }
 
+    // --- create dense geometry tables for transects & custom shapes
+    if ( xsect_createDenseTables() ) report_writeErrorMsg(ERR_MEMORY, "");
+
     // --- validate links before nodes, since the latter can
     //     result in adjustment of node depths
+    //     (in input file order so that any warnings follow it too)
     for ( i=0; i<Nobjects[NODE]; i++) Node[i].oldDepth = Node[i].fullDepth;
-    for ( i=0; i<Nobjects[LINK]; i++) link_validate(i);
-    for ( i=0; i<Nobjects[NODE]; i++) node_validate(i);
+    for ( i=0; i<Nobjects[LINK]; i++) link_validate(project_getObjectIndex(LINK, i));
+    for ( i=0; i<Nobjects[NODE]; i++) node_validate(project_getObjectIndex(NODE, i));
 
     // --- adjust time steps if necessary
     if ( DryStep < WetStep )
@@ -262,12 +358,23 @@ void project_validate()
     if ( RouteModel == DW ) dynwave_validate();
 
     // --- adjust number of parallel threads to be used                        //(5.1.013)
-#pragma omp parallel                                                           //(5.1.008)
+    //     (when none were specified, each thread gets enough links or
+    //     subcatchments for its share of the work to outweigh the cost
+    //     of synchronizing)
+    autoThreads = ( NumThreads == 0 );
+    nItems = MAX(Nobjects[LINK], Nobjects[SUBCATCH]);
+    if ( NumThreads != 1 )
+    {
+#pragma omp parallel copyin(Prj)                                               //(5.1.008)
 {
     if ( NumThreads == 0 ) NumThreads = omp_get_num_threads();                 //(5.1.008)
     else NumThreads = MIN(NumThreads, omp_get_num_threads());                  //(5.1.008)
 }
-    if ( Nobjects[LINK] < 4 * NumThreads ) NumThreads = 1;                     //(5.1.008)
+    }
+    if ( autoThreads )
+        NumThreads = MIN(NumThreads, nItems / MINTHREADLINKS);
+    if ( nItems < 4 * NumThreads ) NumThreads = 1;                             //(5.1.008)
+    if ( NumThreads < 1 ) NumThreads = 1;
 
 }
 
@@ -280,6 +387,12 @@ void project_close()
 //  Purpose: closes a SWMM project.
 //
 {
+    if ( BaseProject )
+    {
+        deleteClonedObjects();
+        BaseProject = NULL;
+        return;
+    }
     deleteObjects();
     deleteHashTables();
 }
@@ -306,6 +419,96 @@ int  project_init(void)
 
 //=============================================================================
 
+void project_snapshot(struct TSnapshot* snap)
+//
+//  Input:   snap = snapshot being built
+//  Output:  none
+//  Purpose: adds the state held by the project's objects to a snapshot.
+//
+//  NOTE: covers the same objects as cloneObjects() less those whose
+//        contents do not change during a run.
+{
+    int j, k;
+    size_t nPollut = Nobjects[POLLUT] * sizeof(double);
+
+    // --- each major category of object that holds state
+    snapshot_addBlock(snap, Gage,     Nobjects[GAGE]     * sizeof(TGage));
+    snapshot_addBlock(snap, Subcatch, Nobjects[SUBCATCH] * sizeof(TSubcatch));
+    snapshot_addBlock(snap, Node,     Nobjects[NODE]     * sizeof(TNode));
+    snapshot_addBlock(snap, Outfall,  Nnodes[OUTFALL]    * sizeof(TOutfall));
+    snapshot_addBlock(snap, Divider,  Nnodes[DIVIDER]    * sizeof(TDivider));
+    snapshot_addBlock(snap, Storage,  Nnodes[STORAGE]    * sizeof(TStorage));
+    snapshot_addBlock(snap, Link,     Nobjects[LINK]     * sizeof(TLink));
+    snapshot_addBlock(snap, Conduit,  Nlinks[CONDUIT]    * sizeof(TConduit));
+    snapshot_addBlock(snap, Pump,     Nlinks[PUMP]       * sizeof(TPump));
+    snapshot_addBlock(snap, Orifice,  Nlinks[ORIFICE]    * sizeof(TOrifice));
+    snapshot_addBlock(snap, Weir,     Nlinks[WEIR]       * sizeof(TWeir));
+    snapshot_addBlock(snap, Outlet,   Nlinks[OUTLET]     * sizeof(TOutlet));
+    snapshot_addBlock(snap, Curve,    Nobjects[CURVE]    * sizeof(TTable));
+    snapshot_addBlock(snap, Tseries,  Nobjects[TSERIES]  * sizeof(TTable));
+    snapshot_addBlock(snap, Snowmelt, Nobjects[SNOWMELT] * sizeof(TSnowmelt));
+
+    // --- subcatchment quality, groundwater & snowpack state
+    for (j = 0; j < Nobjects[SUBCATCH]; j++)
+    {
+        snapshot_addBlock(snap, Subcatch[j].oldQual, nPollut);
+        snapshot_addBlock(snap, Subcatch[j].newQual, nPollut);
+        snapshot_addBlock(snap, Subcatch[j].pondedQual, nPollut);
+        snapshot_addBlock(snap, Subcatch[j].concPonded, nPollut);
+        snapshot_addBlock(snap, Subcatch[j].totalLoad, nPollut);
+        snapshot_addBlock(snap, Subcatch[j].surfaceBuildup, nPollut);
+        snapshot_addBlock(snap, Subcatch[j].landFactor,
+                          Nobjects[LANDUSE] * sizeof(TLandFactor));
+        if ( Subcatch[j].landFactor ) for (k = 0; k < Nobjects[LANDUSE]; k++)
+        {
+            snapshot_addBlock(snap, Subcatch[j].landFactor[k].buildup,
+                              nPollut);
+        }
+        snapshot_addBlock(snap, Subcatch[j].groundwater, sizeof(TGroundwater));
+        snapshot_addBlock(snap, Subcatch[j].snowpack, sizeof(TSnowpack));
+    }
+
+    // --- node & link quality state
+    for (j = 0; j < Nobjects[NODE]; j++)
+    {
+        snapshot_addBlock(snap, Node[j].oldQual, nPollut);
+        snapshot_addBlock(snap, Node[j].newQual, nPollut);
+    }
+    for (j = 0; j < Nobjects[LINK]; j++)
+    {
+        snapshot_addBlock(snap, Link[j].oldQual, nPollut);
+        snapshot_addBlock(snap, Link[j].newQual, nPollut);
+        snapshot_addBlock(snap, Link[j].totalLoad, nPollut);
+    }
+    for (j = 0; j < Nnodes[OUTFALL]; j++)
+    {
+        snapshot_addBlock(snap, Outfall[j].wRouted, nPollut);
+    }
+
+    // --- storage node exfiltration state
+    for (j = 0; j < Nnodes[STORAGE]; j++)
+    {
+        if ( Storage[j].exfil == NULL ) continue;
+        snapshot_addBlock(snap, Storage[j].exfil, sizeof(TExfil));
+        snapshot_addBlock(snap, Storage[j].exfil->btmExfil, sizeof(TGrnAmpt));
+        snapshot_addBlock(snap, Storage[j].exfil->bankExfil, sizeof(TGrnAmpt));
+    }
+
+    // --- position of time series read from external files
+    for (j = 0; j < Nobjects[TSERIES]; j++)
+    {
+        if ( Tseries[j].file.mode == USE_FILE )
+            snapshot_addFile(snap, Tseries[j].file.file);
+    }
+
+    // --- infiltration, LID and control rule state
+    infil_snapshot(snap, Nobjects[SUBCATCH]);
+    lid_snapshot(snap);
+    controls_snapshot(snap);
+}
+
+//=============================================================================
+
 int   project_addObject(int type, char *id, int n)
 //
 //  Input:   type = object type
@@ -325,6 +528,7 @@ int   project_addObject(int type, char *id, int n)
     // --- use memory from the hash tables' common memory pool to store
     //     a copy of the object's ID string
     len = strlen(id) + 1;
+    AllocSetPool(MemPool);
     newID = (char *) Alloc(len*sizeof(char));
     strcpy(newID, id);
 
@@ -365,6 +569,37 @@ char  *project_findID(int type, char *id)
 
 //=============================================================================
 
+int project_getObjectIndex(int type, int i)
+//
+//  Input:   type = object type
+//           i = position of an object among those of its type in the
+//               input file
+//  Output:  returns the object's index
+//  Purpose: finds the index of the i-th object of a given type listed in
+//           the input file.
+//
+{
+    if ( ObjIndex[type] == NULL || i < 0 || i >= Nobjects[type] ) return i;
+    return ObjIndex[type][i];
+}
+
+//=============================================================================
+
+int project_getInputPos(int type, int j)
+//
+//  Input:   type = object type
+//           j = object index
+//  Output:  returns the position of the object in the input file
+//  Purpose: finds where an object appears among those of its type listed
+//           in the input file.
+//
+{
+    if ( InputPos[type] == NULL || j < 0 || j >= Nobjects[type] ) return j;
+    return InputPos[type][j];
+}
+
+//=============================================================================
+
 double ** project_createMatrix(int nrows, int ncols)
 //
 //  Input:   nrows = number of rows (0-based)
@@ -579,6 +814,8 @@ int project_readOption(char* s1, char* s2)
       case IGNORE_ROUTING:
       case IGNORE_QUALITY:
       case IGNORE_RDII:
+      case DEPTH_WARM_START:
+      case ACTIVE_SET:
         m = findmatch(s2, NoYesWords);
         if ( m < 0 ) return error_setInpError(ERR_KEYWORD, s2);
         switch ( k )
@@ -592,6 +829,8 @@ int project_readOption(char* s1, char* s2)
           case IGNORE_ROUTING:    IgnoreRouting   = m;  break;
           case IGNORE_QUALITY:    IgnoreQuality   = m;  break;
           case IGNORE_RDII:       IgnoreRDII      = m;  break;
+          case DEPTH_WARM_START:  DepthWarmStart  = m;  break;
+          case ACTIVE_SET:        ActiveSet       = m;  break;
         }
         break;
 
@@ -730,6 +969,66 @@ int project_readOption(char* s1, char* s2)
           SurchargeMethod = m;
           break;
 
+      // --- method used to solve dynamic wave flow routing equations
+      //     (NEWTON keeps long fixed time steps accurate but runs slower
+      //     than PICARD at its variable step; see dynwave.c)
+      case SOLVER_METHOD:
+          m = findmatch(s2, SolverWords);
+          if (m < 0) return error_setInpError(ERR_KEYWORD, s2);
+          SolverMethod = m;
+          break;
+
+      // --- number of past iterations used by Anderson acceleration
+      case ANDERSON_DEPTH:
+        m = atoi(s2);
+        if ( m < 0 || m > MAXANDERSON )
+            return error_setInpError(ERR_NUMBER, s2);
+        AndersonDepth = m;
+        break;
+
+      // --- schedule used to split routing loops among threads
+      case THREAD_SCHEDULE:
+          m = findmatch(s2, ScheduleWords);
+          if (m < 0) return error_setInpError(ERR_KEYWORD, s2);
+          ThreadSchedule = m;
+          break;
+
+      // --- size of dense geometry tables for transects & custom shapes
+      case DENSE_TABLE_SIZE:
+        m = atoi(s2);
+        if ( m != 0 && (m < N_TRANSECT_TBL || m > MAXDENSETBL) )
+            return error_setInpError(ERR_NUMBER, s2);
+        DenseTableSize = m;
+        break;
+
+      // --- method used to evaluate circular cross section geometry
+      case CIRCULAR_GEOMETRY:
+        m = findmatch(s2, CircGeomWords);
+        if ( m < 0 ) return error_setInpError(ERR_KEYWORD, s2);
+        CircGeometry = m;
+        break;
+
+      // --- order in which nodes & links are indexed
+      case NETWORK_ORDER:
+        m = findmatch(s2, NetworkOrderWords);
+        if ( m < 0 ) return error_setInpError(ERR_KEYWORD, s2);
+        NetworkOrder = m;
+        break;
+
+      // --- extrapolation of initial guess of dynamic wave iterations
+      case PREDICTOR:
+        m = findmatch(s2, PredictorWords);
+        if ( m < 0 ) return error_setInpError(ERR_KEYWORD, s2);
+        Predictor = m;
+        break;
+
+      // --- ODE solver used for the ponded depth of subareas
+      case RUNOFF_SOLVER:
+        m = findmatch(s2, RunoffSolverWords);
+        if ( m < 0 ) return error_setInpError(ERR_KEYWORD, s2);
+        RunoffSolver = m;
+        break;
+
       case TEMPDIR: // Temporary Directory
         sstrncpy(TempDir, s2, MAXFNAME);
         break;
@@ -747,6 +1046,8 @@ void initPointers()
 //  Purpose: assigns NULL to all dynamic arrays for a new project.
 //
 {
+    int j;
+
     Gage     = NULL;
     Subcatch = NULL;
     Node     = NULL;
@@ -770,7 +1071,15 @@ void initPointers()
     UnitHyd    = NULL;
     Snowmelt   = NULL;
     Event      = NULL;
-    MemPoolAllocated = FALSE;
+    LinkListStart = NULL;
+    LinkLists  = NULL;
+    MemPool    = NULL;
+    BaseProject = NULL;
+    for (j = 0; j < MAX_OBJ_TYPES; j++)
+    {
+        ObjIndex[j] = NULL;
+        InputPos[j] = NULL;
+    }
 }
 
 //=============================================================================
@@ -814,6 +1123,14 @@ void setDefaults()
    InfilModel      = HORTON;           // Horton infiltration method
    RouteModel      = KW;               // Kin. wave flow routing method
    SurchargeMethod = EXTRAN;           // Use EXTRAN method for surcharging    //(5.1.013)
+   SolverMethod    = PICARD;           // Use Picard iterations for dyn. wave
+   ThreadSchedule  = STATIC;           // Same nodes & links for each thread
+   CircGeometry    = TABLE_GEOMETRY;   // Circular geometry from tables
+   NetworkOrder    = INPUT_ORDER;      // Nodes & links indexed as read in
+   Predictor       = NO_PREDICTOR;     // Iterations start from last solution
+   RunoffSolver    = RK_RUNOFF;        // Adaptive Runge-Kutta runoff solver
+   DepthWarmStart  = FALSE;            // Depth solves start from scratch
+   ActiveSet       = FALSE;            // Every node & link routed each step
    CrownCutoff     = 0.96;                                                     //(5.1.013)
    AllowPonding    = FALSE;            // No ponding at nodes
    InertDamping    = SOME;             // Partial inertial damping
@@ -839,6 +1156,8 @@ void setDefaults()
    ReportStep      = 900;              // Reporting time step (secs)
    StartDryDays    = 0.0;              // Antecedent dry days
    MaxTrials       = 0;                // Force use of default max. trials 
+   AndersonDepth   = 0;                // Force use of default history depth
+   DenseTableSize  = 0;                // No dense geometry tables
    HeadTol         = 0.0;              // Force use of default head tolerance
    SysFlowTol      = 0.05;             // System flow tolerance for steady state
    LatFlowTol      = 0.05;             // Lateral flow tolerance for steady state
@@ -870,6 +1189,7 @@ void setDefaults()
    RptFlags.links         = FALSE;
    RptFlags.nodeStats     = FALSE;
    RptFlags.averages      = FALSE;
+   RptFlags.cacheStats    = FALSE;
 
    // Temperature data
    Temp.dataSource  = NO_TEMP;
@@ -1178,7 +1498,9 @@ void deleteObjects()
         FREE(Subcatch[j].oldQual);
         FREE(Subcatch[j].newQual);
         FREE(Subcatch[j].pondedQual);
+        FREE(Subcatch[j].concPonded);
         FREE(Subcatch[j].totalLoad);
+        FREE(Subcatch[j].surfaceBuildup);
     }
     if ( Node ) for (j = 0; j < Nobjects[NODE]; j++)
     {
@@ -1226,6 +1548,7 @@ void deleteObjects()
         table_deleteEntries(&Curve[j]);
 
     // --- delete cross section transects
+    xsect_deleteDenseTables();
     transect_delete();
 
     // --- delete control rules
@@ -1257,6 +1580,217 @@ void deleteObjects()
     FREE(Snowmelt);
     FREE(Shape);
     FREE(Event);
+
+    // --- free the mapping between input & index order
+    for (j = 0; j < MAX_OBJ_TYPES; j++)
+    {
+        FREE(ObjIndex[j]);
+        FREE(InputPos[j]);
+    }
+}
+
+//=============================================================================
+
+void* cloneBlock(const void* src, size_t size)
+//
+//  Input:   src = block of memory owned by a base project
+//           size = size of block in bytes
+//  Output:  returns a copy of the block
+//  Purpose: copies a block of memory for a scenario project, noting a
+//           memory error if it can't be allocated.
+//
+{
+    void* p;
+    if ( src == NULL || size == 0 ) return NULL;
+    p = memdup(src, size);
+    if ( p == NULL ) ErrorCode = ERR_MEMORY;
+    return p;
+}
+
+//=============================================================================
+
+void cloneObjects()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: replaces the objects a scenario shares with its base project
+//           by private copies of those whose state changes during a run.
+//
+//  NOTE: every pointer a scenario frees in deleteClonedObjects() is either
+//        copied or set to NULL here, even after a memory error occurs.
+//
+{
+    int j, k;
+    size_t nPollut = Nobjects[POLLUT] * sizeof(double);
+    TLandFactor* landFactor;
+    TExfil* exfil;
+
+    // --- copy each major category of object that holds state
+    Gage     = cloneBlock(Gage,     Nobjects[GAGE]     * sizeof(TGage));
+    Subcatch = cloneBlock(Subcatch, Nobjects[SUBCATCH] * sizeof(TSubcatch));
+    Node     = cloneBlock(Node,     Nobjects[NODE]     * sizeof(TNode));
+    Outfall  = cloneBlock(Outfall,  Nnodes[OUTFALL]    * sizeof(TOutfall));
+    Divider  = cloneBlock(Divider,  Nnodes[DIVIDER]    * sizeof(TDivider));
+    Storage  = cloneBlock(Storage,  Nnodes[STORAGE]    * sizeof(TStorage));
+    Link     = cloneBlock(Link,     Nobjects[LINK]     * sizeof(TLink));
+    Conduit  = cloneBlock(Conduit,  Nlinks[CONDUIT]    * sizeof(TConduit));
+    Pump     = cloneBlock(Pump,     Nlinks[PUMP]       * sizeof(TPump));
+    Orifice  = cloneBlock(Orifice,  Nlinks[ORIFICE]    * sizeof(TOrifice));
+    Weir     = cloneBlock(Weir,     Nlinks[WEIR]       * sizeof(TWeir));
+    Outlet   = cloneBlock(Outlet,   Nlinks[OUTLET]     * sizeof(TOutlet));
+    Curve    = cloneBlock(Curve,    Nobjects[CURVE]    * sizeof(TTable));
+    Tseries  = cloneBlock(Tseries,  Nobjects[TSERIES]  * sizeof(TTable));
+    Snowmelt = cloneBlock(Snowmelt, Nobjects[SNOWMELT] * sizeof(TSnowmelt));
+    Event    = cloneBlock(Event,    (NumEvents+1)      * sizeof(TEvent));
+
+    // --- copy subcatchment quality, groundwater & snowpack state
+    if ( Subcatch ) for (j = 0; j < Nobjects[SUBCATCH]; j++)
+    {
+        Subcatch[j].initBuildup = cloneBlock(Subcatch[j].initBuildup, nPollut);
+        Subcatch[j].oldQual     = cloneBlock(Subcatch[j].oldQual, nPollut);
+        Subcatch[j].newQual     = cloneBlock(Subcatch[j].newQual, nPollut);
+        Subcatch[j].pondedQual  = cloneBlock(Subcatch[j].pondedQual, nPollut);
+        Subcatch[j].concPonded  = cloneBlock(Subcatch[j].concPonded, nPollut);
+        Subcatch[j].totalLoad   = cloneBlock(Subcatch[j].totalLoad, nPollut);
+        Subcatch[j].surfaceBuildup =
+            cloneBlock(Subcatch[j].surfaceBuildup, nPollut);
+        landFactor = Subcatch[j].landFactor;
+        Subcatch[j].landFactor = cloneBlock(landFactor,
+            Nobjects[LANDUSE] * sizeof(TLandFactor));
+        if ( Subcatch[j].landFactor ) for (k = 0; k < Nobjects[LANDUSE]; k++)
+        {
+            Subcatch[j].landFactor[k].buildup =
+                cloneBlock(landFactor[k].buildup, nPollut);
+        }
+        Subcatch[j].groundwater = cloneBlock(Subcatch[j].groundwater,
+                                             sizeof(TGroundwater));
+        Subcatch[j].snowpack = cloneBlock(Subcatch[j].snowpack,
+                                          sizeof(TSnowpack));
+    }
+
+    // --- copy node & link quality state and nodal external inflows
+    if ( Node ) for (j = 0; j < Nobjects[NODE]; j++)
+    {
+        Node[j].oldQual = cloneBlock(Node[j].oldQual, nPollut);
+        Node[j].newQual = cloneBlock(Node[j].newQual, nPollut);
+        if ( inflow_copyExtInflows(j) ) ErrorCode = ERR_MEMORY;
+    }
+    if ( Link ) for (j = 0; j < Nobjects[LINK]; j++)
+    {
+        Link[j].oldQual   = cloneBlock(Link[j].oldQual, nPollut);
+        Link[j].newQual   = cloneBlock(Link[j].newQual, nPollut);
+        Link[j].totalLoad = cloneBlock(Link[j].totalLoad, nPollut);
+    }
+    if ( Outfall ) for (j = 0; j < Nnodes[OUTFALL]; j++)
+    {
+        Outfall[j].wRouted = cloneBlock(Outfall[j].wRouted, nPollut);
+    }
+
+    // --- copy storage node exfiltration objects
+    if ( Storage ) for (j = 0; j < Nnodes[STORAGE]; j++)
+    {
+        exfil = Storage[j].exfil;
+        Storage[j].exfil = cloneBlock(exfil, sizeof(TExfil));
+        if ( Storage[j].exfil )
+        {
+            Storage[j].exfil->btmExfil =
+                cloneBlock(exfil->btmExfil, sizeof(TGrnAmpt));
+            Storage[j].exfil->bankExfil =
+                cloneBlock(exfil->bankExfil, sizeof(TGrnAmpt));
+        }
+    }
+
+    // --- time series read from external files need their own file handle
+    if ( Tseries ) for (j = 0; j < Nobjects[TSERIES]; j++)
+    {
+        if ( Tseries[j].file.mode != USE_FILE ) continue;
+        Tseries[j].file.file = fopen(Tseries[j].file.name, "rt");
+        if ( Tseries[j].file.file == NULL )
+            report_writeErrorMsg(ERR_TABLE_FILE_OPEN, Tseries[j].ID);
+    }
+
+    // --- copy infiltration, LID and control rule state
+    infil_clone(Nobjects[SUBCATCH]);
+    lid_clone();
+    k = controls_clone();
+    if ( k ) ErrorCode = k;
+}
+
+//=============================================================================
+
+void deleteClonedObjects()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: frees the objects a scenario project copied from its base.
+//
+{
+    int j, k;
+
+    if ( Subcatch ) for (j = 0; j < Nobjects[SUBCATCH]; j++)
+    {
+        if ( Subcatch[j].landFactor ) for (k = 0; k < Nobjects[LANDUSE]; k++)
+        {
+            FREE(Subcatch[j].landFactor[k].buildup);
+        }
+        FREE(Subcatch[j].landFactor);
+        FREE(Subcatch[j].groundwater);
+        FREE(Subcatch[j].snowpack);
+        FREE(Subcatch[j].initBuildup);
+        FREE(Subcatch[j].oldQual);
+        FREE(Subcatch[j].newQual);
+        FREE(Subcatch[j].pondedQual);
+        FREE(Subcatch[j].concPonded);
+        FREE(Subcatch[j].totalLoad);
+        FREE(Subcatch[j].surfaceBuildup);
+    }
+    if ( Node ) for (j = 0; j < Nobjects[NODE]; j++)
+    {
+        FREE(Node[j].oldQual);
+        FREE(Node[j].newQual);
+        inflow_deleteExtInflows(j);
+    }
+    if ( Link ) for (j = 0; j < Nobjects[LINK]; j++)
+    {
+        FREE(Link[j].oldQual);
+        FREE(Link[j].newQual);
+        FREE(Link[j].totalLoad);
+    }
+    if ( Outfall ) for (j = 0; j < Nnodes[OUTFALL]; j++)
+        FREE(Outfall[j].wRouted);
+    if ( Storage ) for (j = 0; j < Nnodes[STORAGE]; j++)
+    {
+        if ( Storage[j].exfil )
+        {
+            FREE(Storage[j].exfil->btmExfil);
+            FREE(Storage[j].exfil->bankExfil);
+            FREE(Storage[j].exfil);
+        }
+    }
+    if ( Tseries ) for (j = 0; j < Nobjects[TSERIES]; j++)
+    {
+        if ( Tseries[j].file.file ) fclose(Tseries[j].file.file);
+    }
+    infil_delete();
+    lid_deleteClone();
+    controls_deleteClone();
+
+    FREE(Gage);
+    FREE(Subcatch);
+    FREE(Node);
+    FREE(Outfall);
+    FREE(Divider);
+    FREE(Storage);
+    FREE(Link);
+    FREE(Conduit);
+    FREE(Pump);
+    FREE(Orifice);
+    FREE(Weir);
+    FREE(Outlet);
+    FREE(Curve);
+    FREE(Tseries);
+    FREE(Snowmelt);
+    FREE(Event);
 }
 
 //=============================================================================
@@ -1268,7 +1802,7 @@ void createHashTables()
 //  Purpose: allocates memory for object ID hash tables
 //
 {   int j;
-    MemPoolAllocated = FALSE;
+    MemPool = NULL;
     for (j = 0; j < MAX_OBJ_TYPES ; j++)
     {
         Htable[j] = HTcreate();
@@ -1276,8 +1810,8 @@ void createHashTables()
     }
 
     // --- initialize memory pool used to store object ID's
-    if ( AllocInit() == NULL ) report_writeErrorMsg(ERR_MEMORY, "");
-    else MemPoolAllocated = TRUE;
+    MemPool = AllocInit();
+    if ( MemPool == NULL ) report_writeErrorMsg(ERR_MEMORY, "");
 }
 
 //=============================================================================
@@ -1296,19 +1830,74 @@ void deleteHashTables()
     }
 
     // --- free object ID memory pool
-    if ( MemPoolAllocated ) AllocFreePool();
+    if ( MemPool )
+    {
+        AllocSetPool(MemPool);
+        AllocFreePool();
+        MemPool = NULL;
+    }
 }
 
 //=============================================================================
 
+//=============================================================================
 
+void orderNetwork()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: renumbers nodes & links so that those joined to one another
+//           have nearby indexes.
+//
+//  When called, the ID names of the nodes & links have been entered into
+//  the hash tables along with their position in the input file. The end
+//  nodes of each link are read from the input file, a reverse Cuthill-
+//  McKee ordering of the network is found, and the hash tables are
+//  updated with the new indexes so that objects read in by input_readData
+//  and all references made to them by ID name use the new indexes. The
+//  ObjIndex & InputPos arrays map between the two orders wherever results
+//  must be listed in input file order. Input order is kept if the
+//  ordering can't be made.
+//
+{
+    int  i, m;
+    int  types[2] = {NODE, LINK};
+    int  nLinks = Nobjects[LINK];
+    int* node1 = (int *) calloc(nLinks + 1, sizeof(int));
+    int* node2 = (int *) calloc(nLinks + 1, sizeof(int));
+    int  ordered = FALSE;
+
+    // --- allocate the arrays that map between input & index order
+    for (m = 0; m < 2; m++)
+    {
+        ObjIndex[types[m]] = (int *) calloc(Nobjects[types[m]] + 1, sizeof(int));
+        InputPos[types[m]] = (int *) calloc(Nobjects[types[m]] + 1, sizeof(int));
+    }
 
+    // --- order the network by the end nodes of its links
+    if ( node1 && node2 && ObjIndex[NODE] && InputPos[NODE] &&
+         ObjIndex[LINK] && InputPos[LINK] )
+    {
+        input_readLinkNodes(node1, node2);
+        ordered = toposort_orderNetwork(Nobjects[NODE], nLinks, node1, node2,
+                                        InputPos[NODE], InputPos[LINK]);
+    }
+    FREE(node1);
+    FREE(node2);
 
-
-
-
-
-
-
-
-
+    // --- re-index the objects in each hash table
+    for (m = 0; m < 2; m++)
+    {
+        if ( ordered )
+        {
+            for (i = 0; i < Nobjects[types[m]]; i++)
+                ObjIndex[types[m]][InputPos[types[m]][i]] = i;
+            HTrenumber(Htable[types[m]], ObjIndex[types[m]]);
+        }
+        else
+        {
+            FREE(ObjIndex[types[m]]);
+            FREE(InputPos[types[m]]);
+        }
+    }
+}
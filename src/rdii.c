@@ -57,7 +57,7 @@ typedef struct                         // Data for a single unit hydrograph
    double    iaUsed;                   // initial abstraction used (in or mm)
 }  TUHData;
 
-typedef struct                         // Data for a unit hydrograph group
+typedef struct TUHGroup                // Data for a unit hydrograph group
 {                                      //---------------------------------
    int       isUsed;                   // true if UH group used by any nodes
    int       rainInterval;             // time interval for RDII processing (sec)
@@ -71,17 +71,17 @@ typedef struct                         // Data for a unit hydrograph group
 //-----------------------------------------------------------------------------
 // Shared Variables
 //-----------------------------------------------------------------------------
-static TUHGroup*  UHGroup;             // processing data for each UH group
-static int        RdiiStep;            // RDII time step (sec)
-static int        NumRdiiNodes;        // number of nodes w/ RDII data
-static int*       RdiiNodeIndex;       // indexes of nodes w/ RDII data
-static REAL4*     RdiiNodeFlow;        // inflows for nodes with RDII
-static int        RdiiFlowUnits;       // RDII flow units code
-static DateTime   RdiiStartDate;       // start date of RDII inflow period
-static DateTime   RdiiEndDate;         // end date of RDII inflow period
-static double     TotalRainVol;        // total rainfall volume (ft3)
-static double     TotalRdiiVol;        // total RDII volume (ft3)
-static int        RdiiFileType;        // type (binary/text) of RDII file
+#define UHGroup       (Prj->rdii.UHGroup)       // processing data for each UH group
+#define RdiiStep      (Prj->rdii.RdiiStep)      // RDII time step (sec)
+#define NumRdiiNodes  (Prj->rdii.NumRdiiNodes)  // number of nodes w/ RDII data
+#define RdiiNodeIndex (Prj->rdii.RdiiNodeIndex) // indexes of nodes w/ RDII data
+#define RdiiNodeFlow  (Prj->rdii.RdiiNodeFlow)  // inflows for nodes with RDII
+#define RdiiFlowUnits (Prj->rdii.RdiiFlowUnits) // RDII flow units code
+#define RdiiStartDate (Prj->rdii.RdiiStartDate) // start date of RDII inflow period
+#define RdiiEndDate   (Prj->rdii.RdiiEndDate)   // end date of RDII inflow period
+#define TotalRainVol  (Prj->rdii.TotalRainVol)  // total rainfall volume (ft3)
+#define TotalRdiiVol  (Prj->rdii.TotalRdiiVol)  // total RDII volume (ft3)
+#define RdiiFileType  (Prj->rdii.RdiiFileType)  // type (binary/text) of RDII file
 
 //-----------------------------------------------------------------------------
 // Imported Variables
@@ -105,6 +105,7 @@ extern double Qcf[];                   // flow units conversion factors
 //  rdii_closeRdii          (called from rain_close)
 //  rdii_getNumRdiiFlows    (called from addRdiiInflows in routing.c)
 //  rdii_getRdiiFlow        (called from addRdiiInflows in routing.c)
+//  rdii_snapshot           (called from listState in snapshot.c)
 
 //-----------------------------------------------------------------------------
 // Function Declarations
@@ -509,6 +510,18 @@ void rdii_closeRdii()
 
 //=============================================================================
 
+void rdii_snapshot(struct TSnapshot* snap)
+//
+//  Input:   snap = snapshot being built
+//  Output:  none
+//  Purpose: adds the RDII flows last read from the RDII file to a snapshot.
+//
+{
+    snapshot_addBlock(snap, RdiiNodeFlow, NumRdiiNodes * sizeof(REAL4));
+}
+
+//=============================================================================
+
 int rdii_getNumRdiiFlows(DateTime aDate)
 //
 //  Input:   aDate = current date/time
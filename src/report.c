@@ -40,6 +40,28 @@
 //   - Name of surcharge method reported in report_writeOptions().
 //   - Missing format specifier added to fprintf() in report_writeErrorCode.
 //
+//   Build 5.2.0:
+//   - Name of dynamic wave solver method (when not Picard) and Anderson
+//     history depth reported in report_writeOptions().
+//   - Thread schedule reported in report_writeOptions().
+//   - Size & memory use of dense geometry tables reported in
+//     report_writeOptions().
+//   - Analytic circular geometry method reported in report_writeOptions().
+//   - Hit rates of link critical & normal depth caches, and function
+//     evaluations per depth solved for, reported in report_writeSysStats()
+//     when the CacheStats report option is set.
+//   - Network ordering reported in report_writeOptions() and node & link
+//     results listed in input file order.
+//   - Single precision link state reported in report_writeOptions().
+//   - Dynamic wave predictor reported in report_writeOptions(), and the
+//     percent of time steps it predicted and of those done in one trial
+//     reported in report_writeSysStats().
+//   - Number of threads & thread schedule reported for parallel kinematic
+//     wave and steady flow routing.
+//   - Rosenbrock runoff solver reported in report_writeOptions().
+//   - Depth warm start reported in report_writeOptions().
+//   - Dynamic wave active set reported in report_writeOptions().
+//
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -61,16 +83,16 @@
 //-----------------------------------------------------------------------------
 //  Shared variables
 //-----------------------------------------------------------------------------
-static time_t SysTime;
+#define SysTime (Prj->report.SysTime)
 
 //-----------------------------------------------------------------------------
 //  Imported variables
 //-----------------------------------------------------------------------------
 #define REAL4 float
-extern REAL4* SubcatchResults;         // Results vectors defined in OUTPUT.C
-extern REAL4* NodeResults;             //  "
-extern REAL4* LinkResults;             //  "
-extern char   ErrString[81];           // defined in ERROR.C
+#define SubcatchResults (Prj->output.SubcatchResults) // Results vectors defined in OUTPUT.C
+#define NodeResults     (Prj->output.NodeResults)     //  "
+#define LinkResults     (Prj->output.LinkResults)     //  "
+extern THREADLOCAL char ErrString[256];               // defined in ERROR.C
 
 //-----------------------------------------------------------------------------
 //  Local functions
@@ -148,6 +170,13 @@ int report_readOptions(char* tok[], int ntoks)
         else               return error_setInpError(ERR_KEYWORD, tok[1]);      //
         return 0;                                                              //
 
+      case 9: // Depth Cache Statistics
+        m = findmatch(tok[1], NoYesWords);
+        if      ( m == YES ) RptFlags.cacheStats = TRUE;
+        else if ( m == NO )  RptFlags.cacheStats = FALSE;
+        else                 return error_setInpError(ERR_KEYWORD, tok[1]);
+        return 0;
+
       default: return error_setInpError(ERR_KEYWORD, tok[1]);
     }
     
@@ -279,6 +308,8 @@ void report_writeOptions()
 //
 {
     char str[80];
+    int  nTables, nSections;
+    double bytes;
     WRITE("");
     WRITE("*********************************************************");
     WRITE("NOTE: The summary statistics displayed in this report are");
@@ -335,6 +366,9 @@ void report_writeOptions()
     if (RouteModel == DW)                                                      //(5.1.013)
     fprintf(Frpt.file, "\n  Surcharge Method ......... %s",                    //(5.1.013)
         SurchargeWords[SurchargeMethod]);                                      //(5.1.013)
+    if (RouteModel == DW && SolverMethod != PICARD)
+    fprintf(Frpt.file, "\n  Solver Method ............ %s",
+        SolverWords[SolverMethod]);
 
     datetime_dateToStr(StartDate, str);
     fprintf(Frpt.file, "\n  Starting Date ............ %s", str);
@@ -353,22 +387,58 @@ void report_writeOptions()
         fprintf(Frpt.file, "\n  Wet Time Step ............ %s", str);
         datetime_timeToStr(datetime_encodeTime(0, 0, DryStep), str);
         fprintf(Frpt.file, "\n  Dry Time Step ............ %s", str);
+        if ( RunoffSolver == ROSENBROCK_RUNOFF )
+            fprintf(Frpt.file, "\n  Runoff Solver ............ %s",
+                RunoffSolverWords[RunoffSolver]);
     }
     if ( Nobjects[LINK] > 0 )
     {
         fprintf(Frpt.file, "\n  Routing Time Step ........ %.2f sec", RouteStep);
+        if ( DenseTableSize > 0 )
+        {
+            bytes = xsect_getDenseTableSize(&nTables, &nSections);
+            fprintf(Frpt.file, "\n  Dense Table Size ......... %d",
+                DenseTableSize);
+            fprintf(Frpt.file,
+                "\n  Dense Table Memory ....... %.1f KB (%d of %d sections)",
+                bytes / 1024.0, nTables, nSections);
+        }
+        if ( CircGeometry == ANALYTIC_GEOMETRY )
+            fprintf(Frpt.file, "\n  Circular Geometry ........ %s",
+                CircGeomWords[CircGeometry]);
+        if ( NetworkOrder == RCM_ORDER )
+            fprintf(Frpt.file, "\n  Network Order ............ %s",
+                NetworkOrderWords[NetworkOrder]);
+        if ( RouteModel == DW && Predictor != NO_PREDICTOR )
+            fprintf(Frpt.file, "\n  Predictor ................ %s",
+                PredictorWords[Predictor]);
+        if ( DepthWarmStart )
+            fprintf(Frpt.file, "\n  Depth Warm Start ......... YES");
+        if ( RouteModel == DW && ActiveSet )
+            fprintf(Frpt.file, "\n  Active Set ............... YES");
 		if ( RouteModel == DW )
 		{
 		fprintf(Frpt.file, "\n  Variable Time Step ....... ");
 		if ( CourantFactor > 0.0 ) fprintf(Frpt.file, "YES");
 		else                       fprintf(Frpt.file, "NO");
 		fprintf(Frpt.file, "\n  Maximum Trials ........... %d", MaxTrials);
+		if ( SolverMethod == ANDERSON )
+		fprintf(Frpt.file, "\n  Anderson Depth ........... %d", AndersonDepth);
+#ifdef SWMM_SINGLE_PRECISION_STATE
+		fprintf(Frpt.file, "\n  Link State Precision ..... SINGLE");
+#endif
         fprintf(Frpt.file, "\n  Number of Threads ........ %d", NumThreads);
 		fprintf(Frpt.file, "\n  Head Tolerance ........... %.6f ",
             HeadTol*UCF(LENGTH));
 		if ( UnitSystem == US ) fprintf(Frpt.file, "ft");
 		else                    fprintf(Frpt.file, "m");
 		}
+        else if ( NumThreads > 1 )
+            fprintf(Frpt.file, "\n  Number of Threads ........ %d",
+                NumThreads);
+        if ( NumThreads > 1 )
+            fprintf(Frpt.file, "\n  Thread Schedule .......... %s",
+                ScheduleWords[ThreadSchedule]);
     }
     WRITE("");
 }
@@ -938,7 +1008,7 @@ void report_QualErrors(int p1, int p2, TRoutingTotals* QualTotals)
 
 //=============================================================================
 
-void report_writeMaxStats(TMaxStats maxMassBalErrs[], TMaxStats maxCourantCrit[],
+void report_writeMaxStats(TMaxStats* maxMassBalErrs, TMaxStats* maxCourantCrit,
                           int nMaxStats)
 //
 //  Input:   maxMassBal[] = nodes with highest mass balance errors
@@ -992,7 +1062,7 @@ void report_writeMaxStats(TMaxStats maxMassBalErrs[], TMaxStats maxCourantCrit[]
 
 //=============================================================================
 
-void report_writeMaxFlowTurns(TMaxStats flowTurns[], int nMaxStats)
+void report_writeMaxFlowTurns(TMaxStats* flowTurns, int nMaxStats)
 //
 //  Input:   flowTurns[] = links with highest number of flow turns
 //           nMaxStats = number of links in flowTurns[]
@@ -1033,8 +1103,11 @@ void report_writeSysStats(TSysStats* sysStats)
 //  Purpose: writes simulation statistics for overall system to report file.
 //
 {
+    int    j;
     double x;
     double eventStepCount = (double)StepCount - sysStats->steadyStateCount;
+    double critCalls = 0.0, critHits = 0.0, normCalls = 0.0, normHits = 0.0;
+    double critEvals = 0.0, normEvals = 0.0;
 
     if ( Nobjects[LINK] == 0 || StepCount == 0
 	                     || eventStepCount == 0.0 ) return; 
@@ -1060,6 +1133,45 @@ void report_writeSysStats(TSysStats* sysStats)
     fprintf(Frpt.file,
         "\n  Percent Not Converging      :  %7.2f",
         100.0 * (double)NonConvergeCount / eventStepCount);
+
+    // --- percent of steps started from a predicted solution & percent of
+    //     those done in a single trial
+    if ( RouteModel == DW && Predictor != NO_PREDICTOR )
+    {
+        fprintf(Frpt.file,
+            "\n  Percent Steps Predicted     :  %7.2f",
+            100.0 * (double)PredictCount / eventStepCount);
+        if ( PredictCount > 0 ) fprintf(Frpt.file,
+            "\n  Pct. Predictions Confirmed  :  %7.2f",
+            100.0 * (double)PredictHitCount / (double)PredictCount);
+    }
+
+    // --- percent of critical & normal depths reused from link caches &
+    //     number of function evaluations per depth that was solved for
+    if ( RptFlags.cacheStats )
+    {
+        for (j = 0; j < Nobjects[LINK]; j++)
+        {
+            critCalls += Link[j].yCritCache.calls;
+            critHits  += Link[j].yCritCache.hits;
+            critEvals += Link[j].yCritCache.evals;
+            normCalls += Link[j].yNormCache.calls;
+            normHits  += Link[j].yNormCache.hits;
+            normEvals += Link[j].yNormCache.evals;
+        }
+        if ( critCalls > 0.0 ) fprintf(Frpt.file,
+            "\n  Pct. Critical Depths Cached :  %7.2f",
+            100.0 * critHits / critCalls);
+        if ( critCalls > critHits ) fprintf(Frpt.file,
+            "\n  Crit. Depth Evals per Solve :  %7.2f",
+            critEvals / (critCalls - critHits));
+        if ( normCalls > 0.0 ) fprintf(Frpt.file,
+            "\n  Pct. Normal Depths Cached   :  %7.2f",
+            100.0 * normHits / normCalls);
+        if ( normCalls > normHits ) fprintf(Frpt.file,
+            "\n  Norm. Depth Evals per Solve :  %7.2f",
+            normEvals / (normCalls - normHits));
+    }
     WRITE("");
 }
 
@@ -1224,7 +1336,7 @@ void report_Nodes()
 //  Purpose: writes results for selected nodes to report file.
 //
 {
-    int      j, p, k;
+    int      i, j, p, k;
     int      period;
     DateTime days;
     char     theDate[20];
@@ -1236,8 +1348,9 @@ void report_Nodes()
     WRITE("Node Results");
     WRITE("************");
     k = 0;
-    for (j = 0; j < Nobjects[NODE]; j++)
+    for (i = 0; i < Nobjects[NODE]; i++)
     {
+        j = project_getObjectIndex(NODE, i);
         if ( Node[j].rptFlag == TRUE )
         {
             report_NodeHeader(Node[j].ID);
@@ -1303,7 +1416,7 @@ void report_Links()
 //  Purpose: writes results for selected links to report file.
 //
 {
-    int      j, p, k;
+    int      i, j, p, k;
     int      period;
     DateTime days;
     char     theDate[12];
@@ -1315,8 +1428,9 @@ void report_Links()
     WRITE("Link Results");
     WRITE("************");
     k = 0;
-    for (j = 0; j < Nobjects[LINK]; j++)
+    for (i = 0; i < Nobjects[LINK]; i++)
     {
+        j = project_getObjectIndex(LINK, i);
         if ( Link[j].rptFlag == TRUE )
         {
             report_LinkHeader(Link[j].ID);
@@ -44,6 +44,14 @@
 //     mass balance purposes.
 //   - Global infiltration factor for storage seepage set in routing_execute.
 //
+//   Build 5.2.0:
+//   - Lists of the links of each kind are made when routing begins and
+//     used by loops that apply to only one kind of link.
+//   - Global infiltration factor no longer set in routing_execute (storage
+//     seepage uses the global conductivity adjustment directly).
+//   - Nodes whose lateral inflow changed and links whose setting changed
+//     are passed on to dynamic wave routing for its active set.
+//
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -56,10 +64,10 @@
 //-----------------------------------------------------------------------------
 // Shared variables
 //-----------------------------------------------------------------------------
-static int* SortedLinks;
-static int  NextEvent;
-static int  BetweenEvents;
-static double NewRuleTime;                                                     //(5.1.013)
+#define SortedLinks   (Prj->routing.SortedLinks)
+#define NextEvent     (Prj->routing.NextEvent)
+#define BetweenEvents (Prj->routing.BetweenEvents)
+#define NewRuleTime   (Prj->routing.NewRuleTime)   //(5.1.013)
 
 //-----------------------------------------------------------------------------
 //  External functions (declared in funcs.h)
@@ -111,11 +119,18 @@ int routing_open()
         if ( ErrorCode ) return ErrorCode;
     }
 
+    // --- list the links of each kind
+    if ( !link_createLists() )
+    {
+        report_writeErrorMsg(ERR_MEMORY, "");
+        return ErrorCode;
+    }
+
     // --- open any routing interface files
     iface_openRoutingFiles();
 
     // --- initialize flow and quality routing systems
-    flowrout_init(RouteModel);
+    flowrout_init(SortedLinks, RouteModel);
     if ( Fhotstart1.mode == NO_FILE ) qualrout_init();
 
     // --- initialize routing events
@@ -142,6 +157,7 @@ void routing_close(int routingModel)
     flowrout_close(routingModel);
     treatmnt_close();
     FREE(SortedLinks);
+    link_deleteLists();
 }
 
 //=============================================================================
@@ -221,7 +237,9 @@ void routing_execute(int routingModel, double routingStep)
 
     // --- find new link target settings that are not related to
     // --- control rules (e.g., pump on/off depth limits)
-    for (j=0; j<Nobjects[LINK]; j++) link_setTargetSetting(j);
+    //     (only pumps have such settings)
+    for (j = LinkListStart[PUMP_LIST]; j < LinkListStart[PUMP_LIST+1]; j++)
+        link_setTargetSetting(LinkLists[j]);
 
     // --- find date of start of current time period                           //(5.1.013)
     currentDate = getDateTime(NewRoutingTime);                                 //
@@ -244,6 +262,7 @@ void routing_execute(int routingModel, double routingStep)
 
             // --- implement the change in the link's setting
             link_setSetting(j, routingStep);
+            if ( routingModel == DW ) dynwave_wakeLink(j);
             actionCount++;
         } 
     }
@@ -267,10 +286,6 @@ void routing_execute(int routingModel, double routingStep)
         for (j=0; j<Nobjects[LINK]; j++) link_setOldQualState(j);
     }
 
-    // --- set infiltration factor for storage unit seepage                    //(5.1.013)
-    //     (-1 argument indicates global factor is used)                       //(5.1.013)
-    infil_setInfilFactor(-1);                                                  //(5.1.013)
-
     // --- initialize lateral inflows at nodes
     for (j = 0; j < Nobjects[NODE]; j++)
     {
@@ -329,6 +344,12 @@ void routing_execute(int routingModel, double routingStep)
             {
                 node_setOldHydState(j);
                 node_initInflow(j, routingStep);
+
+                // --- dynamic wave routing must visit nodes whose lateral
+                //     inflow has changed
+                if ( routingModel == DW &&
+                     (Node[j].newLatFlow != Node[j].oldLatFlow ||
+                      Node[j].losses != 0.0) ) dynwave_wakeNode(j);
             }
 
             // --- route flow through the drainage network
@@ -782,18 +803,16 @@ void removeConduitLosses()
            evapLoss = 0.0,
 	       seepLoss = 0.0;
 
-    for ( i = 0; i < Nobjects[LINK]; i++ )
+    for ( i = LinkListStart[CONDUIT_LIST]; i < LinkListStart[CONDUIT_LIST+1];
+          i++ )
     {
-	if (Link[i].type == CONDUIT)
-        {
-            // --- retrieve number of barrels
-            k = Link[i].subIndex;
-            barrels = Conduit[k].barrels;
+        // --- retrieve number of barrels
+        k = Link[LinkLists[i]].subIndex;
+        barrels = Conduit[k].barrels;
 
-            // --- update total conduit losses
-            evapLoss += Conduit[k].evapLossRate * barrels;
-            seepLoss += Conduit[k].seepLossRate * barrels;
-        }
+        // --- update total conduit losses
+        evapLoss += Conduit[k].evapLossRate * barrels;
+        seepLoss += Conduit[k].seepLossRate * barrels;
     }
     massbal_addLinkLosses(evapLoss, seepLoss);
 }
@@ -29,6 +29,15 @@
 //
 //   Build 5.1.012:
 //   - Runoff wet time step no longer kept aligned with reporting times.
+//
+//   Build 5.2.0:
+//   - Subcatchment runoff found in parallel when more than one thread is
+//     used, with each subcatchment's mass balance volumes held in its own
+//     runoff context and added to the system totals in subcatchment order.
+//   - Each thread integrates with its own ODE solver work arrays.
+//   - Subcatchments analyzed in blocks of MAXINFILBATCH whose pervious area
+//     infiltration is found as a batch, so a runoff context is kept for
+//     each subcatchment also when a single thread is used.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -37,28 +46,35 @@
 #include <stdlib.h>
 #include "headers.h"
 #include "odesolve.h"
+#if defined(_OPENMP)
+#include <omp.h>
+#else
+static int omp_get_thread_num(void) { return 0; }
+#endif
 
 //-----------------------------------------------------------------------------
 // Shared variables
 //-----------------------------------------------------------------------------
-static char  IsRaining;                // TRUE if precip. falls on study area
-static char  HasRunoff;                // TRUE if study area generates runoff
-static char  HasSnow;                  // TRUE if any snow cover on study area
-static int   Nsteps;                   // number of runoff time steps taken
-static int   MaxSteps;                 // final number of runoff time steps
-static long  MaxStepsPos;              // position in Runoff interface file
-                                       //    where MaxSteps is saved
+#define IsRaining   (Prj->runoff.IsRaining)   // TRUE if precip. falls on study area
+#define HasRunoff   (Prj->runoff.HasRunoff)   // TRUE if study area generates runoff
+#define HasSnow     (Prj->runoff.HasSnow)     // TRUE if any snow cover on study area
+#define Nsteps      (Prj->runoff.Nsteps)      // number of runoff time steps taken
+#define MaxSteps    (Prj->runoff.MaxSteps)    // final number of runoff time steps
+#define MaxStepsPos (Prj->runoff.MaxStepsPos) // position in Runoff interface file
+                                              //    where MaxSteps is saved
 
 //-----------------------------------------------------------------------------
 //  Exportable variables 
 //-----------------------------------------------------------------------------
-char    HasWetLids;  // TRUE if any LIDs are wet (used in lidproc.c)
-double* OutflowLoad; // exported pollutant mass load (used in surfqual.c)
+#define HasWetLids  (Prj->runoff.HasWetLids)  // TRUE if any LIDs are wet (used in lidproc.c)
+#define OutflowLoad (Prj->runoff.OutflowLoad) // exported pollutant mass load (used in surfqual.c)
+#define RunoffCtx   (Prj->runoff.RunoffCtx)   // runoff context of each subcatchment
+#define OdeSolvers  (Prj->runoff.OdeSolvers)  // ODE solver of each thread
 
 //-----------------------------------------------------------------------------
 //  Imported variables
 //-----------------------------------------------------------------------------
-extern float* SubcatchResults;         // Results vector defined in OUTPUT.C
+#define SubcatchResults (Prj->output.SubcatchResults) // Results vector defined in OUTPUT.C
 
 //-----------------------------------------------------------------------------
 //  External functions (declared in funcs.h)
@@ -66,6 +82,7 @@ extern float* SubcatchResults;         // Results vector defined in OUTPUT.C
 // runoff_open     (called from swmm_start in swmm5.c)
 // runoff_execute  (called from swmm_step in swmm5.c)
 // runoff_close    (called from swmm_end in swmm5.c)
+// runoff_snapshot (called from listState in snapshot.c)
 
 //-----------------------------------------------------------------------------
 // Local functions
@@ -75,6 +92,8 @@ static void   runoff_initFile(void);
 static void   runoff_readFromFile(void);
 static void   runoff_saveToFile(float tStep);
 static void   runoff_getOutfallRunon(double tStep);
+static void   runoff_getParallelRunoff(double tStep);
+static void   runoff_updateTotals(TRunoffContext* ctx);
 
 //=============================================================================
 
@@ -85,13 +104,24 @@ int runoff_open()
 //  Purpose: opens the runoff analyzer.
 //
 {
+    int j;
+
     IsRaining = FALSE;
     HasRunoff = FALSE;
     HasSnow = FALSE;
     Nsteps = 0;
 
-    // --- open the Ordinary Differential Equation solver
-    if ( !odesolve_open(MAXODES) ) report_writeErrorMsg(ERR_ODE_SOLVER, "");
+    // --- open an Ordinary Differential Equation solver for each thread
+    OdeSolvers = (TOdeSolver *) calloc(NumThreads, sizeof(TOdeSolver));
+    if ( !OdeSolvers ) report_writeErrorMsg(ERR_MEMORY, "");
+    else for (j = 0; j < NumThreads; j++)
+    {
+        if ( !odesolve_open(&OdeSolvers[j], MAXODES) )
+        {
+            report_writeErrorMsg(ERR_ODE_SOLVER, "");
+            break;
+        }
+    }
 
     // --- allocate memory for pollutant runoff loads
     OutflowLoad = NULL;
@@ -101,6 +131,15 @@ int runoff_open()
         if ( !OutflowLoad ) report_writeErrorMsg(ERR_MEMORY, "");
     }
 
+    // --- allocate a runoff context for each subcatchment
+    RunoffCtx = NULL;
+    if ( Nobjects[SUBCATCH] > 0 )
+    {
+        RunoffCtx = (TRunoffContext *) calloc(Nobjects[SUBCATCH],
+                                              sizeof(TRunoffContext));
+        if ( !RunoffCtx ) report_writeErrorMsg(ERR_MEMORY, "");
+    }
+
     // --- see if a runoff interface file should be opened
     switch ( Frunoff.mode )
     {
@@ -120,6 +159,18 @@ int runoff_open()
 
 //=============================================================================
 
+void runoff_snapshot(struct TSnapshot* snap)
+//
+//  Input:   snap = snapshot being built
+//  Output:  none
+//  Purpose: adds the runoff analyzer's pollutant loads to a snapshot.
+//
+{
+    snapshot_addBlock(snap, OutflowLoad, Nobjects[POLLUT] * sizeof(double));
+}
+
+//=============================================================================
+
 void runoff_close()
 //
 //  Input:   none
@@ -127,11 +178,18 @@ void runoff_close()
 //  Purpose: closes the runoff analyzer.
 //
 {
-    // --- close the ODE solver
-    odesolve_close();
+    int j;
 
-    // --- free memory for pollutant runoff loads
+    // --- close the ODE solvers
+    if ( OdeSolvers )
+    {
+        for (j = 0; j < NumThreads; j++) odesolve_close(&OdeSolvers[j]);
+        FREE(OdeSolvers);
+    }
+
+    // --- free memory for pollutant runoff loads & runoff contexts
     FREE(OutflowLoad);
+    FREE(RunoffCtx);
 
     // --- close runoff interface file if in use
     if ( Frunoff.file )
@@ -165,6 +223,7 @@ void runoff_execute()
     double   runoff;                   // subcatchment runoff (ft/sec)
     DateTime currentDate;              // current date/time 
     char     canSweep;                 // TRUE if street sweeping can occur
+    TRunoffContext* ctx;               // a subcatchment's runoff context
 
     if ( ErrorCode ) return;
 
@@ -249,17 +308,23 @@ void runoff_execute()
     HasSnow = FALSE;
     HasRunoff = FALSE;
     HasWetLids = FALSE;
+    runoff_getParallelRunoff(runoffStep);
     for (j = 0; j < Nobjects[SUBCATCH]; j++)
     {
         // --- find total runoff rate (in ft/sec) over the subcatchment
         //     (the amount that actually leaves the subcatchment (in cfs)
         //     is also computed and is stored in Subcatch[j].newRunoff)
         if ( Subcatch[j].area == 0.0 ) continue;
-        runoff = subcatch_getRunoff(j, runoffStep);
+        ctx = &RunoffCtx[j];
+        runoff = ctx->runoff;
+
+        // --- add subcatchment's volumes to the system mass balance
+        runoff_updateTotals(ctx);
 
         // --- update state of study area surfaces
         if ( runoff > 0.0 ) HasRunoff = TRUE;
         if ( Subcatch[j].newSnowDepth > 0.0 ) HasSnow = TRUE;
+        if ( ctx->hasWetLids ) HasWetLids = TRUE;
 
         // --- skip pollutant buildup/washoff if quality ignored
         if ( IgnoreQuality ) continue;
@@ -272,7 +337,7 @@ void runoff_execute()
             surfqual_sweepBuildup(j, currentDate);
 
         // --- compute pollutant washoff 
-        surfqual_getWashoff(j, runoff, runoffStep);
+        surfqual_getWashoff(j, runoff, runoffStep, ctx);
     }
 
     // --- update tracking of system-wide max. runoff rate
@@ -291,6 +356,72 @@ void runoff_execute()
 
 //=============================================================================
 
+void runoff_getParallelRunoff(double tStep)
+//
+//  Input:   tStep = runoff time step (sec)
+//  Output:  none
+//  Purpose: finds the runoff from all subcatchments, splitting them
+//           among threads.
+//
+//  Each subcatchment's runoff depends only on its own state and the runon
+//  found previously, so it can be found in any order. Its additions to the
+//  system mass balance are kept in its runoff context.
+//
+//  Subcatchments are handed out in blocks of MAXINFILBATCH. The inflows to
+//  the subareas of each subcatchment in a block are found first, then the
+//  infiltration of all of their pervious subareas at once, and then the
+//  rest of each subcatchment's runoff.
+{
+    int nBlocks = (Nobjects[SUBCATCH] + MAXINFILBATCH - 1) / MAXINFILBATCH;
+
+    flowrout_setThreadSchedule();
+#pragma omp parallel num_threads(NumThreads) copyin(Prj)
+{
+    int b, j, first, last;
+    TOdeSolver* ode = &OdeSolvers[omp_get_thread_num()];
+
+    #pragma omp for schedule(runtime)
+    for (b = 0; b < nBlocks; b++)
+    {
+        first = b * MAXINFILBATCH;
+        last = MIN(first + MAXINFILBATCH, Nobjects[SUBCATCH]);
+        for (j = first; j < last; j++)
+        {
+            if ( Subcatch[j].area == 0.0 ) continue;
+            RunoffCtx[j].ode = ode;
+            subcatch_initRunoff(j, tStep, &RunoffCtx[j]);
+        }
+        subcatch_getInfilBatch(first, last, tStep, RunoffCtx);
+        for (j = first; j < last; j++)
+        {
+            if ( Subcatch[j].area == 0.0 ) continue;
+            subcatch_getRunoff(j, tStep, &RunoffCtx[j]);
+        }
+    }
+}
+}
+
+//=============================================================================
+
+void runoff_updateTotals(TRunoffContext* ctx)
+//
+//  Input:   ctx = a subcatchment's runoff context
+//  Output:  none
+//  Purpose: adds a subcatchment's runoff & groundwater volumes to the
+//           system mass balance totals.
+//
+{
+    massbal_updateRunoffTotals(RUNOFF_DRAINS, ctx->vDrains);
+    massbal_updateGwaterTotals(ctx->gwInfil, ctx->gwUpperEvap,
+        ctx->gwLowerEvap, ctx->gwLowerPerc, ctx->gwFlow);
+    massbal_updateRunoffTotals(RUNOFF_RAINFALL, ctx->vRainfall);
+    massbal_updateRunoffTotals(RUNOFF_EVAP, ctx->vEvap);
+    massbal_updateRunoffTotals(RUNOFF_INFIL, ctx->vInfil + ctx->vLidInfil);
+    massbal_updateRunoffTotals(RUNOFF_RUNOFF, ctx->vRunoff);
+}
+
+//=============================================================================
+
 double runoff_getTimeStep(DateTime currentDate)
 //
 //  Input:   currentDate = current simulation date/time
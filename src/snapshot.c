@@ -0,0 +1,357 @@
+//-----------------------------------------------------------------------------
+//   snapshot.c
+//
+//   Project:  EPA SWMM5
+//   Version:  5.2
+//   Date:     10/16/26   (Build 5.2.0)
+//
+//   In-memory snapshots of a running simulation.
+//
+//   A snapshot is a list of the memory blocks that hold the state of a
+//   running project (its TProject context plus the arrays owned by its
+//   objects and computing modules) together with a single buffer holding
+//   a copy of all of them, and the positions of the files the simulation
+//   reads from or writes to as it advances. Restoring a snapshot copies
+//   the buffer back over the live blocks and repositions those files,
+//   returning the simulation to the time the snapshot was taken without
+//   any file I/O. Apart from the pool of control actions, no memory is
+//   allocated or freed once a run has started, so the block list remains
+//   valid for the rest of the run.
+//
+//   Each module registers the state it owns through a <module>_snapshot
+//   function that calls snapshot_addBlock() and snapshot_addFile().
+//
+//-----------------------------------------------------------------------------
+#define _CRT_SECURE_NO_DEPRECATE
+
+#include <stdlib.h>
+#include <string.h>
+#include "headers.h"
+#include "swmm5.h"
+
+//-----------------------------------------------------------------------------
+//  Shared variables
+//-----------------------------------------------------------------------------
+#define RunCount    (Prj->swmm5.RunCount)      // number of runs started
+#define ActionList  (Prj->controls.ActionList) // pool of control actions
+
+//-----------------------------------------------------------------------------
+//  Data Structures
+//-----------------------------------------------------------------------------
+// Block of memory holding simulation state
+typedef struct
+{
+    void*    data;                 // location of the block
+    size_t   size;                 // size of the block (bytes)
+}   TStateBlock;
+
+// Position of an open file
+typedef struct
+{
+    FILE*    file;                 // file pointer
+    long     pos;                  // position in file
+}   TFilePos;
+
+struct TSnapshot
+{
+    TProject*    project;          // project the snapshot was taken from
+    int          runCount;         // run of the project it was taken in
+    int          blockCount;       // number of state blocks
+    int          maxBlocks;        // capacity of blocks array
+    TStateBlock* blocks;           // array of state blocks
+    size_t       size;             // total size of state blocks (bytes)
+    char*        buffer;           // copy of all state blocks
+    int          fileCount;        // number of file positions
+    int          maxFiles;         // capacity of files array
+    TFilePos*    files;            // array of file positions
+    int          errcode;          // memory error code
+};
+
+//-----------------------------------------------------------------------------
+//  External functions (declared in swmm5.h)
+//-----------------------------------------------------------------------------
+//  swmm_snapshot
+//  swmm_updateSnapshot
+//  swmm_restore
+//  swmm_deleteSnapshot
+
+//-----------------------------------------------------------------------------
+//  Function declarations
+//-----------------------------------------------------------------------------
+static int  createSnapshot(struct TSnapshot** sh);
+static void deleteSnapshot(struct TSnapshot* snap);
+static void listState(struct TSnapshot* snap);
+static void captureState(struct TSnapshot* snap);
+static void restoreState(struct TSnapshot* snap);
+static int  checkSnapshot(struct TSnapshot* snap);
+
+//=============================================================================
+
+int DLLEXPORT swmm_snapshot(SWMM_Snapshot* sh)
+//
+//  Input:   sh = pointer to handle of the new snapshot
+//  Output:  returns an error code
+//  Purpose: saves the state of the simulation running in the current
+//           project.
+//
+{
+    if ( sh == NULL ) return error_getCode(ERR_API_OUTBOUNDS);
+    *sh = NULL;
+    if ( ErrorCode ) return error_getCode(ErrorCode);
+    if ( !swmm_IsStartedFlag() ) return error_getCode(ERR_API_SIM_NRUNNING);
+    return error_getCode(createSnapshot(sh));
+}
+
+//=============================================================================
+
+int DLLEXPORT swmm_updateSnapshot(SWMM_Snapshot sh)
+//
+//  Input:   sh = snapshot handle
+//  Output:  returns an error code
+//  Purpose: replaces the state saved in a snapshot with the current state
+//           of the simulation it was taken from.
+//
+{
+    int errcode = checkSnapshot(sh);
+    if ( errcode == 0 ) errcode = ErrorCode;
+    if ( errcode ) return error_getCode(errcode);
+    captureState(sh);
+    return 0;
+}
+
+//=============================================================================
+
+int DLLEXPORT swmm_restore(SWMM_Snapshot sh)
+//
+//  Input:   sh = snapshot handle
+//  Output:  returns an error code
+//  Purpose: returns the simulation to the state saved in a snapshot.
+//
+{
+    int errcode = checkSnapshot(sh);
+    if ( errcode ) return error_getCode(errcode);
+    restoreState(sh);
+    return 0;
+}
+
+//=============================================================================
+
+int DLLEXPORT swmm_deleteSnapshot(SWMM_Snapshot sh)
+//
+//  Input:   sh = snapshot handle
+//  Output:  returns an error code
+//  Purpose: frees the memory used by a snapshot.
+//
+{
+    if ( sh == NULL ) return error_getCode(ERR_API_OUTBOUNDS);
+    deleteSnapshot(sh);
+    return 0;
+}
+
+//=============================================================================
+
+void snapshot_addBlock(struct TSnapshot* snap, void* data, size_t size)
+//
+//  Input:   snap = snapshot being built
+//           data = location of a block of state variables
+//           size = size of the block (bytes)
+//  Output:  none
+//  Purpose: adds a block of memory to the state saved by a snapshot.
+//
+{
+    TStateBlock* blocks;
+
+    if ( data == NULL || size == 0 || snap->errcode ) return;
+    if ( snap->blockCount == snap->maxBlocks )
+    {
+        snap->maxBlocks = ( snap->maxBlocks ) ? 2 * snap->maxBlocks : 256;
+        blocks = (TStateBlock *) realloc(snap->blocks,
+                                         snap->maxBlocks*sizeof(TStateBlock));
+        if ( blocks == NULL )
+        {
+            snap->errcode = ERR_MEMORY;
+            return;
+        }
+        snap->blocks = blocks;
+    }
+    snap->blocks[snap->blockCount].data = data;
+    snap->blocks[snap->blockCount].size = size;
+    snap->blockCount++;
+    snap->size += size;
+}
+
+//=============================================================================
+
+void snapshot_addFile(struct TSnapshot* snap, FILE* file)
+//
+//  Input:   snap = snapshot being built
+//           file = pointer to an open file
+//  Output:  none
+//  Purpose: adds an open file whose position is saved by a snapshot.
+//
+{
+    TFilePos* files;
+
+    if ( file == NULL || snap->errcode ) return;
+    if ( snap->fileCount == snap->maxFiles )
+    {
+        snap->maxFiles = ( snap->maxFiles ) ? 2 * snap->maxFiles : 16;
+        files = (TFilePos *) realloc(snap->files,
+                                     snap->maxFiles*sizeof(TFilePos));
+        if ( files == NULL )
+        {
+            snap->errcode = ERR_MEMORY;
+            return;
+        }
+        snap->files = files;
+    }
+    snap->files[snap->fileCount].file = file;
+    snap->files[snap->fileCount].pos = 0;
+    snap->fileCount++;
+}
+
+//=============================================================================
+
+int createSnapshot(struct TSnapshot** sh)
+//
+//  Input:   sh = pointer to handle of the new snapshot
+//  Output:  returns an error code
+//  Purpose: builds the list of state blocks of the current project and
+//           saves their contents.
+//
+{
+    struct TSnapshot* snap;
+    int errcode;
+
+    snap = (struct TSnapshot *) calloc(1, sizeof(struct TSnapshot));
+    if ( snap == NULL ) return ERR_MEMORY;
+    snap->project = Prj;
+    snap->runCount = RunCount;
+    listState(snap);
+    if ( snap->errcode == 0 )
+    {
+        snap->buffer = (char *) malloc(snap->size);
+        if ( snap->buffer == NULL ) snap->errcode = ERR_MEMORY;
+    }
+    errcode = snap->errcode;
+    if ( errcode )
+    {
+        deleteSnapshot(snap);
+        return errcode;
+    }
+    captureState(snap);
+    *sh = snap;
+    return 0;
+}
+
+//=============================================================================
+
+void deleteSnapshot(struct TSnapshot* snap)
+{
+    FREE(snap->blocks);
+    FREE(snap->files);
+    FREE(snap->buffer);
+    free(snap);
+}
+
+//=============================================================================
+
+int checkSnapshot(struct TSnapshot* snap)
+//
+//  Input:   snap = a snapshot
+//  Output:  returns an error code
+//  Purpose: checks that a snapshot was taken from the simulation currently
+//           running in the current project.
+//
+{
+    if ( snap == NULL ) return ERR_API_OUTBOUNDS;
+    if ( !swmm_IsStartedFlag() ) return ERR_API_SIM_NRUNNING;
+    if ( snap->project != Prj || snap->runCount != RunCount )
+        return ERR_API_SNAPSHOT;
+    return 0;
+}
+
+//=============================================================================
+
+void listState(struct TSnapshot* snap)
+//
+//  Input:   snap = snapshot being built
+//  Output:  none
+//  Purpose: has each module add the state it owns to a snapshot.
+//
+{
+    // --- the project context holds all scalar state and must come first
+    //     (see restoreState)
+    snapshot_addBlock(snap, Prj, sizeof(TProject));
+
+    project_snapshot(snap);
+    runoff_snapshot(snap);
+    dynwave_snapshot(snap);
+    massbal_snapshot(snap);
+    stats_snapshot(snap);
+    output_snapshot(snap);
+    rdii_snapshot(snap);
+    iface_snapshot(snap);
+
+    // --- interface files read or written as the simulation advances
+    //     (the rainfall file is re-positioned from the state of each gage)
+    snapshot_addFile(snap, Fout.file);
+    snapshot_addFile(snap, Fclimate.file);
+    snapshot_addFile(snap, Frunoff.file);
+    snapshot_addFile(snap, Frdii.file);
+    snapshot_addFile(snap, Finflows.file);
+    snapshot_addFile(snap, Foutflows.file);
+}
+
+//=============================================================================
+
+void captureState(struct TSnapshot* snap)
+//
+//  Input:   snap = a snapshot
+//  Output:  none
+//  Purpose: copies the current contents of a snapshot's state blocks and
+//           the positions of its files into the snapshot.
+//
+{
+    int    i;
+    char*  p = snap->buffer;
+
+    for (i = 0; i < snap->blockCount; i++)
+    {
+        memcpy(p, snap->blocks[i].data, snap->blocks[i].size);
+        p += snap->blocks[i].size;
+    }
+    for (i = 0; i < snap->fileCount; i++)
+    {
+        snap->files[i].pos = ftell(snap->files[i].file);
+    }
+}
+
+//=============================================================================
+
+void restoreState(struct TSnapshot* snap)
+//
+//  Input:   snap = a snapshot
+//  Output:  none
+//  Purpose: copies the state saved in a snapshot back into the project.
+//
+{
+    int    i;
+    char*  p = snap->buffer;
+    struct TActionList* actionList;
+
+    // --- the pool of control actions is re-built at each rule evaluation
+    //     and its items can be re-allocated, so the live pointer is kept
+    actionList = ActionList;
+    for (i = 0; i < snap->blockCount; i++)
+    {
+        memcpy(snap->blocks[i].data, p, snap->blocks[i].size);
+        p += snap->blocks[i].size;
+    }
+    ActionList = actionList;
+
+    for (i = 0; i < snap->fileCount; i++)
+    {
+        fseek(snap->files[i].file, snap->files[i].pos, SEEK_SET);
+    }
+}
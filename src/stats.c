@@ -36,6 +36,13 @@
 //   - Statistics on impervious and pervious runoff totals added.
 //   - Storage nodes with a non-zero surcharge depth (e.g. enclosed tanks)
 //     can now be classified as being surcharged.
+//
+//   Build 5.2.0:
+//   - Total system outfall flow summed over outfalls in a fixed order after
+//     the parallel update of node statistics (it was summed by the threads
+//     as they went, in an order that varied from run to run).
+//   - Arrays of max. stats held by the project passed as TMaxStats
+//     pointers (GCC warned of out of bounds access for array parameters).
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -51,30 +58,29 @@
 //-----------------------------------------------------------------------------
 //  Shared variables
 //-----------------------------------------------------------------------------
-#define MAX_STATS 5
-static TSysStats       SysStats;
-static TMaxStats       MaxMassBalErrs[MAX_STATS];
-static TMaxStats       MaxCourantCrit[MAX_STATS];
-static TMaxStats       MaxFlowTurns[MAX_STATS];
-static double          SysOutfallFlow;
+#define SysStats        (Prj->stats.SysStats)
+#define MaxMassBalErrs  (Prj->stats.MaxMassBalErrs)
+#define MaxCourantCrit  (Prj->stats.MaxCourantCrit)
+#define MaxFlowTurns    (Prj->stats.MaxFlowTurns)
+#define SysOutfallFlow  (Prj->stats.SysOutfallFlow)
 
 //-----------------------------------------------------------------------------
 //  Exportable variables (shared with statsrpt.c)
 //-----------------------------------------------------------------------------
-TSubcatchStats*     SubcatchStats;
-TNodeStats*         NodeStats;
-TLinkStats*         LinkStats;
-TStorageStats*      StorageStats;
-TOutfallStats*      OutfallStats;
-TPumpStats*         PumpStats;
-double              MaxOutfallFlow;
-double              MaxRunoffFlow;
+#define SubcatchStats   (Prj->stats.SubcatchStats)
+#define NodeStats       (Prj->stats.NodeStats)
+#define LinkStats       (Prj->stats.LinkStats)
+#define StorageStats    (Prj->stats.StorageStats)
+#define OutfallStats    (Prj->stats.OutfallStats)
+#define PumpStats       (Prj->stats.PumpStats)
+#define MaxOutfallFlow  (Prj->stats.MaxOutfallFlow)
+#define MaxRunoffFlow   (Prj->stats.MaxRunoffFlow)
 
 //-----------------------------------------------------------------------------
 //  Imported variables
 //-----------------------------------------------------------------------------
-extern double*         NodeInflow;     // defined in massbal.c
-extern double*         NodeOutflow;    // defined in massbal.c
+#define NodeInflow      (Prj->massbal.NodeInflow)     // defined in massbal.c
+#define NodeOutflow     (Prj->massbal.NodeOutflow)    // defined in massbal.c
 
 //-----------------------------------------------------------------------------
 //  External functions (declared in funcs.h)
@@ -82,6 +88,7 @@ extern double*         NodeOutflow;    // defined in massbal.c
 //  stats_open                    (called from swmm_start in swmm5.c)
 //  stats_close                   (called from swmm_end in swmm5.c)
 //  stats_report                  (called from swmm_end in swmm5.c)
+//  stats_snapshot                (called from listState in snapshot.c)
 //  stats_updateSubcatchStats     (called from subcatch_getRunoff)
 //  stats_updateGwaterStats       (called from gwater_getGroundwater)
 //  stats_updateFlowStats         (called from routing_execute)
@@ -94,7 +101,7 @@ extern double*         NodeOutflow;    // defined in massbal.c
 static void stats_updateNodeStats(int node, double tStep, DateTime aDate);
 static void stats_updateLinkStats(int link, double tStep, DateTime aDate);
 static void stats_findMaxStats(void);
-static void stats_updateMaxStats(TMaxStats maxStats[], int i, int j, double x);
+static void stats_updateMaxStats(TMaxStats* maxStats, int i, int j, double x);
 
 //=============================================================================
 
@@ -315,6 +322,31 @@ void  stats_close()
 
 //=============================================================================
 
+void  stats_snapshot(struct TSnapshot* snap)
+//
+//  Input:   snap = snapshot being built
+//  Output:  none
+//  Purpose: adds the simulation statistics to a snapshot.
+//
+{
+    int j;
+
+    snapshot_addBlock(snap, SubcatchStats,
+                      Nobjects[SUBCATCH] * sizeof(TSubcatchStats));
+    snapshot_addBlock(snap, NodeStats, Nobjects[NODE] * sizeof(TNodeStats));
+    snapshot_addBlock(snap, LinkStats, Nobjects[LINK] * sizeof(TLinkStats));
+    snapshot_addBlock(snap, StorageStats,
+                      Nnodes[STORAGE] * sizeof(TStorageStats));
+    snapshot_addBlock(snap, OutfallStats,
+                      Nnodes[OUTFALL] * sizeof(TOutfallStats));
+    if ( OutfallStats ) for ( j=0; j<Nnodes[OUTFALL]; j++ )
+        snapshot_addBlock(snap, OutfallStats[j].totalLoad,
+                          Nobjects[POLLUT] * sizeof(double));
+    snapshot_addBlock(snap, PumpStats, Nlinks[PUMP] * sizeof(TPumpStats));
+}
+
+//=============================================================================
+
 void  stats_report()
 //
 //  Input:   none
@@ -435,7 +467,7 @@ void   stats_updateFlowStats(double tStep, DateTime aDate, int stepCount,
     SysOutfallFlow = 0.0;
 
     // --- update node & link stats
-#pragma omp parallel num_threads(NumThreads)
+#pragma omp parallel num_threads(NumThreads) copyin(Prj)
 {
     #pragma omp for
     for ( j=0; j<Nobjects[NODE]; j++ )
@@ -445,6 +477,11 @@ void   stats_updateFlowStats(double tStep, DateTime aDate, int stepCount,
         stats_updateLinkStats(j, tStep, aDate);
 }
 
+    // --- add up outfall flows in order of node index
+    //     (so the total does not depend on the number of threads)
+    for ( j=0; j<Nobjects[NODE]; j++ )
+        if ( Node[j].type == OUTFALL ) SysOutfallFlow += Node[j].inflow;
+
     // --- update count of times in steady state
     SysStats.steadyStateCount += steadyState;
 
@@ -564,7 +601,6 @@ void stats_updateNodeStats(int j, double tStep, DateTime aDate)
             OutfallStats[k].totalLoad[p] += Node[j].inflow *
             Node[j].newQual[p] * tStep;
         }
-        SysOutfallFlow += Node[j].inflow;
     }
 
     // --- update inflow statistics
@@ -764,7 +800,7 @@ void  stats_findMaxStats()
 
 //=============================================================================
 
-void  stats_updateMaxStats(TMaxStats maxStats[], int i, int j, double x)
+void  stats_updateMaxStats(TMaxStats* maxStats, int i, int j, double x)
 //
 //  Input:   maxStats[] = array of critical statistics values
 //           i = object category (NODE or LINK)
@@ -26,6 +26,10 @@
 //
 //   Build 5.1.013:
 //   - Pervious and impervious runoff added to Subcatchment Runoff Summary.
+//
+//   Build 5.2.0:
+//   - Nodes & links listed in input file order when the network has been
+//     renumbered.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -39,16 +43,16 @@
 //-----------------------------------------------------------------------------
 //  Imported variables
 //-----------------------------------------------------------------------------
-extern TSubcatchStats* SubcatchStats;          // defined in STATS.C
-extern TNodeStats*     NodeStats;
-extern TLinkStats*     LinkStats;
-extern TStorageStats*  StorageStats;
-extern TOutfallStats*  OutfallStats;
-extern TPumpStats*     PumpStats;
-extern double          MaxOutfallFlow;
-extern double          MaxRunoffFlow;
-extern double*         NodeInflow;             // defined in MASSBAL.C
-extern double*         NodeOutflow;            // defined in massbal.c
+#define SubcatchStats  (Prj->stats.SubcatchStats)   // defined in STATS.C
+#define NodeStats      (Prj->stats.NodeStats)
+#define LinkStats      (Prj->stats.LinkStats)
+#define StorageStats   (Prj->stats.StorageStats)
+#define OutfallStats   (Prj->stats.OutfallStats)
+#define PumpStats      (Prj->stats.PumpStats)
+#define MaxOutfallFlow (Prj->stats.MaxOutfallFlow)
+#define MaxRunoffFlow  (Prj->stats.MaxRunoffFlow)
+#define NodeInflow     (Prj->massbal.NodeInflow)   // defined in MASSBAL.C
+#define NodeOutflow    (Prj->massbal.NodeOutflow)  // defined in massbal.c
 
 //-----------------------------------------------------------------------------
 //  Local functions
@@ -70,8 +74,8 @@ void    writeLinkLoads(void);
 
 #define WRITE(x) (report_writeLine((x)))
 
-static char   FlowFmt[6];
-static double Vcf;
+static THREADLOCAL char   FlowFmt[6];
+static THREADLOCAL double Vcf;
 
 //=============================================================================
 
@@ -311,7 +315,7 @@ void writeNodeDepths()
 //  Purpose: writes simulation statistics for nodes to report file.
 //
 {
-    int j, days, hrs, mins;
+    int i, j, days, hrs, mins;
     if ( Nobjects[LINK] == 0 ) return;
 
     WRITE("");
@@ -331,8 +335,9 @@ void writeNodeDepths()
     fprintf(Frpt.file,
 "\n  ---------------------------------------------------------------------------------");
 
-    for ( j = 0; j < Nobjects[NODE]; j++ )
+    for ( i = 0; i < Nobjects[NODE]; i++ )
     {
+        j = project_getObjectIndex(NODE, i);
         fprintf(Frpt.file, "\n  %-20s", Node[j].ID);
         fprintf(Frpt.file, " %-9s ", NodeTypeWords[Node[j].type]);
         getElapsedTime(NodeStats[j].maxDepthDate, &days, &hrs, &mins);
@@ -354,7 +359,7 @@ void writeNodeFlows()
 //  Purpose: writes flow statistics for nodes to report file.
 //
 {
-    int j;
+    int i, j;
     int days1, hrs1, mins1;
 
     WRITE("");
@@ -374,8 +379,9 @@ void writeNodeFlows()
     fprintf(Frpt.file,
 "\n  -------------------------------------------------------------------------------------------------");
 
-    for ( j = 0; j < Nobjects[NODE]; j++ )
+    for ( i = 0; i < Nobjects[NODE]; i++ )
     {
+        j = project_getObjectIndex(NODE, i);
         fprintf(Frpt.file, "\n  %-20s", Node[j].ID);
         fprintf(Frpt.file, " %-9s", NodeTypeWords[Node[j].type]);
         getElapsedTime(NodeStats[j].maxInflowDate, &days1, &hrs1, &mins1);
@@ -399,7 +405,7 @@ void writeNodeFlows()
 
 void writeNodeSurcharge()
 {
-    int    j, n = 0;
+    int    i, j, n = 0;
     double t, d1, d2;
 
     WRITE("");
@@ -408,8 +414,9 @@ void writeNodeSurcharge()
     WRITE("**********************");
     WRITE("");
 
-    for ( j = 0; j < Nobjects[NODE]; j++ )
+    for ( i = 0; i < Nobjects[NODE]; i++ )
     {
+        j = project_getObjectIndex(NODE, i);
         if ( Node[j].type == OUTFALL ) continue;
         if ( NodeStats[j].timeSurcharged == 0.0 ) continue;
         t = MAX(0.01, (NodeStats[j].timeSurcharged / 3600.0));
@@ -445,7 +452,7 @@ void writeNodeSurcharge()
 
 void writeNodeFlooding()
 {
-    int    j, n = 0;
+    int    i, j, n = 0;
     int    days, hrs, mins;
     double t;
 
@@ -455,8 +462,9 @@ void writeNodeFlooding()
     WRITE("*********************");
     WRITE("");
 
-    for ( j = 0; j < Nobjects[NODE]; j++ )
+    for ( i = 0; i < Nobjects[NODE]; i++ )
     {
+        j = project_getObjectIndex(NODE, i);
         if ( Node[j].type == OUTFALL ) continue;
         if ( NodeStats[j].timeFlooded == 0.0 ) continue;
         t = MAX(0.01, (NodeStats[j].timeFlooded / 3600.0));
@@ -509,7 +517,7 @@ void writeStorageVolumes()
 //  Purpose: writes simulation statistics for storage units to report file.
 //
 {
-    int    j, k, days, hrs, mins;
+    int    i, j, k, days, hrs, mins;
     double avgVol, maxVol, pctAvgVol, pctMaxVol;
     double addedVol, pctEvapLoss, pctSeepLoss;
 
@@ -533,8 +541,9 @@ void writeStorageVolumes()
         fprintf(Frpt.file,
 "\n  --------------------------------------------------------------------------------------------------");
 
-        for ( j = 0; j < Nobjects[NODE]; j++ )
+        for ( i = 0; i < Nobjects[NODE]; i++ )
         {
+            j = project_getObjectIndex(NODE, i);
             if ( Node[j].type != STORAGE ) continue;
             k = Node[j].subIndex;
             fprintf(Frpt.file, "\n  %-20s", Node[j].ID);
@@ -626,8 +635,9 @@ void writeOutfallLoads()
         for (p = 0; p < Nobjects[POLLUT]; p++) fprintf(Frpt.file, "--------------");
 
         // --- identify each outfall node
-        for (j=0; j<Nobjects[NODE]; j++)
+        for ( i = 0; i < Nobjects[NODE]; i++ )
         {
+            j = project_getObjectIndex(NODE, i);
             if ( Node[j].type != OUTFALL ) continue;
             k = Node[j].subIndex;
             flowCount = OutfallStats[k].totalPeriods;
@@ -693,7 +703,7 @@ void writeLinkFlows()
 //  Purpose: writes simulation statistics for links to report file.
 //
 {
-    int    j, k, days, hrs, mins;
+    int    i, j, k, days, hrs, mins;
     double v, fullDepth;
 
     if (Nobjects[LINK] == 0) return;
@@ -716,8 +726,9 @@ void writeLinkFlows()
     fprintf(Frpt.file,
         "\n  -----------------------------------------------------------------------------");
 
-    for (j = 0; j < Nobjects[LINK]; j++)
+    for ( i = 0; i < Nobjects[LINK]; i++ )
     {
+        j = project_getObjectIndex(LINK, i);
         // --- print link ID
         k = Link[j].subIndex;
         fprintf(Frpt.file, "\n  %-20s", Link[j].ID);
@@ -780,7 +791,7 @@ void writeFlowClass()
 //  Purpose: writes flow classification fro each conduit to report file.
 //
 {
-    int   i, j, k;
+    int   i, j, k, m;
 
     if ( RouteModel != DW ) return;
     WRITE("");
@@ -794,8 +805,9 @@ void writeFlowClass()
 "\n                       /Actual         Up    Down  Sub   Sup   Up    Down  Norm  Inlet "
 "\n  Conduit               Length    Dry  Dry   Dry   Crit  Crit  Crit  Crit  Ltd   Ctrl  "
 "\n  -------------------------------------------------------------------------------------");
-    for ( j = 0; j < Nobjects[LINK]; j++ )
+    for ( m = 0; m < Nobjects[LINK]; m++ )
     {
+        j = project_getObjectIndex(LINK, m);
         if ( Link[j].type != CONDUIT ) continue;
         if ( Link[j].xsect.type == DUMMY ) continue;
         k = Link[j].subIndex;
@@ -818,7 +830,7 @@ void writeFlowClass()
 
 void writeLinkSurcharge()
 {
-    int    i, j, n = 0;
+    int    i, j, m, n = 0;
     double t[5];
 
     WRITE("");
@@ -826,8 +838,9 @@ void writeLinkSurcharge()
     WRITE("Conduit Surcharge Summary");
     WRITE("*************************");
     WRITE("");
-    for ( j = 0; j < Nobjects[LINK]; j++ )
+    for ( m = 0; m < Nobjects[LINK]; m++ )
     {
+        j = project_getObjectIndex(LINK, m);
         if ( Link[j].type != CONDUIT ||
              Link[j].xsect.type == DUMMY ) continue; 
         t[0] = LinkStats[j].timeSurcharged / 3600.0;
@@ -864,7 +877,7 @@ void writePumpFlows()
 //  Purpose: writes simulation statistics for pumps to report file.
 //
 {
-    int    j, k;
+    int    i, j, k;
     double avgFlow, pctUtilized, pctOffCurve1, pctOffCurve2, totalSeconds;
 
     if ( Nlinks[PUMP] == 0 ) return;
@@ -883,8 +896,9 @@ void writePumpFlows()
 "\n  ---------------------------------------------------------------------------------------------------------",
         FlowUnitWords[FlowUnits], FlowUnitWords[FlowUnits],
         FlowUnitWords[FlowUnits], VolUnitsWords[UnitSystem]);
-    for ( j = 0; j < Nobjects[LINK]; j++ )
+    for ( i = 0; i < Nobjects[LINK]; i++ )
     {
+        j = project_getObjectIndex(LINK, i);
         if ( Link[j].type != PUMP ) continue;
         k = Link[j].subIndex;
         fprintf(Frpt.file, "\n  %-20s", Link[j].ID);
@@ -941,8 +955,9 @@ void writeLinkLoads()
     for (p = 0; p < Nobjects[POLLUT]; p++) fprintf(Frpt.file, "%s", pollutLine);
 
     // --- print the pollutant loadings carried by each link
-    for ( j = 0; j < Nobjects[LINK]; j++ )
+    for ( i = 0; i < Nobjects[LINK]; i++ )
     {
+        j = project_getObjectIndex(LINK, i);
         fprintf(Frpt.file, "\n  %-20s", Link[j].ID);
         for (p = 0; p < Nobjects[POLLUT]; p++)
         {
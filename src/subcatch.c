@@ -45,6 +45,21 @@
 //   - Support added for monthly adjustment of subcatchment's depression
 //     storage, pervious N, and infiltration.
 //
+//   Build 5.2.0:
+//   - Water balance volumes, adjusted subarea parameters and the
+//     infiltration adjustment factor held in a TRunoffContext passed to
+//     subcatch_getRunoff() instead of in shared variables, so that
+//     subcatchments can be analyzed in parallel.
+//   - Mass balance volumes saved to the runoff context, to be added to the
+//     system totals by the caller in subcatchment order.
+//   - Ponded depth integrated with the runoff context's ODE solver, which
+//     passes the context on to getDdDt().
+//   - Ponded depth can instead be updated by a fixed number of Rosenbrock
+//     steps (RUNOFF_SOLVER option), see getRosenbrockDepth().
+//   - Inflows to a subcatchment's subareas found by a separate function,
+//     subcatch_initRunoff(), so that the infiltration of a batch of
+//     subcatchments can be found together by subcatch_getInfilBatch().
+//
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -60,28 +75,13 @@
 const double MCOEFF    = 1.49;              // constant in Manning Eq.
 const double MEXP      = 1.6666667;         // exponent in Manning Eq.
 const double ODETOL    = 0.0001;            // acceptable error for ODE solver
-
-//-----------------------------------------------------------------------------
-// Globally shared variables   
-//-----------------------------------------------------------------------------
-// Volumes (ft3) for a subcatchment over a time step
-double     Vevap;         // evaporation
-double     Vpevap;        // pervious area evaporation
-double     Vinfil;        // non-LID infiltration
-double     Vinflow;       // non-LID precip + snowmelt + runon + ponded water
-double     Voutflow;      // non-LID runoff to subcatchment's outlet
-double     VlidIn;        // impervious area flow to LID units
-double     VlidInfil;     // infiltration from LID units
-double     VlidOut;       // surface outflow from LID units
-double     VlidDrain;     // drain outflow from LID units
-double     VlidReturn;    // LID outflow returned to pervious area
+const double ROSTOL    = 0.001;             // acceptable error for Rosenbrock
+const int    ROSMAXSUB = 16;                // max. substeps of Rosenbrock
+const double ROSGAMMA  = 1.7071068;         // 1 + 1/sqrt(2) for L-stability
 
 //-----------------------------------------------------------------------------
 // Locally shared variables   
 //-----------------------------------------------------------------------------
-static  TSubarea* theSubarea;     // subarea to which getDdDt() is applied
-static  double    Dstore;         // monthly adjusted depression storage (ft)  //(5.1.013)
-static  double    Alpha;          // monthly adjusted runoff coeff.            //
 static  char *RunoffRoutingWords[] = { w_OUTLET,  w_IMPERV, w_PERV, NULL};
 
 //-----------------------------------------------------------------------------
@@ -99,7 +99,9 @@ static  char *RunoffRoutingWords[] = { w_OUTLET,  w_IMPERV, w_PERV, NULL};
 //  subcatch_getRunon          (called from runoff_execute)
 //  subcatch_addRunon          (called from subcatch_getRunon,
 //                              lid_addDrainRunon, & runoff_getOutfallRunon)
-//  subcatch_getRunoff         (called from runoff_execute)
+//  subcatch_initRunoff        (called from runoff_getParallelRunoff)
+//  subcatch_getInfilBatch     (called from runoff_getParallelRunoff)
+//  subcatch_getRunoff         (called from runoff_getParallelRunoff)
 //  subcatch_hadRunoff         (called from runoff_execute)
 
 //  subcatch_getFracPerv       (called from gwater_initState)
@@ -115,13 +117,21 @@ static  char *RunoffRoutingWords[] = { w_OUTLET,  w_IMPERV, w_PERV, NULL};
 //-----------------------------------------------------------------------------
 static void   getNetPrecip(int j, double* netPrecip, double tStep);
 static double getSubareaRunoff(int subcatch, int subarea, double area,
-              double rainfall, double evap, double tStep);
-static double getSubareaInfil(int j, TSubarea* subarea, double precip,
-              double tStep);
-static double findSubareaRunoff(TSubarea* subarea, double tRunoff);
-static void   updatePondedDepth(TSubarea* subarea, double* tx);
-static void   getDdDt(double t, double* d, double* dddt);
-static void   adjustSubareaParams(int subareaType, int subcatch);              //(5.1.013)
+              double rainfall, double evap, double tStep,
+              TRunoffContext* ctx);
+static double findSubareaRunoff(TSubarea* subarea, double tRunoff,
+              TRunoffContext* ctx);
+static void   updatePondedDepth(TSubarea* subarea, double* tx,
+              TRunoffContext* ctx);
+static void   getDdDt(void* data, double t, double* d, double* dddt);
+static double getRosenbrockDepth(double x, double ix, double tx,
+              double alpha);
+static double getRisingStep(double x, double ix, double h, double alpha,
+              double* err);
+static double getRecedingStep(double x, double ix, double h, double alpha,
+              double* err);
+static void   adjustSubareaParams(int subareaType, int subcatch,               //(5.1.013)
+              TRunoffContext* ctx);
 
 //=============================================================================
 
@@ -637,10 +647,134 @@ void  subcatch_addRunonFlow(int k, double q)
 
 //=============================================================================
 
-double subcatch_getRunoff(int j, double tStep)
+void subcatch_initRunoff(int j, double tStep, TRunoffContext* ctx)
+//
+//  Input:   j = subcatchment index
+//           tStep = time step (sec)
+//           ctx = context that receives the subcatchment's water balance
+//  Output:  none
+//  Purpose: starts the subcatchment's water balance over a time step and
+//           finds the net precipitation & evaporation rate over its
+//           subareas.
+//
+{
+    double nonLidArea;                 // non-LID portion of subcatch area (ft2)
+
+    // --- initialize the context's water balance variables
+    ctx->vEvap      = 0.0;
+    ctx->vPevap     = 0.0;
+    ctx->vInfil     = 0.0;
+    ctx->vOutflow   = 0.0;
+    ctx->vLidIn     = 0.0;
+    ctx->vLidInfil  = 0.0;
+    ctx->vLidOut    = 0.0;
+    ctx->vLidDrain  = 0.0;
+    ctx->vLidReturn = 0.0;
+    ctx->vDrains    = 0.0;
+    ctx->hasWetLids = FALSE;
+    ctx->gwInfil     = 0.0;
+    ctx->gwUpperEvap = 0.0;
+    ctx->gwLowerEvap = 0.0;
+    ctx->gwLowerPerc = 0.0;
+    ctx->gwFlow      = 0.0;
+    ctx->pervInfil   = 0.0;
+
+    // --- find volume of inflow to non-LID portion of subcatchment as existing
+    //     ponded water + any runon volume from upstream areas;
+    //     rainfall and snowmelt will be added as each sub-area is analyzed
+    nonLidArea = Subcatch[j].area - Subcatch[j].lidArea;
+    ctx->vRunon = Subcatch[j].runon * tStep * nonLidArea;
+    ctx->vInflow = ctx->vRunon + subcatch_getDepth(j) * nonLidArea;
+
+    // --- find LID runon only if LID occupies full subcatchment
+    if ( nonLidArea == 0.0 )
+        ctx->vRunon = Subcatch[j].runon * tStep * Subcatch[j].area;
+
+    // --- get net precip. (rainfall + snowfall + snowmelt) on the 3 types
+    //     of subcatchment sub-areas and update vInflow with it
+    getNetPrecip(j, ctx->netPrecip, tStep);
+
+    // --- find potential evaporation rate
+    if ( Evap.dryOnly && Subcatch[j].rainfall > 0.0 ) ctx->evapRate = 0.0;
+    else ctx->evapRate = Evap.rate;
+
+    // --- set monthly infiltration adjustment factor                          //(5.1.013)
+    ctx->infilFactor = infil_getInfilFactor(j);
+}
+
+//=============================================================================
+
+void subcatch_getInfilBatch(int first, int last, double tStep,
+                            TRunoffContext ctx[])
+//
+//  Input:   first = index of first subcatchment
+//           last = index of last subcatchment + 1
+//           tStep = time step (sec)
+//           ctx = runoff context of each subcatchment, as set by
+//                 subcatch_initRunoff()
+//  Output:  sets pervInfil of the runoff context of each subcatchment
+//  Purpose: computes the infiltration rate over the pervious subarea of
+//           a range of subcatchments at the current time step.
+//
+//  The range is passed to infil_getInfilBatch() in batches of up to
+//  MAXINFILBATCH consecutive subcatchments. Only subareas that
+//  getSubareaRunoff() will analyze are active in a batch, so that the
+//  infiltration state of the others is left unchanged.
+{
+    int       j, k;
+    double    nonLidArea;              // non-LID portion of subcatch area (ft2)
+    TSubarea* subarea;                 // pointer to pervious sub-area
+    TInfilBatch batch;                 // batch of subcatchments
+
+    for (batch.first = first; batch.first < last;
+         batch.first += MAXINFILBATCH)
+    {
+        // --- find the inflows to the pervious subarea of each subcatchment
+        batch.count = MIN(last - batch.first, MAXINFILBATCH);
+        for (k = 0; k < batch.count; k++)
+        {
+            j = batch.first + k;
+            subarea = &Subcatch[j].subArea[PERV];
+            nonLidArea = Subcatch[j].area - Subcatch[j].lidArea;
+            batch.active[k] = Subcatch[j].area != 0.0 && nonLidArea > 0.0 &&
+                              nonLidArea * subarea->fArea != 0.0;
+            batch.rainfall[k] = 0.0;
+            batch.runon[k]    = 0.0;
+            batch.depth[k]    = 0.0;
+            batch.factor[k]   = 1.0;
+            if ( !batch.active[k] ) continue;
+            batch.rainfall[k] = ctx[j].netPrecip[PERV];
+            batch.runon[k]    = subarea->inflow;
+            batch.depth[k]    = subarea->depth;
+            batch.factor[k]   = ctx[j].infilFactor;
+        }
+
+        // --- compute their infiltration rates
+        infil_getInfilBatch(&batch, InfilModel, tStep);
+        for (k = 0; k < batch.count; k++)
+        {
+            // --- limit infiltration rate by available void space in
+            //     unsaturated zone of any groundwater aquifer
+            if ( !batch.active[k] ) continue;
+            j = batch.first + k;
+            ctx[j].pervInfil = batch.infil[k];
+            if ( !IgnoreGwater && Subcatch[j].groundwater )
+            {
+                ctx[j].pervInfil = MIN(ctx[j].pervInfil,
+                    Subcatch[j].groundwater->maxInfilVol/tStep);
+            }
+        }
+    }
+}
+
+//=============================================================================
+
+double subcatch_getRunoff(int j, double tStep, TRunoffContext* ctx)
 //
 //  Input:   j = subcatchment index
 //           tStep = time step (sec)
+//           ctx = context that receives the subcatchment's water balance,
+//                 as set by subcatch_initRunoff() & subcatch_getInfilBatch()
 //  Output:  returns total runoff produced by subcatchment (ft/sec)
 //  Purpose: Computes runoff & new storage depth for subcatchment.
 //
@@ -652,100 +786,71 @@ double subcatch_getRunoff(int j, double tStep)
 //  that actually leaves the subcatchment after any LID controls are
 //  applied and is saved to Subcatch[j].newRunoff. 
 //
+//  Only this subcatchment's own objects are changed. The volumes that it
+//  contributes to the system mass balance are left in ctx for the caller
+//  to add to the system totals.
 {
     int    i;                          // subarea index
     double nonLidArea;                 // non-LID portion of subcatch area (ft2)
     double area;                       // sub-area or subcatchment area (ft2)
-    double netPrecip[3];               // subarea net precipitation (ft/sec)
     double vRain;                      // rainfall (+ snowfall) volume (ft3)
-    double vRunon    = 0.0;            // runon volume from other areas (ft3)
     double vOutflow  = 0.0;            // runoff volume leaving subcatch (ft3)
     double runoff    = 0.0;            // total runoff flow on subcatch (cfs)
-    double evapRate  = 0.0;            // potential evaporation rate (ft/sec)
     double subAreaRunoff;              // sub-area runoff rate (cfs)           //(5.1.013)
     double vImpervRunoff = 0.0;        // impervious area runoff volume (ft3)  //
     double vPervRunoff = 0.0;          // pervious area runoff volume (ft3)    //
 
-    // --- initialize shared water balance variables
-    Vevap     = 0.0;
-    Vpevap    = 0.0;
-    Vinfil    = 0.0;
-    Voutflow  = 0.0;
-    VlidIn    = 0.0;
-    VlidInfil = 0.0;
-    VlidOut   = 0.0;
-    VlidDrain = 0.0;
-    VlidReturn = 0.0;
-
-    // --- find volume of inflow to non-LID portion of subcatchment as existing
-    //     ponded water + any runon volume from upstream areas;
-    //     rainfall and snowmelt will be added as each sub-area is analyzed
-    nonLidArea = Subcatch[j].area - Subcatch[j].lidArea;
-    vRunon = Subcatch[j].runon * tStep * nonLidArea;
-    Vinflow = vRunon + subcatch_getDepth(j) * nonLidArea;
-
-    // --- find LID runon only if LID occupies full subcatchment
-    if ( nonLidArea == 0.0 )
-        vRunon = Subcatch[j].runon * tStep * Subcatch[j].area;
-
-    // --- get net precip. (rainfall + snowfall + snowmelt) on the 3 types
-    //     of subcatchment sub-areas and update Vinflow with it
-    getNetPrecip(j, netPrecip, tStep);
-
-    // --- find potential evaporation rate
-    if ( Evap.dryOnly && Subcatch[j].rainfall > 0.0 ) evapRate = 0.0;
-    else evapRate = Evap.rate;
-
-    // --- set monthly infiltration adjustment factor                          //(5.1.013)
-    infil_setInfilFactor(j);                                                   //(5.1.013)
-
     // --- examine each type of sub-area (impervious w/o depression storage,
     //     impervious w/ depression storage, and pervious)
+    nonLidArea = Subcatch[j].area - Subcatch[j].lidArea;
     if ( nonLidArea > 0.0 ) for (i = IMPERV0; i <= PERV; i++)
     {
-        // --- get runoff from sub-area updating Vevap, Vpevap,
-        //     Vinfil & Voutflow)
+        // --- get runoff from sub-area updating vEvap, vPevap,
+        //     vInfil & vOutflow)
         area = nonLidArea * Subcatch[j].subArea[i].fArea;
         Subcatch[j].subArea[i].runoff =
-            getSubareaRunoff(j, i, area, netPrecip[i], evapRate, tStep);
+            getSubareaRunoff(j, i, area, ctx->netPrecip[i], ctx->evapRate,
+                             tStep, ctx);
         subAreaRunoff = Subcatch[j].subArea[i].runoff * area;                  //(5.1.013)
         if (i == PERV) vPervRunoff = subAreaRunoff * tStep;                    //
         else           vImpervRunoff += subAreaRunoff * tStep;                 //
         runoff += subAreaRunoff;                                               //
     }
 
-    // --- evaluate any LID treatment provided (updating Vevap,
-    //     Vpevap, VlidInfil, VlidIn, VlidOut, & VlidDrain)
+    // --- evaluate any LID treatment provided (updating vEvap,
+    //     vPevap, vLidInfil, vLidIn, vLidOut, & vLidDrain)
     if ( Subcatch[j].lidArea > 0.0 )
     {
-        lid_getRunoff(j, tStep);
+        lid_getRunoff(j, tStep, ctx);
     }
 
     // --- update groundwater levels & flows if applicable
     if ( !IgnoreGwater && Subcatch[j].groundwater )
     {
-        gwater_getGroundwater(j, Vpevap, Vinfil+VlidInfil, tStep);
+        gwater_getGroundwater(j, ctx->vPevap, ctx->vInfil+ctx->vLidInfil,
+                              tStep, ctx);
     }
 
     // --- save subcatchment's total loss rates (ft/s)
     area = Subcatch[j].area;
-    Subcatch[j].evapLoss = Vevap / tStep / area;
-    Subcatch[j].infilLoss = (Vinfil + VlidInfil) / tStep / area;
+    Subcatch[j].evapLoss = ctx->vEvap / tStep / area;
+    Subcatch[j].infilLoss = (ctx->vInfil + ctx->vLidInfil) / tStep / area;
 
     // --- find net surface runoff volume
-    //     (VlidDrain accounts for LID drain flows)
-    vOutflow = Voutflow      // runoff from all non-LID areas
-               - VlidIn      // runoff treated by LID units
-               + VlidOut;    // runoff from LID units
+    //     (vLidDrain accounts for LID drain flows)
+    vOutflow = ctx->vOutflow      // runoff from all non-LID areas
+               - ctx->vLidIn      // runoff treated by LID units
+               + ctx->vLidOut;    // runoff from LID units
     Subcatch[j].newRunoff = vOutflow / tStep;
 
     // --- obtain external precip. volume (without any snowmelt)
     vRain = Subcatch[j].rainfall * tStep * area;
 
     // --- update the cumulative stats for this subcatchment
-    stats_updateSubcatchStats(j, vRain, vRunon, Vevap, Vinfil + VlidInfil,
-        vImpervRunoff, vPervRunoff, vOutflow + VlidDrain,                      //(5.1.013)
-        Subcatch[j].newRunoff + VlidDrain/tStep);
+    stats_updateSubcatchStats(j, vRain, ctx->vRunon, ctx->vEvap,
+        ctx->vInfil + ctx->vLidInfil,
+        vImpervRunoff, vPervRunoff, vOutflow + ctx->vLidDrain,                 //(5.1.013)
+        Subcatch[j].newRunoff + ctx->vLidDrain/tStep);
 
     // --- include this subcatchment's contribution to overall flow balance
     //     only if its outlet is a drainage system node
@@ -754,14 +859,13 @@ double subcatch_getRunoff(int j, double tStep)
         vOutflow = 0.0;
     }
 
-    // --- update mass balances
-    massbal_updateRunoffTotals(RUNOFF_RAINFALL, vRain);
-    massbal_updateRunoffTotals(RUNOFF_EVAP, Vevap);
-    massbal_updateRunoffTotals(RUNOFF_INFIL, Vinfil+VlidInfil);
-    massbal_updateRunoffTotals(RUNOFF_RUNOFF, vOutflow);
+    // --- save mass balance volumes
+    ctx->vRainfall = vRain;
+    ctx->vRunoff = vOutflow;
 
     // --- return area-averaged runoff (ft/s)
-    return runoff / area;
+    ctx->runoff = runoff / area;
+    return ctx->runoff;
 }
 
 //=============================================================================
@@ -937,7 +1041,7 @@ void  subcatch_getResults(int j, double f, float x[])
 //=============================================================================
 
 double getSubareaRunoff(int j, int i, double area, double precip, double evap,
-    double tStep)
+    double tStep, TRunoffContext* ctx)
 //
 //  Purpose: computes runoff & losses from a subarea over the current time step.
 //  Input:   j = subcatchment index
@@ -946,8 +1050,9 @@ double getSubareaRunoff(int j, int i, double area, double precip, double evap,
 //           precip = rainfall + snowmelt over subarea (ft/sec)
 //           evap = evaporation (ft/sec)
 //           tStep = time step (sec)
+//           ctx = subcatchment's runoff context
 //  Output:  returns runoff rate from the sub-area (cfs);
-//           updates shared variables Vinflow, Vevap, Vpevap, Vinfil & Voutflow.
+//           updates vInflow, vEvap, vPevap, vInfil & vOutflow of ctx.
 //
 {
     double    tRunoff;                 // time over which runoff occurs (sec)
@@ -970,23 +1075,23 @@ double getSubareaRunoff(int j, int i, double area, double precip, double evap,
     surfMoisture = subarea->depth / tStep;
     surfEvap = MIN(surfMoisture, evap);
 
-    // --- compute infiltration loss rate
-    if ( i == PERV ) infil = getSubareaInfil(j, subarea, precip, tStep);
+    // --- infiltration loss rate was found by subcatch_getInfilBatch()
+    if ( i == PERV ) infil = ctx->pervInfil;
 
     // --- add precip to other subarea inflows
     subarea->inflow += precip;
     surfMoisture += subarea->inflow;
 
     // --- update total inflow, evaporation & infiltration volumes
-    Vinflow += precip * area * tStep;
-    Vevap += surfEvap * area * tStep;
-    if ( i == PERV ) Vpevap += Vevap;
-    Vinfil += infil * area * tStep;
+    ctx->vInflow += precip * area * tStep;
+    ctx->vEvap += surfEvap * area * tStep;
+    if ( i == PERV ) ctx->vPevap += ctx->vEvap;
+    ctx->vInfil += infil * area * tStep;
 
-    // --- assign adjusted runoff coeff. & storage to shared variables         //(5.1.013)
-    Alpha = subarea->alpha;                                                    //
-    Dstore = subarea->dStore;                                                  //
-    adjustSubareaParams(i, j);                                                 // 
+    // --- assign adjusted runoff coeff. & storage to the context              //(5.1.013)
+    ctx->alpha = subarea->alpha;                                               //
+    ctx->dStore = subarea->dStore;                                             //
+    adjustSubareaParams(i, j, ctx);                                            // 
 
     // --- if losses exceed available moisture then no ponded water remains
     if ( surfEvap + infil >= surfMoisture )
@@ -999,58 +1104,32 @@ double getSubareaRunoff(int j, int i, double area, double precip, double evap,
     else
     {
         subarea->inflow -= surfEvap + infil;
-        updatePondedDepth(subarea, &tRunoff);
+        updatePondedDepth(subarea, &tRunoff, ctx);
     }
 
     // --- compute runoff based on updated ponded depth
-    runoff = findSubareaRunoff(subarea, tRunoff);
+    runoff = findSubareaRunoff(subarea, tRunoff, ctx);
 
     // --- compute runoff volume leaving subcatchment for mass balance purposes
     //     (fOutlet is the fraction of this subarea's runoff that goes to the
     //     subcatchment outlet as opposed to another subarea of the subcatchment)
-    Voutflow += subarea->fOutlet * runoff * area * tStep;
+    ctx->vOutflow += subarea->fOutlet * runoff * area * tStep;
     return runoff;
 }
 
 //=============================================================================
 
-double getSubareaInfil(int j, TSubarea* subarea, double precip, double tStep)
-//
-//  Purpose: computes infiltration rate at current time step.
-//  Input:   j = subcatchment index
-//           subarea = ptr. to a subarea
-//           precip = rainfall + snowmelt over subarea (ft/sec)
-//           tStep = time step (sec)
-//  Output:  returns infiltration rate (ft/s)
-//
-{
-    double infil = 0.0;                     // actual infiltration rate (ft/sec)
-
-    // --- compute infiltration rate 
-    infil = infil_getInfil(j, InfilModel, tStep, precip,
-                           subarea->inflow, subarea->depth);
-
-    // --- limit infiltration rate by available void space in unsaturated
-    //     zone of any groundwater aquifer
-    if ( !IgnoreGwater && Subcatch[j].groundwater )
-    {
-        infil = MIN(infil,
-                    Subcatch[j].groundwater->maxInfilVol/tStep);
-    }
-    return infil;
-}
-
-//=============================================================================
-
-double findSubareaRunoff(TSubarea* subarea, double tRunoff)
+double findSubareaRunoff(TSubarea* subarea, double tRunoff,
+                         TRunoffContext* ctx)
 //
 //  Purpose: computes runoff (ft/s) from subarea after current time step.
 //  Input:   subarea = ptr. to a subarea
 //           tRunoff = time step over which runoff occurs (sec)
+//           ctx = runoff context holding adjusted dStore & alpha
 //  Output:  returns runoff rate (ft/s)
 //
 {
-    double xDepth = subarea->depth - Dstore;                                   //(5.1.013)
+    double xDepth = subarea->depth - ctx->dStore;                              //(5.1.013)
     double runoff = 0.0;
 
     if ( xDepth > ZERO )
@@ -1058,14 +1137,14 @@ double findSubareaRunoff(TSubarea* subarea, double tRunoff)
         // --- case where nonlinear routing is used
         if ( subarea->N > 0.0 )
         {
-            runoff = Alpha * pow(xDepth, MEXP);                                //(5.1.013)
+            runoff = ctx->alpha * pow(xDepth, MEXP);                           //(5.1.013)
         }
 
         // --- case where no routing is used (Mannings N = 0)
         else
         {
             runoff = xDepth / tRunoff;
-            subarea->depth = Dstore;                                           //(5.1.013)
+            subarea->depth = ctx->dStore;                                      //(5.1.013)
         }
     }
     else
@@ -1077,10 +1156,11 @@ double findSubareaRunoff(TSubarea* subarea, double tRunoff)
 
 //=============================================================================
 
-void updatePondedDepth(TSubarea* subarea, double* dt)
+void updatePondedDepth(TSubarea* subarea, double* dt, TRunoffContext* ctx)
 //
 //  Input:   subarea = ptr. to a subarea,
 //           dt = time step (sec)
+//           ctx = runoff context holding adjusted dStore & alpha
 //  Output:  dt = time ponded depth is above depression storage (sec)
 //  Purpose: computes new ponded depth over subarea after current time step.
 //
@@ -1090,7 +1170,7 @@ void updatePondedDepth(TSubarea* subarea, double* dt)
     double tx = *dt;                   // time over which dx > 0 (sec)
     
     // --- see if not enough inflow to fill depression storage (dStore)
-    if ( subarea->depth + ix*tx <= Dstore )                                    //(5.1.013)
+    if ( subarea->depth + ix*tx <= ctx->dStore )                               //(5.1.013)
     {
         subarea->depth += ix * tx;
     }
@@ -1099,19 +1179,27 @@ void updatePondedDepth(TSubarea* subarea, double* dt)
     else
     {
         // --- if depth < Dstore then fill up Dstore & reduce time step        //(5.1.013)
-        dx = Dstore - subarea->depth;                                          //
+        dx = ctx->dStore - subarea->depth;                                     //
         if ( dx > 0.0 && ix > 0.0 )
         {
             tx -= dx / ix;
-            subarea->depth = Dstore;                                           //(5.1.013)
+            subarea->depth = ctx->dStore;                                      //(5.1.013)
         }
 
         // --- now integrate depth over remaining time step tx
-        if ( Alpha > 0.0 && tx > 0.0 )                                         //(5.1.013)
+        if ( ctx->alpha > 0.0 && tx > 0.0 )                                    //(5.1.013)
         {
-            theSubarea = subarea;
-            odesolve_integrate(&(subarea->depth), 1, 0, tx, ODETOL, tx,
-                               getDdDt);
+            if ( RunoffSolver == ROSENBROCK_RUNOFF )
+            {
+                subarea->depth = ctx->dStore + getRosenbrockDepth(
+                    subarea->depth - ctx->dStore, ix, tx, ctx->alpha);
+            }
+            else
+            {
+                ctx->subarea = subarea;
+                odesolve_integrate(ctx->ode, &(subarea->depth), 1, 0, tx,
+                                   ODETOL, tx, getDdDt, ctx);
+            }
         }
         else
         {
@@ -1130,37 +1218,180 @@ void updatePondedDepth(TSubarea* subarea, double* dt)
 
 //=============================================================================
 
-void  getDdDt(double t, double* d, double* dddt)
+void  getDdDt(void* data, double t, double* d, double* dddt)
 //
-//  Input:   t = current time (not used)
+//  Input:   data = runoff context of the subcatchment being analyzed
+//           t = current time (not used)
 //           d = stored depth (ft)
 //  Output   dddt = derivative of d with respect to time
 //  Purpose: evaluates derivative of stored depth w.r.t. time
 //           for the subarea whose runoff is being computed.
 //
 {
-    double ix = theSubarea->inflow;
-    double rx = *d - Dstore;                                                   //(5.1.013)
+    TRunoffContext* ctx = (TRunoffContext *)data;
+    double ix = ctx->subarea->inflow;
+    double rx = *d - ctx->dStore;                                              //(5.1.013)
     if ( rx < 0.0 )
     {
         rx = 0.0;
     }
     else
     {
-        rx = Alpha * pow(rx, MEXP);                                            //(5.1.013)
+        rx = ctx->alpha * pow(rx, MEXP);                                       //(5.1.013)
     }
     *dddt = ix - rx;
 }
 
 //=============================================================================
 
+double getRosenbrockDepth(double x, double ix, double tx, double alpha)
+//
+//  Input:   x = depth above depression storage (ft)
+//           ix = excess inflow to subarea (ft/sec)
+//           tx = time step (sec)
+//           alpha = adjusted runoff coeff.
+//  Output:  returns depth above depression storage after time step (ft)
+//  Purpose: integrates dx/dt = ix - alpha*x^(5/3) over a time step with the
+//           L-stable two stage Rosenbrock method ROS2, retaking the step in
+//           equal substeps if its error estimate exceeds ROSTOL.
+//
+//  A step costs a few cube & square roots instead of the six or more calls
+//  to pow() made by each adaptive Runge-Kutta step. The depth itself is
+//  integrated while it rises towards the equilibrium depth (ix/alpha)^0.6,
+//  and x^(-2/3) while it recedes, since the latter varies linearly with
+//  time when there is no inflow. The number of substeps is chosen from the
+//  order of the method, so a time step never takes more than 1 + ROSMAXSUB
+//  Rosenbrock steps.
+//
+{
+    int    k, n;
+    double err;
+    double h;
+    double x1;
+
+    // --- take a single step over the full time step
+    if ( x > 0.0 && alpha * x * cbrt(x*x) > fabs(ix) )
+        x1 = getRecedingStep(x, ix, tx, alpha, &err);
+    else x1 = getRisingStep(x, ix, tx, alpha, &err);
+    if ( err <= ROSTOL ) return x1;
+
+    // --- otherwise retake it in n substeps so that each one's
+    //     error (of order h^2) is within tolerance
+    n = (int)ceil(sqrt(err / ROSTOL));
+    n = MIN(n, ROSMAXSUB);
+    h = tx / n;
+    for (k = 0; k < n; k++)
+    {
+        if ( x > 0.0 && alpha * x * cbrt(x*x) > fabs(ix) )
+            x = getRecedingStep(x, ix, h, alpha, &err);
+        else x = getRisingStep(x, ix, h, alpha, &err);
+    }
+    return x;
+}
+
+//=============================================================================
+
+double getRisingStep(double x, double ix, double h, double alpha, double* err)
+//
+//  Input:   x = depth above depression storage (ft)
+//           ix = excess inflow to subarea (ft/sec)
+//           h = step size (sec)
+//           alpha = adjusted runoff coeff.
+//  Output:  err = relative error estimate of the step;
+//           returns depth above depression storage after the step (ft)
+//  Purpose: makes a ROS2 step of dx/dt = ix - alpha*x^(5/3) when runoff
+//           does not exceed inflow or the depth is below depression storage.
+//
+//  The Jacobian is evaluated at the depth reached if all inflow were stored,
+//  or at the equilibrium depth if that is smaller, so the step neither
+//  blows up when filling an empty surface nor lags behind when it is stiff.
+//  ROS2 stays second order for any choice of Jacobian.
+//
+{
+    double x23 = (x > 0.0) ? cbrt(x*x) : 0.0;   // x^(2/3)
+    double xj, xj23;                             // depth for Jacobian
+    double f1, f2, w, k1, k2, y, x1;
+
+    // --- depth at which the Jacobian is evaluated
+    xj = MAX(0.0, x + h * MAX(ix, 0.0));
+    xj23 = cbrt(xj*xj);
+    if ( ix > 0.0 && alpha * xj23 * xj > ix )
+        xj23 = MAX(x23, pow(ix / alpha, 0.4));
+
+    // --- ROS2 stages
+    f1 = ix - alpha * x23 * x;
+    w  = 1.0 + ROSGAMMA * h * MEXP * alpha * xj23;
+    k1 = f1 / w;
+    y  = x + h * k1;
+    f2 = ix - ((y > 0.0) ? alpha * y * cbrt(y*y) : 0.0);
+    k2 = (f2 - 2.0 * k1) / w;
+    x1 = x + h * (1.5 * k1 + 0.5 * k2);
+
+    // --- error estimate from the embedded first order solution x + h*k1
+    *err = 0.5 * h * fabs(k1 + k2) / MAX(MAX(fabs(x), fabs(x1)), TINY);
+    return x1;
+}
+
+//=============================================================================
+
+double getRecedingStep(double x, double ix, double h, double alpha,
+                       double* err)
+//
+//  Input:   x = depth above depression storage (> 0) (ft)
+//           ix = excess inflow to subarea (ft/sec)
+//           h = step size (sec)
+//           alpha = adjusted runoff coeff.
+//  Output:  err = relative error estimate of the step;
+//           returns depth above depression storage after the step (ft)
+//  Purpose: makes a ROS2 step of dz/dt = 2/3*(alpha - ix*z^(5/2)) for
+//           z = x^(-2/3) when runoff exceeds the magnitude of inflow.
+//
+//  The step is exact when there is no inflow. As for a rising depth, the
+//  Jacobian is evaluated ahead of z but not beyond its equilibrium value.
+//  Losses (ix < 0) are treated explicitly since they make the equation
+//  unstable in z.
+//
+{
+    double z = 1.0 / cbrt(x*x);                 // x^(-2/3)
+    double z15 = z * sqrt(z);                   // z^(3/2)
+    double zj, zj15;                            // z for Jacobian
+    double f1, f2, w, k1, k2, y, z1;
+
+    // --- z at which the Jacobian is evaluated
+    f1 = (alpha - ix * z15 * z) / 1.5;
+    zj = z + h * f1;
+    zj15 = zj * sqrt(zj);
+    if ( ix * zj15 * zj > alpha ) zj15 = MAX(z15, pow(alpha / ix, 0.6));
+
+    // --- ROS2 stages
+    w  = 1.0 + ROSGAMMA * h * MEXP * MAX(ix, 0.0) * zj15;
+    k1 = f1 / w;
+    y  = z + h * k1;
+    f2 = (alpha - ix * y * y * sqrt(y)) / 1.5;
+    k2 = (f2 - 2.0 * k1) / w;
+    z1 = z + h * (1.5 * k1 + 0.5 * k2);
+
+    // --- a non-positive z means the step overshot the equilibrium
+    //     depth by too much, so it must be subdivided
+    if ( z1 <= 0.0 )
+    {
+        *err = BIG;
+        return 0.0;
+    }
+    *err = 0.75 * h * fabs(k1 + k2) / MIN(z, z1);
+    return 1.0 / (z1 * sqrt(z1));
+}
+
+//=============================================================================
+
 ////  New function added to release 5.1.013.  ////                             //(5.1.013)
 
-void adjustSubareaParams(int i, int j)
+void adjustSubareaParams(int i, int j, TRunoffContext* ctx)
 //
 //  Input:   i = type of subarea being analyzed
 //           j = index of current subcatchment being analyzed
-//  Output   adjusted values of module-level variables Dstore & Alpha
+//           ctx = runoff context holding the subarea's dStore & alpha
+//  Output   adjusted values of dStore & alpha in ctx
 //  Purpose: adjusts a subarea's depression storage and its pervious
 //           runoff coeff. by month of the year.
 //
@@ -1175,7 +1406,7 @@ void adjustSubareaParams(int i, int j)
      {
          m = datetime_monthOfYear(getDateTime(OldRunoffTime)) - 1;
          f = Pattern[p].factor[m];
-         if (f >= 0.0) Dstore *= f;
+         if (f >= 0.0) ctx->dStore *= f;
      }
 
     // --- pervious area roughness
@@ -1184,7 +1415,7 @@ void adjustSubareaParams(int i, int j)
     {
          m = datetime_monthOfYear(getDateTime(OldRunoffTime)) - 1;
          f = Pattern[p].factor[m];
-         if (f <= 0.0) Alpha = 0.0;
-         else          Alpha /= f;
+         if (f <= 0.0) ctx->alpha = 0.0;
+         else          ctx->alpha /= f;
      }
 }
@@ -13,6 +13,10 @@
 //     subcatch.c.
 //   - Support for separate accounting of LID drain flows included. 
 //
+//   Build 5.2.0:
+//   - A subcatchment's runoff volumes are read from the runoff context
+//     passed to surfqual_getWashoff() instead of from shared variables.
+//
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -25,17 +29,7 @@
 //  Imported variables 
 //-----------------------------------------------------------------------------
 // Declared in RUNOFF.C
-extern  double*    OutflowLoad;   // exported pollutant mass load
-
-// Volumes (ft3) for a subcatchment over a time step declared in SUBCATCH.C
-extern double      Vinfil;        // non-LID infiltration
-extern double      Vinflow;       // non-LID precip + snowmelt + runon + ponded water
-extern double      Voutflow;      // non-LID runoff to subcatchment's outlet
-extern double      VlidIn;        // inflow to LID units
-extern double      VlidInfil;     // infiltration from LID units
-extern double      VlidOut;       // surface outflow from LID units
-extern double      VlidDrain;     // drain outflow from LID units
-extern double      VlidReturn;    // LID outflow returned to pervious area
+#define OutflowLoad (Prj->runoff.OutflowLoad) // exported pollutant mass load
 
 //-----------------------------------------------------------------------------
 //  External functions (declared in funcs.h)   
@@ -49,8 +43,8 @@ extern double      VlidReturn;    // LID outflow returned to pervious area
 //-----------------------------------------------------------------------------
 // Function declarations
 //-----------------------------------------------------------------------------
-static void  findWashoffLoads(int j, double runoff);
-static void  findPondedLoads(int j, double tStep);
+static void  findWashoffLoads(int j, double runoff, double vOutflow);
+static void  findPondedLoads(int j, double tStep, TRunoffContext* ctx);
 static void  findLidLoads(int j, double tStep);
 
 //=============================================================================
@@ -184,12 +178,14 @@ void surfqual_sweepBuildup(int j, DateTime aDate)
 
 //=============================================================================
 
-void  surfqual_getWashoff(int j, double runoff, double tStep)
+void  surfqual_getWashoff(int j, double runoff, double tStep,
+                          TRunoffContext* ctx)
 //
 //  Input:   j = subcatchment index
 //           runoff = total subcatchment runoff before internal re-routing or
 //                    LID controls (ft/sec)
 //           tStep = time step (sec)
+//           ctx = runoff context filled in by subcatch_getRunoff
 //  Output:  none
 //  Purpose: computes new runoff quality for a subcatchment.
 //
@@ -218,8 +214,8 @@ void  surfqual_getWashoff(int j, double runoff, double tStep)
 
     // --- find contributions from washoff, runon and wet precip. to OutflowLoad
     for (p = 0; p < Nobjects[POLLUT]; p++) OutflowLoad[p] = 0.0;
-    findWashoffLoads(j, runoff);
-    findPondedLoads(j, tStep);
+    findWashoffLoads(j, runoff, ctx->vOutflow);
+    findPondedLoads(j, tStep, ctx);
     findLidLoads(j, tStep);
 
     // --- contribution from direct rainfall on LID areas
@@ -234,15 +230,15 @@ void  surfqual_getWashoff(int j, double runoff, double tStep)
     }
 
     // --- runoff volume before LID treatment (ft3)
-    //     (Voutflow, computed in subcatch_getRunoff, is subcatchment
+    //     (vOutflow, computed in subcatch_getRunoff, is subcatchment
     //      runoff volume before LID treatment)
-    vOut1 = Voutflow + vLidRain + vLidRunon;             
+    vOut1 = ctx->vOutflow + vLidRain + vLidRunon;             
 
     // --- surface runoff + LID drain flow volume leaving the subcatchment
     //     (Subcatch.newRunoff, computed in subcatch_getRunoff, includes
     //      any surface runoff reduction from LID treatment)
     vSurfOut = Subcatch[j].newRunoff * tStep;
-    vOut2 = vSurfOut + VlidDrain;
+    vOut2 = vSurfOut + ctx->vLidDrain;
 
     // --- determine if subcatchment outflow is below a small cutoff
     hasOutflow = (vOut2 > MIN_RUNOFF * area * tStep);
@@ -309,10 +305,11 @@ double surfqual_getWtdWashoff(int j, int p, double f)
 
 //=============================================================================
 
-void findPondedLoads(int j, double tStep)
+void findPondedLoads(int j, double tStep, TRunoffContext* ctx)
 //
 //  Input:   j = subcatchment index
 //           tStep = time step (sec)
+//           ctx = subcatchment's runoff context
 //  Output:  updates pondedQual, concPonded and OutflowLoad 
 //  Purpose: mixes wet deposition and runon pollutant loading with existing
 //           ponded pollutant mass to compute an ouflow loading.
@@ -346,7 +343,7 @@ void findPondedLoads(int j, double tStep)
 
         // --- surface is dry and has no runon -- add any remaining mass
         //     to overall mass balance's FINAL_LOAD category
-        if ( Vinflow == 0.0 )
+        if ( ctx->vInflow == 0.0 )
         {
             massbal_updateLoadingTotals(FINAL_LOAD, p,
                 Subcatch[j].pondedQual[p] * Pollut[p].mcf);
@@ -358,16 +355,16 @@ void findPondedLoads(int j, double tStep)
             //     (newQual[] temporarily holds runon mass loading)
             wRunon = Subcatch[j].newQual[p] * tStep;
             wPonded = Subcatch[j].pondedQual[p] + wRain + wRunon;
-            cPonded = wPonded / Vinflow;
+            cPonded = wPonded / ctx->vInflow;
 
             // --- mass lost to infiltration
-            wInfil = cPonded * Vinfil;
+            wInfil = cPonded * ctx->vInfil;
             wInfil = MIN(wInfil, wPonded);
             massbal_updateLoadingTotals(INFIL_LOAD, p, wInfil * Pollut[p].mcf);
             wPonded -= wInfil;
 
             // --- mass lost to runoff
-            wOutflow = cPonded * Voutflow;
+            wOutflow = cPonded * ctx->vOutflow;
             wOutflow = MIN(wOutflow, wPonded);
             wPonded -= wOutflow;
 
@@ -387,11 +384,12 @@ void findPondedLoads(int j, double tStep)
 
 //=============================================================================
 
-void  findWashoffLoads(int j, double runoff)
+void  findWashoffLoads(int j, double runoff, double vOutflow)
 //
 //  Input:   j = subcatchment index
 //           runoff = subcatchment runoff before internal re-routing or
 //                    LID controls (ft/sec)
+//           vOutflow = non-LID runoff volume (ft3)
 //  Output:  updates OutflowLoad array
 //  Purpose: computes pollutant washoff loads for each land use and adds these
 //           to the subcatchment's total outflow loads.
@@ -413,7 +411,7 @@ void  findWashoffLoads(int j, double runoff)
             for (p = 0; p < Nobjects[POLLUT]; p++)
             {
                 OutflowLoad[p] += landuse_getWashoffLoad(
-                    i, p, area, Subcatch[j].landFactor, runoff, Voutflow);
+                    i, p, area, Subcatch[j].landFactor, runoff, vOutflow);
             }
         }
     }
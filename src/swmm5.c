@@ -38,6 +38,16 @@
 //   Build 5.1.013:
 //   - Support added for saving average results within a reporting period.
 //   - SWMM engine now always compiled to a shared object library.
+//
+//   Build 5.2.0:
+//   - All engine state now resides in a TProject context selected per
+//     calling thread, allowing several projects to be open at once.
+//   - Added swmm_createProject, swmm_deleteProject, swmm_selectProject
+//     and re-entrant (_r) versions of the run control functions.
+//   - Added swmm_createScenario to run variants of an opened project
+//     without re-parsing its input file.
+//   - Each simulation started is counted so that snapshots (snapshot.c)
+//     can only be restored into the run they were taken from.
 //     
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
@@ -142,15 +152,22 @@ const double Qcf[6] =                  // Flow Conversion Factors:
     {1.0,     448.831, 0.64632,        // cfs, gpm, mgd --> cfs
      0.02832, 28.317,  2.4466 };       // cms, lps, mld --> cfs
 
+//-----------------------------------------------------------------------------
+//  Project contexts
+//-----------------------------------------------------------------------------
+static TProject    DefaultProject;     // project used by the legacy API
+THREADLOCAL_IE TProject* Prj = &DefaultProject; // project of calling thread
+
 //-----------------------------------------------------------------------------
 //  Shared variables
 //-----------------------------------------------------------------------------
-static int  IsOpenFlag;           // TRUE if a project has been opened
-static int  IsStartedFlag;        // TRUE if a simulation has been started
-static int  SaveResultsFlag;      // TRUE if output to be saved to binary file
-static int  ExceptionCount;       // number of exceptions handled
-static int  DoRunoff;             // TRUE if runoff is computed
-static int  DoRouting;            // TRUE if flow routing is computed
+#define IsOpenFlag      (Prj->swmm5.IsOpenFlag)      // TRUE if a project has been opened
+#define IsStartedFlag   (Prj->swmm5.IsStartedFlag)   // TRUE if a simulation has been started
+#define SaveResultsFlag (Prj->swmm5.SaveResultsFlag) // TRUE if output to be saved to binary file
+#define ExceptionCount  (Prj->swmm5.ExceptionCount)  // number of exceptions handled
+#define DoRunoff        (Prj->swmm5.DoRunoff)        // TRUE if runoff is computed
+#define DoRouting       (Prj->swmm5.DoRouting)       // TRUE if flow routing is computed
+#define RunCount        (Prj->swmm5.RunCount)        // number of simulations started
 
 //-----------------------------------------------------------------------------
 //  External API functions (prototyped in swmm5.h)
@@ -164,6 +181,10 @@ static int  DoRouting;            // TRUE if flow routing is computed
 //  swmm_close
 //  swmm_getMassBalErr
 //  swmm_getVersion
+//  swmm_createProject
+//  swmm_deleteProject
+//  swmm_selectProject
+//  swmm_run_r ... swmm_getError_r
 
 //-----------------------------------------------------------------------------
 //  Local functions
@@ -334,7 +355,10 @@ int DLLEXPORT swmm_start(int saveResults)
         ReportTime =   (double)(1000 * ReportStep);
         StepCount = 0;
         NonConvergeCount = 0;
+        PredictCount = 0;
+        PredictHitCount = 0;
         IsStartedFlag = TRUE;
+        RunCount++;
 
         // --- initialize global continuity errors
         RunoffError = 0.0;
@@ -721,6 +745,258 @@ int  DLLEXPORT swmm_getError(char* errMsg, int msgLen)
     return error_getCode(ErrorCode);
 }
 
+//=============================================================================
+//   Project context functions
+//=============================================================================
+
+int DLLEXPORT swmm_createProject(SWMM_Project* ph)
+//
+//  Input:   ph = pointer to a project handle
+//  Output:  returns an error code
+//  Purpose: creates a new, empty project context.
+//
+{
+    if ( ph == NULL ) return error_getCode(ERR_API_OUTBOUNDS);
+    *ph = (TProject *) calloc(1, sizeof(TProject));
+    if ( *ph == NULL ) return error_getCode(ERR_MEMORY);
+    return 0;
+}
+
+//=============================================================================
+
+int DLLEXPORT swmm_deleteProject(SWMM_Project ph)
+//
+//  Input:   ph = project handle
+//  Output:  returns an error code
+//  Purpose: closes a project if still open and frees its context.
+//
+{
+    TProject* oldPrj;
+
+    if ( ph == NULL || ph == &DefaultProject )
+        return error_getCode(ERR_API_OUTBOUNDS);
+    oldPrj = swmm_selectProject(ph);
+    if ( IsOpenFlag ) swmm_close();
+    Prj = ( oldPrj == ph ) ? &DefaultProject : oldPrj;
+    free(ph);
+    return 0;
+}
+
+//=============================================================================
+
+SWMM_Project DLLEXPORT swmm_selectProject(SWMM_Project ph)
+//
+//  Input:   ph = project handle (NULL for the default project)
+//  Output:  returns handle of the previously selected project
+//  Purpose: makes ph the project acted on by the calling thread's
+//           swmm_xxx and toolkit functions.
+//
+{
+    TProject* oldPrj = Prj;
+    Prj = ( ph ) ? ph : &DefaultProject;
+    return oldPrj;
+}
+
+//=============================================================================
+
+int DLLEXPORT swmm_createScenario(SWMM_Project base, SWMM_Project* ph,
+                                  char* f2, char* f3)
+//
+//  Input:   base = handle of an opened project (NULL for the default project)
+//           ph = pointer to handle of the new scenario project
+//           f2 = name of the scenario's report file
+//           f3 = name of the scenario's binary output file
+//  Output:  returns an error code
+//  Purpose: creates a project that shares the parsed input data of an
+//           opened base project and can be modified and run on its own.
+//
+//  NOTE: scenarios must be deleted before their base project is closed.
+{
+    TProject* p;
+    TProject* oldPrj;
+    int errcode;
+
+    if ( ph == NULL ) return error_getCode(ERR_API_OUTBOUNDS);
+    *ph = NULL;
+    if ( base == NULL ) base = &DefaultProject;
+
+    // --- check that the base project is open, not running and error free
+    oldPrj = swmm_selectProject(base);
+    if ( !IsOpenFlag || IsStartedFlag ) errcode = ERR_NOT_OPEN;
+    else errcode = ErrorCode;
+    Prj = oldPrj;
+    if ( errcode ) return error_getCode(errcode);
+
+    // --- start the scenario from a copy of the base project's context
+    p = (TProject *) malloc(sizeof(TProject));
+    if ( p == NULL ) return error_getCode(ERR_MEMORY);
+    *p = *base;
+    oldPrj = swmm_selectProject(p);
+    Warnings = 0;
+    strcpy(ErrorMsg, "");
+    errcode = project_createScenario(base, f2, f3);
+    if ( errcode ) swmm_close();
+    Prj = oldPrj;
+    if ( errcode )
+    {
+        free(p);
+        return error_getCode(errcode);
+    }
+    *ph = p;
+    return 0;
+}
+
+//=============================================================================
+
+int DLLEXPORT swmm_run_r(SWMM_Project ph, char* f1, char* f2, char* f3)
+//
+//  Input:   ph = project handle
+//           f1 = name of input file
+//           f2 = name of report file
+//           f3 = name of binary output file
+//  Output:  returns error code
+//  Purpose: runs a SWMM simulation of project ph.
+//
+{
+    TProject* oldPrj = swmm_selectProject(ph);
+    int errcode = swmm_run(f1, f2, f3);
+    Prj = oldPrj;
+    return errcode;
+}
+
+//=============================================================================
+
+int DLLEXPORT swmm_open_r(SWMM_Project ph, char* f1, char* f2, char* f3)
+//
+//  Input:   ph = project handle
+//           f1 = name of input file
+//           f2 = name of report file
+//           f3 = name of binary output file
+//  Output:  returns error code
+//  Purpose: opens a SWMM input file for project ph & reads in network data.
+//
+{
+    TProject* oldPrj = swmm_selectProject(ph);
+    int errcode = swmm_open(f1, f2, f3);
+    Prj = oldPrj;
+    return errcode;
+}
+
+//=============================================================================
+
+int DLLEXPORT swmm_start_r(SWMM_Project ph, int saveResults)
+//
+//  Input:   ph = project handle
+//           saveResults = TRUE if simulation results saved to binary file
+//  Output:  returns an error code
+//  Purpose: starts a simulation of project ph.
+//
+{
+    TProject* oldPrj = swmm_selectProject(ph);
+    int errcode = swmm_start(saveResults);
+    Prj = oldPrj;
+    return errcode;
+}
+
+//=============================================================================
+
+int DLLEXPORT swmm_step_r(SWMM_Project ph, double* elapsedTime)
+//
+//  Input:   ph = project handle
+//           elapsedTime = current elapsed time in decimal days
+//  Output:  updated value of elapsedTime,
+//           returns error code
+//  Purpose: advances the simulation of project ph by one routing time step.
+//
+{
+    TProject* oldPrj = swmm_selectProject(ph);
+    int errcode = swmm_step(elapsedTime);
+    Prj = oldPrj;
+    return errcode;
+}
+
+//=============================================================================
+
+int DLLEXPORT swmm_end_r(SWMM_Project ph)
+//
+//  Input:   ph = project handle
+//  Output:  returns an error code
+//  Purpose: ends the simulation of project ph.
+//
+{
+    TProject* oldPrj = swmm_selectProject(ph);
+    int errcode = swmm_end();
+    Prj = oldPrj;
+    return errcode;
+}
+
+//=============================================================================
+
+int DLLEXPORT swmm_report_r(SWMM_Project ph)
+//
+//  Input:   ph = project handle
+//  Output:  returns an error code
+//  Purpose: writes the simulation results of project ph to its report file.
+//
+{
+    TProject* oldPrj = swmm_selectProject(ph);
+    int errcode = swmm_report();
+    Prj = oldPrj;
+    return errcode;
+}
+
+//=============================================================================
+
+int DLLEXPORT swmm_close_r(SWMM_Project ph)
+//
+//  Input:   ph = project handle
+//  Output:  returns an error code
+//  Purpose: closes project ph's SWMM input file.
+//
+{
+    TProject* oldPrj = swmm_selectProject(ph);
+    int errcode = swmm_close();
+    Prj = oldPrj;
+    return errcode;
+}
+
+//=============================================================================
+
+int DLLEXPORT swmm_getMassBalErr_r(SWMM_Project ph, float* runoffErr,
+                                   float* flowErr, float* qualErr)
+//
+//  Input:   ph = project handle
+//  Output:  runoffErr = runoff mass balance error (percent)
+//           flowErr   = flow routing mass balance error (percent)
+//           qualErr   = quality routing mass balance error (percent)
+//           returns an error code
+//  Purpose: reports the mass balance errors of project ph's simulation.
+//
+{
+    TProject* oldPrj = swmm_selectProject(ph);
+    int errcode = swmm_getMassBalErr(runoffErr, flowErr, qualErr);
+    Prj = oldPrj;
+    return errcode;
+}
+
+//=============================================================================
+
+int DLLEXPORT swmm_getError_r(SWMM_Project ph, char* errMsg, int msgLen)
+//
+//  Input:   ph = project handle
+//           errMsg = character array to hold error message text
+//           msgLen = maximum size of error message text
+//  Output:  returns the API error code of project ph
+//  Purpose: retrieves the code number and text of project ph's error
+//           condition that caused SWMM to abort its analysis.
+//
+{
+    TProject* oldPrj = swmm_selectProject(ph);
+    int errcode = swmm_getError(errMsg, msgLen);
+    Prj = oldPrj;
+    return errcode;
+}
+
 //=============================================================================
 //   General purpose functions
 //=============================================================================
@@ -755,6 +1031,24 @@ char* sstrncpy(char *dest, const char *src, size_t maxlen)
 
 //=============================================================================
 
+void* memdup(const void* src, size_t size)
+//
+//  Input:   src = block of memory to be copied
+//           size = size of block in bytes
+//  Output:  returns a pointer to a newly allocated copy of src
+//           (or NULL if src is empty or out of memory)
+//  Purpose: duplicates a block of memory.
+//
+{
+    void* dest;
+    if ( src == NULL || size == 0 ) return NULL;
+    dest = malloc(size);
+    if ( dest ) memcpy(dest, src, size);
+    return dest;
+}
+
+//=============================================================================
+
 int  strcomp(char *s1, char *s2)
 //
 //  Input:   s1 = a character string
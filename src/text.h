@@ -106,6 +106,16 @@
 #define  w_MIN_ROUTE_STEP    "MINIMUM_STEP"
 #define  w_NUM_THREADS       "THREADS"
 #define  w_SURCHARGE_METHOD  "SURCHARGE_METHOD"                                //(5.1.013)
+#define  w_SOLVER_METHOD     "SOLVER_METHOD"
+#define  w_ANDERSON_DEPTH    "ANDERSON_DEPTH"
+#define  w_THREAD_SCHEDULE   "THREAD_SCHEDULE"
+#define  w_DENSE_TABLE_SIZE  "DENSE_TABLE_SIZE"
+#define  w_CIRCULAR_GEOMETRY "CIRCULAR_GEOMETRY"
+#define  w_NETWORK_ORDER     "NETWORK_ORDER"
+#define  w_PREDICTOR         "PREDICTOR"
+#define  w_RUNOFF_SOLVER     "RUNOFF_SOLVER"
+#define  w_DEPTH_WARM_START  "DEPTH_WARM_START"
+#define  w_ACTIVE_SET        "ACTIVE_SET"
 
 // Flow Units
 #define  w_CFS               "CFS"
@@ -130,6 +140,30 @@
 #define  w_EXTRAN            "EXTRAN"
 #define  w_SLOT              "SLOT"
 
+// Dynamic Wave Solver Methods
+#define  w_PICARD            "PICARD"
+#define  w_NEWTON            "NEWTON"
+#define  w_ANDERSON          "ANDERSON"
+
+// Thread Schedules
+#define  w_STATIC            "STATIC"
+#define  w_DYNAMIC           "DYNAMIC"
+#define  w_GUIDED            "GUIDED"
+
+// Circular Geometry Methods
+#define  w_ANALYTIC          "ANALYTIC"
+
+// Network Orderings
+#define  w_RCM               "RCM"
+
+// Dynamic Wave Predictors
+#define  w_LINEAR            "LINEAR"
+#define  w_QUADRATIC         "QUADRATIC"
+
+// Runoff ODE Solvers
+#define  w_RUNGE_KUTTA       "RUNGE_KUTTA"
+#define  w_ROSENBROCK        "ROSENBROCK"
+
 // Infiltration Methods
 #define  w_HORTON            "HORTON"
 #define  w_MOD_HORTON        "MODIFIED_HORTON"
@@ -318,6 +352,7 @@
 #define  w_CONTROLS          "CONTROL"
 #define  w_NODESTATS         "NODESTATS"
 #define  w_AVERAGES          "AVERAGES"                                        //(5.1.013)
+#define  w_CACHESTATS        "CACHESTATS"
 
 // Interface File Types
 #define  w_RAINFALL          "RAINFALL"
@@ -62,7 +62,7 @@ int DLLEXPORT swmm_project_findObject(int type, char *id, int *index)
         index    = NULL;
         error_code_index = ERR_API_OBJECT_INDEX;
     } else
-        *index = idx;
+        *index = project_getInputPos(type, idx);
 
     return error_getCode(error_code_index);
 }
@@ -329,7 +329,7 @@ int DLLEXPORT swmm_getObjectIndex(SM_ObjectType type, char *id, int *index)
 
     // Check if Open
     if(swmm_IsOpenFlag() == TRUE)
-        *index = project_findObject(type, id);
+        *index = project_getInputPos(type, project_findObject(type, id));
     else
         error_code_index = ERR_API_INPUTNOTOPEN;
 
@@ -368,9 +368,9 @@ int DLLEXPORT swmm_getObjectId(int type, int index, char *id)
             case SM_SUBCATCH:
                 strcpy(id,Subcatch[index].ID); break;
             case SM_NODE:
-                strcpy(id,Node[index].ID); break;
+                strcpy(id,Node[project_getObjectIndex(NODE, index)].ID); break;
             case SM_LINK:
-                strcpy(id,Link[index].ID); break;
+                strcpy(id,Link[project_getObjectIndex(LINK, index)].ID); break;
             case SM_POLLUT:
                 strcpy(id,Pollut[index].ID); break;
             case SM_LANDUSE:
@@ -415,6 +415,8 @@ int DLLEXPORT swmm_getNodeType(int index, int *Ntype)
 {
     int error_code_index = 0;
     *Ntype = -1;
+    index = project_getObjectIndex(NODE, index);
+
     // Check if Open
     if(swmm_IsOpenFlag() == FALSE)
     {
@@ -439,6 +441,8 @@ int DLLEXPORT swmm_getLinkType(int index, int *Ltype)
 {
     int error_code_index = 0;
     *Ltype = -1;
+    index = project_getObjectIndex(LINK, index);
+
     // Check if Open
     if(swmm_IsOpenFlag() == FALSE)
     {
@@ -464,6 +468,8 @@ int DLLEXPORT swmm_getLinkConnections(int index, int *Node1, int *Node2)
     int error_code_index = 0;
     *Node1 = -1;
     *Node2 = -1;
+    index = project_getObjectIndex(LINK, index);
+
     // Check if Open
     if(swmm_IsOpenFlag() == FALSE)
     {
@@ -476,8 +482,8 @@ int DLLEXPORT swmm_getLinkConnections(int index, int *Node1, int *Node2)
     }
     else
     {
-        *Node1 = Link[index].node1;
-        *Node2 = Link[index].node2;
+        *Node1 = project_getInputPos(NODE, Link[index].node1);
+        *Node2 = project_getInputPos(NODE, Link[index].node2);
     }
     return error_getCode(error_code_index);
 }
@@ -491,6 +497,8 @@ int DLLEXPORT swmm_getLinkDirection(int index, signed char *value)
 {
     int error_code_index = 0;
     *value = 0;
+    index = project_getObjectIndex(LINK, index);
+
     // Check if Open
     if(swmm_IsOpenFlag() == FALSE)
     {
@@ -518,6 +526,8 @@ int DLLEXPORT swmm_getNodeParam(int index, int Param, double *value)
 {
     int error_code_index = 0;
     *value = 0;
+    index = project_getObjectIndex(NODE, index);
+
     // Check if Open
     if(swmm_IsOpenFlag() == FALSE)
     {
@@ -557,6 +567,8 @@ int DLLEXPORT swmm_setNodeParam(int index, int Param, double value)
 /// Purpose: Sets Node Parameter
 {
     int error_code_index = 0;
+    index = project_getObjectIndex(NODE, index);
+
     // Check if Open
     if(swmm_IsOpenFlag() == FALSE)
     {
@@ -604,6 +616,8 @@ int DLLEXPORT swmm_getLinkParam(int index, int Param, double *value)
 {
     int error_code_index = 0;
     *value = 0;
+    index = project_getObjectIndex(LINK, index);
+
     // Check if Open
     if(swmm_IsOpenFlag() == FALSE)
     {
@@ -647,6 +661,8 @@ int DLLEXPORT swmm_setLinkParam(int index, int Param, double value)
 /// Purpose: Sets Link Parameter
 {
     int error_code_index = 0;
+    index = project_getObjectIndex(LINK, index);
+
     // Check if Open
     if(swmm_IsOpenFlag() == FALSE)
     {
@@ -818,7 +834,7 @@ int DLLEXPORT swmm_getSubcatchOutConnection(int index, int *type, int *out_index
         }
         if (Subcatch[index].outNode >= 0)
         {
-            *out_index = Subcatch[index].outNode;
+            *out_index = project_getInputPos(NODE, Subcatch[index].outNode);
             *type = NODE;
         }
         if (Subcatch[index].outSubcatch >= 0)
@@ -1018,7 +1034,7 @@ int DLLEXPORT swmm_getLidUOption(int index, int lidIndex, int param, int *value)
                 case SM_DRAINSUB:
                     *value = lidUnit->drainSubcatch; break;
                 case SM_DRAINNODE:
-                    *value = lidUnit->drainNode; break;
+                    *value = project_getInputPos(NODE, lidUnit->drainNode); break;
                 default:
                     error_code_index = ERR_API_OUTBOUNDS; break;
             }
@@ -1072,7 +1088,7 @@ int DLLEXPORT swmm_setLidUOption(int index, int lidIndex, int param, int value)
                 lidUnit->drainNode = -1;
                 break;
             case SM_DRAINNODE:
-                lidUnit->drainNode = value;
+                lidUnit->drainNode = project_getObjectIndex(NODE, value);
                 lidUnit->drainSubcatch = -1;
                 break;
             default:
@@ -1101,7 +1117,7 @@ int DLLEXPORT swmm_setLidUOption(int index, int lidIndex, int param, int value)
                     lidUnit->drainNode = -1;
                     break;
                 case SM_DRAINNODE:
-                    lidUnit->drainNode = value;
+                    lidUnit->drainNode = project_getObjectIndex(NODE, value);
                     lidUnit->drainSubcatch = -1;
                     break;
                 default:
@@ -1733,6 +1749,8 @@ int DLLEXPORT swmm_getNodeResult(int index, int type, double *result)
     int error_code_index = 0;
     *result = 0;
 
+    index = project_getObjectIndex(NODE, index);
+
     // Check if Open
     if(swmm_IsOpenFlag() == FALSE)
     {
@@ -1782,6 +1800,8 @@ int DLLEXPORT swmm_getNodePollut(int index, int type, double **PollutArray)
     int error_code_index = 0;
     double* result;
 
+    index = project_getObjectIndex(NODE, index);
+
     // Check if Open
     if(swmm_IsOpenFlag() == FALSE)
     {
@@ -1825,6 +1845,8 @@ int DLLEXPORT swmm_getLinkResult(int index, int type, double *result)
     int error_code_index = 0;
     *result = 0;
 
+    index = project_getObjectIndex(LINK, index);
+
     // Check if Open
     if(swmm_IsOpenFlag() == FALSE)
     {
@@ -1873,6 +1895,8 @@ int DLLEXPORT swmm_getLinkPollut(int index, int type, double **PollutArray)
     int error_code_index = 0;
     double* result;
 
+    index = project_getObjectIndex(LINK, index);
+
     // Check if Open
     if(swmm_IsOpenFlag() == FALSE)
     {
@@ -2078,7 +2102,7 @@ int DLLEXPORT swmm_getNodeStats(int index, SM_NodeStats *nodeStats)
 /// Return:  API Error
 /// Purpose: Gets Node Stats and Converts Units
 {
-    int error_code_index = stats_getNodeStat(index, nodeStats);
+    int error_code_index = stats_getNodeStat(project_getObjectIndex(NODE, index), nodeStats);
 
     if (error_code_index == 0)
     {
@@ -2116,7 +2140,7 @@ int DLLEXPORT swmm_getNodeTotalInflow(int index, double *value)
 /// Purpose: Get Node Total Inflow Volume.
 {
     //*value = 0;
-    int error_code_index = massbal_getNodeTotalInflow(index, value);
+    int error_code_index = massbal_getNodeTotalInflow(project_getObjectIndex(NODE, index), value);
 
     if (error_code_index == 0)
     {
@@ -2132,7 +2156,7 @@ int DLLEXPORT swmm_getStorageStats(int index, SM_StorageStats *storageStats)
 /// Return:  API Error
 /// Purpose: Gets Storage Node Stats and Converts Units
 {
-    int error_code_index = stats_getStorageStat(index, storageStats);
+    int error_code_index = stats_getStorageStat(project_getObjectIndex(NODE, index), storageStats);
 
     if (error_code_index == 0)
     {
@@ -2162,7 +2186,7 @@ int DLLEXPORT swmm_getOutfallStats(int index, SM_OutfallStats *outfallStats)
 ///          to free the pollutants array.
 {
     int p;
-    int error_code_index = stats_getOutfallStat(index, outfallStats);
+    int error_code_index = stats_getOutfallStat(project_getObjectIndex(NODE, index), outfallStats);
 
     if (error_code_index == 0)
     {
@@ -2210,7 +2234,7 @@ int DLLEXPORT swmm_getLinkStats(int index, SM_LinkStats *linkStats)
 /// Return:  API Error
 /// Purpose: Gets Link Stats and Converts Units
 {
-    int error_code_index = stats_getLinkStat(index, linkStats);
+    int error_code_index = stats_getLinkStat(project_getObjectIndex(LINK, index), linkStats);
 
     if (error_code_index == 0)
     {
@@ -2248,7 +2272,7 @@ int DLLEXPORT swmm_getPumpStats(int index, SM_PumpStats *pumpStats)
 /// Return:  API Error
 /// Purpose: Gets Pump Link Stats and Converts Units
 {
-    int error_code_index = stats_getPumpStat(index, pumpStats);
+    int error_code_index = stats_getPumpStat(project_getObjectIndex(LINK, index), pumpStats);
 
     if (error_code_index == 0)
     {
@@ -2615,6 +2639,8 @@ int DLLEXPORT swmm_setLinkSetting(int index, double setting)
     int error_code_index = 0;
     char _rule_[11] = "ToolkitAPI";
 
+    index = project_getObjectIndex(LINK, index);
+
     // Check if Open
     if (swmm_IsOpenFlag() == FALSE)
     {
@@ -2656,6 +2682,8 @@ int DLLEXPORT swmm_setNodeInflow(int index, double flowrate)
 {
     int error_code_index = 0;
 
+    index = project_getObjectIndex(NODE, index);
+
     // Check if Open
     if (swmm_IsOpenFlag() == FALSE)
     {
@@ -2716,6 +2744,8 @@ int DLLEXPORT swmm_setOutfallStage(int index, double stage)
 /// Purpose: Sets new outfall stage and holds until set again.
 {
     int error_code_index = 0;
+    index = project_getObjectIndex(NODE, index);
+
     // Check if Open
     if (swmm_IsOpenFlag() == FALSE)
     {
@@ -7,6 +7,14 @@
 //   Author:   L. Rossman
 //
 //   Topological sorting of conveyance network links
+//
+//   Build 5.2.0:
+//   - Nodes & links can be ordered so that consecutive runs of them form
+//     connected parts of the network (for partitioning among threads).
+//   - Reverse Cuthill-McKee ordering of nodes & links added (for
+//     renumbering the network).
+//   - Nodes can be grouped into levels whose outgoing links can be routed
+//     at the same time (for parallel Kinematic Wave & Steady Flow routing).
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -18,28 +26,38 @@
 //-----------------------------------------------------------------------------
 enum AdjListType {UNDIRECTED, DIRECTED};    // type of nodal adjacency list
 
+typedef struct                         // sort key of a link in a node ordering
+{
+    int  lo;                           // lower position of its end nodes
+    int  hi;                           // higher position of its end nodes
+    int  link;                         // link index
+} TLinkKey;
+
 //-----------------------------------------------------------------------------
 //  Shared variables
 //-----------------------------------------------------------------------------
-static int* InDegree;                  // number of incoming links to each node
-static int* StartPos;                  // start of a node's outlinks in AdjList
-static int* AdjList;                   // list of outlink indexes for each node
-static int* Stack;                     // array of nodes "reached" during sorting
-static int  First;                     // position of first node in stack
-static int  Last;                      // position of last node added to stack
-
-static char* Examined;                 // TRUE if node included in spanning tree
-static char* InTree;                   // state of each link in spanning tree:
+static THREADLOCAL int* InDegree;                  // number of incoming links to each node
+static THREADLOCAL int* StartPos;                  // start of a node's outlinks in AdjList
+static THREADLOCAL int* AdjList;                   // list of outlink indexes for each node
+static THREADLOCAL int* Stack;                     // array of nodes "reached" during sorting
+static THREADLOCAL int  First;                     // position of first node in stack
+static THREADLOCAL int  Last;                      // position of last node added to stack
+
+static THREADLOCAL char* Examined;                 // TRUE if node included in spanning tree
+static THREADLOCAL char* InTree;                   // state of each link in spanning tree:
                                        // 0 = unexamined,
                                        // 1 = in spanning tree,
                                        // 2 = chord of spanning tree
-static int*  LoopLinks;                // list of links which forms a loop
-static int   LoopLinksLast;            // number of links in a loop
+static THREADLOCAL int*  LoopLinks;                // list of links which forms a loop
+static THREADLOCAL int   LoopLinksLast;            // number of links in a loop
 
 //-----------------------------------------------------------------------------
 //  External functions (declared in funcs.h)   
 //-----------------------------------------------------------------------------
 //  toposort_sortLinks (called by routing_open)
+//  toposort_partitionNetwork (called by dynwave_init)
+//  toposort_orderNetwork (called by orderNetwork in project.c)
+//  toposort_findLevels (called by flowrout_init)
 
 //-----------------------------------------------------------------------------
 //  Local functions
@@ -52,6 +70,9 @@ static void findSpanningTree(int startNode);
 static void evalLoop(int startLink);
 static int  traceLoop(int i1, int i2, int k);
 static void checkDummyLinks(void);
+static int  findPeripheralNode(int root, int start[], int adj[], int level[],
+                               int queue[]);
+static int  compareLinkKeys(const void* a, const void* b);
 //=============================================================================
 
 void toposort_sortLinks(int sortedLinks[])
@@ -136,6 +157,382 @@ void toposort_sortLinks(int sortedLinks[])
 
 //=============================================================================
 
+int toposort_partitionNetwork(int nodeOrder[], int linkOrder[])
+//
+//  Input:   none
+//  Output:  nodeOrder = node indexes in partition order
+//           linkOrder = link indexes in partition order
+//           returns FALSE if not enough memory
+//  Purpose: orders nodes & links so that any run of consecutive entries
+//           forms a connected part of the drainage network.
+//
+//  Nodes are listed in the order a depth-first search reaches them,
+//  starting from each outfall, so that every branch of a drainage tree
+//  occupies one contiguous block of the list. Splitting the list into
+//  equal runs gives parts of equal size that are joined to each other
+//  only by the few links on the path back to the outfall. Each link is
+//  listed with the first of its two end nodes to be reached.
+{
+    int  i, j, k, m, n, pass, top, count;
+    int  nNodes = Nobjects[NODE];
+    int* degree;                       // saved degree of each node
+    int* rank;                         // position of each node in nodeOrder
+    int* next;                         // next adjacency entry to search
+    int  result = FALSE;
+
+    // --- allocate arrays
+    StartPos = (int *) calloc(nNodes + 1, sizeof(int));
+    AdjList  = (int *) calloc(2*Nobjects[LINK] + 1, sizeof(int));
+    Stack    = (int *) calloc(nNodes + 1, sizeof(int));
+    degree   = (int *) calloc(nNodes + 1, sizeof(int));
+    rank     = (int *) calloc(nNodes + 1, sizeof(int));
+    next     = (int *) calloc(nNodes + 1, sizeof(int));
+    if ( StartPos && AdjList && Stack && degree && rank && next )
+    {
+        // --- create an undirected adjacency list for the nodes
+        //     (keeping the node degrees used by the routing methods)
+        for (i = 0; i < nNodes; i++) degree[i] = Node[i].degree;
+        createAdjList(UNDIRECTED);
+
+        // --- search from each outfall first and then from any node
+        //     not yet reached
+        for (i = 0; i < nNodes; i++) rank[i] = -1;
+        count = 0;
+        for (pass = 0; pass < 2; pass++)
+        {
+            for (n = 0; n < nNodes; n++)
+            {
+                if ( rank[n] >= 0 ) continue;
+                if ( pass == 0 && Node[n].type != OUTFALL ) continue;
+                rank[n] = count;
+                nodeOrder[count++] = n;
+                next[n] = StartPos[n];
+                top = 0;
+                Stack[top] = n;
+                while ( top >= 0 )
+                {
+                    // --- back up once all of a node's links are searched
+                    i = Stack[top];
+                    if ( next[i] == StartPos[i] + Node[i].degree )
+                    {
+                        top--;
+                        continue;
+                    }
+
+                    // --- add the node at the far end of the next link
+                    k = AdjList[next[i]++];
+                    if ( Link[k].node1 == i ) j = Link[k].node2;
+                    else j = Link[k].node1;
+                    if ( rank[j] >= 0 ) continue;
+                    rank[j] = count;
+                    nodeOrder[count++] = j;
+                    next[j] = StartPos[j];
+                    Stack[++top] = j;
+                }
+            }
+        }
+
+        // --- list each link with its first end node to be reached
+        count = 0;
+        for (n = 0; n < nNodes; n++)
+        {
+            i = nodeOrder[n];
+            for (m = StartPos[i]; m < StartPos[i] + Node[i].degree; m++)
+            {
+                k = AdjList[m];
+                if ( (Link[k].node1 == i && rank[Link[k].node2] >= n) ||
+                     (Link[k].node2 == i && rank[Link[k].node1] > n) )
+                    linkOrder[count++] = k;
+            }
+        }
+        for (i = 0; i < nNodes; i++) Node[i].degree = degree[i];
+        result = TRUE;
+    }
+
+    // --- free allocated memory
+    FREE(StartPos);
+    FREE(AdjList);
+    FREE(Stack);
+    FREE(degree);
+    FREE(rank);
+    FREE(next);
+    return result;
+}
+
+//=============================================================================
+
+int toposort_orderNetwork(int nNodes, int nLinks, int node1[], int node2[],
+                          int nodeOrder[], int linkOrder[])
+//
+//  Input:   nNodes = number of nodes
+//           nLinks = number of links
+//           node1 = start node of each link (-1 if unknown)
+//           node2 = end node of each link (-1 if unknown)
+//  Output:  nodeOrder = node indexes in reverse Cuthill-McKee order
+//           linkOrder = link indexes in a matching order
+//           returns FALSE if not enough memory
+//  Purpose: orders nodes & links so that those joined to one another lie
+//           close together.
+//
+//  Works only with the node1 & node2 arrays since it is used before the
+//  project's Node and Link objects are created. Each connected part of
+//  the network is listed breadth-first, starting from a node on its
+//  periphery and taking the neighbors of each node in order of increasing
+//  degree, which keeps the two end nodes of every link near each other in
+//  the list. As is customary, the list is then reversed. Links are listed
+//  in order of their nearest end node and then their farthest one.
+{
+    int       i, j, k, m, n, head, count;
+    int*      start;                   // start of each node's neighbors in adj
+    int*      adj;                     // list of neighbors of each node
+    int*      rank;                    // position of each node in nodeOrder
+    int*      level;                   // work array for findPeripheralNode
+    int*      queue;                   // work array for findPeripheralNode
+    TLinkKey* keys;                    // sort keys of the links
+    int       result = FALSE;
+
+    // --- allocate arrays
+    start = (int *) calloc(nNodes + 1, sizeof(int));
+    adj   = (int *) calloc(2*nLinks + 1, sizeof(int));
+    rank  = (int *) calloc(nNodes + 1, sizeof(int));
+    level = (int *) calloc(nNodes + 1, sizeof(int));
+    queue = (int *) calloc(nNodes + 1, sizeof(int));
+    keys  = (TLinkKey *) calloc(nLinks + 1, sizeof(TLinkKey));
+    if ( start && adj && rank && level && queue && keys )
+    {
+        // --- build the list of neighbors of each node
+        //     (rank is used to count entries as they are added)
+        for (k = 0; k < nLinks; k++)
+        {
+            if ( node1[k] < 0 || node2[k] < 0 ) continue;
+            start[node1[k]+1]++;
+            start[node2[k]+1]++;
+        }
+        for (i = 0; i < nNodes; i++) start[i+1] += start[i];
+        for (k = 0; k < nLinks; k++)
+        {
+            if ( node1[k] < 0 || node2[k] < 0 ) continue;
+            adj[start[node1[k]] + rank[node1[k]]++] = node2[k];
+            adj[start[node2[k]] + rank[node2[k]]++] = node1[k];
+        }
+
+        // --- sort each node's neighbors by increasing degree
+        for (i = 0; i < nNodes; i++)
+        {
+            for (m = start[i] + 1; m < start[i+1]; m++)
+            {
+                j = adj[m];
+                n = start[j+1] - start[j];
+                for (k = m; k > start[i]; k--)
+                {
+                    if ( start[adj[k-1]+1] - start[adj[k-1]] <= n ) break;
+                    adj[k] = adj[k-1];
+                }
+                adj[k] = j;
+            }
+        }
+
+        // --- list each connected part of the network breadth-first
+        //     from a node on its periphery
+        for (i = 0; i < nNodes; i++)
+        {
+            rank[i] = -1;
+            level[i] = -1;
+        }
+        count = 0;
+        for (n = 0; n < nNodes; n++)
+        {
+            if ( rank[n] >= 0 ) continue;
+            i = findPeripheralNode(n, start, adj, level, queue);
+            head = count;
+            rank[i] = count;
+            nodeOrder[count++] = i;
+            while ( head < count )
+            {
+                i = nodeOrder[head++];
+                for (m = start[i]; m < start[i+1]; m++)
+                {
+                    j = adj[m];
+                    if ( rank[j] >= 0 ) continue;
+                    rank[j] = count;
+                    nodeOrder[count++] = j;
+                }
+            }
+        }
+
+        // --- reverse the list
+        for (i = 0; i < nNodes / 2; i++)
+        {
+            j = nodeOrder[i];
+            nodeOrder[i] = nodeOrder[nNodes-1-i];
+            nodeOrder[nNodes-1-i] = j;
+        }
+        for (i = 0; i < nNodes; i++) rank[nodeOrder[i]] = i;
+
+        // --- sort links by the positions of their end nodes
+        //     (those with unknown end nodes go last)
+        for (k = 0; k < nLinks; k++)
+        {
+            keys[k].link = k;
+            if ( node1[k] < 0 || node2[k] < 0 )
+            {
+                keys[k].lo = nNodes;
+                keys[k].hi = nNodes;
+                continue;
+            }
+            keys[k].lo = MIN(rank[node1[k]], rank[node2[k]]);
+            keys[k].hi = MAX(rank[node1[k]], rank[node2[k]]);
+        }
+        qsort(keys, nLinks, sizeof(TLinkKey), compareLinkKeys);
+        for (k = 0; k < nLinks; k++) linkOrder[k] = keys[k].link;
+        result = TRUE;
+    }
+
+    // --- free allocated memory
+    FREE(start);
+    FREE(adj);
+    FREE(rank);
+    FREE(level);
+    FREE(queue);
+    FREE(keys);
+    return result;
+}
+
+//=============================================================================
+
+int toposort_findLevels(int sortedLinks[], int levelStart[], int levelNodes[])
+//
+//  Input:   sortedLinks = array of link indexes in topo-sorted order
+//  Output:  levelStart = start of each level's nodes in levelNodes
+//           levelNodes = node indexes listed by level
+//           returns number of levels (or -1 if not enough memory)
+//  Purpose: groups nodes into levels so that all links entering the nodes
+//           of a level leave nodes of lower levels.
+//
+//  A node's level is one more than the highest level of the nodes whose
+//  links enter it, or 0 if no links enter it. Since the links leaving a
+//  node of one level depend only on flows from lower levels, the outgoing
+//  links of all nodes of a level can be routed at the same time. Nodes
+//  are listed in index order within each level. levelStart must have room
+//  for Nobjects[NODE] + 1 entries.
+{
+    int  i, j, k, n, nLevels = 0;
+    int  nNodes = Nobjects[NODE];
+    int* level;                        // level of each node
+
+    level = (int *) calloc(nNodes + 1, sizeof(int));
+    if ( level == NULL ) return -1;
+
+    // --- a node's level is final once the links entering it are sorted,
+    //     which is before the first of its own outgoing links
+    for (k = 0; k < Nobjects[LINK]; k++)
+    {
+        j = sortedLinks[k];
+        i = Link[j].node1;
+        n = Link[j].node2;
+        level[n] = MAX(level[n], level[i] + 1);
+    }
+
+    // --- count the nodes in each level & find where each level starts
+    for (n = 0; n <= nNodes; n++) levelStart[n] = 0;
+    for (n = 0; n < nNodes; n++)
+    {
+        levelStart[level[n] + 1]++;
+        nLevels = MAX(nLevels, level[n] + 1);
+    }
+    for (i = 0; i < nLevels; i++) levelStart[i+1] += levelStart[i];
+
+    // --- list the nodes of each level (advancing each level's start
+    //     past its listed nodes and then shifting the starts back)
+    for (n = 0; n < nNodes; n++)
+    {
+        k = levelStart[level[n]]++;
+        levelNodes[k] = n;
+    }
+    for (i = nLevels; i > 0; i--) levelStart[i] = levelStart[i-1];
+    levelStart[0] = 0;
+    FREE(level);
+    return nLevels;
+}
+
+//=============================================================================
+
+int findPeripheralNode(int root, int start[], int adj[], int level[],
+                       int queue[])
+//
+//  Input:   root = a node of the network
+//           start = start of each node's neighbors in adj
+//           adj = list of neighbors of each node
+//           level = work array whose entries are all -1
+//           queue = work array
+//  Output:  returns a node on the periphery of the part of the network
+//           that contains root
+//  Purpose: finds a starting node for a Cuthill-McKee ordering.
+//
+//  Uses the method of Gibbs, Poole & Stockmeyer as simplified by George
+//  & Liu: a breadth-first search is repeated from the lowest degree node
+//  on the last level reached by the previous search for as long as the
+//  number of levels keeps increasing.
+{
+    int i, j, m, head, tail, node, depth;
+    int lastDepth = -1;
+
+    for (;;)
+    {
+        // --- find the level of each node reached from root
+        queue[0] = root;
+        level[root] = 0;
+        head = 0;
+        tail = 1;
+        while ( head < tail )
+        {
+            i = queue[head++];
+            for (m = start[i]; m < start[i+1]; m++)
+            {
+                j = adj[m];
+                if ( level[j] >= 0 ) continue;
+                level[j] = level[i] + 1;
+                queue[tail++] = j;
+            }
+        }
+
+        // --- find the lowest degree node on the last level
+        node = queue[tail-1];
+        depth = level[node];
+        for (m = tail - 2; m >= 0 && level[queue[m]] == depth; m--)
+        {
+            i = queue[m];
+            if ( start[i+1] - start[i] < start[node+1] - start[node] )
+                node = i;
+        }
+        for (m = 0; m < tail; m++) level[queue[m]] = -1;
+
+        // --- stop once the search gets no deeper
+        if ( depth <= lastDepth ) return root;
+        lastDepth = depth;
+        root = node;
+    }
+}
+
+//=============================================================================
+
+int compareLinkKeys(const void* a, const void* b)
+//
+//  Input:   a, b = pointers to two link sort keys
+//  Output:  returns -1, 0 or 1 as a comes before, with or after b
+//  Purpose: compares the sort keys of two links (used with qsort).
+//
+{
+    const TLinkKey* k1 = (const TLinkKey *) a;
+    const TLinkKey* k2 = (const TLinkKey *) b;
+    if ( k1->lo != k2->lo ) return ( k1->lo < k2->lo ) ? -1 : 1;
+    if ( k1->hi != k2->hi ) return ( k1->hi < k2->hi ) ? -1 : 1;
+    if ( k1->link != k2->link ) return ( k1->link < k2->link ) ? -1 : 1;
+    return 0;
+}
+
+//=============================================================================
+
 void createAdjList(int listType)
 //
 //  Input:   lsitType = DIRECTED or UNDIRECTED
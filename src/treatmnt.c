@@ -32,13 +32,13 @@ enum   ProcessVarType {pvHRT,          // hydraulic residence time
 //-----------------------------------------------------------------------------
 //  Shared variables
 //-----------------------------------------------------------------------------
-static int     ErrCode;                // treatment error code
-static int     J;                      // index of node being analyzed
-static double  Dt;                     // curent time step (sec)
-static double  Q;                      // node inflow (cfs)
-static double  V;                      // node volume (ft3)
-static double* R;                      // array of pollut. removals
-static double* Cin;                    // node inflow concentrations
+static THREADLOCAL int     ErrCode;                // treatment error code
+static THREADLOCAL int     J;                      // index of node being analyzed
+static THREADLOCAL double  Dt;                     // curent time step (sec)
+static THREADLOCAL double  Q;                      // node inflow (cfs)
+static THREADLOCAL double  V;                      // node volume (ft3)
+#define R   (Prj->treatmnt.R)   // array of pollut. removals
+#define Cin (Prj->treatmnt.Cin) // node inflow concentrations
 
 //-----------------------------------------------------------------------------
 //  External functions (declared in funcs.h)
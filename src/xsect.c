@@ -31,6 +31,19 @@
 //
 //   Build 5.1.013:
 //   - Width at full height set to 0 for closed rectangular shape.
+//
+//   Build 5.2.0:
+//   - Batch versions of xsect_getAofY & xsect_getRofY added that evaluate
+//     a group of cross sections of the same closed-form shape in a
+//     vectorizable loop.
+//   - Optional dense tables of depth, hyd. radius & section factor v. area
+//     for irregular & custom shapes (see xsect_createDenseTables).
+//   - Optional non-iterative evaluation of circular geometry over the
+//     full range of fill (see CircGeometry option & getThetaOfAlpha).
+//   - xsect_getAofSNear & xsect_getYcritNear added that start their root
+//     solves from a solution found for a nearby section factor or flow
+//     (DepthWarmStart option), and that count the function evaluations
+//     their root solves make.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -41,6 +54,8 @@
 #define  RECT_ALFMAX        0.97
 #define  RECT_TRIANG_ALFMAX 0.98
 #define  RECT_ROUND_ALFMAX  0.98
+#define  DENSE_TABLE_TOL    0.001  // max. error of dense tables (fraction of full value)
+#define  CIRC_PSIMAX        1.0757061294004651  // max. s/sFull of circular shape
 
 #include "xsect.dat"    // File containing geometry tables for rounded shapes
 
@@ -84,6 +99,7 @@ typedef struct
     double  s;                // section factor
     double  qc;               // critical flow
     TXsect* xsect;            // pointer to a cross section object
+    long*   evals;            // count of function evaluations (or NULL)
 } TXsectStar;
 
 //-----------------------------------------------------------------------------
@@ -98,20 +114,38 @@ typedef struct
 //  xsect_getYofA
 //  xsect_getRofA
 //  xsect_getAofS
+//  xsect_getAofSNear
 //  xsect_getdSdA
 //  xsect_getAofY
 //  xsect_getRofY
 //  xsect_getWofY
 //  xsect_getYcrit
+//  xsect_getYcritNear
+//  xsect_getAofYBatch
+//  xsect_getRofYBatch
+//  xsect_createDenseTables
+//  xsect_deleteDenseTables
+//  xsect_getDenseTableSize
 
 //-----------------------------------------------------------------------------
 //  Local functions
 //-----------------------------------------------------------------------------
-static double generic_getAofS(TXsect* xsect, double s);
+static double generic_getAofS(TXsect* xsect, double s, double a0,
+                              long* evals);
 static void   evalSofA(double a, double* f, double* df, void* p);
 static double tabular_getdSdA(TXsect* xsect, double a, double *table, int nItems);
 static double generic_getdSdA(TXsect* xsect, double a);
 static double lookup(double x, double *table, int nItems);
+
+static int    createDenseTable(TDenseTbl* dense, double* aTbl, double* rTbl,
+              int nItems);
+static void   deleteDenseTable(TDenseTbl* dense);
+static void   getTableGeometry(double alpha, double* aTbl, double* rTbl,
+              int nItems, double* y, double* r, double* s);
+static double getDenseTableError(TDenseTbl* dense, double alpha,
+              double* aTbl, double* rTbl, int nItems);
+static TDenseTbl* getDenseTbl(TXsect* xsect);
+static double denseLookup(double x, double* table, int n);
 static double invLookup(double y, double *table, int nItems);
 static int    locate(double y, double *table, int nItems);
 
@@ -187,10 +221,16 @@ static double getScircular(double alpha);
 static double getAcircular(double psi);
 static double getThetaOfAlpha(double alpha);
 static double getThetaOfPsi(double psi);
+static double getThetaOfAlphaDirect(double alpha);
+static double getThetaOfPsiDirect(double psi);
+static double chebyshev(const double c[], int n, double x, double x1, double x2);
 
 static double getQcritical(double yc, void* p);
-static double getYcritEnum(TXsect* xsect, double q, double y0);
-static double getYcritRidder(TXsect* xsect, double q, double y0);
+static double getYcritEnum(TXsect* xsect, double q, double y0,
+                           TDepthCache* cache);
+static double getYcritRidder(TXsect* xsect, double q, double y0,
+                             long* evals);
+static double getYcritNear(TXsect* xsect, double q, double y0, long* evals);
 
 //=============================================================================
 
@@ -722,6 +762,12 @@ double xsect_getSofA(TXsect *xsect, double a)
 {
     double alpha = a / xsect->aFull;
     double r;
+    TDenseTbl* dense = getDenseTbl(xsect);
+
+    // --- use dense table of irregular or custom shape if available
+    if ( dense && alpha < 1.0 )
+        return xsect->sFull * denseLookup(alpha, dense->sTbl, dense->n);
+
     switch ( xsect->type )
     {
       case FORCE_MAIN:
@@ -780,6 +826,11 @@ double xsect_getYofA(TXsect *xsect, double a)
 //
 {
     double alpha = a / xsect->aFull;
+    TDenseTbl* dense = getDenseTbl(xsect);
+
+    // --- use dense table of irregular or custom shape if available
+    if ( dense ) return xsect->yFull * denseLookup(alpha, dense->yTbl, dense->n);
+
     switch ( xsect->type )
     {
       case FORCE_MAIN:
@@ -1078,6 +1129,359 @@ double xsect_getRofY(TXsect *xsect, double y)
 
 //=============================================================================
 
+void xsect_getAofYBatch(TXsect* xsect[], double y[], double a[], int n)
+//
+//  Input:   xsect = array of ptrs. to cross sections that all have same shape
+//           y = depth in each cross section (ft)
+//           n = number of cross sections
+//  Output:  a = area of each cross section (ft2)
+//  Purpose: computes the areas of a group of cross sections at given depths.
+//
+//  NOTE: the shape is checked only once for the whole group so that the
+//        loops below have no branches the compiler can't turn into selects
+//        and can be vectorized. Only shapes with closed-form geometry are
+//        evaluated this way; cross sections of other shapes (including
+//        circular ones) are evaluated one at a time with xsect_getAofY().
+//        Results are the same as those returned by xsect_getAofY() for
+//        each cross section.
+{
+    int i;
+
+    if ( n <= 0 ) return;
+    switch ( xsect[0]->type )
+    {
+      case RECT_CLOSED:
+      case RECT_OPEN:
+        #pragma omp simd
+        for (i = 0; i < n; i++)
+            a[i] = ( y[i] <= 0.0 ) ? 0.0 : y[i] * xsect[i]->wMax;
+        return;
+
+      case TRAPEZOIDAL:
+        #pragma omp simd
+        for (i = 0; i < n; i++)
+            a[i] = ( y[i] <= 0.0 ) ? 0.0 :
+                   (xsect[i]->yBot + xsect[i]->sBot * y[i]) * y[i];
+        return;
+
+      case TRIANGULAR:
+        #pragma omp simd
+        for (i = 0; i < n; i++)
+            a[i] = ( y[i] <= 0.0 ) ? 0.0 : y[i] * y[i] * xsect[i]->sBot;
+        return;
+
+      default:
+        for (i = 0; i < n; i++) a[i] = xsect_getAofY(xsect[i], y[i]);
+    }
+}
+
+//=============================================================================
+
+void xsect_getRofYBatch(TXsect* xsect[], double y[], double r[], int n)
+//
+//  Input:   xsect = array of ptrs. to cross sections that all have same shape
+//           y = depth in each cross section (ft)
+//           n = number of cross sections
+//  Output:  r = hydraulic radius of each cross section (ft)
+//  Purpose: computes the hydraulic radii of a group of cross sections at
+//           given depths.
+//
+//  NOTE: see xsect_getAofYBatch(). Results are the same as those returned
+//        by xsect_getRofY() for each cross section.
+{
+    int    i;
+    double ai, p;
+
+    if ( n <= 0 ) return;
+    switch ( xsect[0]->type )
+    {
+      case RECT_CLOSED:
+        #pragma omp simd private(ai, p)
+        for (i = 0; i < n; i++)
+        {
+            ai = ( y[i] <= 0.0 ) ? 0.0 : y[i] * xsect[i]->wMax;
+            p = xsect[i]->wMax + 2. * ai / xsect[i]->wMax;
+            p += ( ai / xsect[i]->aFull > RECT_ALFMAX ) ?
+                 (ai / xsect[i]->aFull - RECT_ALFMAX) / (1.0 - RECT_ALFMAX) *
+                 xsect[i]->wMax : 0.0;
+            r[i] = ( ai <= 0.0 ) ? 0.0 : ai / p;
+        }
+        return;
+
+      case RECT_OPEN:
+        #pragma omp simd private(ai)
+        for (i = 0; i < n; i++)
+        {
+            ai = ( y[i] <= 0.0 ) ? 0.0 : y[i] * xsect[i]->wMax;
+            r[i] = ( ai <= 0.0 ) ? 0.0 : ai / (xsect[i]->wMax +
+                   (2. - xsect[i]->sBot) * ai / xsect[i]->wMax);
+        }
+        return;
+
+      case TRAPEZOIDAL:
+        #pragma omp simd
+        for (i = 0; i < n; i++)
+        {
+            r[i] = ( y[i] == 0.0 ) ? 0.0 :
+                   (xsect[i]->yBot + xsect[i]->sBot * y[i]) * y[i] /
+                   (xsect[i]->yBot + y[i] * xsect[i]->rBot);
+        }
+        return;
+
+      case TRIANGULAR:
+        #pragma omp simd
+        for (i = 0; i < n; i++)
+            r[i] = (y[i] * xsect[i]->sBot) / (2. * xsect[i]->rBot);
+        return;
+
+      default:
+        for (i = 0; i < n; i++) r[i] = xsect_getRofY(xsect[i], y[i]);
+    }
+}
+
+//=============================================================================
+
+int xsect_createDenseTables(void)
+//
+//  Input:   none
+//  Output:  returns an error code
+//  Purpose: creates dense geometry tables for each transect and custom
+//           shape when the DenseTableSize option is used.
+//
+//  NOTE: the standard geometry tables of transects & custom shapes are
+//        indexed by depth, so finding depth, hyd. radius or section factor
+//        from area requires a search of the area table. The dense tables
+//        are indexed by area instead and are evaluated directly.
+{
+    int i;
+
+    if ( DenseTableSize <= 0 ) return 0;
+    if ( Transect ) for (i = 0; i < Nobjects[TRANSECT]; i++)
+    {
+        if ( Transect[i].aFull <= 0.0 ) continue;
+        if ( !createDenseTable(&Transect[i].dense, Transect[i].areaTbl,
+            Transect[i].hradTbl, N_TRANSECT_TBL) ) return ERR_MEMORY;
+    }
+    if ( Shape ) for (i = 0; i < Nobjects[SHAPE]; i++)
+    {
+        if ( Shape[i].aFull <= 0.0 ) continue;
+        if ( !createDenseTable(&Shape[i].dense, Shape[i].areaTbl,
+            Shape[i].hradTbl, N_SHAPE_TBL) ) return ERR_MEMORY;
+    }
+    return 0;
+}
+
+//=============================================================================
+
+void xsect_deleteDenseTables(void)
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: frees memory used by the dense geometry tables.
+//
+{
+    int i;
+    if ( Transect ) for (i = 0; i < Nobjects[TRANSECT]; i++)
+        deleteDenseTable(&Transect[i].dense);
+    if ( Shape ) for (i = 0; i < Nobjects[SHAPE]; i++)
+        deleteDenseTable(&Shape[i].dense);
+}
+
+//=============================================================================
+
+double xsect_getDenseTableSize(int* nTables, int* nSections)
+//
+//  Input:   none
+//  Output:  nTables = number of sections using dense tables
+//           nSections = number of transects & custom shapes
+//           returns memory used by dense tables (bytes)
+//  Purpose: summarizes the use of dense geometry tables.
+//
+{
+    int    i;
+    double bytes = 0.0;
+
+    *nTables = 0;
+    *nSections = 0;
+    if ( Transect ) for (i = 0; i < Nobjects[TRANSECT]; i++)
+    {
+        (*nSections)++;
+        if ( Transect[i].dense.n == 0 ) continue;
+        (*nTables)++;
+        bytes += 3.0 * Transect[i].dense.n * sizeof(double);
+    }
+    if ( Shape ) for (i = 0; i < Nobjects[SHAPE]; i++)
+    {
+        (*nSections)++;
+        if ( Shape[i].dense.n == 0 ) continue;
+        (*nTables)++;
+        bytes += 3.0 * Shape[i].dense.n * sizeof(double);
+    }
+    return bytes;
+}
+
+//=============================================================================
+
+int createDenseTable(TDenseTbl* dense, double* aTbl, double* rTbl, int nItems)
+//
+//  Input:   dense = dense geometry tables of a transect or custom shape
+//           aTbl = standard table of area v. depth
+//           rTbl = standard table of hyd. radius v. depth
+//           nItems = number of items in the standard tables
+//  Output:  returns FALSE if memory could not be allocated
+//  Purpose: fills dense tables of depth, hyd. radius & section factor v.
+//           area from a section's standard tables.
+//
+//  NOTE: entries are equally spaced in the square root of area, which puts
+//        more of them near the bottom of a section where depth changes
+//        fastest with area. Values are normalized by their full section
+//        values. The tables are not used (dense->n is left at 0) if linear
+//        interpolation between their entries strays from the standard
+//        tables by more than DENSE_TABLE_TOL, so a larger DenseTableSize
+//        should then be used.
+{
+    int    i, n = DenseTableSize;
+    double dx = 1.0 / (n - 1);
+    double x;
+    double err = 0.0;
+
+    // --- allocate all three tables in one block
+    deleteDenseTable(dense);
+    dense->yTbl = (double *) calloc(3 * n, sizeof(double));
+    if ( dense->yTbl == NULL ) return FALSE;
+    dense->rTbl = dense->yTbl + n;
+    dense->sTbl = dense->rTbl + n;
+    dense->n = n;
+
+    // --- evaluate standard tables at areas equally spaced in sqrt(area)
+    for (i = 0; i < n; i++)
+    {
+        x = i * dx;
+        getTableGeometry(x * x, aTbl, rTbl, nItems,
+            &dense->yTbl[i], &dense->rTbl[i], &dense->sTbl[i]);
+    }
+
+    // --- check interpolation error midway between table entries and
+    //     at the areas where the standard tables change slope
+    for (i = 0; i < n-1; i++)
+    {
+        x = (i + 0.5) * dx;
+        err = MAX(err, getDenseTableError(dense, x * x, aTbl, rTbl, nItems));
+    }
+    for (i = 1; i < nItems-1; i++)
+    {
+        err = MAX(err, getDenseTableError(dense, aTbl[i], aTbl, rTbl, nItems));
+    }
+    if ( err > DENSE_TABLE_TOL ) deleteDenseTable(dense);
+    return TRUE;
+}
+
+//=============================================================================
+
+void deleteDenseTable(TDenseTbl* dense)
+//
+//  Input:   dense = dense geometry tables of a transect or custom shape
+//  Output:  none
+//  Purpose: frees memory used by a set of dense geometry tables.
+//
+{
+    FREE(dense->yTbl);
+    dense->rTbl = NULL;
+    dense->sTbl = NULL;
+    dense->n = 0;
+}
+
+//=============================================================================
+
+void getTableGeometry(double alpha, double* aTbl, double* rTbl, int nItems,
+                      double* y, double* r, double* s)
+//
+//  Input:   alpha = area / full area
+//           aTbl = standard table of area v. depth
+//           rTbl = standard table of hyd. radius v. depth
+//           nItems = number of items in the standard tables
+//  Output:  y = depth / full depth
+//           r = hyd. radius / full hyd. radius
+//           s = section factor / full section factor
+//  Purpose: finds the normalized geometry of a transect or custom shape at
+//           a given area from its standard tables the same way as
+//           xsect_getYofA, xsect_getRofA & xsect_getSofA do.
+//
+{
+    *y = invLookup(alpha, aTbl, nItems);
+    *r = ( alpha <= 0.0 ) ? 0.0 : lookup(*y, rTbl, nItems);
+    *s = ( alpha <= 0.0 ) ? 0.0 : alpha * pow(*r, 2./3.);
+}
+
+//=============================================================================
+
+double getDenseTableError(TDenseTbl* dense, double alpha, double* aTbl,
+                          double* rTbl, int nItems)
+//
+//  Input:   dense = dense geometry tables of a transect or custom shape
+//           alpha = area / full area
+//           aTbl = standard table of area v. depth
+//           rTbl = standard table of hyd. radius v. depth
+//           nItems = number of items in the standard tables
+//  Output:  returns largest normalized difference between dense and
+//           standard tables
+//  Purpose: checks the accuracy of a set of dense tables at a given area.
+//
+{
+    double y, r, s, err;
+
+    getTableGeometry(alpha, aTbl, rTbl, nItems, &y, &r, &s);
+    err = fabs(denseLookup(alpha, dense->yTbl, dense->n) - y);
+    err = MAX(err, fabs(denseLookup(alpha, dense->rTbl, dense->n) - r));
+    err = MAX(err, fabs(denseLookup(alpha, dense->sTbl, dense->n) - s));
+    return err;
+}
+
+//=============================================================================
+
+TDenseTbl* getDenseTbl(TXsect* xsect)
+//
+//  Input:   xsect = ptr. to a cross section data structure
+//  Output:  returns ptr. to the section's dense geometry tables or NULL
+//           if it has none
+//  Purpose: finds the dense geometry tables used by a cross section.
+//
+{
+    TDenseTbl* dense;
+    if      ( xsect->type == IRREGULAR )
+        dense = &Transect[xsect->transect].dense;
+    else if ( xsect->type == CUSTOM )
+        dense = &Shape[Curve[xsect->transect].refersTo].dense;
+    else return NULL;
+    if ( dense->n == 0 ) return NULL;
+    return dense;
+}
+
+//=============================================================================
+
+double denseLookup(double x, double* table, int n)
+//
+//  Input:   x = area / full area
+//           table = dense geometry table
+//           n = number of items in table
+//  Output:  returns value of dependent table variable
+//  Purpose: linearly interpolates a value from a dense geometry table
+//           whose entries are equally spaced in sqrt(x) between x = 0 and 1.
+//
+{
+    double xi;
+    int    i;
+
+    if ( x <= 0.0 ) return table[0];
+    if ( x >= 1.0 ) return table[n-1];
+    xi = sqrt(x) * (n - 1);
+    i = (int)xi;
+    if ( i > n - 2 ) i = n - 2;
+    return table[i] + (xi - i) * (table[i+1] - table[i]);
+}
+
+//=============================================================================
+
 double xsect_getRofA(TXsect *xsect, double a)
 //
 //  Input:   xsect = ptr. to a cross section data structure
@@ -1087,7 +1491,14 @@ double xsect_getRofA(TXsect *xsect, double a)
 //
 {
     double cathy;
+    TDenseTbl* dense = getDenseTbl(xsect);
+
     if ( a <= 0.0 ) return 0.0;
+
+    // --- use dense table of irregular or custom shape if available
+    if ( dense )
+        return xsect->rFull * denseLookup(a / xsect->aFull, dense->rTbl, dense->n);
+
     switch ( xsect->type )
     {
       case HORIZ_ELLIPSE:
@@ -1133,6 +1544,24 @@ double xsect_getAofS(TXsect* xsect, double s)
 //  Output:  returns area (ft2)
 //  Purpose: computes xsection's area at a given section factor.
 //
+{
+    return xsect_getAofSNear(xsect, s, 0.0, NULL);
+}
+
+//=============================================================================
+
+double xsect_getAofSNear(TXsect* xsect, double s, double a0, long* evals)
+//
+//  Input:   xsect = ptr. to a cross section data structure
+//           s = section factor (ft^(8/3))
+//           a0 = area found for a nearby section factor (ft2)
+//                (or 0 if not available)
+//           evals = count of section factor evaluations made by a root
+//                   solve (or NULL if not counted)
+//  Output:  returns area (ft2)
+//  Purpose: computes xsection's area at a given section factor, using a0
+//           as the starting value for shapes that require a root solve.
+//
 {
     double psi = s / xsect->sFull;
     if ( s <= 0.0 ) return 0.0;
@@ -1165,7 +1594,7 @@ double xsect_getAofS(TXsect* xsect, double s)
       case SEMICIRCULAR:
         return xsect->aFull * invLookup(psi, S_SemiCirc, N_S_SemiCirc);
 
-      default: return generic_getAofS(xsect, s);
+      default: return generic_getAofS(xsect, s, a0, evals);
     }
 }
 
@@ -1241,9 +1670,33 @@ double xsect_getYcrit(TXsect* xsect, double q)
 //  Output:  returns critical depth (ft)
 //  Purpose: computes critical depth at a specific flow rate.
 //
+{
+    return xsect_getYcritNear(xsect, q, NULL);
+}
+
+//=============================================================================
+
+double xsect_getYcritNear(TXsect* xsect, double q, TDepthCache* cache)
+//
+//  Input:   xsect = ptr. to a cross section data structure
+//           q = flow rate (cfs)
+//           cache = critical depth found for a nearby flow rate
+//                   (or NULL if not available)
+//  Output:  returns critical depth (ft)
+//  Purpose: computes critical depth at a specific flow rate, starting
+//           the search for it from the cached depth for shapes that
+//           require a root solve.
+//
+//  For shapes solved by interval enumeration the cache also holds the
+//  interval that contained the cached depth. A flow that still falls
+//  within it is interpolated there directly, which gives the same
+//  result as a full search. Ridder's method only starts from the cached
+//  depth when the DepthWarmStart option is set, since its root then
+//  differs from that of a full search by up to its tolerance.
+//
 {
     double q2g = SQR(q) / GRAVITY;
-    double y, r;
+    double y, y0, r;
 
     if ( q2g == 0.0 ) return 0.0;
     switch ( xsect->type )
@@ -1279,8 +1732,15 @@ double xsect_getYcrit(TXsect* xsect, double q)
       default:
         // --- first estimate yCritical for an equivalent circular conduit
         //     using 1.01 * (q2g / yFull)^(1/4)
-        y = 1.01 * pow(q2g / xsect->yFull, 1./4.);
-        if (y >= xsect->yFull) y = 0.97 * xsect->yFull;
+        //     (unless a nearby critical depth can be used)
+        y0 = ( cache && DepthWarmStart ) ? cache->y : 0.0;
+        if ( y0 > 0.0 && y0 < xsect->yFull ) y = y0;
+        else
+        {
+            y0 = 0.0;
+            y = 1.01 * pow(q2g / xsect->yFull, 1./4.);
+            if (y >= xsect->yFull) y = 0.97 * xsect->yFull;
+        }
 
         // --- then find ratio of conduit area to equiv. circular area
         r = xsect->aFull / (PI / 4.0 * SQR(xsect->yFull));
@@ -1288,10 +1748,12 @@ double xsect_getYcrit(TXsect* xsect, double q)
         // --- use interval enumeration method to find yCritical if
         //     area ratio not too far from 1.0
         if ( r >= 0.5 && r <= 2.0 )
-            y = getYcritEnum(xsect, q, y);
+            y = getYcritEnum(xsect, q, y, cache);
 
         // --- otherwise use Ridder's root finding method
-        else y = getYcritRidder(xsect, q, y);
+        else if ( y0 > 0.0 )
+            y = getYcritNear(xsect, q, y0, cache ? &cache->evals : NULL);
+        else y = getYcritRidder(xsect, q, y, cache ? &cache->evals : NULL);
     }
 
     // --- do not allow yCritical to be > yFull
@@ -1300,10 +1762,12 @@ double xsect_getYcrit(TXsect* xsect, double q)
 
 //=============================================================================
 
-double generic_getAofS(TXsect* xsect, double s)
+double generic_getAofS(TXsect* xsect, double s, double a0, long* evals)
 //
 //  Input:   xsect = ptr. to a cross section data structure
 //           s = section factor (ft^8/3)
+//           a0 = starting guess for area (ft2) (or 0 if not available)
+//           evals = count of section factor evaluations (or NULL)
 //  Output:  returns area (ft2)
 //  Purpose: finds area given section factor by
 //           solving S = A*(A/P(A))^(2/3) using Newton-Raphson iterations.
@@ -1333,9 +1797,11 @@ double generic_getAofS(TXsect* xsect, double s)
     // --- place S & xsect in xsectStar for access by evalSofA function
     xsectStar.xsect = xsect;
     xsectStar.s = s;
+    xsectStar.evals = evals;
 
-    // --- compute starting guess for A
-    a = 0.5 * (a1 + a2);
+    // --- compute starting guess for A if none supplied
+    if ( a0 > a1 && a0 < a2 ) a = a0;
+    else a = 0.5 * (a1 + a2);
 
     // use the Newton-Raphson root finder function to find A
     tol = 0.0001 * xsect->aFull;
@@ -1358,6 +1824,7 @@ void evalSofA(double a, double* f, double* df, void* p)
     double s;
 
     xsectStar = (TXsectStar *)p;
+    if ( xsectStar->evals ) (*xsectStar->evals)++;
     s = xsect_getSofA(xsectStar->xsect, a);
     *f = s - xsectStar->s;
     *df = xsect_getdSdA(xsectStar->xsect, a);
@@ -1566,6 +2033,7 @@ double getQcritical(double yc, void* p)
     TXsectStar* xsectStar;
 
     xsectStar = (TXsectStar *)p;
+    if ( xsectStar->evals ) (*xsectStar->evals)++;
     a = xsect_getAofY(xsectStar->xsect, yc);
     w = xsect_getWofY(xsectStar->xsect, yc);
     qc = -xsectStar->qc;
@@ -1575,11 +2043,13 @@ double getQcritical(double yc, void* p)
 
 //=============================================================================
 
-double getYcritEnum(TXsect* xsect, double q, double y0)
+double getYcritEnum(TXsect* xsect, double q, double y0, TDepthCache* cache)
 //
 //  Input:   xsect = ptr. to cross section data structure
 //           q = critical flow rate (cfs)
 //           y0 = estimate of critical depth (ft)
+//           cache = last interval found to hold critical depth
+//                   (or NULL if not available)
 //  Output:  returns true critical depth (ft)
 //  Purpose: solves a * sqrt(a(y)*g / w(y)) - q for y using interval
 //           enumeration with starting guess of y0.
@@ -1589,14 +2059,28 @@ double getYcritEnum(TXsect* xsect, double q, double y0)
     int        i1, i;
     TXsectStar xsectStar;
 
-    // --- divide cross section depth into 25 increments and
-    //     locate increment corresponding to initial guess y0
+    // --- divide cross section depth into 25 increments
     dy = xsect->yFull / 25.;
+
+    // --- interpolate within the cached interval if it holds flow q
+    if ( cache )
+    {
+        if ( q > cache->qLo && q <= cache->qHi )
+        {
+            cache->hits++;
+            return ( (q - cache->qLo) / (cache->qHi - cache->qLo) +
+                     (double)cache->k ) * dy;
+        }
+        cache->qLo = cache->qHi = 0.0;
+    }
+
+    // --- locate increment corresponding to initial guess y0
     i1 = (int)(y0 / dy);
 
     // --- evaluate critical flow at this increment
     xsectStar.xsect = xsect;
     xsectStar.qc = 0.0;
+    xsectStar.evals = cache ? &cache->evals : NULL;
     q0 = getQcritical(i1*dy, &xsectStar);
 
     // --- initial flow lies below target flow
@@ -1612,6 +2096,12 @@ double getYcritEnum(TXsect* xsect, double q, double y0)
             if ( qc >= q )
             {
                 yc = ( (q-q0) / (qc - q0) + (double)(i-1) ) * dy;
+                if ( cache )
+                {
+                    cache->k = i - 1;
+                    cache->qLo = q0;
+                    cache->qHi = qc;
+                }
                 break;
             }
             q0 = qc;
@@ -1631,6 +2121,12 @@ double getYcritEnum(TXsect* xsect, double q, double y0)
             if ( qc < q )
             {
                 yc = ( (q-qc) / (q0-qc) + (double)i ) * dy;
+                if ( cache )
+                {
+                    cache->k = i;
+                    cache->qLo = qc;
+                    cache->qHi = q0;
+                }
                 break;
             }
             q0 = qc;
@@ -1641,11 +2137,12 @@ double getYcritEnum(TXsect* xsect, double q, double y0)
 
 //=============================================================================
 
-double getYcritRidder(TXsect* xsect, double q, double y0)
+double getYcritRidder(TXsect* xsect, double q, double y0, long* evals)
 //
 //  Input:   xsect = ptr. to cross section data structure
 //           q = critical flow rate (cfs)
 //           y0 = estimate of critical depth (ft)
+//           evals = count of critical flow evaluations (or NULL)
 //  Output:  returns true critical depth (ft)
 //  Purpose: solves a * sqrt(a(y)*g / w(y)) - q for y using Ridder's
 //           root finding method with starting guess of y0.
@@ -1660,6 +2157,7 @@ double getYcritRidder(TXsect* xsect, double q, double y0)
     // --- store reference to cross section in global pointer
     xsectStar.xsect = xsect;
     xsectStar.qc = 0.0;
+    xsectStar.evals = evals;
 
     // --- check if critical flow at (nearly) full depth < target flow
     q2 = getQcritical(y2, &xsectStar);
@@ -1691,6 +2189,49 @@ double getYcritRidder(TXsect* xsect, double q, double y0)
     return yc;
 }
 
+//=============================================================================
+
+double getYcritNear(TXsect* xsect, double q, double y0, long* evals)
+//
+//  Input:   xsect = ptr. to cross section data structure
+//           q = critical flow rate (cfs)
+//           y0 = critical depth found for a nearby flow rate (ft)
+//           evals = count of critical flow evaluations (or NULL)
+//  Output:  returns true critical depth (ft)
+//  Purpose: solves a * sqrt(a(y)*g / w(y)) - q for y using Ridder's
+//           root finding method over a narrow interval next to y0.
+//
+{
+    double  yMax = 0.99 * xsect->yFull;
+    double  y1, dy, q0, q1;
+    TXsectStar xsectStar;
+
+    xsectStar.xsect = xsect;
+    xsectStar.qc = 0.0;
+    xsectStar.evals = evals;
+
+    // --- critical flow at y0 must be known to step toward the new root
+    q0 = getQcritical(y0, &xsectStar);
+    if ( q0 <= 0.0 || y0 >= yMax ) return getYcritRidder(xsect, q, y0, evals);
+
+    // --- step from y0 past the new root assuming critical flow
+    //     varies as depth^1.5 (step is enlarged by half for safety)
+    dy = 1.5 * y0 * (pow(q / q0, 2./3.) - 1.0);
+    if ( fabs(dy) < 0.001 ) dy = SIGN(0.001, dy);
+    y1 = y0 + dy;
+    y1 = MAX(y1, 0.0);
+    y1 = MIN(y1, yMax);
+    q1 = getQcritical(y1, &xsectStar);
+
+    // --- use the full search if the interval doesn't contain flow q
+    if ( (q0 - q) * (q1 - q) > 0.0 ) return getYcritRidder(xsect, q, y0, evals);
+
+    // --- find critical depth within the interval to 0.001 ft
+    xsectStar.qc = q;
+    return findroot_Ridder(MIN(y0, y1), MAX(y0, y1), 0.001, getQcritical,
+                           &xsectStar);
+}
+
 
 //=============================================================================
 //  RECT_CLOSED fuctions
@@ -2313,7 +2854,9 @@ double circ_getYofA(TXsect* xsect, double a)
     double alpha = a / xsect->aFull;
 
     // --- use special function for small a/aFull
-    if ( alpha < 0.04 )  return xsect->yFull * getYcircular(alpha);
+    //     (or for all a/aFull if analytic geometry selected)
+    if ( alpha < 0.04 || CircGeometry == ANALYTIC_GEOMETRY )
+        return xsect->yFull * getYcircular(alpha);
 
     // --- otherwise use table
     else return xsect->yFull * lookup(alpha, Y_Circ, N_Y_Circ);
@@ -2326,7 +2869,9 @@ double circ_getAofS(TXsect* xsect, double s)
     if (psi >= 1.0) return xsect->aFull;
 
     // --- use special function for small s/sFull
-    if (psi <= 0.015) return xsect->aFull * getAcircular(psi);
+    //     (or for all s/sFull if analytic geometry selected)
+    if ( psi <= 0.015 || CircGeometry == ANALYTIC_GEOMETRY )
+        return xsect->aFull * getAcircular(psi);
 
     // --- otherwise use table
     else return xsect->aFull * invLookup(psi, S_Circ, N_S_Circ);
@@ -2337,7 +2882,9 @@ double circ_getSofA(TXsect* xsect, double a)
     double alpha = a / xsect->aFull;
 
     // --- use special function for small a/aFull
-    if ( alpha < 0.04 ) return xsect->sFull * getScircular(alpha);
+    //     (or for all a/aFull if analytic geometry selected)
+    if ( alpha < 0.04 || CircGeometry == ANALYTIC_GEOMETRY )
+        return xsect->sFull * getScircular(alpha);
 
     // --- otherwise use table
     else
@@ -2519,6 +3066,7 @@ double getThetaOfAlpha(double alpha)
     int    k;
     double theta, theta1, ap, d;
 
+    if ( CircGeometry == ANALYTIC_GEOMETRY ) return getThetaOfAlphaDirect(alpha);
     if ( alpha > 0.04 ) theta = 1.2 + 5.08 * (alpha - 0.04) / 0.96;
     else theta = 0.031715 - 12.79384 * alpha + 8.28479 * sqrt(alpha);
     theta1 = theta;
@@ -2539,6 +3087,7 @@ double getThetaOfPsi(double psi)
     int    k;
     double theta, theta1, ap, tt, tt23, t3, d;
 
+    if ( CircGeometry == ANALYTIC_GEOMETRY ) return getThetaOfPsiDirect(psi);
     if      (psi > 0.90)  theta = 4.17 + 1.12 * (psi - 0.90) / 0.176;
     else if (psi > 0.5)   theta = 3.14 + 1.03 * (psi - 0.5) / 0.4;
     else if (psi > 0.015) theta = 1.2 + 1.94 * (psi - 0.015) / 0.485;
@@ -2561,4 +3110,118 @@ double getThetaOfPsi(double psi)
     return theta1;
 }
 
+double getThetaOfAlphaDirect(double alpha)
+//
+//  Input:   alpha = a / aFull (0 < alpha < 1)
+//  Output:  returns central angle (radians) subtended by the flow area
+//  Purpose: solves theta - sin(theta) = 2*PI*alpha without iteration.
+//
+//  Series expansions of theta about alpha = 0, 1 and 1/2 give a starting
+//  value accurate to 1e-4 radians which a single Halley step refines to
+//  within 1e-12 radians. Near the ends of the range, where the series alone
+//  are accurate to machine precision, the Halley step is skipped since
+//  round-off in theta - sin(theta) would only degrade the estimate.
+//
+{
+    double a, u, u2, w, w2, theta, f, f1, f2;
+
+    if ( alpha <= 0.0 ) return 0.0;
+    if ( alpha >= 1.0 ) return 2.0 * PI;
+
+    // --- series about theta = 0 (or 2*PI for nearly full sections)
+    a = MIN(alpha, 1.0 - alpha);
+    if ( a < 0.2 )
+    {
+        u = cbrt(12.0 * PI * a);
+        u2 = u * u;
+        theta = u * (1.0 + u2 * (1./60. + u2 * (1./1400. + u2 * (1./25200. +
+                u2 * (43./17248000. + u2 * (1213./7207200000.))))));
+        if ( alpha > 0.5 ) theta = 2.0 * PI - theta;
+        if ( a < 0.001 ) return theta;
+    }
+
+    // --- series about theta = PI
+    else
+    {
+        w = 2.0 * PI * (alpha - 0.5);
+        w2 = w * w;
+        theta = PI + w * (1./2. + w2 * (1./96. + w2 * (1./1920. +
+                w2 * (43./1290240. + w2 * (223./92897280. +
+                w2 * (60623./326998425600.))))));
+    }
+
+    // --- one Halley step
+    f  = theta - sin(theta) - 2.0 * PI * alpha;
+    f1 = 1.0 - cos(theta);
+    f2 = sin(theta);
+    return theta - 2.0 * f * f1 / (2.0 * f1 * f1 - f * f2);
+}
+
+double getThetaOfPsiDirect(double psi)
+//
+//  Input:   psi = s / sFull (0 < psi < 1)
+//  Output:  returns central angle (radians) subtended by the flow area
+//  Purpose: solves (theta - sin(theta))^(5/3) / theta^(2/3) = 2*PI*psi
+//           without iteration.
+//
+//  Theta is fit by Chebyshev series in psi^(3/13) (its leading order
+//  behavior) below psi = 0.3 and in sqrt(CIRC_PSIMAX - psi) (the behavior
+//  near the maximum section factor) above it. One Newton step then brings
+//  the error to within 1e-10 radians.
+//
+{
+    // --- Chebyshev coefficients for theta on each part of the range
+    static const double psiLow[] = {
+        1.2486371964703047,     1.3009287236166502,
+        0.067189418973390105,   0.017458313470416553,
+        0.0032131552325075797,  0.00080906143152042272,
+        0.00019766981991375701, 5.2355399662872007e-05,
+        1.3990681146547162e-05, 3.5879629569341919e-06 };
+    static const double psiHigh[] = {
+         3.6532755091528792,     -0.92423386629338333,
+        -0.064862390436886311,   -0.019412536552370342,
+        -0.0044104588206153933,  -0.0013003715129905836,
+        -0.00037787493137377839, -0.00011730054772325361,
+        -3.6632820222415321e-05, -1.0696150237521351e-05 };
+    double theta, ap, tt, tt23, t3, d;
+
+    if ( psi <= 0.0 ) return 0.0;
+    if ( psi < 0.3 ) theta = chebyshev(psiLow, 10, pow(psi, 3./13.),
+                                       0.0, 0.75741809116425152);
+    else theta = chebyshev(psiHigh, 10, sqrt(MAX(CIRC_PSIMAX - psi, 0.0)),
+                           0.27514746846094196, 0.88074180632036825);
+
+    // --- one Newton step (see getThetaOfPsi)
+    ap   = (2.0*PI) * psi;
+    tt   = theta - sin(theta);
+    tt23 = pow(tt, 2./3.);
+    t3   = pow(theta, 1./3.);
+    d    = ap * theta / t3 - tt * tt23;
+    d    = d / ( ap*(2./3.)/t3 - (5./3.)*tt23*(1.0-cos(theta)) );
+    return theta - d;
+}
+
+double chebyshev(const double c[], int n, double x, double x1, double x2)
+//
+//  Input:   c = array of Chebyshev series coefficients
+//           n = number of coefficients
+//           x = value at which series is evaluated
+//           x1, x2 = interval over which series was fit
+//  Output:  returns value of series at x
+//  Purpose: evaluates a Chebyshev series by Clenshaw's recurrence.
+//
+{
+    int    k;
+    double t = (2.0 * x - x1 - x2) / (x2 - x1);
+    double b0 = 0.0, b1 = 0.0, b2;
+
+    for (k = n - 1; k >= 1; k--)
+    {
+        b2 = b1;
+        b1 = b0;
+        b0 = 2.0 * t * b1 - b2 + c[k];
+    }
+    return t * b0 - b1 + c[0];
+}
+
 //=============================================================================
@@ -16,10 +16,14 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <string>
 #include <math.h>
+#include <thread>
+#include <vector>
 
 #include "swmm5.h"
+#include "toolkitAPI.h"
 
 
 // NOTE: Test Input File
@@ -31,6 +35,18 @@
 #define DATA_PATH_RPT2 "./swmm_api_test2.rpt"
 #define DATA_PATH_OUT2 "./swmm_api_test2.out"
 
+#define DATA_PATH_RPT_A "./swmm_api_test_a.rpt"
+#define DATA_PATH_OUT_A "./swmm_api_test_a.out"
+#define DATA_PATH_RPT_B "./swmm_api_test_b.rpt"
+#define DATA_PATH_OUT_B "./swmm_api_test_b.out"
+
+// NOTE: Dynamic wave test input file with conduits of several shapes
+#define DATA_PATH_INP_DW "./swmm_dw_test.inp"
+#define DATA_PATH_INP_OPT "./swmm_option_test.inp"
+
+// NOTE: Generated dynamic wave test input file (see writeTree)
+#define DATA_PATH_INP_TREE "./swmm_tree_test.inp"
+
 using namespace std;
 
 // Custom test to check the minimum number of correct decimal digits between
@@ -170,3 +186,914 @@ BOOST_FIXTURE_TEST_CASE(FailStart403, FixtureBeforeStart) {
 
 
 BOOST_AUTO_TEST_SUITE_END()
+
+
+// Runs a project to completion through the re-entrant API
+static int runProject(SWMM_Project ph, const char* rpt, const char* out,
+                      float* flowErr)
+{
+    int error;
+    float runoffErr, qualErr;
+    double elapsedTime = 0.0;
+
+    error = swmm_open_r(ph, (char *)DATA_PATH_INP, (char *)rpt, (char *)out);
+    if (!error) error = swmm_start_r(ph, 0);
+    while (!error)
+    {
+        error = swmm_step_r(ph, &elapsedTime);
+        if (elapsedTime == 0) break;
+    }
+    if (!error) error = swmm_end_r(ph);
+    swmm_getMassBalErr_r(ph, &runoffErr, flowErr, &qualErr);
+    swmm_close_r(ph);
+    return error;
+}
+
+BOOST_AUTO_TEST_SUITE(test_swmm_project)
+
+BOOST_AUTO_TEST_CASE(ConcurrentProjects) {
+    SWMM_Project pa, pb;
+    float flowErr, flowErrA = -1.0f, flowErrB = -1.0f;
+    int errorA = -1, errorB = -1;
+
+    BOOST_REQUIRE(swmm_createProject(&pa) == 0);
+    BOOST_REQUIRE(swmm_createProject(&pb) == 0);
+
+    // --- reference result from the default project
+    BOOST_REQUIRE(runProject(NULL, DATA_PATH_RPT, DATA_PATH_OUT, &flowErr) == 0);
+
+    std::thread ta([&] {
+        errorA = runProject(pa, DATA_PATH_RPT_A, DATA_PATH_OUT_A, &flowErrA);
+    });
+    std::thread tb([&] {
+        errorB = runProject(pb, DATA_PATH_RPT_B, DATA_PATH_OUT_B, &flowErrB);
+    });
+    ta.join();
+    tb.join();
+
+    BOOST_CHECK_EQUAL(0, errorA);
+    BOOST_CHECK_EQUAL(0, errorB);
+    BOOST_CHECK_EQUAL(flowErr, flowErrA);
+    BOOST_CHECK_EQUAL(flowErr, flowErrB);
+
+    BOOST_CHECK_EQUAL(0, swmm_deleteProject(pa));
+    BOOST_CHECK_EQUAL(0, swmm_deleteProject(pb));
+}
+
+BOOST_AUTO_TEST_CASE(InterleavedProjects) {
+    SWMM_Project ph;
+    double elapsedTime = 0.0;
+
+    BOOST_REQUIRE(swmm_createProject(&ph) == 0);
+    BOOST_REQUIRE(swmm_open((char *)DATA_PATH_INP, (char *)DATA_PATH_RPT,
+                            (char *)DATA_PATH_OUT) == 0);
+    BOOST_REQUIRE(swmm_open_r(ph, (char *)DATA_PATH_INP,
+                              (char *)DATA_PATH_RPT_A, (char *)DATA_PATH_OUT_A) == 0);
+    BOOST_CHECK_EQUAL(0, swmm_start_r(ph, 0));
+
+    // --- default project is still unstarted
+    BOOST_CHECK_EQUAL(403, swmm_step(&elapsedTime));
+    BOOST_CHECK_EQUAL(0, swmm_step_r(ph, &elapsedTime));
+
+    swmm_end_r(ph);
+    swmm_close();
+    BOOST_CHECK_EQUAL(0, swmm_deleteProject(ph));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+
+// Runs an opened scenario project to completion
+static int runScenario(SWMM_Project ph, float* runoffErr, float* flowErr)
+{
+    int error;
+    float qualErr;
+    double elapsedTime = 0.0;
+
+    error = swmm_start_r(ph, 0);
+    while (!error)
+    {
+        error = swmm_step_r(ph, &elapsedTime);
+        if (elapsedTime == 0) break;
+    }
+    if (!error) error = swmm_end_r(ph);
+    swmm_getMassBalErr_r(ph, runoffErr, flowErr, &qualErr);
+    return error;
+}
+
+BOOST_AUTO_TEST_SUITE(test_swmm_scenario)
+
+BOOST_AUTO_TEST_CASE(FailCreate403) {
+    SWMM_Project base, scn;
+
+    BOOST_REQUIRE(swmm_createProject(&base) == 0);
+    BOOST_CHECK_EQUAL(403, swmm_createScenario(base, &scn,
+        (char *)DATA_PATH_RPT_A, (char *)DATA_PATH_OUT_A));
+    BOOST_CHECK(scn == NULL);
+    BOOST_CHECK_EQUAL(0, swmm_deleteProject(base));
+}
+
+BOOST_AUTO_TEST_CASE(ScenariosShareBase) {
+    SWMM_Project base, sa, sb;
+    float runoffErr, flowErr;
+    float runoffErrA = -1.0f, flowErrA = -1.0f;
+    float runoffErrB = -1.0f, flowErrB = -1.0f;
+    int errorA = -1, errorB = -1;
+
+    // --- reference result from a plain run
+    BOOST_REQUIRE(swmm_open((char *)DATA_PATH_INP, (char *)DATA_PATH_RPT,
+                            (char *)DATA_PATH_OUT) == 0);
+    BOOST_REQUIRE(runScenario(NULL, &runoffErr, &flowErr) == 0);
+    swmm_close();
+
+    BOOST_REQUIRE(swmm_createProject(&base) == 0);
+    BOOST_REQUIRE(swmm_open_r(base, (char *)DATA_PATH_INP,
+                              (char *)DATA_PATH_RPT, (char *)DATA_PATH_OUT) == 0);
+    BOOST_REQUIRE(swmm_createScenario(base, &sa, (char *)DATA_PATH_RPT_A,
+                                      (char *)DATA_PATH_OUT_A) == 0);
+    BOOST_REQUIRE(swmm_createScenario(base, &sb, (char *)DATA_PATH_RPT_B,
+                                      (char *)DATA_PATH_OUT_B) == 0);
+
+    // --- scenario b gets wider subcatchments
+    SWMM_Project oldPrj = swmm_selectProject(sb);
+    BOOST_CHECK_EQUAL(0, swmm_setSubcatchParam(0, SM_WIDTH, 1500.0));
+    BOOST_CHECK_EQUAL(0, swmm_setSubcatchParam(1, SM_WIDTH, 1500.0));
+    swmm_selectProject(oldPrj);
+
+    std::thread ta([&] { errorA = runScenario(sa, &runoffErrA, &flowErrA); });
+    std::thread tb([&] { errorB = runScenario(sb, &runoffErrB, &flowErrB); });
+    ta.join();
+    tb.join();
+
+    BOOST_CHECK_EQUAL(0, errorA);
+    BOOST_CHECK_EQUAL(0, errorB);
+    BOOST_CHECK_EQUAL(runoffErr, runoffErrA);
+    BOOST_CHECK_EQUAL(flowErr, flowErrA);
+    BOOST_CHECK(runoffErr != runoffErrB);
+
+    // --- a scenario can be re-run and leaves its base unchanged
+    BOOST_CHECK_EQUAL(0, runScenario(sa, &runoffErrA, &flowErrA));
+    BOOST_CHECK_EQUAL(runoffErr, runoffErrA);
+    BOOST_CHECK_EQUAL(0, runScenario(base, &runoffErrA, &flowErrA));
+    BOOST_CHECK_EQUAL(runoffErr, runoffErrA);
+
+    BOOST_CHECK_EQUAL(0, swmm_deleteProject(sa));
+    BOOST_CHECK_EQUAL(0, swmm_deleteProject(sb));
+    BOOST_CHECK_EQUAL(0, swmm_deleteProject(base));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+
+// Steps a running simulation until its elapsed time reaches tEnd (days)
+static int stepTo(double tEnd, double* elapsedTime)
+{
+    int error = 0;
+    while (!error && *elapsedTime < tEnd)
+    {
+        error = swmm_step(elapsedTime);
+        if (*elapsedTime == 0) break;
+    }
+    return error;
+}
+
+// Saves current node heads, link flows and routing totals
+static void getState(std::vector<double>& state)
+{
+    int j, nNodes, nLinks;
+    double x;
+    SM_RoutingTotals totals;
+
+    state.clear();
+    swmm_countObjects(SM_NODE, &nNodes);
+    swmm_countObjects(SM_LINK, &nLinks);
+    for (j = 0; j < nNodes; j++)
+    {
+        swmm_getNodeResult(j, SM_NODEHEAD, &x);
+        state.push_back(x);
+    }
+    for (j = 0; j < nLinks; j++)
+    {
+        swmm_getLinkResult(j, SM_LINKFLOW, &x);
+        state.push_back(x);
+    }
+    swmm_getSystemRoutingStats(&totals);
+    state.push_back(totals.wwInflow);
+    state.push_back(totals.flooding);
+    state.push_back(totals.outflow);
+}
+
+BOOST_AUTO_TEST_SUITE(test_swmm_snapshot)
+
+BOOST_AUTO_TEST_CASE(RestoreRepeatsRun) {
+    double elapsedTime = 0.0;
+    double tSnapshot, tEnd;
+    std::vector<double> state1, state2;
+    SWMM_Snapshot sh;
+
+    BOOST_REQUIRE(swmm_open((char *)DATA_PATH_INP, (char *)DATA_PATH_RPT,
+                            (char *)DATA_PATH_OUT) == 0);
+    BOOST_CHECK_EQUAL(503, swmm_snapshot(&sh));
+    BOOST_REQUIRE(swmm_start(0) == 0);
+
+    // --- take a snapshot partway through the storm and run on from it
+    BOOST_REQUIRE(stepTo(0.1, &elapsedTime) == 0);
+    tSnapshot = elapsedTime;
+    BOOST_REQUIRE(swmm_snapshot(&sh) == 0);
+    BOOST_REQUIRE(stepTo(0.2, &elapsedTime) == 0);
+    tEnd = elapsedTime;
+    getState(state1);
+
+    // --- re-running from the snapshot gives identical results, twice over
+    BOOST_CHECK_EQUAL(0, swmm_restore(sh));
+    elapsedTime = tSnapshot;
+    BOOST_REQUIRE(stepTo(0.2, &elapsedTime) == 0);
+    BOOST_CHECK_EQUAL(tEnd, elapsedTime);
+    getState(state2);
+    BOOST_CHECK(state1 == state2);
+
+    BOOST_CHECK_EQUAL(0, swmm_restore(sh));
+    elapsedTime = tSnapshot;
+    BOOST_REQUIRE(stepTo(0.2, &elapsedTime) == 0);
+    getState(state2);
+    BOOST_CHECK(state1 == state2);
+
+    // --- a snapshot only applies to the run it was taken in
+    BOOST_CHECK_EQUAL(0, swmm_end());
+    BOOST_CHECK_EQUAL(503, swmm_restore(sh));
+    BOOST_REQUIRE(swmm_start(0) == 0);
+    BOOST_CHECK_EQUAL(512, swmm_restore(sh));
+    BOOST_CHECK_EQUAL(512, swmm_updateSnapshot(sh));
+    BOOST_CHECK_EQUAL(0, swmm_end());
+    BOOST_CHECK_EQUAL(0, swmm_deleteSnapshot(sh));
+    swmm_close();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+
+// Writes a copy of an input file with an extra analysis option
+static void addOption(const char* inpFile, const char* newFile, const char* option)
+{
+    char line[1024];
+    FILE* fin = fopen(inpFile, "rt");
+    FILE* fout = fopen(newFile, "wt");
+    while (fgets(line, sizeof(line), fin))
+    {
+        fputs(line, fout);
+        if (strncmp(line, "[OPTIONS]", 9) == 0) fprintf(fout, "%s\n", option);
+    }
+    fclose(fin);
+    fclose(fout);
+}
+
+// Saves the network as seen through the toolkit API along with the
+// state of the system after running it for a day
+static void getNetwork(const char* inpFile, std::vector<std::string>& ids,
+                       std::vector<int>& connections, std::vector<double>& state)
+{
+    int j, n1, n2, type, nSubcatch, nNodes, nLinks;
+    double elapsedTime = 0.0;
+    char id[64];
+
+    ids.clear();
+    connections.clear();
+    BOOST_REQUIRE(swmm_open((char *)inpFile, (char *)DATA_PATH_RPT,
+                            (char *)DATA_PATH_OUT) == 0);
+    swmm_countObjects(SM_SUBCATCH, &nSubcatch);
+    swmm_countObjects(SM_NODE, &nNodes);
+    swmm_countObjects(SM_LINK, &nLinks);
+    for (j = 0; j < nNodes; j++)
+    {
+        swmm_getObjectId(SM_NODE, j, id);
+        ids.push_back(id);
+        swmm_getObjectIndex(SM_NODE, id, &n1);
+        BOOST_CHECK_EQUAL(j, n1);
+    }
+    for (j = 0; j < nLinks; j++)
+    {
+        swmm_getObjectId(SM_LINK, j, id);
+        ids.push_back(id);
+        swmm_getObjectIndex(SM_LINK, id, &n1);
+        BOOST_CHECK_EQUAL(j, n1);
+        swmm_getLinkConnections(j, &n1, &n2);
+        connections.push_back(n1);
+        connections.push_back(n2);
+    }
+    for (j = 0; j < nSubcatch; j++)
+    {
+        swmm_getSubcatchOutConnection(j, &type, &n1);
+        connections.push_back(n1);
+    }
+    BOOST_REQUIRE(swmm_start(0) == 0);
+    BOOST_REQUIRE(stepTo(1.0, &elapsedTime) == 0);
+    getState(state);
+    swmm_end();
+    swmm_close();
+}
+
+BOOST_AUTO_TEST_SUITE(test_swmm_network_order)
+
+BOOST_AUTO_TEST_CASE(RenumberingIsTransparent) {
+    const char* rcmFile = "./swmm_api_test_rcm.inp";
+    std::vector<std::string> ids1, ids2;
+    std::vector<int> connections1, connections2;
+    std::vector<double> state1, state2;
+    size_t j;
+
+    // --- objects keep their input file indexes when renumbered internally
+    addOption(DATA_PATH_INP, rcmFile, "NETWORK_ORDER RCM");
+    getNetwork(DATA_PATH_INP, ids1, connections1, state1);
+    getNetwork(rcmFile, ids2, connections2, state2);
+    remove(rcmFile);
+    BOOST_CHECK(ids1 == ids2);
+    BOOST_CHECK(connections1 == connections2);
+
+    // --- and give the same results
+    BOOST_REQUIRE_EQUAL(state1.size(), state2.size());
+    for (j = 0; j < state1.size(); j++)
+        BOOST_CHECK_SMALL(state1[j] - state2[j], 1.0e-6 * (1.0 + fabs(state1[j])));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+
+// Continuity errors, routing totals, peak link flows and peak & total
+// subcatchment runoff of a complete run
+struct RunResults
+{
+    float  runoffErr;
+    float  flowErr;
+    float  qualErr;
+    double inflow;
+    double flooding;
+    double outflow;
+    std::vector<double> peakFlow;
+    std::vector<double> peakRunoff;
+    std::vector<double> runoff;
+};
+
+static int getResults(const char* inpFile, RunResults& results)
+{
+    int j, error, nLinks, nSubcatch;
+    double elapsedTime = 0.0;
+    SM_RoutingTotals totals;
+    SM_LinkStats linkStats;
+    SM_SubcatchStats* subcatchStats = NULL;
+
+    error = swmm_open((char *)inpFile, (char *)DATA_PATH_RPT, (char *)DATA_PATH_OUT);
+    if (!error) error = swmm_start(0);
+    while (!error)
+    {
+        error = swmm_step(&elapsedTime);
+        if (elapsedTime == 0) break;
+    }
+    if (!error)
+    {
+        swmm_getSystemRoutingStats(&totals);
+        results.inflow = totals.wwInflow;
+        results.flooding = totals.flooding;
+        results.outflow = totals.outflow;
+        results.peakFlow.clear();
+        swmm_countObjects(SM_LINK, &nLinks);
+        for (j = 0; j < nLinks; j++)
+        {
+            swmm_getLinkStats(j, &linkStats);
+            results.peakFlow.push_back(linkStats.maxFlow);
+        }
+        results.peakRunoff.clear();
+        results.runoff.clear();
+        swmm_countObjects(SM_SUBCATCH, &nSubcatch);
+        for (j = 0; j < nSubcatch; j++)
+        {
+            swmm_getSubcatchStats(j, &subcatchStats);
+            results.peakRunoff.push_back(subcatchStats->maxFlow);
+            results.runoff.push_back(subcatchStats->runoff);
+            freeArray((void**)&subcatchStats);
+        }
+        error = swmm_end();
+    }
+    swmm_getMassBalErr(&results.runoffErr, &results.flowErr, &results.qualErr);
+    swmm_close();
+    return error;
+}
+
+static bool sameResults(const RunResults& a, const RunResults& b,
+                        double errTol, double totalTol)
+{
+    return fabs(a.runoffErr - b.runoffErr) <= errTol &&
+           fabs(a.flowErr - b.flowErr) <= errTol &&
+           fabs(a.qualErr - b.qualErr) <= errTol &&
+           fabs(a.inflow - b.inflow) <= totalTol * fabs(b.inflow) &&
+           fabs(a.flooding - b.flooding) <= totalTol * fabs(b.flooding) &&
+           fabs(a.outflow - b.outflow) <= totalTol * fabs(b.outflow);
+}
+
+BOOST_AUTO_TEST_SUITE(test_swmm_results)
+
+BOOST_AUTO_TEST_CASE(MatchesReferenceRun) {
+    // --- results of the engine before parallel runoff was added, built
+    //     with IEEE arithmetic (-O3) and with fast-math (-Ofast)
+    const RunResults ref[2] = {
+        {-0.271728814f,  0.102537356f, -0.152406216f,
+         274225.862792, 18057.4982314, 255873.767828},
+        {-0.271728814f, -0.0235736612f, -0.27910769f,
+         274225.862792, 18062.0972119, 256214.997876}
+    };
+    RunResults results;
+
+    BOOST_REQUIRE(getResults(DATA_PATH_INP, results) == 0);
+    BOOST_CHECK(sameResults(results, ref[0], 1.0e-4, 1.0e-6) ||
+                sameResults(results, ref[1], 1.0e-4, 1.0e-6));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+
+// Writes an input file for dynamic wave routing through a binary tree of
+// conduits of several shapes draining to an outfall, with an orifice, a
+// weir and a storage unit near the outfall and a subcatchment on each
+// junction. Subcatchment and conduit properties are drawn from a fixed
+// pseudo-random sequence.
+static unsigned TreeSeed;
+
+static double treeUniform(double a, double b)
+{
+    TreeSeed = TreeSeed * 1103515245u + 12345u;
+    return a + (b - a) * ((TreeSeed >> 8) & 0xFFFF) / 65536.0;
+}
+
+static void writeTree(const char* inpFile, int nNodes, const char* option)
+{
+    int i, level;
+    double d;
+    FILE* f = fopen(inpFile, "wt");
+
+    TreeSeed = 1;
+    fprintf(f, "[OPTIONS]\n"
+               "FLOW_UNITS CFS\nINFILTRATION HORTON\nFLOW_ROUTING DYNWAVE\n"
+               "START_DATE 01/01/2000\nSTART_TIME 00:00:00\n"
+               "REPORT_START_DATE 01/01/2000\nREPORT_START_TIME 00:00:00\n"
+               "END_DATE 01/01/2000\nEND_TIME 06:00:00\n"
+               "REPORT_STEP 00:15:00\nWET_STEP 00:01:00\nDRY_STEP 00:05:00\n"
+               "ROUTING_STEP 0:00:05\nVARIABLE_STEP 0.75\nTHREADS 1\n%s\n\n",
+               option);
+    fprintf(f, "[RAINGAGES]\nRG1 INTENSITY 0:05 1.0 TIMESERIES TS1\n\n");
+    fprintf(f, "[TIMESERIES]\nTS1 0:00 0.0\nTS1 1:00 0.5\nTS1 2:00 1.5\n"
+               "TS1 3:00 0.8\nTS1 4:00 0.2\nTS1 5:00 0.0\n\n");
+
+    fprintf(f, "[SUBCATCHMENTS]\n");
+    for (i = 0; i < nNodes; i++)
+    {
+        double area = treeUniform(1, 10), imperv = treeUniform(20, 80);
+        double width = treeUniform(200, 800), slope = treeUniform(0.5, 3);
+        fprintf(f, "S%d RG1 J%d %.2f %.1f %.0f %.2f 0\n", i, i, area, imperv,
+                width, slope);
+    }
+    fprintf(f, "\n[SUBAREAS]\n");
+    for (i = 0; i < nNodes; i++)
+        fprintf(f, "S%d 0.01 0.1 0.05 0.05 25 OUTLET\n", i);
+    fprintf(f, "\n[INFILTRATION]\n");
+    for (i = 0; i < nNodes; i++) fprintf(f, "S%d 3.0 0.5 4 7 0\n", i);
+
+    // --- junction i drains to junction (i-1)/2 through conduit i, except
+    //     for an orifice from junction 3 & a weir from junction 4, and
+    //     junction 0 drains to the outfall; inverts drop & conduit sizes
+    //     grow toward the outfall
+    fprintf(f, "\n[JUNCTIONS]\n");
+    for (i = 0; i < nNodes; i++)
+    {
+        if (i == 5) continue;
+        for (level = 0; (2 << level) <= i + 1; level++);
+        fprintf(f, "J%d %.2f 6 0 0 0\n", i, 100.0 + level);
+    }
+    fprintf(f, "\n[OUTFALLS]\nOUT1 98 FREE NO\n");
+    fprintf(f, "\n[STORAGE]\nJ5 102.00 10 0 FUNCTIONAL 1000 0 0 0 0\n");
+    fprintf(f, "\n[CONDUITS]\n");
+    for (i = 0; i < nNodes; i++)
+    {
+        double length = treeUniform(200, 500);
+        if (i == 3 || i == 4) continue;
+        if (i == 0) fprintf(f, "C0 J0 OUT1 %.0f 0.013 0 0 0 0\n", length);
+        else fprintf(f, "C%d J%d J%d %.0f 0.013 0 0 0 0\n", i, i, (i - 1) / 2,
+                     length);
+    }
+    fprintf(f, "\n[ORIFICES]\nC3 J3 J1 SIDE 0 0.65 NO 0\n");
+    fprintf(f, "\n[WEIRS]\nC4 J4 J1 TRANSVERSE 0 3.33 NO 0 0 YES\n");
+    fprintf(f, "\n[XSECTIONS]\nC3 RECT_CLOSED 1 1 0 0\nC4 RECT_OPEN 1 3 0 0\n");
+    for (i = 0; i < nNodes; i++)
+    {
+        if (i == 3 || i == 4) continue;
+        for (level = 0; (2 << level) <= i + 1; level++);
+        d = 1.0 + 0.125 * (level < 12 ? 12 - level : 0);
+        if (i % 3) fprintf(f, "C%d CIRCULAR %.2f 0 0 0 1\n", i, d);
+        else if (i % 2) fprintf(f, "C%d TRAPEZOIDAL %.2f 2 1 1 1\n", i, d);
+        else fprintf(f, "C%d RECT_OPEN %.2f 2 0 0 1\n", i, d);
+    }
+    fclose(f);
+}
+
+// Iterations per time step, percent of time steps not converging,
+// (with the PREDICTOR option) percent of time steps predicted & percent of
+// those done in one trial and (with the CACHESTATS report option) function
+// evaluations per critical & normal depth solved for, as listed in the
+// Routing Time Step Summary of a run's report
+struct RoutingStats
+{
+    double iterations;
+    double notConverging;
+    double predicted;
+    double confirmed;
+    double critEvals;
+    double normEvals;
+};
+
+static int getRoutingStats(const char* inpFile, RoutingStats& stats)
+{
+    char line[256];
+    const char* p;
+    FILE* f;
+    int error = swmm_run((char *)inpFile, (char *)DATA_PATH_RPT,
+                         (char *)DATA_PATH_OUT);
+
+    stats.iterations = -1.0;
+    stats.notConverging = -1.0;
+    stats.predicted = -1.0;
+    stats.confirmed = -1.0;
+    stats.critEvals = -1.0;
+    stats.normEvals = -1.0;
+    if (error) return error;
+    f = fopen(DATA_PATH_RPT, "rt");
+    while (fgets(line, sizeof(line), f))
+    {
+        if ((p = strchr(line, ':')) == NULL) continue;
+        if (strstr(line, "Average Iterations per Step"))
+            sscanf(p + 1, "%lf", &stats.iterations);
+        else if (strstr(line, "Percent Not Converging"))
+            sscanf(p + 1, "%lf", &stats.notConverging);
+        else if (strstr(line, "Percent Steps Predicted"))
+            sscanf(p + 1, "%lf", &stats.predicted);
+        else if (strstr(line, "Pct. Predictions Confirmed"))
+            sscanf(p + 1, "%lf", &stats.confirmed);
+        else if (strstr(line, "Crit. Depth Evals per Solve"))
+            sscanf(p + 1, "%lf", &stats.critEvals);
+        else if (strstr(line, "Norm. Depth Evals per Solve"))
+            sscanf(p + 1, "%lf", &stats.normEvals);
+    }
+    fclose(f);
+    return 0;
+}
+
+BOOST_AUTO_TEST_SUITE(test_swmm_options)
+
+BOOST_AUTO_TEST_CASE(DepthWarmStart) {
+    const char* coldFile = "./swmm_option_test_cold.inp";
+    RoutingStats cold, warm;
+    RunResults results1, results2;
+    FILE* f;
+
+    // --- normal depths of the non-circular conduits take fewer section
+    //     factor evaluations when solved from the last one found
+    addOption(DATA_PATH_INP_DW, coldFile, "DEPTH_WARM_START NO");
+    addOption(DATA_PATH_INP_DW, DATA_PATH_INP_OPT, "DEPTH_WARM_START YES");
+    f = fopen(coldFile, "at");
+    fprintf(f, "\n[REPORT]\nCACHESTATS YES\n");
+    fclose(f);
+    f = fopen(DATA_PATH_INP_OPT, "at");
+    fprintf(f, "\n[REPORT]\nCACHESTATS YES\n");
+    fclose(f);
+    BOOST_REQUIRE(getRoutingStats(coldFile, cold) == 0);
+    BOOST_REQUIRE(getRoutingStats(DATA_PATH_INP_OPT, warm) == 0);
+    BOOST_REQUIRE(cold.normEvals > 1.0);
+    BOOST_CHECK_LT(warm.normEvals, 0.5 * cold.normEvals);
+    BOOST_CHECK_LE(warm.critEvals, cold.critEvals);
+
+    // --- while converging to the same depths
+    BOOST_REQUIRE(getResults(coldFile, results1) == 0);
+    BOOST_REQUIRE(getResults(DATA_PATH_INP_OPT, results2) == 0);
+    remove(coldFile);
+    remove(DATA_PATH_INP_OPT);
+    BOOST_CHECK(sameResults(results1, results2, 0.01, 1.0e-3));
+}
+
+BOOST_AUTO_TEST_CASE(SolverNewton) {
+    RoutingStats picard, newton;
+    RunResults results1, results2;
+
+    // --- with fixed time steps 4 times longer than the variable ones,
+    //     fewer steps fail to converge than with Picard iterations
+    writeTree(DATA_PATH_INP_TREE, 255,
+              "VARIABLE_STEP 0\nROUTING_STEP 0:00:20\nSOLVER_METHOD PICARD");
+    BOOST_REQUIRE(getRoutingStats(DATA_PATH_INP_TREE, picard) == 0);
+    BOOST_REQUIRE(getResults(DATA_PATH_INP_TREE, results1) == 0);
+    writeTree(DATA_PATH_INP_TREE, 255,
+              "VARIABLE_STEP 0\nROUTING_STEP 0:00:20\nSOLVER_METHOD NEWTON");
+    BOOST_REQUIRE(getRoutingStats(DATA_PATH_INP_TREE, newton) == 0);
+    BOOST_REQUIRE(getResults(DATA_PATH_INP_TREE, results2) == 0);
+    remove(DATA_PATH_INP_TREE);
+    BOOST_CHECK_LT(newton.notConverging, 0.5 * picard.notConverging);
+
+    // --- and flow continuity holds where Picard iterations lose it
+    BOOST_CHECK_GT(fabs(results1.flowErr), 1.0f);
+    BOOST_CHECK_LT(fabs(results2.flowErr), 0.5f);
+}
+
+BOOST_AUTO_TEST_CASE(SolverAnderson) {
+    RoutingStats picard, anderson;
+    RunResults results1, results2;
+
+    // --- fewer iterations per time step than with Picard iterations alone
+    writeTree(DATA_PATH_INP_TREE, 511, "SOLVER_METHOD PICARD");
+    BOOST_REQUIRE(getRoutingStats(DATA_PATH_INP_TREE, picard) == 0);
+    writeTree(DATA_PATH_INP_TREE, 511, "SOLVER_METHOD ANDERSON");
+    BOOST_REQUIRE(getRoutingStats(DATA_PATH_INP_TREE, anderson) == 0);
+    remove(DATA_PATH_INP_TREE);
+    BOOST_REQUIRE(picard.iterations > 2.0);
+    BOOST_CHECK_LT(anderson.iterations, 0.95 * picard.iterations);
+
+    // --- with no loss of flow continuity
+    addOption(DATA_PATH_INP_DW, DATA_PATH_INP_OPT, "SOLVER_METHOD ANDERSON");
+    BOOST_REQUIRE(getResults(DATA_PATH_INP_DW, results1) == 0);
+    BOOST_REQUIRE(getResults(DATA_PATH_INP_OPT, results2) == 0);
+    remove(DATA_PATH_INP_OPT);
+    BOOST_CHECK_LE(fabs(results2.flowErr), fabs(results1.flowErr) + 0.01f);
+}
+
+// Adds a constant base flow into every junction of a tree written by
+// writeTree()
+static void addBaseFlow(const char* inpFile, int nNodes)
+{
+    int i;
+    FILE* f = fopen(inpFile, "at");
+
+    fprintf(f, "\n[INFLOWS]\n");
+    for (i = 0; i < nNodes; i++)
+    {
+        if (i == 5) continue;
+        fprintf(f, "J%d FLOW \"\" FLOW 1.0 1.0 0.05\n", i);
+    }
+    fclose(f);
+}
+
+BOOST_AUTO_TEST_CASE(ActiveSetBaseFlow) {
+    RunResults settled, visited;
+
+    // --- with the ACTIVE_SET option, nodes & conduits that settle at a
+    //     steady base flow are left out of the iterations with little
+    //     change from the results of visiting every node & conduit
+    writeTree(DATA_PATH_INP_TREE, 255, "END_TIME 12:00:00\nACTIVE_SET YES");
+    addBaseFlow(DATA_PATH_INP_TREE, 255);
+    BOOST_REQUIRE(getResults(DATA_PATH_INP_TREE, settled) == 0);
+    writeTree(DATA_PATH_INP_TREE, 255, "END_TIME 12:00:00");
+    addBaseFlow(DATA_PATH_INP_TREE, 255);
+    BOOST_REQUIRE(getResults(DATA_PATH_INP_TREE, visited) == 0);
+    remove(DATA_PATH_INP_TREE);
+    BOOST_CHECK(sameResults(settled, visited, 0.05, 0.01));
+    BOOST_CHECK_CLOSE(settled.peakFlow[0], visited.peakFlow[0], 0.1);
+}
+
+// Writes an input file for kinematic wave routing through twin chains of
+// conduits, one of circular conduits and one of custom conduits whose
+// shape curve traces the same circles, with a subcatchment on each
+// junction. Link 2i of the file is the i-th circular conduit and link
+// 2i+1 is its custom twin.
+static void writeTwinChains(const char* inpFile, int nLinks, const char* option)
+{
+    int i, k;
+    double y;
+    FILE* f = fopen(inpFile, "wt");
+
+    fprintf(f, "[OPTIONS]\n"
+               "FLOW_UNITS CFS\nINFILTRATION HORTON\nFLOW_ROUTING KINWAVE\n"
+               "START_DATE 01/01/2000\nSTART_TIME 00:00:00\n"
+               "REPORT_START_DATE 01/01/2000\nREPORT_START_TIME 00:00:00\n"
+               "END_DATE 01/01/2000\nEND_TIME 06:00:00\n"
+               "REPORT_STEP 00:15:00\nWET_STEP 00:01:00\nDRY_STEP 00:05:00\n"
+               "ROUTING_STEP 0:00:30\n%s\n\n", option);
+    fprintf(f, "[RAINGAGES]\nRG1 INTENSITY 0:05 1.0 TIMESERIES TS1\n\n");
+    fprintf(f, "[TIMESERIES]\nTS1 0:00 0.0\nTS1 1:00 0.5\nTS1 2:00 1.5\n"
+               "TS1 3:00 0.8\nTS1 4:00 0.2\nTS1 5:00 0.0\n\n");
+    fprintf(f, "[SUBCATCHMENTS]\n");
+    for (i = 0; i < nLinks; i++)
+    {
+        fprintf(f, "SA%d RG1 A%d %d 50 400 1 0\n", i, i, 2 + i % 5);
+        fprintf(f, "SB%d RG1 B%d %d 50 400 1 0\n", i, i, 2 + i % 5);
+    }
+    fprintf(f, "\n[SUBAREAS]\n");
+    for (i = 0; i < nLinks; i++)
+    {
+        fprintf(f, "SA%d 0.01 0.1 0.05 0.05 25 OUTLET\n", i);
+        fprintf(f, "SB%d 0.01 0.1 0.05 0.05 25 OUTLET\n", i);
+    }
+    fprintf(f, "\n[INFILTRATION]\n");
+    for (i = 0; i < nLinks; i++)
+        fprintf(f, "SA%d 3.0 0.5 4 7 0\nSB%d 3.0 0.5 4 7 0\n", i, i);
+
+    fprintf(f, "\n[JUNCTIONS]\n");
+    for (i = 0; i < nLinks; i++)
+        fprintf(f, "A%d %d 6 0 0 0\nB%d %d 6 0 0 0\n", i, 10 + nLinks - i,
+                i, 10 + nLinks - i);
+    fprintf(f, "\n[OUTFALLS]\nOA 9 FREE NO\nOB 9 FREE NO\n");
+    fprintf(f, "\n[CONDUITS]\n");
+    for (i = 0; i < nLinks - 1; i++)
+        fprintf(f, "AL%d A%d A%d 400 0.013 0 0 0 0\n"
+                   "BL%d B%d B%d 400 0.013 0 0 0 0\n", i, i, i + 1, i, i, i + 1);
+    fprintf(f, "AL%d A%d OA 400 0.013 0 0 0 0\n"
+               "BL%d B%d OB 400 0.013 0 0 0 0\n", i, i, i, i);
+    fprintf(f, "\n[XSECTIONS]\n");
+    for (i = 0; i < nLinks; i++)
+        fprintf(f, "AL%d CIRCULAR %.2f 0 0 0 1\nBL%d CUSTOM %.2f CIRCLE 0 0 1\n",
+                i, 1.0 + 0.25 * i, i, 1.0 + 0.25 * i);
+
+    // --- width / full depth of a circle at 49 relative depths
+    fprintf(f, "\n[CURVES]\n");
+    for (k = 1; k < 50; k++)
+    {
+        y = k / 50.0;
+        fprintf(f, "CIRCLE %s %.4f %.5f\n", k == 1 ? "SHAPE" : "", y,
+                2.0 * sqrt(y * (1.0 - y)));
+    }
+    fclose(f);
+}
+
+// Checks if a line of the last report written contains some text
+static bool reportHas(const char* text)
+{
+    char line[256];
+    bool found = false;
+    FILE* f = fopen(DATA_PATH_RPT, "rt");
+    if (f == NULL) return false;
+    while (!found && fgets(line, sizeof(line), f))
+        found = (strstr(line, text) != NULL);
+    fclose(f);
+    return found;
+}
+
+// Largest relative difference between the peak flows of the custom
+// conduits of writeTwinChains and their circular twins
+static double twinPeakDiff(const RunResults& results)
+{
+    size_t j;
+    double diff = 0.0;
+    for (j = 0; j + 1 < results.peakFlow.size(); j += 2)
+        diff = fmax(diff, fabs(results.peakFlow[j + 1] - results.peakFlow[j]) /
+                          results.peakFlow[j]);
+    return diff;
+}
+
+BOOST_AUTO_TEST_CASE(DenseTableSize) {
+    RunResults standard, dense;
+
+    // --- the circular conduits use the analytic geometry as a reference
+    //     for their custom twins, whose peak flows stay as close to it with
+    //     dense tables as with the standard ones
+    writeTwinChains(DATA_PATH_INP_TREE, 20, "CIRCULAR_GEOMETRY ANALYTIC");
+    BOOST_REQUIRE(getResults(DATA_PATH_INP_TREE, standard) == 0);
+    writeTwinChains(DATA_PATH_INP_TREE, 20,
+                    "CIRCULAR_GEOMETRY ANALYTIC\nDENSE_TABLE_SIZE 5001");
+    BOOST_REQUIRE(getResults(DATA_PATH_INP_TREE, dense) == 0);
+    BOOST_CHECK(reportHas("(1 of 1 sections)"));
+    BOOST_CHECK_LT(twinPeakDiff(standard), 0.01);
+    BOOST_CHECK_LT(twinPeakDiff(dense), twinPeakDiff(standard) + 0.001);
+    BOOST_CHECK(sameResults(dense, standard, 0.01f, 1.0e-3));
+
+    // --- tables too coarse to interpolate the circle's crown within
+    //     tolerance are not used
+    writeTwinChains(DATA_PATH_INP_TREE, 20,
+                    "CIRCULAR_GEOMETRY ANALYTIC\nDENSE_TABLE_SIZE 1001");
+    BOOST_REQUIRE(getResults(DATA_PATH_INP_TREE, dense) == 0);
+    remove(DATA_PATH_INP_TREE);
+    BOOST_CHECK(reportHas("(0 of 1 sections)"));
+    BOOST_CHECK(sameResults(dense, standard, 0.0f, 0.0));
+}
+
+BOOST_AUTO_TEST_CASE(CircularGeometry) {
+    RunResults tabular, analytic;
+
+    // --- with the analytic geometry the circular conduits agree with
+    //     their custom twins, whose shape curve gives an independent
+    //     estimate of circular geometry, better than with the tables
+    writeTwinChains(DATA_PATH_INP_TREE, 20, "CIRCULAR_GEOMETRY TABULAR");
+    BOOST_REQUIRE(getResults(DATA_PATH_INP_TREE, tabular) == 0);
+    writeTwinChains(DATA_PATH_INP_TREE, 20, "CIRCULAR_GEOMETRY ANALYTIC");
+    BOOST_REQUIRE(getResults(DATA_PATH_INP_TREE, analytic) == 0);
+    remove(DATA_PATH_INP_TREE);
+    BOOST_CHECK_LT(twinPeakDiff(analytic), 0.005);
+    BOOST_CHECK_LT(twinPeakDiff(analytic), 0.5 * twinPeakDiff(tabular));
+}
+
+// Runs an input file with and without a PREDICTOR option and checks that
+// the predicted steps need fewer iterations with no loss of flow
+// continuity
+static void checkPredictor(const char* inpFile, const char* option)
+{
+    RoutingStats none, predicted;
+    RunResults results1, results2;
+
+    addOption(inpFile, DATA_PATH_INP_OPT, option);
+    BOOST_REQUIRE(getRoutingStats(inpFile, none) == 0);
+    BOOST_REQUIRE(getRoutingStats(DATA_PATH_INP_OPT, predicted) == 0);
+    BOOST_REQUIRE(getResults(inpFile, results1) == 0);
+    BOOST_REQUIRE(getResults(DATA_PATH_INP_OPT, results2) == 0);
+    remove(DATA_PATH_INP_OPT);
+
+    // --- no prediction statistics are reported without the option
+    BOOST_CHECK_EQUAL(none.predicted, -1.0);
+
+    // --- nearly every step is predicted and many are done in one trial
+    BOOST_CHECK_GT(predicted.predicted, 90.0);
+    BOOST_CHECK_GT(predicted.confirmed, 50.0);
+    BOOST_CHECK_LT(predicted.iterations, 0.75 * none.iterations);
+    BOOST_CHECK_LE(predicted.notConverging, none.notConverging);
+    BOOST_CHECK_SMALL(results1.flowErr - results2.flowErr, 0.05f);
+}
+
+BOOST_AUTO_TEST_CASE(PredictorLinear) {
+    checkPredictor(DATA_PATH_INP_DW, "PREDICTOR LINEAR");
+}
+
+BOOST_AUTO_TEST_CASE(PredictorQuadratic) {
+    checkPredictor(DATA_PATH_INP_DW, "PREDICTOR QUADRATIC");
+}
+
+// Writes an input file for a runoff-only model of small, wide and steep
+// subcatchments, whose ponded depths respond quickly to rainfall, under a
+// 2 hour storm given at 5 minute intervals
+static void writeRunoffModel(const char* inpFile, const char* solver,
+                             int wetStep)
+{
+    int i, t;
+    FILE* f = fopen(inpFile, "wt");
+
+    fprintf(f, "[OPTIONS]\n"
+               "FLOW_UNITS CFS\nINFILTRATION HORTON\nFLOW_ROUTING KINWAVE\n"
+               "START_DATE 01/01/2000\nSTART_TIME 00:00:00\n"
+               "REPORT_START_DATE 01/01/2000\nREPORT_START_TIME 00:00:00\n"
+               "END_DATE 01/01/2000\nEND_TIME 06:00:00\n"
+               "REPORT_STEP 00:05:00\nWET_STEP 00:%02d:%02d\n"
+               "DRY_STEP 00:05:00\nROUTING_STEP 0:00:30\n"
+               "IGNORE_ROUTING YES\nRUNOFF_SOLVER %s\n\n",
+               wetStep / 60, wetStep % 60, solver);
+    fprintf(f, "[RAINGAGES]\nRG1 INTENSITY 0:05 1.0 TIMESERIES TS1\n\n");
+    fprintf(f, "[TIMESERIES]\n");
+    for (t = 0; t <= 24; t++)
+        fprintf(f, "TS1 %d:%02d %.3f\n", 5 * t / 60, 5 * t % 60,
+                t < 8 ? 3.0 * t / 8.0 : 3.0 * (24 - t) / 16.0);
+
+    fprintf(f, "\n[SUBCATCHMENTS]\n");
+    for (i = 0; i < 20; i++)
+        fprintf(f, "S%d RG1 OUT1 %.2f %d %d %d 0\n", i, 0.02 * (i + 1),
+                5 * (i + 1), 1000 + 200 * i, 2 + i % 6);
+    fprintf(f, "\n[SUBAREAS]\n");
+    for (i = 0; i < 20; i++)
+        fprintf(f, "S%d 0.012 0.15 0.05 0.1 25 OUTLET\n", i);
+    fprintf(f, "\n[INFILTRATION]\n");
+    for (i = 0; i < 20; i++) fprintf(f, "S%d 3.0 0.5 4 7 0\n", i);
+    fprintf(f, "\n[OUTFALLS]\nOUT1 0 FREE NO\n");
+    fclose(f);
+}
+
+// Largest difference between the peak runoff of each subcatchment of two
+// runs relative to the peak of the first run
+static double peakRunoffDiff(const RunResults& a, const RunResults& b)
+{
+    size_t j;
+    double diff = 0.0;
+    for (j = 0; j < a.peakRunoff.size(); j++)
+        diff = fmax(diff, fabs(b.peakRunoff[j] - a.peakRunoff[j]) /
+                          a.peakRunoff[j]);
+    return diff;
+}
+
+BOOST_AUTO_TEST_CASE(RunoffSolver) {
+    RunResults reference, rungeKutta, rosenbrock;
+    size_t j;
+
+    // --- at a 1 second wet step both solvers give the same runoff
+    writeRunoffModel(DATA_PATH_INP_OPT, "RUNGE_KUTTA", 1);
+    BOOST_REQUIRE(getResults(DATA_PATH_INP_OPT, reference) == 0);
+    writeRunoffModel(DATA_PATH_INP_OPT, "ROSENBROCK", 1);
+    BOOST_REQUIRE(getResults(DATA_PATH_INP_OPT, rosenbrock) == 0);
+    BOOST_REQUIRE_EQUAL(reference.peakRunoff.size(), 20);
+    BOOST_CHECK_LT(peakRunoffDiff(reference, rosenbrock), 1.0e-3);
+    for (j = 0; j < reference.runoff.size(); j++)
+        BOOST_CHECK_SMALL(rosenbrock.runoff[j] - reference.runoff[j],
+                          1.0e-3 * reference.runoff[j]);
+
+    // --- and at 1 and 5 minute wet steps the Rosenbrock steps stay about
+    //     as close to that runoff as the Runge-Kutta solver does
+    for (int wetStep = 60; wetStep <= 300; wetStep += 240)
+    {
+        writeRunoffModel(DATA_PATH_INP_OPT, "RUNGE_KUTTA", wetStep);
+        BOOST_REQUIRE(getResults(DATA_PATH_INP_OPT, rungeKutta) == 0);
+        writeRunoffModel(DATA_PATH_INP_OPT, "ROSENBROCK", wetStep);
+        BOOST_REQUIRE(getResults(DATA_PATH_INP_OPT, rosenbrock) == 0);
+        BOOST_CHECK_LT(peakRunoffDiff(reference, rosenbrock),
+                       peakRunoffDiff(reference, rungeKutta) + 0.005);
+        BOOST_CHECK_LE(fabs(rosenbrock.runoffErr),
+                       fabs(rungeKutta.runoffErr) + 0.05f);
+    }
+    remove(DATA_PATH_INP_OPT);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
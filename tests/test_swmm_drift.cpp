@@ -0,0 +1,172 @@
+/*
+ *   test_swmm_drift.cpp
+ *
+ *   Unit testing of the numerical drift of the mixed precision build
+ *   (SWMM_SINGLE_PRECISION_STATE) using Boost Test.
+ *
+ *   NOTE: the single precision build is the run-swmm-single executable,
+ *         whose path is passed in the SWMM_SINGLE_ENGINE environment
+ *         variable (see CMakeLists.txt). Its results are compared with
+ *         those of the swmm5 library the tests are linked with.
+ */
+
+#define BOOST_TEST_MODULE "swmm5_drift"
+#include <boost/test/included/unit_test.hpp>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string>
+#include <fstream>
+
+#include "swmm5.h"
+#include "swmm_output.h"
+
+
+#define DATA_PATH_INP    "./swmm_dw_test.inp"
+#define DATA_PATH_INP_NK "./swmm_drift_newton.inp"
+#define DATA_PATH_RPT_1  "./swmm_drift_double.rpt"
+#define DATA_PATH_OUT_1  "./swmm_drift_double.out"
+#define DATA_PATH_RPT_2  "./swmm_drift_single.rpt"
+#define DATA_PATH_OUT_2  "./swmm_drift_single.out"
+
+// Largest difference allowed in any reported value, relative to the
+// largest value of its variable (drift of the test model is at most
+// ~5e-6)
+#define MAX_DRIFT 1.0e-4
+
+using namespace std;
+
+struct DriftVar
+{
+    const char* name;
+    int         type;                  // SMO_node, SMO_link or SMO_sys
+    int         attr;                  // variable code
+};
+
+static const DriftVar DriftVars[] = {
+    {"Node depth",          SMO_node, SMO_invert_depth},
+    {"Node total inflow",   SMO_node, SMO_total_inflow},
+    {"Node flooding",       SMO_node, SMO_flooding_losses},
+    {"Link flow",           SMO_link, SMO_flow_rate_link},
+    {"Link depth",          SMO_link, SMO_flow_depth},
+    {"Link volume",         SMO_link, SMO_flow_volume},
+    {"System outfall flow", SMO_sys,  SMO_outfall_flows},
+    {"System storage",      SMO_sys,  SMO_volume_stored}
+};
+
+// Reads the values of a variable for all elements in a reporting period
+static int getValues(SMO_Handle h, const DriftVar& v, int period,
+                     float** x, int* n)
+{
+    int err;
+
+    switch (v.type)
+    {
+    case SMO_node: return SMO_getNodeAttribute(h, period,
+                          (SMO_nodeAttribute)v.attr, x, n);
+    case SMO_link: return SMO_getLinkAttribute(h, period,
+                          (SMO_linkAttribute)v.attr, x, n);
+    default:
+        // --- system values are read as a whole record
+        err = SMO_getSystemResult(h, period, 0, x, n);
+        if (err <= 10)
+        {
+            (*x)[0] = (*x)[v.attr];
+            *n = 1;
+        }
+        return err;
+    }
+}
+
+// Finds the largest difference between the values of a variable in two
+// output files relative to its largest value in the first one
+static double getDrift(SMO_Handle h1, SMO_Handle h2, const DriftVar& v,
+                       int nPeriods)
+{
+    int    i, p, n1, n2;
+    double d = 0.0, ref = 0.0;
+    float  *x1, *x2;
+
+    for (p = 0; p < nPeriods; p++)
+    {
+        x1 = NULL;
+        x2 = NULL;
+        BOOST_REQUIRE(getValues(h1, v, p, &x1, &n1) <= 10);
+        BOOST_REQUIRE(getValues(h2, v, p, &x2, &n2) <= 10);
+        BOOST_REQUIRE_EQUAL(n1, n2);
+        for (i = 0; i < n1; i++)
+        {
+            d = fmax(d, fabs((double)x2[i] - x1[i]));
+            ref = fmax(ref, fabs(x1[i]));
+        }
+        SMO_free((void**)&x1);
+        SMO_free((void**)&x2);
+    }
+    return (ref > 0.0) ? d / ref : d;
+}
+
+// Runs a model with the default and the single precision builds and checks
+// that no reported variable drifts apart
+static void checkDrift(const char* inpFile)
+{
+    const char* engine = getenv("SWMM_SINGLE_ENGINE");
+    int         nPeriods1 = 0, nPeriods2 = 0;
+    SMO_Handle  h1 = NULL, h2 = NULL;
+
+    BOOST_REQUIRE(engine != NULL);
+    BOOST_REQUIRE_EQUAL(0, swmm_run((char *)inpFile,
+                        (char *)DATA_PATH_RPT_1, (char *)DATA_PATH_OUT_1));
+    string cmd = string("\"") + engine + "\" " + inpFile + " "
+                 DATA_PATH_RPT_2 " " DATA_PATH_OUT_2;
+    BOOST_REQUIRE_EQUAL(0, system(cmd.c_str()));
+
+    SMO_init(&h1);
+    SMO_init(&h2);
+    BOOST_REQUIRE(SMO_open(h1, DATA_PATH_OUT_1) <= 10);
+    BOOST_REQUIRE(SMO_open(h2, DATA_PATH_OUT_2) <= 10);
+    SMO_getTimes(h1, SMO_numPeriods, &nPeriods1);
+    SMO_getTimes(h2, SMO_numPeriods, &nPeriods2);
+    BOOST_REQUIRE(nPeriods1 > 0);
+    BOOST_REQUIRE_EQUAL(nPeriods1, nPeriods2);
+
+    for (size_t k = 0; k < sizeof(DriftVars) / sizeof(DriftVars[0]); k++)
+    {
+        BOOST_TEST_CONTEXT(DriftVars[k].name)
+        {
+            BOOST_CHECK_LE(getDrift(h1, h2, DriftVars[k], nPeriods1),
+                           MAX_DRIFT);
+        }
+    }
+    SMO_close(&h1);
+    SMO_close(&h2);
+
+    remove(DATA_PATH_RPT_1);
+    remove(DATA_PATH_OUT_1);
+    remove(DATA_PATH_RPT_2);
+    remove(DATA_PATH_OUT_2);
+}
+
+BOOST_AUTO_TEST_SUITE(test_swmm_drift)
+
+// Picard iterations use the single precision link arrays
+BOOST_AUTO_TEST_CASE(PicardDrift) {
+    checkDrift(DATA_PATH_INP);
+}
+
+// the Newton-Krylov solver also uses a single precision Krylov basis
+BOOST_AUTO_TEST_CASE(NewtonDrift) {
+    ifstream in(DATA_PATH_INP);
+    ofstream out(DATA_PATH_INP_NK);
+    string line;
+    while (getline(in, line))
+    {
+        out << line << "\n";
+        if (line == "[OPTIONS]") out << "SOLVER_METHOD        NEWTON\n";
+    }
+    out.close();
+    checkDrift(DATA_PATH_INP_NK);
+    remove(DATA_PATH_INP_NK);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,184 @@
+/*
+ *   test_swmm_threads.cpp
+ *
+ *   Unit testing of multithreaded runs for SWMM using Boost Test.
+ *
+ *   NOTE: the engine never uses more threads than the OpenMP runtime
+ *         provides, so these tests are run with OMP_NUM_THREADS set
+ *         (see CMakeLists.txt) to give several threads on any machine.
+ */
+
+#define BOOST_TEST_MODULE "swmm5_threads"
+#include <boost/test/included/unit_test.hpp>
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "swmm5.h"
+
+
+#define DATA_PATH_INP_1 "./swmm_threads_1.inp"
+#define DATA_PATH_INP_N "./swmm_threads_n.inp"
+#define DATA_PATH_RPT_1 "./swmm_threads_1.rpt"
+#define DATA_PATH_RPT_N "./swmm_threads_n.rpt"
+#define DATA_PATH_OUT_1 "./swmm_threads_1.out"
+#define DATA_PATH_OUT_N "./swmm_threads_n.out"
+
+// Number of conduits in the test network, enough for each of 4 threads
+// to get a share of the links and subcatchments
+#define NETWORK_LINKS 1200
+
+using namespace std;
+
+// Writes an input file for a network of conduits of several shapes that
+// drain a binary tree of junctions to an outfall, with a subcatchment on
+// each junction
+static void writeNetwork(const char* inpFile, int nLinks, int nThreads,
+                         const char* routing, const char* infil)
+{
+    int i, level, maxLevel = 0;
+    FILE* f = fopen(inpFile, "wt");
+
+    for (i = nLinks; i > 1; i /= 2) maxLevel++;
+    fprintf(f, "[OPTIONS]\n"
+               "FLOW_UNITS CFS\nINFILTRATION %s\nFLOW_ROUTING %s\n"
+               "START_DATE 01/01/2000\nSTART_TIME 00:00:00\n"
+               "REPORT_START_DATE 01/01/2000\nREPORT_START_TIME 00:00:00\n"
+               "END_DATE 01/01/2000\nEND_TIME 03:00:00\n"
+               "REPORT_STEP 00:15:00\nWET_STEP 00:01:00\nDRY_STEP 00:05:00\n"
+               "ROUTING_STEP 0:00:10\nVARIABLE_STEP 0.75\nTHREADS %d\n\n",
+               infil, routing, nThreads);
+    fprintf(f, "[RAINGAGES]\nRG1 INTENSITY 0:15 1.0 TIMESERIES TS1\n\n");
+    fprintf(f, "[TIMESERIES]\nTS1 0:00 0.2\nTS1 0:15 1.5\nTS1 0:30 3.0\n"
+               "TS1 0:45 1.0\nTS1 1:00 0.3\nTS1 1:15 0.0\n\n");
+
+    fprintf(f, "[SUBCATCHMENTS]\n");
+    for (i = 0; i < nLinks; i++)
+        fprintf(f, "S%d RG1 J%d %.1f 50 300 0.5 0\n", i, i, 2.0 + i % 5);
+    fprintf(f, "\n[SUBAREAS]\n");
+    for (i = 0; i < nLinks; i++)
+        fprintf(f, "S%d 0.01 0.1 0.05 0.05 25 OUTLET\n", i);
+    fprintf(f, "\n[INFILTRATION]\n");
+    for (i = 0; i < nLinks; i++)
+    {
+        if (strcmp(infil, "HORTON") == 0)
+            fprintf(f, "S%d 3.0 0.5 4 7 0\n", i);
+        else if (strcmp(infil, "GREEN_AMPT") == 0)
+            fprintf(f, "S%d 3.5 0.5 0.26\n", i);
+        else fprintf(f, "S%d 80 0.5 7\n", i);
+    }
+
+    // --- junction i drains to junction (i-1)/2 and junction 0 drains
+    //     to the outfall; inverts drop & conduit sizes grow with the
+    //     area drained toward the outfall
+    fprintf(f, "\n[JUNCTIONS]\n");
+    for (i = 0; i < nLinks; i++)
+    {
+        for (level = 0; (2 << level) <= i + 1; level++);
+        fprintf(f, "J%d %.2f 6 0 0 0\n", i, 1.0 + 1.0 * level);
+    }
+    fprintf(f, "\n[OUTFALLS]\nOUT1 0 FREE NO\n\n[CONDUITS]\n");
+    fprintf(f, "C0 J0 OUT1 400 0.013 0 0 0 0\n");
+    for (i = 1; i < nLinks; i++)
+        fprintf(f, "C%d J%d J%d 400 0.013 0 0 0 0\n", i, i, (i - 1) / 2);
+    fprintf(f, "\n[XSECTIONS]\n");
+    for (i = 0; i < nLinks; i++)
+    {
+        double size;
+        for (level = 0; (2 << level) <= i + 1; level++);
+        size = pow(2.0, 0.375 * (maxLevel - level));
+        switch (i % 4)
+        {
+        case 0:  fprintf(f, "C%d CIRCULAR %.2f 0 0 0 1\n", i, size); break;
+        case 1:  fprintf(f, "C%d RECT_CLOSED %.2f %.2f 0 0 1\n", i, size,
+                         1.5 * size); break;
+        case 2:  fprintf(f, "C%d TRAPEZOIDAL %.2f %.2f 1 1 1\n", i, size,
+                         size); break;
+        default: fprintf(f, "C%d RECT_OPEN %.2f %.2f 0 0 1\n", i, size,
+                         2.0 * size);
+        }
+    }
+    fprintf(f, "\n[REPORT]\nSUBCATCHMENTS ALL\nNODES ALL\nLINKS ALL\n");
+    fclose(f);
+}
+
+// Reads all of the bytes of a file
+static vector<char> readBytes(const char* fileName)
+{
+    ifstream f(fileName, ios::binary);
+    return vector<char>(istreambuf_iterator<char>(f),
+                        istreambuf_iterator<char>());
+}
+
+// Reads the lines of a report file, skipping those that report the run's
+// clock times and thread settings
+static vector<string> readReport(const char* fileName)
+{
+    const char* skipped[] = {"Analysis begun", "Analysis ended",
+                             "Total elapsed", "Number of Threads",
+                             "Thread Schedule"};
+    vector<string> lines;
+    string line;
+    ifstream f(fileName);
+    while (getline(f, line))
+    {
+        bool skip = false;
+        for (size_t k = 0; k < sizeof(skipped) / sizeof(skipped[0]); k++)
+            if (line.find(skipped[k]) != string::npos) skip = true;
+        if (!skip) lines.push_back(line);
+    }
+    return lines;
+}
+
+// Runs the test network with 1 thread and with nThreads threads and checks
+// that the binary output files are identical and that the reports differ
+// only in their clock times and thread settings
+static void checkThreadCount(const char* routing, const char* infil,
+                             int nThreads)
+{
+    writeNetwork(DATA_PATH_INP_1, NETWORK_LINKS, 1, routing, infil);
+    writeNetwork(DATA_PATH_INP_N, NETWORK_LINKS, nThreads, routing, infil);
+    BOOST_REQUIRE_EQUAL(0, swmm_run((char *)DATA_PATH_INP_1,
+                        (char *)DATA_PATH_RPT_1, (char *)DATA_PATH_OUT_1));
+    BOOST_REQUIRE_EQUAL(0, swmm_run((char *)DATA_PATH_INP_N,
+                        (char *)DATA_PATH_RPT_N, (char *)DATA_PATH_OUT_N));
+
+    vector<char> out1 = readBytes(DATA_PATH_OUT_1);
+    vector<char> outN = readBytes(DATA_PATH_OUT_N);
+    BOOST_REQUIRE(out1.size() > 0);
+    BOOST_CHECK(out1 == outN);
+
+    vector<string> rpt1 = readReport(DATA_PATH_RPT_1);
+    vector<string> rptN = readReport(DATA_PATH_RPT_N);
+    BOOST_REQUIRE(rpt1.size() > 0);
+    BOOST_CHECK(rpt1 == rptN);
+
+    remove(DATA_PATH_INP_1);
+    remove(DATA_PATH_INP_N);
+    remove(DATA_PATH_RPT_1);
+    remove(DATA_PATH_RPT_N);
+    remove(DATA_PATH_OUT_1);
+    remove(DATA_PATH_OUT_N);
+}
+
+BOOST_AUTO_TEST_SUITE(test_swmm_threads)
+
+BOOST_AUTO_TEST_CASE(DynwaveThreadCount) {
+    checkThreadCount("DYNWAVE", "HORTON", 4);
+}
+
+BOOST_AUTO_TEST_CASE(KinwaveThreadCount) {
+    checkThreadCount("KINWAVE", "GREEN_AMPT", 4);
+}
+
+// 3 threads don't divide the network's links and nodes evenly
+BOOST_AUTO_TEST_CASE(DynwaveUnevenThreadCount) {
+    checkThreadCount("DYNWAVE", "CURVE_NUMBER", 3);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,155 @@
+//-----------------------------------------------------------------------------
+//   bench_active.c
+//
+//   Project:  EPA SWMM5
+//   Version:  5.2
+//
+//   Cost per time step of dynamic wave routing against the size of its
+//   active set (the nodes & links that its iterations visit).
+//
+//   A network of separate chains of circular conduits, each draining to
+//   its own outfall, is written to bench_active.inp and routed for 12
+//   hours. A storm hydrograph enters the top of a given share of the
+//   chains while the others stay dry, or (in the base flow cases) carry a
+//   constant inflow that has settled before the storm arrives. For each
+//   case the average number of active nodes & links per time step (with
+//   the ACTIVE_SET option) is reported together with the run time per
+//   time step with and without the option. The run time that
+//   does not depend on the active set (the per-step loops over all nodes
+//   & links made outside of dynwave.c, such as those of routing.c and of
+//   the statistics) is the part left when no chain is wet.
+//
+//   Usage:  bench-active [chains] [conduits per chain]
+//-----------------------------------------------------------------------------
+#define _CRT_SECURE_NO_DEPRECATE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "headers.h"
+#include "swmm5.h"
+
+#define INP_FILE "bench_active.inp"
+#define RPT_FILE "bench_active.rpt"
+#define OUT_FILE "bench_active.out"
+
+//  Writes the network with a storm on the first nWet chains and, if
+//  baseFlow is set, a constant inflow into every chain, routed with or
+//  without the ACTIVE_SET option.
+static int writeModel(int nChains, int nLinks, int nWet, int baseFlow,
+                      int activeSet)
+{
+    int   c, k;
+    FILE* f = fopen(INP_FILE, "wt");
+
+    if ( f == NULL ) return 0;
+    fprintf(f, "[OPTIONS]\n"
+        "FLOW_UNITS CFS\nFLOW_ROUTING DYNWAVE\n"
+        "START_DATE 01/01/2020\nSTART_TIME 00:00:00\n"
+        "END_DATE 01/01/2020\nEND_TIME 12:00:00\n"
+        "REPORT_STEP 00:15:00\nROUTING_STEP 0:00:10\n"
+        "VARIABLE_STEP 0.75\nTHREADS 1\nACTIVE_SET %s\n\n",
+        activeSet ? "YES" : "NO");
+    fprintf(f, "[JUNCTIONS]\n");
+    for (c = 0; c < nChains; c++)
+    {
+        for (k = 0; k < nLinks; k++)
+            fprintf(f, "J%d_%d %.2f 8 0 0 0\n", c, k, 100.0 - 0.5 * k);
+    }
+    fprintf(f, "\n[OUTFALLS]\n");
+    for (c = 0; c < nChains; c++)
+        fprintf(f, "O%d %.2f FREE NO\n", c, 100.0 - 0.5 * nLinks);
+    fprintf(f, "\n[CONDUITS]\n");
+    for (c = 0; c < nChains; c++)
+    {
+        for (k = 0; k < nLinks - 1; k++)
+            fprintf(f, "C%d_%d J%d_%d J%d_%d 400 0.013 0 0 0 0\n",
+                    c, k, c, k, c, k + 1);
+        fprintf(f, "C%d_%d J%d_%d O%d 400 0.013 0 0 0 0\n",
+                c, k, c, k, c);
+    }
+    fprintf(f, "\n[XSECTIONS]\n");
+    for (c = 0; c < nChains; c++)
+    {
+        for (k = 0; k < nLinks; k++)
+            fprintf(f, "C%d_%d CIRCULAR 2.5 0 0 0 1\n", c, k);
+    }
+    fprintf(f, "\n[INFLOWS]\n");
+    for (c = 0; c < nChains; c++)
+    {
+        if ( c < nWet ) fprintf(f, "J%d_0 FLOW TS1 FLOW 1.0 1.0 %s\n", c,
+                                baseFlow ? "0.5" : "0");
+        else if ( baseFlow ) fprintf(f, "J%d_0 FLOW \"\" FLOW 1.0 1.0 0.5\n",
+                                     c);
+    }
+    fprintf(f, "\n[TIMESERIES]\nTS1 0:00 0\nTS1 3:00 0\nTS1 4:00 12\n"
+               "TS1 6:00 4\nTS1 8:00 0\n");
+    fclose(f);
+    return 1;
+}
+
+//  Runs the model, returning the run time per time step (msec) and the
+//  average number of active nodes & links per time step.
+static double runModel(double* nActive)
+{
+    int     err, steps = 0;
+    double  elapsedTime = 0.0, total = 0.0, t;
+    clock_t start;
+
+    err = swmm_open(INP_FILE, RPT_FILE, OUT_FILE);
+    if ( !err ) err = swmm_start(FALSE);
+    start = clock();
+    while ( !err )
+    {
+        err = swmm_step(&elapsedTime);
+        if ( elapsedTime == 0.0 ) break;
+        total += Prj->dynwave.Active.nNodes + Prj->dynwave.Active.nLinks;
+        steps++;
+    }
+    t = 1000.0 * (double)(clock() - start) / CLOCKS_PER_SEC;
+    swmm_end();
+    swmm_close();
+    if ( err || steps == 0 )
+    {
+        fprintf(stderr, "\n  Error %d running %s\n", err, INP_FILE);
+        exit(1);
+    }
+    *nActive = total / steps;
+    return t / steps;
+}
+
+int main(int argc, char* argv[])
+{
+    int    i, k, nChains = 400, nLinks = 20;
+    int    wetPct[] = {0, 5, 25, 100};
+    double nAll, nActive[2 * 4], msPerStep[2][2 * 4];
+
+    if ( argc > 1 ) nChains = atoi(argv[1]);
+    if ( argc > 2 ) nLinks = atoi(argv[2]);
+    for (i = 0; i < 2 * 4; i++)
+    {
+        for (k = 0; k < 2; k++)
+        {
+            if ( !writeModel(nChains, nLinks, nChains * wetPct[i % 4] / 100,
+                             i >= 4, k) ) return 1;
+            msPerStep[k][i] = runModel(k ? &nActive[i] : &nAll);
+        }
+    }
+
+    // --- the engine writes progress messages while it runs, so the
+    //     table follows all runs
+    printf("\n\n  %d chains of %d conduits (%d nodes & links)\n\n",
+           nChains, nLinks, 2 * nChains * nLinks + nChains);
+    printf("  %-10s %6s %14s %14s %14s\n", "inflow", "% wet",
+           "active/step", "ms/step (all)", "ms/step (set)");
+    for (i = 0; i < 2 * 4; i++)
+    {
+        printf("  %-10s %6d %14.0f %14.3f %14.3f\n",
+               i >= 4 ? "base flow" : "dry", wetPct[i % 4], nActive[i],
+               msPerStep[0][i], msPerStep[1][i]);
+    }
+    remove(INP_FILE);
+    remove(RPT_FILE);
+    remove(OUT_FILE);
+    return 0;
+}
@@ -0,0 +1,191 @@
+//-----------------------------------------------------------------------------
+//   bench_circ.c
+//
+//   Project:  EPA SWMM5
+//   Version:  5.2
+//
+//   Accuracy & throughput benchmark of the two methods available for
+//   circular cross section geometry (CIRCULAR_GEOMETRY option):
+//   TABULAR (xsect.dat tables plus iterative solutions for small fill)
+//   and ANALYTIC (non-iterative closed form solutions).
+//
+//   Depth and section factor v. area (xsect_getYofA & xsect_getSofA)
+//   and area v. section factor (xsect_getAofS) are evaluated over the
+//   full 0..1 range of fill, both on a uniform grid and on a log-spaced
+//   grid of nearly empty sections. Errors are measured against a bisection
+//   solution in long double precision and reported as a fraction of the
+//   full section value. Throughput is reported in M evaluations per second
+//   for each grid (the TABULAR method iterates for nearly empty sections).
+//
+//   Usage:  bench-circ [repeats]
+//-----------------------------------------------------------------------------
+#define _CRT_SECURE_NO_DEPRECATE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "headers.h"
+
+#define NUNIFORM 10000                 // points on uniform grid of fill
+#define NSMALL   1000                  // points on log grid of small fill
+#define NPOINTS  (NUNIFORM + NSMALL)
+#define PI_L     3.141592653589793238462643383279503L
+
+enum FunctionType {Y_OF_A, S_OF_A, A_OF_S};
+
+static char* FunctionNames[] = {"Y of A", "S of A", "A of S"};
+static char* MethodNames[]   = {"TABULAR", "ANALYTIC"};
+
+static TXsect Xsect;
+static double X[3][NPOINTS];           // function arguments
+static double Ref[3][NPOINTS];         // reference results
+static double Out[NPOINTS];            // computed results
+static volatile double Sink;         // keeps timed results live
+
+static double elapsed(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+//  Area fraction of circle for central angle theta.
+static long double alphaOfTheta(long double theta)
+{
+    return (theta - sinl(theta)) / (2.0L * PI_L);
+}
+
+//  Section factor fraction of circle for central angle theta.
+static long double psiOfTheta(long double theta)
+{
+    long double tt = theta - sinl(theta);
+    return powl(tt, 5.0L/3.0L) / powl(theta, 2.0L/3.0L) / (2.0L * PI_L);
+}
+
+//  Finds theta where f(theta) = v by bisection on [0, tMax].
+static long double bisect(long double (*f)(long double), long double v,
+                          long double tMax)
+{
+    int k;
+    long double t1 = 0.0L, t2 = tMax, t;
+    for (k = 0; k < 200; k++)
+    {
+        t = 0.5L * (t1 + t2);
+        if ( f(t) < v ) t1 = t;
+        else            t2 = t;
+    }
+    return 0.5L * (t1 + t2);
+}
+
+//  Finds theta at which the section factor is a maximum.
+static long double thetaOfPsiMax(void)
+{
+    int k;
+    long double t1 = PI_L, t2 = 2.0L * PI_L, m1, m2;
+    for (k = 0; k < 200; k++)
+    {
+        m1 = t1 + (t2 - t1) / 3.0L;
+        m2 = t2 - (t2 - t1) / 3.0L;
+        if ( psiOfTheta(m1) < psiOfTheta(m2) ) t1 = m1;
+        else                                   t2 = m2;
+    }
+    return 0.5L * (t1 + t2);
+}
+
+static void makeGrid(void)
+{
+    int i;
+    double f;
+    long double theta, tMax = thetaOfPsiMax();
+
+    for (i = 0; i < NPOINTS; i++)
+    {
+        // --- fraction full: uniform over (0,1) or log-spaced in 1e-8..1e-2
+        if ( i < NUNIFORM ) f = (i + 0.5) / NUNIFORM;
+        else f = pow(10.0, -8.0 + 6.0 * (i - NUNIFORM + 0.5) / NSMALL);
+
+        // --- depth & section factor at area fraction f
+        theta = bisect(alphaOfTheta, f, 2.0L * PI_L);
+        X[Y_OF_A][i] = X[S_OF_A][i] = f * Xsect.aFull;
+        Ref[Y_OF_A][i] = (double)((1.0L - cosl(theta/2.0L)) / 2.0L);
+        Ref[S_OF_A][i] = (double)(psiOfTheta(theta) / psiOfTheta(2.0L*PI_L));
+
+        // --- area at section factor fraction f (lower branch)
+        theta = bisect(psiOfTheta, f * psiOfTheta(2.0L*PI_L), tMax);
+        X[A_OF_S][i] = f * Xsect.sFull;
+        Ref[A_OF_S][i] = (double)alphaOfTheta(theta);
+    }
+}
+
+static double evaluate(int func, double x)
+{
+    switch ( func )
+    {
+    case Y_OF_A: return xsect_getYofA(&Xsect, x) / Xsect.yFull;
+    case S_OF_A: return xsect_getSofA(&Xsect, x) / Xsect.sFull;
+    default:     return xsect_getAofS(&Xsect, x) / Xsect.aFull;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int     i, r, func, method;
+    int     repeats = 200;
+    double  p[4] = {1.0, 0.0, 0.0, 0.0};
+    double  err, errUniform, errSmall, tUniform, tSmall, sum;
+    clock_t start;
+
+    if ( argc > 1 ) repeats = atoi(argv[1]);
+    if ( repeats < 1 ) repeats = 1;
+
+    memset(&Xsect, 0, sizeof(TXsect));
+    xsect_setParams(&Xsect, CIRCULAR, p, 1.0);
+    makeGrid();
+
+    printf("\n  Circular geometry: %d uniform + %d small fill points"
+           " x %d repeats\n", NUNIFORM, NSMALL, repeats);
+    printf("\n  %-8s %-9s %13s %13s %13s %13s\n", "Function", "Method",
+           "MaxErr(0..1)", "MaxErr(<1%)", "Speed(0..1)", "Speed(<1%)");
+    for (func = Y_OF_A; func <= A_OF_S; func++)
+    {
+        for (method = TABLE_GEOMETRY; method <= ANALYTIC_GEOMETRY; method++)
+        {
+            CircGeometry = method;
+
+            // --- accuracy
+            errUniform = errSmall = 0.0;
+            for (i = 0; i < NPOINTS; i++)
+            {
+                Out[i] = evaluate(func, X[func][i]);
+                err = fabs(Out[i] - Ref[func][i]);
+                if ( i < NUNIFORM ) errUniform = MAX(errUniform, err);
+                else                errSmall = MAX(errSmall, err);
+            }
+
+            // --- throughput over each grid
+            sum = 0.0;
+            start = clock();
+            for (r = 0; r < repeats; r++)
+            {
+                for (i = 0; i < NUNIFORM; i++)
+                    sum += evaluate(func, X[func][i]);
+            }
+            tUniform = elapsed(start);
+            start = clock();
+            for (r = 0; r < repeats * NUNIFORM / NSMALL; r++)
+            {
+                for (i = NUNIFORM; i < NPOINTS; i++)
+                    sum += evaluate(func, X[func][i]);
+            }
+            tSmall = elapsed(start);
+            Sink += sum;
+
+            printf("  %-8s %-9s %13.2e %13.2e %13.1f %13.1f\n",
+                   FunctionNames[func], MethodNames[method],
+                   errUniform, errSmall,
+                   (double)NUNIFORM * repeats / 1.0e6 / MAX(tUniform, 1.e-9),
+                   (double)NUNIFORM * repeats / 1.0e6 / MAX(tSmall, 1.e-9));
+        }
+    }
+    CircGeometry = TABLE_GEOMETRY;
+    return 0;
+}
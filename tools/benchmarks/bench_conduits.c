@@ -0,0 +1,162 @@
+//-----------------------------------------------------------------------------
+//   bench_conduits.c
+//
+//   Project:  EPA SWMM5
+//   Version:  5.2
+//
+//   Microbenchmark of the dynamic wave conduit flow update
+//   (dwflow_findConduitFlows) for each cross section shape.
+//
+//   For each shape a network of separate chains of conduits, each draining
+//   to its own outfall, is written to bench_conduits.inp and routed until
+//   a storm has filled its conduits part full. The flows of all conduits
+//   are then updated repeatedly in the same blocks of MAXCONDUITBATCH
+//   conduits used by dynwave.c and the time per conduit update reported.
+//   Comparing the times of engine builds that update a shape's conduits in
+//   batches or one at a time shows which of the two is faster for it.
+//
+//   Usage:  bench-conduits [repeats]
+//-----------------------------------------------------------------------------
+#define _CRT_SECURE_NO_DEPRECATE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "headers.h"
+#include "swmm5.h"
+
+#define INP_FILE "bench_conduits.inp"
+#define RPT_FILE "bench_conduits.rpt"
+#define OUT_FILE "bench_conduits.out"
+#define NCHAINS  100                   // number of chains of conduits
+#define NLINKS   20                    // number of conduits per chain
+
+typedef struct
+{
+    char*  name;                       // shape name
+    char*  params;                     // shape parameters (ft)
+} TBenchShape;
+
+static TBenchShape BenchShapes[] = {
+    {"CIRCULAR",    "2.5 0 0 0"},
+    {"EGGSHAPED",   "3 0 0 0"},
+    {"HORSESHOE",   "3 0 0 0"},
+    {"RECT_CLOSED", "2.5 3 0 0"},
+    {"RECT_OPEN",   "2.5 3 0 0"},
+    {"TRAPEZOIDAL", "2.5 3 1 1"},
+    {"TRIANGULAR",  "2.5 3 0 0"}
+};
+
+static int Links[NCHAINS * NLINKS];
+
+//  Writes the network with conduits of the given shape.
+static int writeModel(TBenchShape* shape)
+{
+    int   c, k;
+    FILE* f = fopen(INP_FILE, "wt");
+
+    if ( f == NULL ) return 0;
+    fprintf(f, "[OPTIONS]\n"
+        "FLOW_UNITS CFS\nFLOW_ROUTING DYNWAVE\n"
+        "START_DATE 01/01/2020\nSTART_TIME 00:00:00\n"
+        "END_DATE 01/01/2020\nEND_TIME 06:00:00\n"
+        "REPORT_STEP 00:15:00\nROUTING_STEP 0:00:10\n"
+        "VARIABLE_STEP 0.75\nTHREADS 1\n\n");
+    fprintf(f, "[JUNCTIONS]\n");
+    for (c = 0; c < NCHAINS; c++)
+    {
+        for (k = 0; k < NLINKS; k++)
+            fprintf(f, "J%d_%d %.2f 8 0 0 0\n", c, k, 100.0 - 0.5 * k);
+    }
+    fprintf(f, "\n[OUTFALLS]\n");
+    for (c = 0; c < NCHAINS; c++)
+        fprintf(f, "O%d %.2f FREE NO\n", c, 100.0 - 0.5 * NLINKS);
+    fprintf(f, "\n[CONDUITS]\n");
+    for (c = 0; c < NCHAINS; c++)
+    {
+        for (k = 0; k < NLINKS - 1; k++)
+            fprintf(f, "C%d_%d J%d_%d J%d_%d 400 0.013 0 0 0 0\n",
+                    c, k, c, k, c, k + 1);
+        fprintf(f, "C%d_%d J%d_%d O%d 400 0.013 0 0 0 0\n",
+                c, k, c, k, c);
+    }
+    fprintf(f, "\n[XSECTIONS]\n");
+    for (c = 0; c < NCHAINS; c++)
+    {
+        for (k = 0; k < NLINKS; k++)
+            fprintf(f, "C%d_%d %s %s 1\n", c, k, shape->name, shape->params);
+    }
+    fprintf(f, "\n[INFLOWS]\n");
+    for (c = 0; c < NCHAINS; c++)
+        fprintf(f, "J%d_0 FLOW TS1 FLOW 1.0 %.2f\n", c, 0.5 + 0.01 * c);
+    fprintf(f, "\n[TIMESERIES]\nTS1 0:00 0\nTS1 1:00 12\nTS1 6:00 12\n");
+    fclose(f);
+    return 1;
+}
+
+//  Routes the network for 2 hours, then returns the time per conduit
+//  update (nanosec) of the given number of updates of all conduits.
+static double runModel(int repeats)
+{
+    int     err, i, r, start, n = 0;
+    double  elapsedTime = 0.0, t;
+    clock_t clock0;
+
+    err = swmm_open(INP_FILE, RPT_FILE, OUT_FILE);
+    if ( !err ) err = swmm_start(FALSE);
+    while ( !err && elapsedTime < 2.0 / 24.0 )
+    {
+        err = swmm_step(&elapsedTime);
+        if ( elapsedTime == 0.0 ) break;
+    }
+    if ( err )
+    {
+        fprintf(stderr, "\n  Error %d running %s\n", err, INP_FILE);
+        exit(1);
+    }
+    for (i = 0; i < Nobjects[LINK]; i++)
+    {
+        if ( Link[i].type == CONDUIT ) Links[n++] = i;
+    }
+
+    clock0 = clock();
+    for (r = 0; r < repeats; r++)
+    {
+        for (start = 0; start < n; start += MAXCONDUITBATCH)
+        {
+            dwflow_findConduitFlows(&Links[start],
+                MIN(n - start, MAXCONDUITBATCH), 1, 0.5, 5.0);
+        }
+    }
+    t = 1.0e9 * (double)(clock() - clock0) / CLOCKS_PER_SEC;
+    swmm_end();
+    swmm_close();
+    return t / repeats / MAX(n, 1);
+}
+
+int main(int argc, char* argv[])
+{
+    int    k, repeats = 2000;
+    int    nShapes = sizeof(BenchShapes) / sizeof(TBenchShape);
+    double nsPerUpdate[sizeof(BenchShapes) / sizeof(TBenchShape)];
+
+    if ( argc > 1 ) repeats = atoi(argv[1]);
+    if ( repeats < 1 ) repeats = 1;
+    for (k = 0; k < nShapes; k++)
+    {
+        if ( !writeModel(&BenchShapes[k]) ) return 1;
+        nsPerUpdate[k] = runModel(repeats);
+    }
+
+    // --- the engine writes progress messages while it runs, so the
+    //     table follows all runs
+    printf("\n\n  Conduit flow updates: %d conduits x %d repeats\n\n",
+           NCHAINS * NLINKS, repeats);
+    printf("  %-12s %14s\n", "Shape", "ns/conduit");
+    for (k = 0; k < nShapes; k++)
+        printf("  %-12s %14.1f\n", BenchShapes[k].name, nsPerUpdate[k]);
+    remove(INP_FILE);
+    remove(RPT_FILE);
+    remove(OUT_FILE);
+    return 0;
+}
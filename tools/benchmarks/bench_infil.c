@@ -0,0 +1,262 @@
+//-----------------------------------------------------------------------------
+//   bench_infil.c
+//
+//   Project:  EPA SWMM5
+//   Version:  5.2
+//
+//   Microbenchmark of the batch infiltration function infil_getInfilBatch
+//   for batches of one subcatchment and of MAXINFILBATCH subcatchments.
+//
+//   For each infiltration method a model of many subcatchments with
+//   randomly drawn infiltration parameters is opened and their
+//   infiltration is found over a day of time steps holding an intense
+//   storm, a dry spell with some ponded water left over and a light
+//   storm, first one subcatchment at a time and then in batches of
+//   MAXINFILBATCH (the batch size used by the runoff analyzer). The
+//   infiltration rates and final states of both methods are checked to be
+//   identical, showing that a lane's results do not depend on the size
+//   of its batch, and the number of evaluations per second is reported.
+//
+//   Usage:  bench-infil [subcatchments]
+//-----------------------------------------------------------------------------
+#define _CRT_SECURE_NO_DEPRECATE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "headers.h"
+#include "swmm5.h"
+
+#define INP_FILE "bench_infil.inp"
+#define RPT_FILE "bench_infil.rpt"
+#define NSTEPS   1440                  // number of 1 minute time steps
+#define TSTEP    60.0                  // time step (sec)
+#define NSTATES  6                     // max. size of an infil. state
+
+static char* MethodNames[] = {"HORTON", "MODIFIED_HORTON", "GREEN_AMPT",
+                              "MODIFIED_GREEN_AMPT", "CURVE_NUMBER"};
+
+static double  Rainfall[NSTEPS];       // rainfall at each step (ft/sec)
+static double* Runon;                  // runon of each subcatch. (ft/sec)
+static double* Depth;                  // ponded depth of each subcatch. (ft)
+static double* Factor;                 // conductivity factor of each subcatch.
+static double* Infil1;                 // total infil. of single method (ft)
+static double* Infil2;                 // total infil. of batch method (ft)
+static double* State1;                 // final state of single method
+static double* State2;                 // final state of batch method
+
+//  Uniform random number in [a, b).
+static double uniform(double a, double b)
+{
+    return a + (b - a) * rand() / (RAND_MAX + 1.0);
+}
+
+static double elapsed(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static int writeModel(int nSubcatch, int m)
+{
+    int   j;
+    FILE* f = fopen(INP_FILE, "wt");
+
+    if ( f == NULL ) return 0;
+    fprintf(f, "[OPTIONS]\nFLOW_UNITS CFS\nINFILTRATION %s\n"
+               "START_DATE 01/01/2020\nEND_DATE 01/02/2020\n"
+               "IGNORE_ROUTING YES\n\n", MethodNames[m]);
+    fprintf(f, "[RAINGAGES]\nRG1 INTENSITY 1:00 1.0 TIMESERIES TS1\n\n");
+    fprintf(f, "[TIMESERIES]\nTS1 0:00 0.0\n\n");
+    fprintf(f, "[OUTFALLS]\nOUT1 0 FREE\n\n[SUBCATCHMENTS]\n");
+    for (j = 0; j < nSubcatch; j++)
+    {
+        fprintf(f, "S%d RG1 OUT1 1 50 100 1 0\n", j);
+    }
+    fprintf(f, "\n[SUBAREAS]\n");
+    for (j = 0; j < nSubcatch; j++)
+    {
+        fprintf(f, "S%d 0.015 0.2 0.05 0.1 25 OUTLET\n", j);
+    }
+    fprintf(f, "\n[INFILTRATION]\n");
+    for (j = 0; j < nSubcatch; j++)
+    {
+        if ( m == HORTON || m == MOD_HORTON )
+            fprintf(f, "S%d %.2f %.2f %.1f %.1f %.1f\n", j, uniform(1.0, 5.0),
+                uniform(0.1, 0.7), uniform(2.0, 5.0), uniform(0.5, 7.0),
+                rand() % 2 ? uniform(1.0, 4.0) : 0.0);
+        else if ( m == CURVE_NUMBER )
+            fprintf(f, "S%d %.1f 0.5 %.1f\n", j, uniform(60.0, 95.0),
+                uniform(0.1, 1.0));
+        else
+            fprintf(f, "S%d %.2f %.3f %.2f\n", j, uniform(2.0, 8.0),
+                uniform(0.01, 1.0), uniform(0.1, 0.35));
+    }
+    fclose(f);
+    return 1;
+}
+
+//  Ponded depth of a subcatchment at a time step: water is ponded while
+//  it rains and, on a quarter of the subcatchments, for an hour after.
+static double getDepth(int j, int step)
+{
+    if ( Rainfall[step] > 0.0 ) return Depth[j];
+    if ( j % 4 == 0 && (step % 600) < 240 ) return 0.1 * Depth[j];
+    return 0.0;
+}
+
+static void saveState(int nSubcatch, int m, double* state)
+{
+    int j;
+    for (j = 0; j < nSubcatch; j++)
+    {
+        memset(&state[j*NSTATES], 0, NSTATES * sizeof(double));
+        infil_getState(j, m, &state[j*NSTATES]);
+    }
+}
+
+static double runSingle(int nSubcatch, int m)
+{
+    int     j, step;
+    clock_t start;
+    TInfilBatch batch;
+
+    for (j = 0; j < nSubcatch; j++) infil_initState(j, m);
+    start = clock();
+    batch.count = 1;
+    batch.active[0] = TRUE;
+    for (step = 0; step < NSTEPS; step++)
+    {
+        for (j = 0; j < nSubcatch; j++)
+        {
+            batch.first = j;
+            batch.rainfall[0] = Rainfall[step];
+            batch.runon[0] = Rainfall[step] > 0.0 ? Runon[j] : 0.0;
+            batch.depth[0] = getDepth(j, step);
+            batch.factor[0] = Factor[j];
+            infil_getInfilBatch(&batch, m, TSTEP);
+            Infil1[j] += TSTEP * batch.infil[0];
+        }
+    }
+    return elapsed(start);
+}
+
+static double runBatch(int nSubcatch, int m)
+{
+    int     j, k, step, first;
+    clock_t start;
+    TInfilBatch batch;
+
+    for (j = 0; j < nSubcatch; j++) infil_initState(j, m);
+    start = clock();
+    for (step = 0; step < NSTEPS; step++)
+    {
+        for (first = 0; first < nSubcatch; first += MAXINFILBATCH)
+        {
+            batch.first = first;
+            batch.count = MIN(nSubcatch - first, MAXINFILBATCH);
+            for (k = 0; k < batch.count; k++)
+            {
+                j = first + k;
+                batch.active[k] = TRUE;
+                batch.rainfall[k] = Rainfall[step];
+                batch.runon[k] = Rainfall[step] > 0.0 ? Runon[j] : 0.0;
+                batch.depth[k] = getDepth(j, step);
+                batch.factor[k] = Factor[j];
+            }
+            infil_getInfilBatch(&batch, m, TSTEP);
+            for (k = 0; k < batch.count; k++)
+            {
+                Infil2[first + k] += TSTEP * batch.infil[k];
+            }
+        }
+    }
+    return elapsed(start);
+}
+
+int main(int argc, char* argv[])
+{
+    int    j, m, step;
+    int    nSubcatch = 4096;
+    int    nDiff[CURVE_NUMBER+1];
+    double tSingle[CURVE_NUMBER+1], tBatch[CURVE_NUMBER+1], evals, rain;
+
+    if ( argc > 1 ) nSubcatch = atoi(argv[1]);
+    if ( nSubcatch < 1 ) nSubcatch = 1;
+
+    // --- rainfall (in/hr): 2 hour triangular storm peaking at 3 in/hr
+    //     and a 2 hour storm of 0.2 in/hr after 10 hours
+    for (step = 0; step < NSTEPS; step++)
+    {
+        if ( step < 40 ) rain = 3.0 * step / 40.0;
+        else if ( step < 120 ) rain = 3.0 * (120 - step) / 80.0;
+        else if ( step >= 600 && step < 720 ) rain = 0.2;
+        else rain = 0.0;
+        Rainfall[step] = rain / 43200.0;
+    }
+
+    Runon  = (double *) calloc(nSubcatch, sizeof(double));
+    Depth  = (double *) calloc(nSubcatch, sizeof(double));
+    Factor = (double *) calloc(nSubcatch, sizeof(double));
+    Infil1 = (double *) calloc(nSubcatch, sizeof(double));
+    Infil2 = (double *) calloc(nSubcatch, sizeof(double));
+    State1 = (double *) calloc(nSubcatch * NSTATES, sizeof(double));
+    State2 = (double *) calloc(nSubcatch * NSTATES, sizeof(double));
+    if ( !Runon || !Depth || !Factor || !Infil1 || !Infil2 || !State1 ||
+         !State2 )
+    {
+        fprintf(stderr, "\n  Out of memory\n");
+        return 1;
+    }
+
+    // --- run each method
+    //     (results are listed afterwards since swmm_open writes to stdout)
+    for (m = HORTON; m <= CURVE_NUMBER; m++)
+    {
+        // --- open a model with random infiltration parameters
+        srand(1);
+        if ( !writeModel(nSubcatch, m) ||
+             swmm_open(INP_FILE, RPT_FILE, "") )
+        {
+            fprintf(stderr, "\n  Cannot open %s\n", INP_FILE);
+            return 1;
+        }
+        Evap.recoveryFactor = 1.0;
+        for (j = 0; j < nSubcatch; j++)
+        {
+            Runon[j]  = uniform(0.0, 2.0) / 43200.0;
+            Depth[j]  = uniform(0.0, 0.05);
+            Factor[j] = uniform(0.8, 1.2);
+            Infil1[j] = 0.0;
+            Infil2[j] = 0.0;
+        }
+
+        tSingle[m] = runSingle(nSubcatch, m);
+        saveState(nSubcatch, m, State1);
+        tBatch[m] = runBatch(nSubcatch, m);
+        saveState(nSubcatch, m, State2);
+        swmm_close();
+
+        nDiff[m] = 0;
+        for (j = 0; j < nSubcatch; j++)
+        {
+            if ( Infil1[j] != Infil2[j] ||
+                 memcmp(&State1[j*NSTATES], &State2[j*NSTATES],
+                        NSTATES * sizeof(double)) ) nDiff[m]++;
+        }
+    }
+
+    printf("\n\n  Infiltration: %d subcatchments x %d time steps\n",
+           nSubcatch, NSTEPS);
+    printf("\n  %-20s %14s %14s %9s %s\n", "Method", "Single(M/s)",
+           "Batch(M/s)", "Speedup", "");
+    evals = (double)nSubcatch * NSTEPS / 1.0e6;
+    for (m = HORTON; m <= CURVE_NUMBER; m++)
+    {
+        printf("  %-20s %14.1f %14.1f %8.2fx %s\n", MethodNames[m],
+               evals / MAX(tSingle[m], 1.e-9), evals / MAX(tBatch[m], 1.e-9),
+               tSingle[m] / MAX(tBatch[m], 1.e-9),
+               nDiff[m] ? "RESULTS DIFFER" : "");
+    }
+    return 0;
+}
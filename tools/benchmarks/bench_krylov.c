@@ -0,0 +1,86 @@
+//-----------------------------------------------------------------------------
+//   bench_krylov.c
+//
+//   Project:  EPA SWMM5
+//   Version:  5.2
+//
+//   Microbenchmark of the Newton-Krylov solver (nksolve_solve) on systems
+//   large enough for its GMRES iterations to be limited by the memory
+//   traffic of the Krylov basis.
+//
+//   The system solved is a chain of n unknowns with a weakly diagonally
+//   dominant linear residual that is cheap to evaluate, so that nearly all
+//   of the run time goes to the orthogonalization of the Krylov vectors.
+//   The time per solve is reported for several sizes. Comparing the times
+//   of a default build with those of one made with the SINGLE_PRECISION_STATE
+//   option shows what a single precision basis gains once the basis no
+//   longer fits in cache.
+//
+//   Usage:  bench-krylov [max. unknowns]
+//-----------------------------------------------------------------------------
+#define _CRT_SECURE_NO_DEPRECATE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "nksolve.h"
+
+#define NBASIS 31                      // Krylov vectors held by nksolve.c
+                                       // (MAXKRYLOV + 1)
+
+static int N;                          // number of unknowns
+
+//  Residual of the chain: each unknown is coupled to its two neighbors.
+static void getResidual(void* data, double* x, double* f)
+{
+    int    i;
+    double xLeft, xRight;
+
+    for (i = 0; i < N; i++)
+    {
+        xLeft = ( i > 0 ) ? x[i-1] : 0.0;
+        xRight = ( i < N - 1 ) ? x[i+1] : 0.0;
+        f[i] = 2.01 * x[i] - xLeft - xRight - 1.0;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int       i, r, repeats, iter, maxN = 320000, converged;
+    double    *x, *xscal, t;
+    clock_t   start;
+    TNkSolver nk = {0};
+
+    if ( argc > 1 ) maxN = atoi(argv[1]);
+    x = (double *) malloc(maxN * sizeof(double));
+    xscal = (double *) malloc(maxN * sizeof(double));
+    if ( x == NULL || xscal == NULL ) return 1;
+
+    printf("\n  Newton-Krylov solver: %d byte Krylov basis values\n\n",
+           (int)sizeof(NkReal));
+    printf("  %10s %14s %12s\n", "Unknowns", "Basis (MB)", "ms/solve");
+    for (N = 20000; N <= maxN; N *= 4)
+    {
+        repeats = 320000 / N + 1;
+        converged = 1;
+        start = clock();
+        for (r = 0; r < repeats; r++)
+        {
+            for (i = 0; i < N; i++)
+            {
+                x[i] = 0.0;
+                xscal[i] = 1.0e-4;
+            }
+            converged &= nksolve_solve(&nk, x, xscal, N, 1.0e-15, 50, &iter,
+                                       getResidual, NULL);
+        }
+        t = 1000.0 * (double)(clock() - start) / CLOCKS_PER_SEC;
+        printf("  %10d %14.1f %12.2f %s\n", N,
+               (double)NBASIS * N * sizeof(NkReal) / 1.0e6, t / repeats,
+               converged ? "" : "FAILED TO CONVERGE");
+    }
+    nksolve_close(&nk);
+    free(x);
+    free(xscal);
+    return 0;
+}
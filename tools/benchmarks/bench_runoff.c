@@ -0,0 +1,251 @@
+//-----------------------------------------------------------------------------
+//   bench_runoff.c
+//
+//   Project:  EPA SWMM5
+//   Version:  5.2
+//
+//   Accuracy & throughput benchmark of the two solvers available for the
+//   ponded depth of subcatchment subareas (RUNOFF_SOLVER option):
+//   RUNGE_KUTTA (adaptive 5th order Runge-Kutta) and ROSENBROCK (ROS2
+//   steps with error controlled substeps).
+//
+//   A runoff-only model of a large set of subcatchments with randomly
+//   drawn properties (area, imperviousness, width, slope, roughness,
+//   depression storage, Horton infiltration and internal subarea routing)
+//   is written to bench_runoff.inp and run with each solver for several
+//   wet weather time steps. Its rainfall holds an intense storm followed
+//   by a long dry spell and a second, lighter storm. The time taken by the
+//   runoff computations is reported together with the drift of ROSENBROCK
+//   runoff from RUNGE_KUTTA runoff: the largest difference over all
+//   reporting periods relative to each subcatchment's peak runoff (max. &
+//   mean over subcatchments), the difference in total runoff volume and
+//   the runoff continuity error of each run.
+//
+//   RUNGE_KUTTA is not an exact reference: its error is controlled relative
+//   to the total ponded depth, so for stiff subareas (small & wide) and long
+//   wet steps its runoff can overshoot the excess inflow while the depth
+//   rises. The largest differences at long wet steps come from such steps.
+//
+//   Usage:  bench-runoff [subcatchments]
+//-----------------------------------------------------------------------------
+#define _CRT_SECURE_NO_DEPRECATE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "headers.h"
+#include "swmm5.h"
+#include "swmm_output.h"
+
+#define INP_FILE "bench_runoff.inp"
+#define RPT_FILE "bench_runoff.rpt"
+
+static char* MethodNames[] = {"RUNGE_KUTTA", "ROSENBROCK"};
+static char* OutFiles[]    = {"bench_runoff_rk.out", "bench_runoff_ros.out"};
+static int   WetSteps[]    = {30, 60, 120, 300};
+
+//  Uniform random number in [a, b).
+static double uniform(double a, double b)
+{
+    return a + (b - a) * rand() / (RAND_MAX + 1.0);
+}
+
+//  Rainfall intensity (in/hr) at minute t of the simulation.
+static double rainfall(int t)
+{
+    // --- 2 hour triangular storm peaking at 3 in/hr after 40 minutes
+    if ( t < 40 )  return 3.0 * t / 40.0;
+    if ( t < 120 ) return 3.0 * (120 - t) / 80.0;
+
+    // --- 1 hour storm of 0.4 in/hr after 10 hours
+    if ( t >= 600 && t < 660 ) return 0.4;
+    return 0.0;
+}
+
+static int writeModel(int nSubcatch, int wetStep)
+{
+    int   j, t;
+    char* routeTo[] = {"OUTLET", "OUTLET", "PERVIOUS", "IMPERVIOUS"};
+    double area;
+    FILE* f = fopen(INP_FILE, "wt");
+
+    if ( f == NULL ) return 0;
+    srand(1);
+    fprintf(f, "[OPTIONS]\n"
+        "FLOW_UNITS CFS\nINFILTRATION HORTON\nFLOW_ROUTING KINWAVE\n"
+        "START_DATE 01/01/2020\nSTART_TIME 00:00:00\n"
+        "END_DATE 01/02/2020\nEND_TIME 00:00:00\n"
+        "REPORT_STEP 00:05:00\nWET_STEP 00:%02d:%02d\nDRY_STEP 01:00:00\n"
+        "ROUTING_STEP 0:00:30\nIGNORE_ROUTING YES\nTHREADS 1\n\n",
+        wetStep / 60, wetStep % 60);
+    fprintf(f, "[REPORT]\nSUBCATCHMENTS ALL\n\n");
+    fprintf(f, "[RAINGAGES]\nRG1 INTENSITY 0:05 1.0 TIMESERIES TS1\n\n");
+    fprintf(f, "[OUTFALLS]\nOUT1 0 FREE\n\n[SUBCATCHMENTS]\n");
+    for (j = 0; j < nSubcatch; j++)
+    {
+        area = pow(10.0, uniform(-1.0, 2.0));
+        fprintf(f, "S%d RG1 OUT1 %.4f %.1f %.1f %.3f 0\n", j, area,
+            uniform(0.0, 100.0), sqrt(area * 43560.0) * uniform(0.2, 2.0),
+            pow(10.0, uniform(-1.0, 1.0)));
+    }
+    fprintf(f, "\n[SUBAREAS]\n");
+    for (j = 0; j < nSubcatch; j++)
+    {
+        fprintf(f, "S%d %.3f %.3f %.3f %.3f %.0f %s %.0f\n", j,
+            uniform(0.01, 0.03), uniform(0.1, 0.4), uniform(0.02, 0.1),
+            uniform(0.1, 0.3), uniform(0.0, 50.0), routeTo[rand() % 4],
+            uniform(20.0, 100.0));
+    }
+    fprintf(f, "\n[INFILTRATION]\n");
+    for (j = 0; j < nSubcatch; j++)
+    {
+        fprintf(f, "S%d %.2f %.2f %.1f 7 0\n", j, uniform(1.0, 5.0),
+            uniform(0.1, 0.7), uniform(2.0, 5.0));
+    }
+    fprintf(f, "\n[TIMESERIES]\n");
+    for (t = 0; t <= 720; t += 5)
+    {
+        fprintf(f, "TS1 %d:%02d %.3f\n", t / 60, t % 60, rainfall(t));
+    }
+    fclose(f);
+    return 1;
+}
+
+//  Runs the model with a given solver, returning the time spent on runoff.
+static double runModel(int method, float* runoffErr)
+{
+    int     err;
+    double  elapsedTime = 0.0;
+    float   flowErr, qualErr;
+    clock_t start;
+
+    err = swmm_open(INP_FILE, RPT_FILE, OutFiles[method]);
+    if ( !err )
+    {
+        RunoffSolver = method;
+        err = swmm_start(TRUE);
+    }
+    start = clock();
+    while ( !err )
+    {
+        err = swmm_step(&elapsedTime);
+        if ( elapsedTime == 0.0 ) break;
+    }
+    elapsedTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+    swmm_end();
+    swmm_getMassBalErr(runoffErr, &flowErr, &qualErr);
+    swmm_close();
+    if ( err )
+    {
+        fprintf(stderr, "\n  Error %d running %s\n", err, INP_FILE);
+        exit(1);
+    }
+    return elapsedTime;
+}
+
+static SMO_Handle openOutput(const char* path)
+{
+    SMO_Handle h = NULL;
+    SMO_init(&h);
+    if ( SMO_open(h, path) > 10 )
+    {
+        fprintf(stderr, "\n  Cannot read output file %s\n", path);
+        exit(1);
+    }
+    return h;
+}
+
+//  Compares the runoff of the two output files.
+static void compareRunoff(int nSubcatch, double* maxDiff, double* meanDiff,
+                          double* volDiff)
+{
+    int        j, p, n1, n2, nPeriods;
+    float      *q1, *q2;
+    double     *peak, *diff, vol1 = 0.0, vol2 = 0.0;
+    SMO_Handle h1 = openOutput(OutFiles[RK_RUNOFF]);
+    SMO_Handle h2 = openOutput(OutFiles[ROSENBROCK_RUNOFF]);
+
+    peak = (double *) calloc(nSubcatch, sizeof(double));
+    diff = (double *) calloc(nSubcatch, sizeof(double));
+    SMO_getTimes(h1, SMO_numPeriods, &nPeriods);
+    for (p = 0; p < nPeriods; p++)
+    {
+        q1 = NULL;
+        q2 = NULL;
+        if ( SMO_getSubcatchAttribute(h1, p, SMO_runoff_rate, &q1, &n1) > 10
+          || SMO_getSubcatchAttribute(h2, p, SMO_runoff_rate, &q2, &n2) > 10
+          || n1 != nSubcatch || n2 != nSubcatch )
+        {
+            fprintf(stderr, "\n  Output files do not hold the subcatchments\n");
+            exit(1);
+        }
+        for (j = 0; j < nSubcatch; j++)
+        {
+            peak[j] = MAX(peak[j], q1[j]);
+            diff[j] = MAX(diff[j], fabs((double)q2[j] - q1[j]));
+            vol1 += q1[j];
+            vol2 += q2[j];
+        }
+        SMO_free((void**)&q1);
+        SMO_free((void**)&q2);
+    }
+    *maxDiff = 0.0;
+    *meanDiff = 0.0;
+    for (j = 0; j < nSubcatch; j++)
+    {
+        if ( peak[j] > 0.0 ) diff[j] /= peak[j];
+        *maxDiff = MAX(*maxDiff, diff[j]);
+        *meanDiff += diff[j] / nSubcatch;
+    }
+    *volDiff = ( vol1 > 0.0 ) ? (vol2 - vol1) / vol1 : 0.0;
+    free(peak);
+    free(diff);
+    SMO_close(&h1);
+    SMO_close(&h2);
+}
+
+int main(int argc, char* argv[])
+{
+    int    i, method;
+    int    nSubcatch = 10000;
+    int    nWetSteps = sizeof(WetSteps) / sizeof(int);
+    float  runoffErr[4][2];
+    double t[4][2], maxDiff[4], meanDiff[4], volDiff[4];
+
+    if ( argc > 1 ) nSubcatch = atoi(argv[1]);
+    if ( nSubcatch < 1 ) nSubcatch = 1;
+
+    // --- run the model for each wet step & solver
+    //     (results are listed afterwards since swmm_open writes to stdout)
+    for (i = 0; i < nWetSteps; i++)
+    {
+        if ( !writeModel(nSubcatch, WetSteps[i]) )
+        {
+            fprintf(stderr, "\n  Cannot write %s\n", INP_FILE);
+            return 1;
+        }
+        for (method = RK_RUNOFF; method <= ROSENBROCK_RUNOFF; method++)
+        {
+            t[i][method] = runModel(method, &runoffErr[i][method]);
+        }
+        compareRunoff(nSubcatch, &maxDiff[i], &meanDiff[i], &volDiff[i]);
+    }
+
+    printf("\n\n  Runoff solvers: %d subcatchments, 24 hours\n", nSubcatch);
+    printf("\n  %7s %9s %9s %8s %10s %10s %10s %8s %8s\n", "WetStep",
+           "RK(sec)", "ROS(sec)", "Speedup", "MaxDiff", "MeanDiff",
+           "VolDiff", "RK CE%", "ROS CE%");
+    for (i = 0; i < nWetSteps; i++)
+    {
+        printf("  %7d %9.3f %9.3f %8.2f %10.2e %10.2e %10.2e %8.3f %8.3f\n",
+               WetSteps[i], t[i][0], t[i][1],
+               t[i][0] / MAX(t[i][1], 1.e-9), maxDiff[i], meanDiff[i],
+               volDiff[i], runoffErr[i][0], runoffErr[i][1]);
+    }
+    printf("\n  MaxDiff & MeanDiff: largest runoff difference relative to"
+           " peak runoff\n  (max. & mean over subcatchments); VolDiff:"
+           " relative difference in total\n  runoff; CE: runoff continuity"
+           " error of %s & %s.\n", MethodNames[0], MethodNames[1]);
+    return 0;
+}
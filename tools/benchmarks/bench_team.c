@@ -0,0 +1,125 @@
+//-----------------------------------------------------------------------------
+//   bench_team.c
+//
+//   Project:  EPA SWMM5
+//   Version:  5.2
+//
+//   Benchmark of the OpenMP thread team overhead paid by each dynamic wave
+//   routing time step. Each step starts one team of threads (with the
+//   project pointer copied to each thread) and joins it at the end. A team
+//   kept alive for a whole simulation would instead need two barriers per
+//   step: one to release its parked threads and one to collect them.
+//
+//   For each thread count from 2 to the number of threads the OpenMP
+//   runtime provides, the time to start & join a team and the time of a
+//   barrier inside a running team are reported in microseconds. When an
+//   input file is given, it is also run through the API to report its
+//   number of routing steps and run time, and the share of that run time
+//   spent starting teams.
+//
+//   Usage:  bench-team [inpFile] [repeats]
+//-----------------------------------------------------------------------------
+#define _CRT_SECURE_NO_DEPRECATE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+#include "headers.h"
+#include "swmm5.h"
+
+static volatile int Sink;              // keeps team work live
+
+//  Microseconds to start & join a team of nThreads threads.
+static double timeTeam(int nThreads, int repeats)
+{
+    int    r;
+    double start = omp_get_wtime();
+
+    for (r = 0; r < repeats; r++)
+    {
+#pragma omp parallel num_threads(nThreads) copyin(Prj)
+        {
+            if ( omp_get_thread_num() == 0 ) Sink++;
+        }
+    }
+    return (omp_get_wtime() - start) / repeats * 1.0e6;
+}
+
+//  Microseconds for a barrier inside a running team of nThreads threads.
+static double timeBarrier(int nThreads, int repeats)
+{
+    int    r;
+    double start = 0.0, stop = 0.0;
+
+#pragma omp parallel num_threads(nThreads) copyin(Prj) private(r)
+    {
+        #pragma omp barrier
+        #pragma omp master
+        start = omp_get_wtime();
+        for (r = 0; r < repeats; r++)
+        {
+            #pragma omp barrier
+        }
+        #pragma omp master
+        stop = omp_get_wtime();
+    }
+    return (stop - start) / repeats * 1.0e6;
+}
+
+//  Runs an input file through the API, returning its number of routing
+//  steps & run time in seconds.
+static int runModel(char* inpFile, long* steps, double* seconds)
+{
+    double elapsed = 0.0;
+    double start = omp_get_wtime();
+    int    err;
+
+    *steps = 0;
+    err = swmm_open(inpFile, "bench-team.rpt", "");
+    if ( !err ) err = swmm_start(FALSE);
+    while ( !err )
+    {
+        err = swmm_step(&elapsed);
+        if ( elapsed == 0.0 ) break;
+        (*steps)++;
+    }
+    swmm_end();
+    swmm_close();
+    *seconds = omp_get_wtime() - start;
+    remove("bench-team.rpt");
+    return err;
+}
+
+int main(int argc, char* argv[])
+{
+    int    n, nMax, repeats = 20000;
+    long   steps = 0;
+    double seconds = 0.0, team, barrier;
+
+    if ( argc > 2 ) repeats = atoi(argv[2]);
+    if ( repeats < 1 ) repeats = 1;
+    if ( argc > 1 && runModel(argv[1], &steps, &seconds) )
+    {
+        printf("\n  Could not run %s\n", argv[1]);
+        return 1;
+    }
+
+    nMax = omp_get_max_threads();
+    printf("\n  Thread team overhead (microseconds), %d repeats\n", repeats);
+    printf("\n  %7s %12s %12s", "Threads", "Start+join", "Barrier");
+    if ( steps > 0 ) printf(" %14s", "Start+join(%)");
+    printf("\n");
+    for (n = 2; n <= nMax; n++)
+    {
+        team = timeTeam(n, repeats);
+        barrier = timeBarrier(n, repeats);
+        printf("  %7d %12.2f %12.2f", n, team, barrier);
+        if ( steps > 0 )
+            printf(" %14.3f", 100.0 * steps * team * 1.0e-6 / seconds);
+        printf("\n");
+    }
+    if ( steps > 0 )
+        printf("\n  %s: %ld routing steps in %.2f s (%.1f us per step)\n",
+               argv[1], steps, seconds, seconds / steps * 1.0e6);
+    return 0;
+}
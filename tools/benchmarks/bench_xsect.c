@@ -0,0 +1,131 @@
+//-----------------------------------------------------------------------------
+//   bench_xsect.c
+//
+//   Project:  EPA SWMM5
+//   Version:  5.2
+//
+//   Microbenchmark comparing the scalar cross section geometry functions
+//   xsect_getAofY & xsect_getRofY with their batch versions
+//   xsect_getAofYBatch & xsect_getRofYBatch.
+//
+//   For each shape a set of cross sections of varying size is evaluated
+//   at random part-full depths, first one at a time and then in batches
+//   of MAXCONDUITBATCH (the batch size used by dynamic wave routing).
+//   Results of both methods are checked to be identical and the number
+//   of area + hyd. radius evaluations per second is reported.
+//
+//   Usage:  bench-xsect [repeats]
+//-----------------------------------------------------------------------------
+#define _CRT_SECURE_NO_DEPRECATE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "headers.h"
+
+#define NSECTS 4096                    // number of cross sections per shape
+
+typedef struct
+{
+    char*  name;                       // shape name
+    int    type;                       // shape type code
+    double p[4];                       // shape parameters (ft)
+} TBenchShape;
+
+static TBenchShape BenchShapes[] = {
+    {"CIRCULAR",    CIRCULAR,    {2.0, 0.0, 0.0, 0.0}},
+    {"FORCE_MAIN",  FORCE_MAIN,  {2.0, 120., 0.0, 0.0}},
+    {"EGGSHAPED",   EGGSHAPED,   {3.0, 0.0, 0.0, 0.0}},
+    {"HORSESHOE",   HORSESHOE,   {3.0, 0.0, 0.0, 0.0}},
+    {"ARCH",        ARCH,        {3.0, 4.0, 0.0, 0.0}},
+    {"RECT_CLOSED", RECT_CLOSED, {2.0, 3.0, 0.0, 0.0}},
+    {"RECT_OPEN",   RECT_OPEN,   {2.0, 3.0, 0.0, 0.0}},
+    {"TRAPEZOIDAL", TRAPEZOIDAL, {2.0, 3.0, 1.0, 1.5}},
+    {"TRIANGULAR",  TRIANGULAR,  {2.0, 3.0, 0.0, 0.0}}
+};
+
+static TXsect  Xsect[NSECTS];
+static TXsect* XsectPtr[NSECTS];
+static double  Y[NSECTS];
+static double  A1[NSECTS], R1[NSECTS];
+static double  A2[NSECTS], R2[NSECTS];
+
+static double elapsed(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static void runScalar(int n)
+{
+    int i;
+    for (i = 0; i < n; i++)
+    {
+        A1[i] = xsect_getAofY(&Xsect[i], Y[i]);
+        R1[i] = xsect_getRofY(&Xsect[i], Y[i]);
+    }
+}
+
+static void runBatch(int n)
+{
+    int i, m;
+    for (i = 0; i < n; i += m)
+    {
+        m = MIN(n - i, MAXCONDUITBATCH);
+        xsect_getAofYBatch(&XsectPtr[i], &Y[i], &A2[i], m);
+        xsect_getRofYBatch(&XsectPtr[i], &Y[i], &R2[i], m);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int     i, k, r, nDiff;
+    int     repeats = 2000;
+    int     nShapes = sizeof(BenchShapes) / sizeof(TBenchShape);
+    double  p[4], tScalar, tBatch, evals;
+    clock_t start;
+
+    if ( argc > 1 ) repeats = atoi(argv[1]);
+    if ( repeats < 1 ) repeats = 1;
+    srand(1);
+
+    printf("\n  Cross section geometry: %d sections x %d repeats\n",
+           NSECTS, repeats);
+    printf("\n  %-12s %14s %14s %9s %s\n", "Shape", "Scalar(M/s)",
+           "Batch(M/s)", "Speedup", "");
+    for (k = 0; k < nShapes; k++)
+    {
+        // --- build sections of varying size with random part-full depths
+        for (i = 0; i < NSECTS; i++)
+        {
+            memcpy(p, BenchShapes[k].p, sizeof(p));
+            p[0] *= 0.5 + (double)rand() / RAND_MAX;
+            p[1] *= ( BenchShapes[k].type == FORCE_MAIN ) ? 1.0 :
+                    0.5 + (double)rand() / RAND_MAX;
+            memset(&Xsect[i], 0, sizeof(TXsect));
+            xsect_setParams(&Xsect[i], BenchShapes[k].type, p, 1.0);
+            XsectPtr[i] = &Xsect[i];
+            Y[i] = Xsect[i].yFull * (0.001 + 0.998 * rand() / RAND_MAX);
+        }
+
+        start = clock();
+        for (r = 0; r < repeats; r++) runScalar(NSECTS);
+        tScalar = elapsed(start);
+
+        start = clock();
+        for (r = 0; r < repeats; r++) runBatch(NSECTS);
+        tBatch = elapsed(start);
+
+        nDiff = 0;
+        for (i = 0; i < NSECTS; i++)
+        {
+            if ( A1[i] != A2[i] || R1[i] != R2[i] ) nDiff++;
+        }
+
+        evals = 2.0 * NSECTS * repeats / 1.0e6;
+        printf("  %-12s %14.1f %14.1f %8.2fx %s\n", BenchShapes[k].name,
+               evals / MAX(tScalar, 1.e-9), evals / MAX(tBatch, 1.e-9),
+               tScalar / MAX(tBatch, 1.e-9),
+               nDiff ? "RESULTS DIFFER" : "");
+    }
+    return 0;
+}
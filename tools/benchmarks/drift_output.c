@@ -0,0 +1,173 @@
+//-----------------------------------------------------------------------------
+//   drift_output.c
+//
+//   Project:  EPA SWMM5
+//   Version:  5.2
+//
+//   Regression harness measuring the numerical drift of a binary output
+//   file from a reference one, such as the results of a build made with
+//   the SINGLE_PRECISION_STATE option against those of a default (double
+//   precision) build for the same input file.
+//
+//   For each node, link and system variable the largest absolute
+//   difference over all elements and reporting periods is listed along
+//   with the element & period where it occurs, the difference relative
+//   to the largest reference value of the variable, and the smallest log
+//   relative error (number of matching significant digits, at most 7).
+//
+//   Usage:  drift-output reference.out test.out [max_relative_drift]
+//
+//   Returns 1 if the files don't match in size or if any relative drift
+//   exceeds max_relative_drift (when given), otherwise 0.
+//-----------------------------------------------------------------------------
+#define _CRT_SECURE_NO_DEPRECATE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "swmm_output.h"
+
+#define MAXLRE 7.0                     // max. log relative error (digits)
+
+typedef struct
+{
+    char*  name;                       // variable name
+    int    type;                       // SMO_node, SMO_link or SMO_sys
+    int    attr;                       // variable code
+} TDriftVar;
+
+static TDriftVar DriftVars[] = {
+    {"Node depth",         SMO_node, SMO_invert_depth},
+    {"Node head",          SMO_node, SMO_hydraulic_head},
+    {"Node volume",        SMO_node, SMO_stored_ponded_volume},
+    {"Node total inflow",  SMO_node, SMO_total_inflow},
+    {"Node flooding",      SMO_node, SMO_flooding_losses},
+    {"Link flow",          SMO_link, SMO_flow_rate_link},
+    {"Link depth",         SMO_link, SMO_flow_depth},
+    {"Link velocity",      SMO_link, SMO_flow_velocity},
+    {"Link volume",        SMO_link, SMO_flow_volume},
+    {"Link capacity",      SMO_link, SMO_capacity},
+    {"System flooding",    SMO_sys,  SMO_flood_losses},
+    {"System outfall flow",SMO_sys,  SMO_outfall_flows},
+    {"System storage",     SMO_sys,  SMO_volume_stored}
+};
+
+static int getValues(SMO_Handle h, TDriftVar* v, int period, float** x,
+                     int* n)
+//
+//  System values are read as a whole record, since SMO_getSystemAttribute
+//  returns an array that can't be freed.
+{
+    int err;
+
+    switch ( v->type )
+    {
+    case SMO_node: return SMO_getNodeAttribute(h, period, v->attr, x, n);
+    case SMO_link: return SMO_getLinkAttribute(h, period, v->attr, x, n);
+    default:
+        err = SMO_getSystemResult(h, period, 0, x, n);
+        if ( err <= 10 )
+        {
+            (*x)[0] = (*x)[v->attr];
+            *n = 1;
+        }
+        return err;
+    }
+}
+
+static double getLre(double x, double ref)
+{
+    double re = fabs(x - ref);
+    if ( fabs(ref) >= 1.0e-6 ) re /= fabs(ref);
+    if ( re < pow(10.0, -MAXLRE) ) return MAXLRE;
+    return fmax(0.0, -log10(re));
+}
+
+static SMO_Handle openOutput(const char* path)
+{
+    SMO_Handle h = NULL;
+    SMO_init(&h);
+    if ( SMO_open(h, path) > 10 )
+    {
+        fprintf(stderr, "\n  Cannot read output file %s\n", path);
+        SMO_close(&h);
+        return NULL;
+    }
+    return h;
+}
+
+int main(int argc, char* argv[])
+{
+    int        i, k, p, n1, n2, nPeriods1, nPeriods2;
+    int        nVars = sizeof(DriftVars) / sizeof(TDriftVar);
+    int        iMax, pMax, failed = 0;
+    float      *x1, *x2;
+    double     d, dMax, refMax, lreMin, relDrift, maxDrift = -1.0;
+    SMO_Handle h1, h2;
+
+    if ( argc < 3 )
+    {
+        printf("\n  Usage: drift-output reference.out test.out "
+               "[max_relative_drift]\n");
+        return 1;
+    }
+    if ( argc > 3 ) maxDrift = atof(argv[3]);
+    h1 = openOutput(argv[1]);
+    h2 = openOutput(argv[2]);
+    if ( h1 == NULL || h2 == NULL ) return 1;
+    SMO_getTimes(h1, SMO_numPeriods, &nPeriods1);
+    SMO_getTimes(h2, SMO_numPeriods, &nPeriods2);
+    if ( nPeriods1 != nPeriods2 )
+    {
+        printf("\n  Files have different numbers of periods (%d, %d)\n",
+               nPeriods1, nPeriods2);
+        return 1;
+    }
+
+    printf("\n  Drift of %s from %s over %d periods\n", argv[2], argv[1],
+           nPeriods1);
+    printf("\n  %-20s %12s %8s %7s %12s %6s\n", "Variable", "Max |Diff|",
+           "Element", "Period", "Rel. Drift", "LRE");
+    for (k = 0; k < nVars; k++)
+    {
+        dMax = 0.0;
+        refMax = 0.0;
+        lreMin = MAXLRE;
+        iMax = -1;
+        pMax = -1;
+        for (p = 0; p < nPeriods1; p++)
+        {
+            x1 = NULL;
+            x2 = NULL;
+            if ( getValues(h1, &DriftVars[k], p, &x1, &n1) > 10 ||
+                 getValues(h2, &DriftVars[k], p, &x2, &n2) > 10 ||
+                 n1 != n2 )
+            {
+                printf("\n  Files do not hold the same elements\n");
+                return 1;
+            }
+            for (i = 0; i < n1; i++)
+            {
+                d = fabs((double)x2[i] - x1[i]);
+                refMax = fmax(refMax, fabs(x1[i]));
+                lreMin = fmin(lreMin, getLre(x2[i], x1[i]));
+                if ( d > dMax )
+                {
+                    dMax = d;
+                    iMax = i;
+                    pMax = p;
+                }
+            }
+            SMO_free((void**)&x1);
+            SMO_free((void**)&x2);
+        }
+        relDrift = ( refMax > 0.0 ) ? dMax / refMax : 0.0;
+        if ( maxDrift >= 0.0 && relDrift > maxDrift ) failed = 1;
+        printf("  %-20s %12.4e %8d %7d %12.4e %6.2f %s\n", DriftVars[k].name,
+               dMax, iMax, pMax, relDrift, lreMin,
+               ( maxDrift >= 0.0 && relDrift > maxDrift ) ? "FAIL" : "");
+    }
+    SMO_close(&h1);
+    SMO_close(&h2);
+    return failed;
+}
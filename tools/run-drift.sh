@@ -0,0 +1,46 @@
+#! /bin/bash
+#
+#  run-drift.sh - Measures the numerical drift of the single precision
+#                 link state build from the default double precision build
+#
+#  Arguments:
+#   1 - input file of model to run
+#   2 - (optional) max. relative drift allowed for any output variable
+#
+#  Note:
+#    Both builds are made (with benchmarks enabled) in build-double and
+#    build-single under the current directory. The model's report and
+#    output files are written there too, and drift-output compares the
+#    two output files. The script returns drift-output's exit code.
+#
+
+SCRIPT_HOME="$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )"
+SOURCE_HOME="$( dirname "${SCRIPT_HOME}" )"
+
+if [ $# -lt 1 ]; then
+  echo " "
+  echo "run-drift.sh - compares single & double precision link state results"
+  echo " "
+  echo "usage: run-drift.sh input_file [max_relative_drift]"
+  echo " "
+  exit 1
+fi
+
+input_file=$1
+name=$( basename "${input_file%.*}" )
+
+for precision in double single; do
+  if [ ${precision} = 'single' ]; then flag=ON; else flag=OFF; fi
+  build=build-${precision}
+  echo INFO: Building ${precision} precision link state in ${build}
+  cmake -S "${SOURCE_HOME}" -B ${build} -DBUILD_BENCHMARKS=ON \
+        -DSINGLE_PRECISION_STATE=${flag} > /dev/null || exit 1
+  cmake --build ${build} > /dev/null || exit 1
+  echo INFO: Running ${input_file}
+  ${build}/bin/run-swmm "${input_file}" ${build}/${name}.rpt \
+        ${build}/${name}.out > /dev/null
+  grep "Continuity Error" ${build}/${name}.rpt
+done
+
+build-single/bin/drift-output build-double/${name}.out \
+    build-single/${name}.out $2